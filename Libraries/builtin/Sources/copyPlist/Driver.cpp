@@ -10,14 +10,17 @@
 #include <builtin/copyPlist/Options.h>
 #include <plist/Object.h>
 #include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
 #include <libutil/Filesystem.h>
 #include <process/Context.h>
 #include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
 
 using builtin::copyPlist::Driver;
 using builtin::copyPlist::Options;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::MappedFile;
 
 Driver::
 Driver()
@@ -89,30 +92,53 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
      * Process each input.
      */
     for (std::string const &inputPath : options.inputs()) {
-        /* Read in the input. */
-        std::vector<uint8_t> inputContents;
-        if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory()))) {
+        /* Map the input, so binary property lists can be read in place. */
+        std::unique_ptr<MappedFile> input = filesystem->map(FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory()));
+        if (input == nullptr) {
             fprintf(stderr, "error: unable to read input %s\n", inputPath.c_str());
             return 1;
         }
 
-        std::vector<uint8_t> outputContents;
+        /* Output to the same name as the input, but in the output directory. */
+        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
 
         if (convertFormat == nullptr && !options.validate()) {
             /*
              * If we aren't converting or validating, don't even bother parsing as a plist.
+             * Copying a file over itself would truncate the mapped input; it's already there.
              */
-            outputContents = inputContents;
-        } else {
-            /* Determine the input format. */
-            std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
-            if (inputFormat == nullptr) {
-                fprintf(stderr, "error: input %s is not a plist\n", inputPath.c_str());
+            if (filesystem->resolvePath(outputPath) == filesystem->resolvePath(FSUtil::ResolveRelativePath(inputPath, processContext->currentDirectory()))) {
+                continue;
+            }
+
+            bool written = filesystem->write([&](Filesystem::Output const &output) -> bool {
+                return output(input->data(), input->size());
+            }, outputPath);
+            if (!written) {
+                fprintf(stderr, "error: could not open output path %s to write\n", outputPath.c_str());
                 return 1;
             }
+        } else {
+            /* Determine the input format, and deserialize the input. */
+            std::unique_ptr<plist::Format::Any> inputFormat;
+            std::pair<std::unique_ptr<plist::Object>, std::string> deserialize;
+            if (auto binary = plist::Format::Binary::Identify(input->data(), input->size())) {
+                /* Binary is read in place. */
+                inputFormat = std::unique_ptr<plist::Format::Any>(new plist::Format::Any(plist::Format::Any::Create(*binary)));
+                deserialize = plist::Format::Binary::Deserialize(input->data(), input->size(), *binary);
+            } else {
+                /* The text parsers need their own copy. */
+                std::vector<uint8_t> const contents = std::vector<uint8_t>(input->data(), input->data() + input->size());
+
+                inputFormat = plist::Format::Any::Identify(contents);
+                if (inputFormat == nullptr) {
+                    fprintf(stderr, "error: input %s is not a plist\n", inputPath.c_str());
+                    return 1;
+                }
+
+                deserialize = plist::Format::Any::Deserialize(contents, *inputFormat);
+            }
 
-            /* Deserialize the input. */
-            auto deserialize = plist::Format::Any::Deserialize(inputContents, *inputFormat);
             if (!deserialize.first) {
                 fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), deserialize.second.c_str());
                 return 1;
@@ -121,23 +147,20 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
             /* Use the conversion format if specified, otherwise use the same as the input. */
             plist::Format::Any outputFormat = (convertFormat != nullptr ? *convertFormat : *inputFormat);
 
-            /* Serialize the output. */
-            auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
-            if (serialize.first == nullptr) {
+            /* Serialize the output straight into the output file. */
+            std::pair<bool, std::string> serialize = std::make_pair(true, std::string());
+            bool written = filesystem->write([&](Filesystem::Output const &output) -> bool {
+                serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat, output);
+                return serialize.first;
+            }, outputPath);
+
+            if (!serialize.first) {
                 fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), serialize.second.c_str());
                 return 1;
+            } else if (!written) {
+                fprintf(stderr, "error: could not open output path %s to write\n", outputPath.c_str());
+                return 1;
             }
-
-            outputContents = *serialize.first;
-        }
-
-        /* Output to the same name as the input, but in the output directory. */
-        std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
-
-        /* Write out the output. */
-        if (!filesystem->write(outputContents, outputPath)) {
-            fprintf(stderr, "error: could not open output path %s to write\n", outputPath.c_str());
-            return 1;
         }
     }
 
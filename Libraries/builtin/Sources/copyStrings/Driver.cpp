@@ -8,18 +8,19 @@
 
 #include <builtin/copyStrings/Driver.h>
 #include <builtin/copyStrings/Options.h>
-#include <plist/Dictionary.h>
 #include <plist/Object.h>
-#include <plist/String.h>
 #include <plist/Format/Any.h>
 #include <plist/Format/ASCII.h>
 #include <plist/Format/Binary.h>
 #include <plist/Format/Encoding.h>
+#include <plist/Format/Visitor.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 #include <libutil/Strings.h>
 #include <process/Context.h>
 
+#include <functional>
+
 using builtin::copyStrings::Driver;
 using builtin::copyStrings::Options;
 using libutil::Filesystem;
@@ -64,25 +65,201 @@ ParseStringsEncoding(std::string const &string, plist::Format::Any *format)
     }
 }
 
+namespace {
+
+/*
+ * Checks that the values visited are a valid strings file, if requested,
+ * passing each on to another visitor (if any) once it has been checked.
+ */
+class StringsValidator : public plist::Format::Visitor {
+private:
+    bool                    _validate;
+    plist::Format::Visitor *_next;
+    size_t                  _depth;
+    std::string             _key;
+    std::string             _error;
+    bool                    _stopped;
+
+public:
+    StringsValidator(bool validate, plist::Format::Visitor *next) :
+        _validate(validate),
+        _next    (next),
+        _depth   (0),
+        _stopped (false)
+    {
+    }
+
+public:
+    /*
+     * Why the contents are not a valid strings file, if they are not.
+     */
+    std::string const &error() const
+    { return _error; }
+
+    /*
+     * If the next visitor stopped, rather than the contents being invalid.
+     */
+    bool stopped() const
+    { return _stopped; }
+
+private:
+    bool value(bool root, bool entry)
+    {
+        if (!_validate) {
+            return true;
+        } else if (_depth == 0 && !root) {
+            _error = "strings file is not a dictionary";
+            return false;
+        } else if (_depth == 1 && !entry) {
+            /* Strings are valid for .strings files, dictionaries for .stringsdict files. */
+            _error = "strings key '" + _key + "' is not a string (.strings) or a dictionary (.stringsdict)";
+            return false;
+        }
+
+        return true;
+    }
+
+    bool forward(std::function<bool(plist::Format::Visitor *)> const &visit)
+    {
+        if (_next != nullptr && !visit(_next)) {
+            _stopped = true;
+            return false;
+        }
+
+        return true;
+    }
+
+public:
+    virtual bool beginArray()
+    {
+        if (!value(false, false)) {
+            return false;
+        }
+
+        _depth++;
+        return forward([](plist::Format::Visitor *next) { return next->beginArray(); });
+    }
+
+    virtual bool endArray()
+    {
+        _depth--;
+        return forward([](plist::Format::Visitor *next) { return next->endArray(); });
+    }
+
+public:
+    virtual bool beginDictionary()
+    {
+        if (!value(true, true)) {
+            return false;
+        }
+
+        _depth++;
+        return forward([](plist::Format::Visitor *next) { return next->beginDictionary(); });
+    }
+
+    virtual bool key(std::string const &key)
+    {
+        if (_depth == 1) {
+            _key = key;
+        }
+
+        return forward([&](plist::Format::Visitor *next) { return next->key(key); });
+    }
+
+    virtual bool endDictionary()
+    {
+        _depth--;
+        return forward([](plist::Format::Visitor *next) { return next->endDictionary(); });
+    }
+
+public:
+    virtual bool string(std::string const &value)
+    { return this->value(false, true) && forward([&](plist::Format::Visitor *next) { return next->string(value); }); }
+    virtual bool integer(int64_t value)
+    { return this->value(false, false) && forward([&](plist::Format::Visitor *next) { return next->integer(value); }); }
+    virtual bool real(double value)
+    { return this->value(false, false) && forward([&](plist::Format::Visitor *next) { return next->real(value); }); }
+    virtual bool boolean(bool value)
+    { return this->value(false, false) && forward([&](plist::Format::Visitor *next) { return next->boolean(value); }); }
+    virtual bool null()
+    { return this->value(false, false) && forward([&](plist::Format::Visitor *next) { return next->null(); }); }
+    virtual bool data(std::vector<uint8_t> const &value)
+    { return this->value(false, false) && forward([&](plist::Format::Visitor *next) { return next->data(value); }); }
+    virtual bool date(struct tm const &value)
+    { return this->value(false, false) && forward([&](plist::Format::Visitor *next) { return next->date(value); }); }
+    virtual bool uid(uint32_t value)
+    { return this->value(false, false) && forward([&](plist::Format::Visitor *next) { return next->uid(value); }); }
+};
+
+}
+
+/*
+ * Writes text strings files as the input is read: each value is checked
+ * and written as it is visited, and no objects are built.
+ */
 static std::pair<bool, std::string>
-ValidateStrings(plist::Object const *root)
+WriteVisited(Filesystem *filesystem, std::vector<uint8_t> const &contents, plist::Format::Any const &inputFormat, plist::Format::ASCII const &outputFormat, bool validate, std::string const &outputPath)
 {
-    if (plist::Dictionary const *dictionary = plist::CastTo<plist::Dictionary>(root)) {
-        for (size_t n = 0; n < dictionary->count(); n++) {
-            auto key = dictionary->key(n);
-            if (dictionary->value <plist::String> (key)) {
-                /* Valid for .strings files. */
-            } else if (dictionary->value <plist::Dictionary> (key)) {
-                /* Valid for .stringdict files. */
-            } else {
-                return std::make_pair(false, "strings key '" + key + "' is not a string (.strings) or a dictionary (.stringsdict)");
-            }
+    StringsValidator validator = StringsValidator(validate, nullptr);
+    std::pair<bool, std::string> visit = std::make_pair(true, std::string());
+    std::pair<bool, std::string> serialize = std::make_pair(true, std::string());
+
+    bool written = filesystem->write([&](Filesystem::Output const &output) -> bool {
+        serialize = plist::Format::ASCII::Serialize([&](plist::Format::Visitor *writer) -> bool {
+            validator = StringsValidator(validate, writer);
+            visit = plist::Format::Any::Visit(contents, inputFormat, &validator);
+            return visit.first;
+        }, outputFormat, output);
+        return serialize.first;
+    }, outputPath);
+
+    if (!validator.error().empty()) {
+        return std::make_pair(false, validator.error());
+    } else if (validator.stopped()) {
+        return std::make_pair(false, serialize.second);
+    } else if (!visit.first) {
+        return std::make_pair(false, visit.second);
+    } else if (!serialize.first) {
+        return std::make_pair(false, serialize.second);
+    } else if (!written) {
+        return std::make_pair(false, "could not write output");
+    }
+
+    return std::make_pair(true, std::string());
+}
+
+/*
+ * Writes binary strings files, which must be built in memory first.
+ */
+static std::pair<bool, std::string>
+WriteSerialized(Filesystem *filesystem, std::vector<uint8_t> const &contents, plist::Format::Any const &inputFormat, plist::Format::Any const &outputFormat, bool validate, std::string const &outputPath)
+{
+    auto deserialize = plist::Format::Any::Deserialize(contents, inputFormat);
+    if (!deserialize.first) {
+        return std::make_pair(false, deserialize.second);
+    }
+
+    if (validate) {
+        StringsValidator validator = StringsValidator(true, nullptr);
+        if (!plist::Format::Visitor::Visit(deserialize.first.get(), &validator)) {
+            return std::make_pair(false, validator.error());
         }
+    }
 
-        return std::make_pair(true, std::string());
-    } else {
-        return std::make_pair(false, "strings file is not a dictionary");
+    /* Write out the output as it's serialized. */
+    std::pair<bool, std::string> serialize = std::make_pair(true, std::string());
+    bool written = filesystem->write([&](Filesystem::Output const &output) -> bool {
+        serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat, output);
+        return serialize.first;
+    }, outputPath);
+
+    if (!serialize.first) {
+        return std::make_pair(false, serialize.second);
+    } else if (!written) {
+        return std::make_pair(false, "could not write output");
     }
+
+    return std::make_pair(true, std::string());
 }
 
 static bool
@@ -161,34 +338,19 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
             return -1;
         }
 
-        /* Deserialize the input. */
-        auto deserialize = plist::Format::Any::Deserialize(inputContents, resolvedInputFormat);
-        if (!deserialize.first) {
-            fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), deserialize.second.c_str());
-            return 1;
-        }
-
-        /* If requested, validate the strings file is valid. */
-        if (options.validate()) {
-            auto validation = ValidateStrings(deserialize.first.get());
-            if (!validation.first) {
-                fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), validation.second.c_str());
-                return 1;
-            }
-        }
-
         /* Output to the same name as the input, but in the output directory. */
         std::string outputPath = FSUtil::ResolveRelativePath(*options.outputDirectory(), processContext->currentDirectory()) + "/" + FSUtil::GetBaseName(inputPath);
 
-        /* Write out the output. */
-        auto serialize = plist::Format::Any::Serialize(deserialize.first.get(), outputFormat);
-        if (serialize.first == nullptr) {
-            fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), serialize.second.c_str());
-            return 1;
+        /* Convert the input, validating it if requested. */
+        std::pair<bool, std::string> write;
+        if (plist::Format::ASCII const *ascii = outputFormat.format<plist::Format::ASCII>()) {
+            write = WriteVisited(filesystem, inputContents, resolvedInputFormat, *ascii, options.validate(), outputPath);
+        } else {
+            write = WriteSerialized(filesystem, inputContents, resolvedInputFormat, outputFormat, options.validate(), outputPath);
         }
 
-        if (!filesystem->write(*serialize.first, outputPath)) {
-            fprintf(stderr, "error: %s: could not write output\n", inputPath.c_str());
+        if (!write.first) {
+            fprintf(stderr, "error: %s: %s\n", inputPath.c_str(), write.second.c_str());
             return 1;
         }
     }
@@ -23,12 +23,14 @@
 #include <plist/Format/XML.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
 #include <process/Context.h>
 
 using builtin::infoPlistUtility::Driver;
 using builtin::infoPlistUtility::Options;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::MappedFile;
 
 Driver::
 Driver()
@@ -176,22 +178,33 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
 
     pbxsetting::Environment settingsEnvironment = CreateBuildEnvironment(processContext->environmentVariables());
 
-    /* Read in the input. */
-    std::vector<uint8_t> inputContents;
-    if (!filesystem->read(&inputContents, FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory()))) {
+    /* Map the input, so binary property lists can be read in place. */
+    std::unique_ptr<MappedFile> input = filesystem->map(FSUtil::ResolveRelativePath(*options.input(), processContext->currentDirectory()));
+    if (input == nullptr) {
         fprintf(stderr, "error: unable to read input %s\n", options.input()->c_str());
         return 1;
     }
 
-    /* Determine the input format. */
-    std::unique_ptr<plist::Format::Any> inputFormat = plist::Format::Any::Identify(inputContents);
-    if (inputFormat == nullptr) {
-        fprintf(stderr, "error: input %s is not a plist\n", options.input()->c_str());
-        return 1;
+    /* Determine the input format, and deserialize the input. */
+    std::unique_ptr<plist::Format::Any> inputFormat;
+    std::pair<std::unique_ptr<plist::Object>, std::string> deserialize;
+    if (auto binary = plist::Format::Binary::Identify(input->data(), input->size())) {
+        /* Binary is read in place. */
+        inputFormat = std::unique_ptr<plist::Format::Any>(new plist::Format::Any(plist::Format::Any::Create(*binary)));
+        deserialize = plist::Format::Binary::Deserialize(input->data(), input->size(), *binary);
+    } else {
+        /* The text parsers need their own copy. */
+        std::vector<uint8_t> const contents = std::vector<uint8_t>(input->data(), input->data() + input->size());
+
+        inputFormat = plist::Format::Any::Identify(contents);
+        if (inputFormat == nullptr) {
+            fprintf(stderr, "error: input %s is not a plist\n", options.input()->c_str());
+            return 1;
+        }
+
+        deserialize = plist::Format::Any::Deserialize(contents, *inputFormat);
     }
 
-    /* Deserialize the input. */
-    auto deserialize = plist::Format::Any::Deserialize(inputContents, *inputFormat);
     if (!deserialize.first) {
         fprintf(stderr, "error: %s: %s\n", options.input()->c_str(), deserialize.second.c_str());
         return 1;
@@ -304,15 +317,17 @@ run(process::Context const *processContext, libutil::Filesystem *filesystem)
         }
     }
 
-    /* Serialize the output. */
-    auto serialize = plist::Format::Any::Serialize(root, outputFormat);
-    if (serialize.first == nullptr) {
+    /* Serialize the output straight into the output file. */
+    std::pair<bool, std::string> serialize = std::make_pair(true, std::string());
+    bool written = filesystem->write([&](Filesystem::Output const &output) -> bool {
+        serialize = plist::Format::Any::Serialize(root, outputFormat, output);
+        return serialize.first;
+    }, FSUtil::ResolveRelativePath(*options.output(), processContext->currentDirectory()));
+
+    if (!serialize.first) {
         fprintf(stderr, "error: %s\n", serialize.second.c_str());
         return 1;
-    }
-
-    /* Write out the output. */
-    if (!filesystem->write(*serialize.first, FSUtil::ResolveRelativePath(*options.output(), processContext->currentDirectory()))) {
+    } else if (!written) {
         fprintf(stderr, "error: could not open output path %s to write\n", options.output()->c_str());
         return 1;
     }
@@ -17,6 +17,7 @@ class DefaultFilesystem : public Filesystem {
 public:
     virtual bool exists(std::string const &path) const;
     virtual ext::optional<Type> type(std::string const &path) const;
+    virtual ext::optional<uint64_t> modificationTime(std::string const &path) const;
 
 public:
     virtual bool isReadable(std::string const &path) const;
@@ -28,7 +29,11 @@ public:
     virtual bool writeFilePermissions(std::string const &path, Permissions::Operation operation, Permissions permissions);
     virtual bool createFile(std::string const &path);
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
+    virtual std::unique_ptr<MappedFile> map(std::string const &path) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool write(std::function<bool(Output const &output)> const &producer, std::string const &path);
+    virtual bool replace(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool replace(std::function<bool(Output const &output)> const &producer, std::string const &path);
     virtual bool copyFile(std::string const &from, std::string const &to);
     virtual bool removeFile(std::string const &path);
 
@@ -12,12 +12,15 @@
 #include <libutil/Permissions.h>
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <ext/optional>
 
 namespace libutil {
 
+class MappedFile;
+
 class Filesystem {
 public:
     /*
@@ -49,6 +52,12 @@ public:
      */
     virtual ext::optional<Type> type(std::string const &path) const = 0;
 
+    /*
+     * Get the time a filesystem entry was last modified, in nanoseconds. Only
+     * meaningful when compared with another time from the same filesystem.
+     */
+    virtual ext::optional<uint64_t> modificationTime(std::string const &path) const = 0;
+
 public:
     /*
      * Test if a file is readable.
@@ -87,11 +96,41 @@ public:
      */
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const = 0;
 
+    /*
+     * Map the contents of a file into memory, avoiding a copy where the
+     * filesystem allows. By default, reads the file. Returns nullptr on
+     * error.
+     */
+    virtual std::unique_ptr<MappedFile> map(std::string const &path) const;
+
     /*
      * Write to a file.
      */
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path) = 0;
 
+    /*
+     * Receives the parts of a file being written, in order.
+     */
+    typedef std::function<bool(uint8_t const *data, size_t size)> Output;
+
+    /*
+     * Write to a file in parts, as the producer passes them to the output
+     * it is given. Fails if the producer or any write fails. By default,
+     * collects the parts and writes them together.
+     */
+    virtual bool write(std::function<bool(Output const &output)> const &producer, std::string const &path);
+
+    /*
+     * Replace a file with new contents only once they are complete. Until
+     * then, the file is unchanged, so a failed write leaves it as it was,
+     * and anyone reading or mapping it, such as a tool writing over its own
+     * input, never sees a partial file. The file is replaced rather than
+     * written in place, which needs a writable directory and doesn't keep
+     * hard links or ownership. By default, writes the file.
+     */
+    virtual bool replace(std::vector<uint8_t> const &contents, std::string const &path);
+    virtual bool replace(std::function<bool(Output const &output)> const &producer, std::string const &path);
+
     /*
      * Copy a file to a new path.
      */
@@ -0,0 +1,62 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __libutil_MappedFile_h
+#define __libutil_MappedFile_h
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace libutil {
+
+/*
+ * The read-only contents of a file, either mapped into memory or, where
+ * that isn't possible, read into a buffer. The contents are valid for as
+ * long as the mapped file exists.
+ */
+class MappedFile {
+private:
+    void                 *_mapping;
+    size_t                _size;
+    std::vector<uint8_t>  _contents;
+
+public:
+    /*
+     * Take ownership of a region mapped with mmap().
+     */
+    MappedFile(void *mapping, size_t size);
+
+    /*
+     * Contents already read into memory.
+     */
+    explicit MappedFile(std::vector<uint8_t> &&contents);
+
+    ~MappedFile();
+
+public:
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+
+public:
+    /*
+     * The contents of the file.
+     */
+    uint8_t const *data() const
+    { return (_mapping != nullptr ? static_cast<uint8_t const *>(_mapping) : _contents.data()); }
+
+    /*
+     * The size of the file, in bytes.
+     */
+    size_t size() const
+    { return _size; }
+};
+
+}
+
+#endif  // !__libutil_MappedFile_h
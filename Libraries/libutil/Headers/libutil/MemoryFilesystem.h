@@ -23,6 +23,7 @@ public:
         Type                 _type;
         std::vector<uint8_t> _contents;
         std::vector<Entry>   _children;
+        uint64_t             _modificationTime;
 
     private:
         Entry(std::string const &name, Type type);
@@ -44,6 +45,10 @@ public:
         { return _children; }
         std::vector<Entry> const &children() const
         { return _children; }
+        uint64_t &modificationTime()
+        { return _modificationTime; }
+        uint64_t const &modificationTime() const
+        { return _modificationTime; }
 
     public:
         MemoryFilesystem::Entry *child(std::string const &name);
@@ -55,11 +60,18 @@ public:
     };
 
 private:
-    Entry _root;
+    Entry    _root;
+    uint64_t _clock;
 
 public:
     MemoryFilesystem(std::vector<Entry> const &entries);
 
+private:
+    /*
+     * Modification times are a counter incremented on each change.
+     */
+    uint64_t tick();
+
 public:
     Entry &root()
     { return _root; }
@@ -72,6 +84,7 @@ public:
 public:
     virtual bool exists(std::string const &path) const;
     virtual ext::optional<Type> type(std::string const &path) const;
+    virtual ext::optional<uint64_t> modificationTime(std::string const &path) const;
 
 public:
     virtual bool isReadable(std::string const &path) const;
@@ -84,6 +97,7 @@ public:
     virtual bool createFile(std::string const &path);
     virtual bool read(std::vector<uint8_t> *contents, std::string const &path, size_t offset = 0, ext::optional<size_t> length = ext::nullopt) const;
     virtual bool write(std::vector<uint8_t> const &contents, std::string const &path);
+    using Filesystem::write;
     virtual bool copyFile(std::string const &from, std::string const &to);
     virtual bool removeFile(std::string const &path);
 
@@ -0,0 +1,82 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __libutil_ThreadPool_h
+#define __libutil_ThreadPool_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libutil {
+
+/*
+ * A fixed-size pool of worker threads. Work items are run in the order
+ * they are submitted, at most `size()` at a time. Work submitted to the
+ * same pool from several places shares that limit.
+ */
+class ThreadPool {
+private:
+    std::size_t                        _size;
+    std::vector<std::thread>           _threads;
+    std::deque<std::function<void()>>  _queue;
+    std::mutex                         _mutex;
+    std::condition_variable            _condition;
+    bool                               _stopping;
+
+public:
+    /*
+     * Creates a pool with `size` worker threads. A size of zero is
+     * treated as one.
+     */
+    explicit ThreadPool(std::size_t size);
+
+    /*
+     * Waits for all submitted work to finish and joins the workers.
+     */
+    ~ThreadPool();
+
+public:
+    /*
+     * The number of worker threads.
+     */
+    std::size_t size() const
+    { return _size; }
+
+public:
+    /*
+     * Queues work to run on one of the worker threads. Thread-safe.
+     */
+    void submit(std::function<void()> const &work);
+
+    /*
+     * Runs `work` once for each index in [0, count) on the worker threads,
+     * and waits for all of them to finish. Results written by index are in
+     * a deterministic order regardless of which thread ran them. Must not
+     * be called from one of this pool's own worker threads.
+     */
+    void apply(std::size_t count, std::function<void(std::size_t)> const &work);
+
+public:
+    /*
+     * The default pool size, based on the number of hardware threads.
+     */
+    static std::size_t
+    DefaultSize();
+
+private:
+    void run();
+};
+
+}
+
+#endif  // !__libutil_ThreadPool_h
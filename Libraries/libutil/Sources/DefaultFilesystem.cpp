@@ -8,8 +8,10 @@
 
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
 #include <libutil/Relative.h>
 
+#include <atomic>
 #include <stack>
 #include <climits>
 #include <cstdlib>
@@ -20,6 +22,8 @@
 #include <unistd.h>
 #include <libgen.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #if defined(__APPLE__)
 #include <copyfile.h>
@@ -28,6 +32,7 @@
 #include <iostream>
 
 using libutil::DefaultFilesystem;
+using libutil::MappedFile;
 using libutil::Filesystem;
 using libutil::Permissions;
 
@@ -57,6 +62,22 @@ type(std::string const &path) const
     }
 }
 
+ext::optional<uint64_t> DefaultFilesystem::
+modificationTime(std::string const &path) const
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0) {
+        return ext::nullopt;
+    }
+
+#if defined(__APPLE__)
+    struct timespec const &time = st.st_mtimespec;
+#else
+    struct timespec const &time = st.st_mtim;
+#endif
+    return static_cast<uint64_t>(time.tv_sec) * 1000000000 + static_cast<uint64_t>(time.tv_nsec);
+}
+
 bool DefaultFilesystem::
 isReadable(std::string const &path) const
 {
@@ -310,6 +331,101 @@ read(std::vector<uint8_t> *contents, std::string const &path, size_t offset, ext
     return true;
 }
 
+std::unique_ptr<MappedFile> DefaultFilesystem::
+map(std::string const &path) const
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return Filesystem::map(path);
+    }
+
+    /* Empty files can't be mapped. */
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return std::unique_ptr<MappedFile>(new MappedFile(std::vector<uint8_t>()));
+    }
+
+    /* The mapping stays valid after the file is closed. */
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return Filesystem::map(path);
+    }
+
+    return std::unique_ptr<MappedFile>(new MappedFile(mapping, size));
+}
+
+/*
+ * Writes a file through a temporary file next to it, renamed over the path
+ * only once the producer succeeds. Until then, the path is left untouched,
+ * and anyone reading or mapping it sees either the old or the new contents.
+ */
+static bool
+WriteAtomically(std::string const &path, std::function<bool(FILE *fp)> const &producer)
+{
+    /* Write through symbolic links, like opening the path would. */
+    std::string target = path;
+    char resolved[PATH_MAX];
+    if (::realpath(path.c_str(), resolved) != nullptr) {
+        target = resolved;
+    }
+
+    /* Devices, pipes, and the like can't be replaced; write to them directly. */
+    struct stat st;
+    bool exists = (::stat(target.c_str(), &st) == 0);
+    if (exists && !S_ISREG(st.st_mode)) {
+        FILE *fp = std::fopen(target.c_str(), "wb");
+        if (fp == nullptr) {
+            return false;
+        }
+
+        bool result = producer(fp);
+        return (std::fclose(fp) == 0 && result);
+    }
+
+    static std::atomic<unsigned long> counter;
+    std::string temporary;
+    int fd;
+    do {
+        temporary = target + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+        fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    } while (fd < 0 && errno == EEXIST);
+    if (fd < 0) {
+        return false;
+    }
+
+    /* Keep the permissions of the file being replaced. */
+    if (exists) {
+        ::fchmod(fd, st.st_mode & 07777);
+    }
+
+    FILE *fp = ::fdopen(fd, "wb");
+    if (fp == nullptr) {
+        ::close(fd);
+        ::unlink(temporary.c_str());
+        return false;
+    }
+
+    bool result = producer(fp);
+    if (std::fclose(fp) != 0) {
+        result = false;
+    }
+
+    if (!result || ::rename(temporary.c_str(), target.c_str()) != 0) {
+        ::unlink(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
 bool DefaultFilesystem::
 write(std::vector<uint8_t> const &contents, std::string const &path)
 {
@@ -332,6 +448,51 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
     return true;
 }
 
+bool DefaultFilesystem::
+write(std::function<bool(Output const &output)> const &producer, std::string const &path)
+{
+    FILE *fp = std::fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    /* Each part goes through the stream's buffer, not a copy of the file. */
+    bool result = producer([fp](uint8_t const *data, size_t size) {
+        return (size == 0 || std::fwrite(data, size, 1, fp) == 1);
+    });
+
+    if (std::fclose(fp) != 0) {
+        result = false;
+    }
+
+    /* Don't leave a partial file behind. */
+    if (!result) {
+        std::remove(path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool DefaultFilesystem::
+replace(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    return WriteAtomically(path, [&contents](FILE *fp) {
+        return (contents.empty() || std::fwrite(contents.data(), contents.size(), 1, fp) == 1);
+    });
+}
+
+bool DefaultFilesystem::
+replace(std::function<bool(Output const &output)> const &producer, std::string const &path)
+{
+    return WriteAtomically(path, [&producer](FILE *fp) {
+        /* Each part goes through the stream's buffer, not a copy of the file. */
+        return producer([fp](uint8_t const *data, size_t size) {
+            return (size == 0 || std::fwrite(data, size, 1, fp) == 1);
+        });
+    });
+}
+
 bool DefaultFilesystem::
 copyFile(std::string const &from, std::string const &to)
 {
@@ -498,12 +659,8 @@ removeSymbolicLink(std::string const &path)
 bool DefaultFilesystem::
 createDirectory(std::string const &path, bool recursive)
 {
-    /* Get and re-set current mode mask. */
-    mode_t mask = ::umask(0);
-    ::umask(mask);
-
-    /* Mode is most allowed by mask. */
-    mode_t mode = (S_IRWXU | S_IRWXG | S_IRWXO) & ~mask;
+    /* Mode is most allowed by mask; mkdir() applies the mask itself. */
+    mode_t mode = (S_IRWXU | S_IRWXG | S_IRWXO);
 
     if (recursive) {
         std::string current = path;
@@ -520,7 +677,10 @@ createDirectory(std::string const &path, bool recursive)
             std::string const &directory = create.top();
 
             if (::mkdir(directory.c_str(), mode) != 0) {
-                return false;
+                /* Another thread or process could have created it first. */
+                if (errno != EEXIST || this->type(directory) != Type::Directory) {
+                    return false;
+                }
             }
             create.pop();
         }
@@ -8,17 +8,21 @@
 
 #include <libutil/Escape.h>
 
+#include <mutex>
+
 using libutil::Escape;
 
 std::string Escape::
 Shell(std::string const &value)
 {
     static std::string const *escaped = nullptr;
-    if (escaped == nullptr) {
+
+    static std::once_flag flag;
+    std::call_once(flag, []{
         std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
         std::string digits = "0123456789";
         escaped = new std::string(alphabet + digits + "@%_-+=:,./");
-    }
+    });
 
     if (value.find_first_not_of(*escaped) == std::string::npos) {
         return value;
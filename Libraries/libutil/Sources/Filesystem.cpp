@@ -8,12 +8,53 @@
 
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
 
 #include <unordered_set>
 #include <sstream>
 
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::MappedFile;
+
+std::unique_ptr<MappedFile> Filesystem::
+map(std::string const &path) const
+{
+    std::vector<uint8_t> contents;
+    if (!this->read(&contents, path)) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<MappedFile>(new MappedFile(std::move(contents)));
+}
+
+bool Filesystem::
+write(std::function<bool(Output const &output)> const &producer, std::string const &path)
+{
+    std::vector<uint8_t> contents;
+
+    bool result = producer([&contents](uint8_t const *data, size_t size) {
+        contents.insert(contents.end(), data, data + size);
+        return true;
+    });
+    if (!result) {
+        return false;
+    }
+
+    return this->write(contents, path);
+}
+
+bool Filesystem::
+replace(std::vector<uint8_t> const &contents, std::string const &path)
+{
+    return this->write(contents, path);
+}
+
+bool Filesystem::
+replace(std::function<bool(Output const &output)> const &producer, std::string const &path)
+{
+    return this->write(producer, path);
+}
 
 bool Filesystem::
 copyFile(std::string const &from, std::string const &to)
@@ -157,13 +198,17 @@ findExecutable(std::string const &name, std::vector<std::string> const &paths) c
 
 #include <libutil/DefaultFilesystem.h>
 
+#include <mutex>
+
 Filesystem *Filesystem::
 GetDefaultUNSAFE()
 {
     static DefaultFilesystem *filesystem = nullptr;
-    if (filesystem == nullptr) {
+
+    static std::once_flag flag;
+    std::call_once(flag, []{
         filesystem = new DefaultFilesystem();
-    }
+    });
 
     return filesystem;
 }
@@ -0,0 +1,36 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <libutil/MappedFile.h>
+
+#include <sys/mman.h>
+
+using libutil::MappedFile;
+
+MappedFile::
+MappedFile(void *mapping, size_t size) :
+    _mapping(mapping),
+    _size   (size)
+{
+}
+
+MappedFile::
+MappedFile(std::vector<uint8_t> &&contents) :
+    _mapping (nullptr),
+    _size    (contents.size()),
+    _contents(std::move(contents))
+{
+}
+
+MappedFile::
+~MappedFile()
+{
+    if (_mapping != nullptr) {
+        ::munmap(_mapping, _size);
+    }
+}
@@ -20,8 +20,9 @@ using libutil::FSUtil;
 
 MemoryFilesystem::Entry::
 Entry(std::string const &name, Type type) :
-    _name(name),
-    _type(type)
+    _name            (name),
+    _type            (type),
+    _modificationTime(0)
 {
 }
 
@@ -71,10 +72,17 @@ Directory(std::string const &name, std::vector<Entry> const &children)
 
 MemoryFilesystem::
 MemoryFilesystem(std::vector<MemoryFilesystem::Entry> const &entries) :
-    _root(MemoryFilesystem::Entry::Directory("", entries))
+    _root (MemoryFilesystem::Entry::Directory("", entries)),
+    _clock(0)
 {
 }
 
+uint64_t MemoryFilesystem::
+tick()
+{
+    return ++_clock;
+}
+
 std::string MemoryFilesystem::
 path(std::string const &path) const
 {
@@ -156,6 +164,24 @@ exists(std::string const &path) const
     });
 }
 
+ext::optional<uint64_t> MemoryFilesystem::
+modificationTime(std::string const &path) const
+{
+    ext::optional<uint64_t> modificationTime;
+
+    if (!WalkPath<MemoryFilesystem::Entry const>(this, path, false, [&modificationTime](MemoryFilesystem::Entry const *parent, std::string const &name, MemoryFilesystem::Entry const *entry) -> MemoryFilesystem::Entry const * {
+        if (entry != nullptr) {
+            modificationTime = entry->modificationTime();
+        }
+
+        return entry;
+    })) {
+        return ext::nullopt;
+    }
+
+    return modificationTime;
+}
+
 ext::optional<Filesystem::Type> MemoryFilesystem::
 type(std::string const &path) const
 {
@@ -248,7 +274,7 @@ writeDirectoryPermissions(std::string const &path, Permissions::Operation operat
 bool MemoryFilesystem::
 createFile(std::string const &path)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [this](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == Type::File) {
                 /* Exists as a file. */
@@ -260,6 +286,7 @@ createFile(std::string const &path)
         } else {
             /* Add empty file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, std::vector<uint8_t>());
+            file.modificationTime() = parent->modificationTime() = tick();
             std::vector<MemoryFilesystem::Entry> *children = &parent->children();
             children->emplace_back(std::move(file));
             return &children->back();
@@ -295,6 +322,7 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
             if (entry->type() == Type::File) {
                 /* Exists as a file, replace contents. */
                 entry->contents() = contents;
+                entry->modificationTime() = tick();
                 return entry;
             } else {
                 /* Exists already, but not as a file. */
@@ -303,6 +331,7 @@ write(std::vector<uint8_t> const &contents, std::string const &path)
         } else {
             /* Add file. */
             MemoryFilesystem::Entry file = MemoryFilesystem::Entry::File(name, contents);
+            file.modificationTime() = parent->modificationTime() = tick();
             std::vector<MemoryFilesystem::Entry> *children = &parent->children();
             children->emplace_back(std::move(file));
             return &children->back();
@@ -319,7 +348,7 @@ copyFile(std::string const &from, std::string const &to)
 bool MemoryFilesystem::
 removeFile(std::string const &path)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [this](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == Type::File) {
                 /* Found, remove it. */
@@ -327,6 +356,7 @@ removeFile(std::string const &path)
                 children->erase(std::remove_if(children->begin(), children->end(), [&](MemoryFilesystem::Entry const &entry) {
                     return (entry.name() == name);
                 }), children->end());
+                parent->modificationTime() = tick();
                 return parent;
             } else {
                 /* Can't remove directories. */
@@ -372,7 +402,7 @@ removeSymbolicLink(std::string const &path)
 bool MemoryFilesystem::
 createDirectory(std::string const &path, bool recursive)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, recursive, [](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, recursive, [this](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr) {
             if (entry->type() == Type::Directory) {
                 /* Intermediate directory already exists. */
@@ -384,6 +414,7 @@ createDirectory(std::string const &path, bool recursive)
         } else {
             /* Add intermediate directory. */
             MemoryFilesystem::Entry directory = MemoryFilesystem::Entry::Directory(name, { });
+            directory.modificationTime() = parent->modificationTime() = tick();
             std::vector<MemoryFilesystem::Entry> *children = &parent->children();
             children->emplace_back(std::move(directory));
             return &children->back();
@@ -430,7 +461,7 @@ readDirectory(std::string const &path, bool recursive, std::function<void(std::s
 bool MemoryFilesystem::
 removeDirectory(std::string const &path, bool recursive)
 {
-    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [&recursive](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
+    return WalkPath<MemoryFilesystem::Entry>(this, path, false, [this, &recursive](MemoryFilesystem::Entry *parent, std::string const &name, MemoryFilesystem::Entry *entry) -> MemoryFilesystem::Entry * {
         if (entry != nullptr && entry->type() == Type::Directory) {
             /* Only remove empty directories unless recursive. */
             if (!recursive && !entry->children().empty()) {
@@ -442,6 +473,7 @@ removeDirectory(std::string const &path, bool recursive)
             children->erase(std::remove_if(children->begin(), children->end(), [&](MemoryFilesystem::Entry const &entry) {
                 return (entry.name() == name);
             }), children->end());
+            parent->modificationTime() = tick();
             return parent;
         } else {
             /* Did not exist or not a directory. */
@@ -0,0 +1,98 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <libutil/ThreadPool.h>
+
+using libutil::ThreadPool;
+
+ThreadPool::
+ThreadPool(std::size_t size) :
+    _size    (size == 0 ? 1 : size),
+    _stopping(false)
+{
+    _threads.reserve(_size);
+    for (std::size_t i = 0; i < _size; i++) {
+        _threads.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::
+~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_all();
+
+    for (std::thread &thread : _threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::
+submit(std::function<void()> const &work)
+{
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _queue.push_back(work);
+    }
+    _condition.notify_one();
+}
+
+void ThreadPool::
+apply(std::size_t count, std::function<void(std::size_t)> const &work)
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::size_t remaining = count;
+
+    for (std::size_t i = 0; i < count; i++) {
+        submit([i, &work, &mutex, &condition, &remaining] {
+            work(i);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            if (--remaining == 0) {
+                condition.notify_one();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&remaining] { return remaining == 0; });
+}
+
+void ThreadPool::
+run()
+{
+    while (true) {
+        std::function<void()> work;
+
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _stopping || !_queue.empty(); });
+
+            /* Drain remaining work before stopping. */
+            if (_queue.empty()) {
+                return;
+            }
+
+            work = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        work();
+    }
+}
+
+std::size_t ThreadPool::
+DefaultSize()
+{
+    unsigned int concurrency = std::thread::hardware_concurrency();
+    return (concurrency == 0 ? 1 : concurrency);
+}
@@ -8,9 +8,11 @@
 
 #include <gtest/gtest.h>
 #include <libutil/MemoryFilesystem.h>
+#include <libutil/MappedFile.h>
 
 using libutil::MemoryFilesystem;
 using libutil::Filesystem;
+using libutil::MappedFile;
 
 static std::vector<uint8_t>
 Contents(std::string const &string)
@@ -60,6 +62,30 @@ TEST(MemoryFilesystem, Type)
     EXPECT_EQ(filesystem.type(filesystem.path("invalid1/invalid2")), ext::nullopt);
 }
 
+TEST(MemoryFilesystem, ModificationTime)
+{
+    auto filesystem = BasicFilesystem();
+    EXPECT_EQ(filesystem.modificationTime(filesystem.path("invalid")), ext::nullopt);
+
+    ext::optional<uint64_t> file1 = filesystem.modificationTime(filesystem.path("file1"));
+    ext::optional<uint64_t> dir1 = filesystem.modificationTime(filesystem.path("dir1"));
+    ext::optional<uint64_t> dir2 = filesystem.modificationTime(filesystem.path("dir2"));
+    ASSERT_NE(file1, ext::nullopt);
+    ASSERT_NE(dir1, ext::nullopt);
+    ASSERT_NE(dir2, ext::nullopt);
+
+    /* Rewriting a file modifies only the file. */
+    EXPECT_TRUE(filesystem.write(Contents("new"), filesystem.path("file1")));
+    EXPECT_NE(filesystem.modificationTime(filesystem.path("file1")), file1);
+    EXPECT_EQ(filesystem.modificationTime(filesystem.path("dir1")), dir1);
+
+    /* Adding or removing an entry modifies its directory. */
+    EXPECT_TRUE(filesystem.write(Contents("new"), filesystem.path("dir1/new")));
+    EXPECT_NE(filesystem.modificationTime(filesystem.path("dir1")), dir1);
+    EXPECT_TRUE(filesystem.removeDirectory(filesystem.path("dir2/dir3"), false));
+    EXPECT_NE(filesystem.modificationTime(filesystem.path("dir2")), dir2);
+}
+
 TEST(MemoryFilesystem, IsReadable)
 {
     auto filesystem = BasicFilesystem();
@@ -163,6 +189,19 @@ TEST(MemoryFilesystem, Read)
     EXPECT_EQ(contents, Contents(""));
 }
 
+TEST(MemoryFilesystem, Map)
+{
+    auto filesystem = BasicFilesystem();
+
+    std::unique_ptr<MappedFile> mapped = filesystem.map(filesystem.path("dir1/file2"));
+    ASSERT_NE(mapped, nullptr);
+    EXPECT_EQ(std::vector<uint8_t>(mapped->data(), mapped->data() + mapped->size()), Contents("two1"));
+
+    /* Can't map directories or nonexistent files. */
+    EXPECT_EQ(filesystem.map(filesystem.path("dir1")), nullptr);
+    EXPECT_EQ(filesystem.map(filesystem.path("invalid")), nullptr);
+}
+
 TEST(MemoryFilesystem, Write)
 {
     auto filesystem = BasicFilesystem();
@@ -195,6 +234,29 @@ TEST(MemoryFilesystem, Write)
     EXPECT_FALSE(filesystem.exists(filesystem.path("invalid/new")));
 }
 
+TEST(MemoryFilesystem, WriteParts)
+{
+    auto filesystem = BasicFilesystem();
+    std::vector<uint8_t> contents;
+
+    /* Parts are written in order. */
+    EXPECT_TRUE(filesystem.write([](Filesystem::Output const &output) {
+        std::vector<uint8_t> first = Contents("pa"), second = Contents("rts");
+        return output(first.data(), first.size()) && output(second.data(), second.size());
+    }, filesystem.path("new")));
+    EXPECT_TRUE(filesystem.read(&contents, filesystem.path("new")));
+    EXPECT_EQ(contents, Contents("parts"));
+
+    /* Nothing is written if the producer fails. */
+    EXPECT_FALSE(filesystem.write([](Filesystem::Output const &output) {
+        std::vector<uint8_t> first = Contents("partial");
+        return output(first.data(), first.size()) && false;
+    }, filesystem.path("file1")));
+    contents.clear();
+    EXPECT_TRUE(filesystem.read(&contents, filesystem.path("file1")));
+    EXPECT_EQ(contents, Contents("one"));
+}
+
 TEST(MemoryFilesystem, CopyFile)
 {
     std::vector<uint8_t> contents;
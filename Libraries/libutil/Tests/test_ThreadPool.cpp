@@ -0,0 +1,75 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <libutil/ThreadPool.h>
+
+#include <atomic>
+
+using libutil::ThreadPool;
+
+TEST(ThreadPool, Size)
+{
+    EXPECT_EQ(1, ThreadPool(0).size());
+    EXPECT_EQ(4, ThreadPool(4).size());
+    EXPECT_LE(1, ThreadPool::DefaultSize());
+}
+
+TEST(ThreadPool, RunsAllWork)
+{
+    std::atomic<int> count(0);
+
+    {
+        ThreadPool pool(4);
+        for (int i = 0; i < 100; i++) {
+            pool.submit([&count] { count++; });
+        }
+    }
+
+    /* Destroying the pool waits for queued work. */
+    EXPECT_EQ(100, count);
+}
+
+TEST(ThreadPool, LimitsConcurrency)
+{
+    std::atomic<int> running(0);
+    std::atomic<int> maximum(0);
+
+    {
+        ThreadPool pool(2);
+        for (int i = 0; i < 20; i++) {
+            pool.submit([&running, &maximum] {
+                int current = ++running;
+                int previous = maximum;
+                while (current > previous && !maximum.compare_exchange_weak(previous, current)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                running--;
+            });
+        }
+    }
+
+    EXPECT_LE(maximum, 2);
+}
+
+TEST(ThreadPool, Apply)
+{
+    ThreadPool pool(4);
+
+    std::vector<std::size_t> results = std::vector<std::size_t>(100, 0);
+    pool.apply(results.size(), [&results](std::size_t i) {
+        results[i] = i * i;
+    });
+
+    for (std::size_t i = 0; i < results.size(); i++) {
+        EXPECT_EQ(i * i, results[i]);
+    }
+
+    /* Nothing to do returns immediately. */
+    pool.apply(0, [](std::size_t i) { FAIL(); });
+}
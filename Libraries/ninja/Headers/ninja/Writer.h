@@ -50,6 +50,11 @@ public:
      */
     void comment(std::string const &text);
 
+    /*
+     * Write out previously serialized Ninja text unchanged.
+     */
+    void append(std::string const &serialized);
+
 public:
     /*
      * Write a subninja directive to load a scoped Ninja file.
@@ -60,6 +60,12 @@ comment(std::string const &text)
     _buffer << "#" << " " << text << std::endl;
 }
 
+void Writer::
+append(std::string const &serialized)
+{
+    _buffer << serialized;
+}
+
 void Writer::
 subninja(Value const &path)
 {
@@ -38,6 +38,18 @@ TEST(Writer, Comment)
     EXPECT_EQ(writer.serialize(), "# comment\n# comment 2\n");
 }
 
+TEST(Writer, Append)
+{
+    Writer other;
+    other.comment("other");
+    other.build({ Value::String("output") }, "phony", { });
+
+    Writer writer;
+    writer.comment("comment");
+    writer.append(other.serialize());
+    EXPECT_EQ(writer.serialize(), "# comment\n" + other.serialize());
+}
+
 TEST(Writer, Binding)
 {
     Writer writer;
@@ -0,0 +1,337 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <ninja/Writer.h>
+#include <ninja/Value.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Compares loading the two manifest layouts xcbuild's Ninja executor writes
+ * for a synthetic workspace. Each target has compile, link, and copy edges
+ * shaped like the executor's, chained with begin and finish phony targets:
+ *
+ *  - per-target: a generic rule with the full command bound on every edge,
+ *    and one build.ninja per target loaded through subninja.
+ *  - single: every edge in the top-level manifest, with a rule per tool so
+ *    edges only bind their arguments (-ninja-single-manifest).
+ *
+ * Both layouts are loaded by a scanner that reads every manifest, following
+ * subninja, and splits each line into tokens, about what Ninja's lexer does.
+ * If a Ninja binary is passed, it also times `ninja -t targets all`, which
+ * loads the whole manifest without building or checking outputs.
+ */
+
+struct Manifest {
+    size_t files;
+    size_t bytes;
+};
+
+static std::string
+ToolPath(size_t tool)
+{
+    static char const *const tools[] = {
+        "/Applications/Xcode.app/Contents/Developer/Toolchains/XcodeDefault.xctoolchain/usr/bin/clang",
+        "/Applications/Xcode.app/Contents/Developer/Toolchains/XcodeDefault.xctoolchain/usr/bin/ld",
+        "/usr/local/bin/builtin-copy",
+    };
+    return tools[tool];
+}
+
+static std::string
+ToolRuleName(size_t tool)
+{
+    static char const *const names[] = { "invoke-clang", "invoke-ld", "invoke-builtin-copy" };
+    return names[tool];
+}
+
+static std::string
+Description(size_t tool)
+{
+    static char const *const descriptions[] = { "CompileC", "Ld", "CpResource" };
+    return descriptions[tool];
+}
+
+static std::string
+Arguments(size_t tool, std::string const &input, std::string const &output)
+{
+    std::string arguments;
+    if (tool == 0) {
+        arguments += " -x objective-c -arch arm64 -fmessage-length=0 -fdiagnostics-show-note-include-stack -fmodules -gmodules";
+        arguments += " -fmodules-cache-path=/Users/user/Library/Developer/Xcode/DerivedData/ModuleCache -fmodules-prune-interval=86400";
+        arguments += " -Wnon-modular-include-in-framework-module -Werror=non-modular-include-in-framework-module -Wno-trigraphs";
+        arguments += " -fpascal-strings -O0 -fno-common -Wno-missing-field-initializers -Wno-missing-prototypes -DDEBUG=1";
+        arguments += " -isysroot /Applications/Xcode.app/Contents/Developer/Platforms/iPhoneOS.platform/Developer/SDKs/iPhoneOS.sdk";
+        arguments += " -MMD -MT dependencies -MF " + output + ".d --serialize-diagnostics " + output + ".dia";
+        arguments += " -c " + input + " -o " + output;
+    } else if (tool == 1) {
+        arguments += " -arch arm64 -isysroot /Applications/Xcode.app/Contents/Developer/Platforms/iPhoneOS.platform/Developer/SDKs/iPhoneOS.sdk";
+        arguments += " -filelist " + input + " -Xlinker -rpath -Xlinker @executable_path/Frameworks -dead_strip -fobjc-arc -fobjc-link-runtime";
+        arguments += " -o " + output;
+    } else {
+        arguments += " -exclude .DS_Store -exclude CVS -exclude .svn -exclude .git -strip-debug-symbols -resolve-src-symlinks";
+        arguments += " " + input + " " + output;
+    }
+    return arguments;
+}
+
+static void
+WriteEdge(ninja::Writer *writer, bool single, size_t tool, std::string const &input, std::string const &output, std::string const &after)
+{
+    std::string arguments = Arguments(tool, input, output);
+
+    std::vector<ninja::Binding> bindings = {
+        { "description", ninja::Value::String(Description(tool) + " " + output) },
+        { "dir", ninja::Value::String("/Users/user/Projects/Workspace") },
+    };
+    if (single) {
+        bindings.push_back({ "args", ninja::Value::String(arguments) });
+    } else {
+        bindings.push_back({ "exec", ninja::Value::String(ToolPath(tool) + arguments) });
+    }
+    bindings.push_back({ "depexec", ninja::Value::String("true") });
+
+    writer->build({ ninja::Value::String(output) }, single ? ToolRuleName(tool) : "invoke", { ninja::Value::String(input) }, bindings, { }, { ninja::Value::String(after) });
+}
+
+static void
+WriteTarget(ninja::Writer *writer, bool single, size_t target, size_t invocations)
+{
+    std::string name = "Target" + std::to_string(target);
+    std::string build = "/Users/user/Library/Developer/Xcode/DerivedData/Build/Intermediates/" + name + ".build";
+    std::string begin = "begin-target-" + name;
+
+    std::vector<ninja::Value> objects;
+    for (size_t n = 0; n < invocations; n++) {
+        std::string object = build + "/Objects-normal/arm64/File" + std::to_string(n) + ".o";
+        if (n % 10 == 9) {
+            WriteEdge(writer, single, 2, "/Users/user/Projects/Workspace/" + name + "/Resource" + std::to_string(n) + ".png", build + "/Resource" + std::to_string(n) + ".png", begin);
+        } else {
+            WriteEdge(writer, single, 0, "/Users/user/Projects/Workspace/" + name + "/File" + std::to_string(n) + ".m", object, begin);
+            objects.push_back(ninja::Value::String(object));
+        }
+    }
+
+    std::string product = build + "/" + name;
+    WriteEdge(writer, single, 1, build + "/Objects-normal/arm64/" + name + ".LinkFileList", product, begin);
+    writer->build({ ninja::Value::String("finish-target-" + name) }, "phony", { ninja::Value::String(product) }, { }, objects);
+}
+
+static bool
+WriteFile(std::string const &path, std::string const &contents)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (fp == NULL) {
+        return false;
+    }
+
+    bool success = (fwrite(contents.data(), 1, contents.size(), fp) == contents.size());
+    return (fclose(fp) == 0 && success);
+}
+
+static bool
+WriteManifest(std::string const &directory, bool single, size_t targets, size_t invocations, Manifest *manifest)
+{
+    *manifest = { 1, 0 };
+
+    ninja::Writer writer;
+    writer.binding({ "ninja_required_version", ninja::Value::String("1.5") });
+    writer.rule("invoke", ninja::Value::Expression("cd $dir && env $env $exec && $depexec"));
+    if (single) {
+        for (size_t tool = 0; tool < 3; tool++) {
+            writer.rule(ToolRuleName(tool), ninja::Value::Expression("cd $dir && env $env ") + ninja::Value::String(ToolPath(tool)) + ninja::Value::Expression("$args && $depexec"));
+        }
+    }
+
+    for (size_t target = 0; target < targets; target++) {
+        std::string name = "Target" + std::to_string(target);
+
+        /* Each target depends on the one before it, like a chain of libraries. */
+        std::vector<ninja::Value> dependencies;
+        if (target > 0) {
+            dependencies.push_back(ninja::Value::String("finish-target-Target" + std::to_string(target - 1)));
+        }
+
+        writer.newline();
+        writer.comment("Target: " + name);
+        writer.build({ ninja::Value::String("begin-target-" + name) }, "phony", dependencies);
+
+        if (single) {
+            WriteTarget(&writer, true, target, invocations);
+        } else {
+            std::string targetDirectory = directory + "/" + name;
+            if (mkdir(targetDirectory.c_str(), 0755) != 0) {
+                return false;
+            }
+
+            ninja::Writer targetWriter;
+            WriteTarget(&targetWriter, false, target, invocations);
+
+            std::string contents = targetWriter.serialize();
+            if (!WriteFile(targetDirectory + "/build.ninja", contents)) {
+                return false;
+            }
+
+            manifest->files++;
+            manifest->bytes += contents.size();
+            writer.subninja(ninja::Value::String(targetDirectory + "/build.ninja"));
+        }
+    }
+
+    std::string contents = writer.serialize();
+    manifest->bytes += contents.size();
+    return WriteFile(directory + "/build.ninja", contents);
+}
+
+/*
+ * Reads a manifest and anything it loads, returning the number of tokens. The
+ * buffer is reused between files, so both layouts pay for memory only once.
+ */
+static size_t
+Scan(std::string const &root, std::vector<char> *contents)
+{
+    static char const subninja[] = "subninja ";
+
+    size_t tokens = 0;
+    std::vector<std::string> paths = { root };
+    while (!paths.empty()) {
+        std::string path = paths.back();
+        paths.pop_back();
+
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (fp == NULL) {
+            continue;
+        }
+
+        struct stat st;
+        if (fstat(fileno(fp), &st) != 0) {
+            fclose(fp);
+            continue;
+        }
+
+        contents->resize(static_cast<size_t>(st.st_size));
+        contents->resize(fread(contents->data(), 1, contents->size(), fp));
+        fclose(fp);
+
+        char const *p = contents->data();
+        char const *end = p + contents->size();
+        while (p < end) {
+            char const *eol = static_cast<char const *>(memchr(p, '\n', end - p));
+            if (eol == NULL) {
+                eol = end;
+            }
+
+            if (static_cast<size_t>(eol - p) > sizeof(subninja) - 1 && strncmp(p, subninja, sizeof(subninja) - 1) == 0) {
+                paths.push_back(std::string(p + sizeof(subninja) - 1, eol));
+            }
+
+            bool space = true;
+            for (char const *c = p; c < eol; c++) {
+                bool separator = (*c == ' ' || *c == '$');
+                if (space && !separator) {
+                    tokens++;
+                }
+                space = separator;
+            }
+
+            p = eol + 1;
+        }
+    }
+
+    return tokens;
+}
+
+static void
+Report(char const *name, size_t iterations, double milliseconds)
+{
+    if (iterations == 0) {
+        return;
+    }
+
+    fprintf(stdout, "%s: %.3f ms per load\n", name, milliseconds / iterations);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t targets = 300;
+    if (argc > 1) {
+        targets = static_cast<size_t>(std::strtoul(argv[1], NULL, 10));
+    }
+
+    size_t invocations = 100;
+    if (argc > 2) {
+        invocations = static_cast<size_t>(std::strtoul(argv[2], NULL, 10));
+    }
+
+    size_t iterations = 10;
+    if (argc > 3) {
+        iterations = static_cast<size_t>(std::strtoul(argv[3], NULL, 10));
+    }
+
+    char const *ninja = (argc > 4 ? argv[4] : NULL);
+
+    char temporary[] = "/tmp/benchmark_manifest.XXXXXX";
+    if (mkdtemp(temporary) == NULL) {
+        fprintf(stderr, "error: unable to create temporary directory\n");
+        return 1;
+    }
+
+    for (bool single : { false, true }) {
+        char const *name = (single ? "single" : "per-target");
+
+        std::string directory = std::string(temporary) + "/" + name;
+        if (mkdir(directory.c_str(), 0755) != 0) {
+            fprintf(stderr, "error: unable to create %s\n", directory.c_str());
+            return 1;
+        }
+
+        Manifest manifest;
+        if (!WriteManifest(directory, single, targets, invocations, &manifest)) {
+            fprintf(stderr, "error: unable to write %s manifest\n", name);
+            return 1;
+        }
+        fprintf(stdout, "%s: %zu targets, %zu files, %.1f MB\n", name, targets, manifest.files, static_cast<double>(manifest.bytes) / (1024 * 1024));
+
+        std::string path = directory + "/build.ninja";
+        std::vector<char> contents;
+        size_t tokens = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            tokens += Scan(path, &contents);
+        }
+        auto end = std::chrono::steady_clock::now();
+        fprintf(stdout, "%s: %zu tokens\n", name, iterations > 0 ? tokens / iterations : 0);
+        Report((std::string(name) + " (scan)").c_str(), iterations, std::chrono::duration<double, std::milli>(end - start).count());
+
+        if (ninja != NULL) {
+            std::string command = std::string(ninja) + " -C " + directory + " -t targets all > /dev/null";
+
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                if (std::system(command.c_str()) != 0) {
+                    fprintf(stderr, "error: %s failed\n", command.c_str());
+                    return 1;
+                }
+            }
+            end = std::chrono::steady_clock::now();
+            Report((std::string(name) + " (ninja)").c_str(), iterations, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+
+    fprintf(stdout, "manifests: %s\n", temporary);
+    return 0;
+}
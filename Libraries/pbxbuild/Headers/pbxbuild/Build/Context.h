@@ -15,6 +15,7 @@
 #include <pbxbuild/Target/Environment.h>
 
 #include <ext/optional>
+#include <mutex>
 
 namespace pbxbuild {
 namespace Build {
@@ -36,6 +37,7 @@ private:
 
 private:
     std::shared_ptr<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>> _targetEnvironments;
+    std::shared_ptr<std::mutex>                                                                _targetEnvironmentsMutex;
 
 public:
     Context(
@@ -69,13 +69,15 @@ public:
 public:
     /*
      * Creates a build environment from the default configuration
-     * of each of the build environment's subcomponents.
+     * of each of the build environment's subcomponents. If the
+     * XCBUILD_SPECIFICATION_CACHE_PATH environment variable is set,
+     * the registered specifications are cached at that path.
      */
     static ext::optional<Environment>
     Default(
         process::User const *user,
         process::Context const *processContext,
-        libutil::Filesystem const *filesystem);
+        libutil::Filesystem *filesystem);
 };
 
 }
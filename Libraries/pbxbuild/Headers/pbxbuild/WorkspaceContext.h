@@ -15,6 +15,7 @@
 
 namespace pbxsetting { class Environment; }
 namespace libutil { class Filesystem; }
+namespace pbxproj { class ProjectCache; }
 
 namespace pbxbuild {
 
@@ -118,16 +119,19 @@ public:
 
 public:
     /*
-     * Creates a workspace context from a real workspace.
+     * Creates a workspace context from a real workspace. The projects in the
+     * workspace, and the projects nested in those, are loaded concurrently,
+     * through the project cache if one is provided.
      */
     static WorkspaceContext
-    Workspace(libutil::Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace);
+    Workspace(libutil::Filesystem const *filesystem, pbxproj::ProjectCache *projectCache, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace);
 
     /*
-     * Creates a workspace context for a legacy project-only build.
+     * Creates a workspace context for a legacy project-only build. Nested
+     * projects are loaded through the project cache if one is provided.
      */
     static WorkspaceContext
-    Project(libutil::Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project);
+    Project(libutil::Filesystem const *filesystem, pbxproj::ProjectCache *projectCache, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project);
 };
 
 }
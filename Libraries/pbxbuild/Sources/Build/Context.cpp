@@ -22,30 +22,41 @@ Context(
     bool defaultConfiguration,
     std::vector<pbxsetting::Level> const &overrideLevels
 ) :
-    _workspaceContext    (workspaceContext),
-    _scheme              (scheme),
-    _schemeGroup         (schemeGroup),
-    _action              (action),
-    _configuration       (configuration),
-    _defaultConfiguration(defaultConfiguration),
-    _overrideLevels      (overrideLevels),
-    _targetEnvironments  (std::make_shared<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>>())
+    _workspaceContext       (workspaceContext),
+    _scheme                 (scheme),
+    _schemeGroup            (schemeGroup),
+    _action                 (action),
+    _configuration          (configuration),
+    _defaultConfiguration   (defaultConfiguration),
+    _overrideLevels         (overrideLevels),
+    _targetEnvironments     (std::make_shared<std::unordered_map<pbxproj::PBX::Target::shared_ptr, Target::Environment>>()),
+    _targetEnvironmentsMutex(std::make_shared<std::mutex>())
 {
 }
 
 ext::optional<pbxbuild::Target::Environment> Build::Context::
 targetEnvironment(Build::Environment const &buildEnvironment, pbxproj::PBX::Target::shared_ptr const &target) const
 {
-    auto TEI = _targetEnvironments->find(target);
-    if (TEI != _targetEnvironments->end()) {
-        return TEI->second;
-    } else {
-        ext::optional<Target::Environment> targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
-        if (targetEnvironment) {
-            _targetEnvironments->insert(std::make_pair(target, *targetEnvironment));
+    {
+        std::lock_guard<std::mutex> lock(*_targetEnvironmentsMutex);
+
+        auto TEI = _targetEnvironments->find(target);
+        if (TEI != _targetEnvironments->end()) {
+            return TEI->second;
         }
-        return targetEnvironment;
     }
+
+    /*
+     * Create the environment without holding the lock, so other targets' environments
+     * can be created at the same time. If another thread created this target's first,
+     * use that one so all callers share the same environment.
+     */
+    ext::optional<Target::Environment> targetEnvironment = Target::Environment::Create(buildEnvironment, *this, target);
+    if (targetEnvironment) {
+        std::lock_guard<std::mutex> lock(*_targetEnvironmentsMutex);
+        return _targetEnvironments->insert(std::make_pair(target, *targetEnvironment)).first->second;
+    }
+    return targetEnvironment;
 }
 
 pbxproj::PBX::Target::shared_ptr Build::Context::
@@ -7,6 +7,7 @@
  */
 
 #include <pbxbuild/Build/Environment.h>
+#include <pbxspec/Cache.h>
 #include <xcsdk/Configuration.h>
 #include <xcsdk/Environment.h>
 #include <pbxsetting/DefaultSettings.h>
@@ -31,8 +32,37 @@ Environment(
 {
 }
 
+static ext::optional<std::string>
+SpecificationCachePath(process::Context const *processContext)
+{
+    /*
+     * Only used if requested, like the SDK snapshot. The cache is checked
+     * against every directory and file the specifications were found in.
+     */
+    if (ext::optional<std::string> path = processContext->environmentVariable("XCBUILD_SPECIFICATION_CACHE_PATH")) {
+        if (!path->empty()) {
+            return path;
+        }
+    }
+
+    return ext::nullopt;
+}
+
+static ext::optional<std::string>
+SDKSnapshotPath(process::Context const *processContext)
+{
+    /* Only used if requested, so nothing is written anywhere by default. */
+    if (ext::optional<std::string> path = processContext->environmentVariable("XCBUILD_SDK_SNAPSHOT_PATH")) {
+        if (!path->empty()) {
+            return path;
+        }
+    }
+
+    return ext::nullopt;
+}
+
 ext::optional<Build::Environment> Build::Environment::
-Default(process::User const *user, process::Context const *processContext, Filesystem const *filesystem)
+Default(process::User const *user, process::Context const *processContext, Filesystem *filesystem)
 {
     ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(user, processContext, filesystem);
     if (!developerRoot) {
@@ -57,31 +87,50 @@ Default(process::User const *user, process::Context const *processContext, Files
         }
     }
 
-    /*
-     * Register global specifications.
-     */
-    specManager->registerDomains(filesystem, pbxspec::Manager::DefaultDomains(*developerRoot));
-
     auto configuration = xcsdk::Configuration::Load(filesystem, xcsdk::Configuration::DefaultPaths(user, processContext));
-    auto sdkManager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration);
+    ext::optional<std::string> sdkSnapshotPath = SDKSnapshotPath(processContext);
+    auto sdkManager = (sdkSnapshotPath ?
+        xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration, *sdkSnapshotPath) :
+        xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration));
     if (sdkManager == nullptr) {
         fprintf(stderr, "error: couldn't create SDK manager\n");
         return ext::nullopt;
     }
 
-    /*
-     * Register platform-specific specifications.
-     */
     std::unordered_map<std::string, std::string> platforms;
     for (xcsdk::SDK::Platform::shared_ptr const &platform : sdkManager->platforms()) {
         platforms.insert({ platform->name(), platform->path() });
     }
-    specManager->registerDomains(filesystem, pbxspec::Manager::PlatformDomains(platforms));
 
     /*
-     * Register global specifications, but depend on platform-specific specifications.
+     * Global specifications, then platform-specific specifications, then global
+     * specifications that depend on platform-specific specifications.
      */
-    specManager->registerDomains(filesystem, pbxspec::Manager::PlatformDependentDomains(*developerRoot));
+    std::vector<std::vector<std::pair<std::string, std::string>>> specDomains = {
+        pbxspec::Manager::DefaultDomains(*developerRoot),
+        pbxspec::Manager::PlatformDomains(platforms),
+        pbxspec::Manager::PlatformDependentDomains(*developerRoot),
+    };
+
+    /*
+     * Register the specifications from the last build if none of their domains
+     * changed. Otherwise, search the domains and cache what was found.
+     */
+    ext::optional<std::string> specCachePath = SpecificationCachePath(processContext);
+    std::string specCacheKey = pbxspec::Cache::Key(specDomains);
+    ext::optional<pbxspec::Cache> specCache = (specCachePath ? pbxspec::Cache::Load(filesystem, *specCachePath, specCacheKey) : ext::nullopt);
+    if (specCache) {
+        specManager->registerCache(std::make_shared<pbxspec::Cache const>(std::move(*specCache)));
+    } else {
+        pbxspec::Cache createdCache = pbxspec::Cache(specCacheKey);
+        for (std::vector<std::pair<std::string, std::string>> const &domains : specDomains) {
+            specManager->registerDomains(filesystem, domains, specCachePath ? &createdCache : nullptr);
+        }
+
+        if (specCachePath && !createdCache.write(filesystem, *specCachePath)) {
+            fprintf(stderr, "warning: couldn't write specification cache\n");
+        }
+    }
 
     pbxspec::PBX::BuildSystem::shared_ptr buildSystem = specManager->buildSystem("com.apple.build-system.core", { "default" });
     if (buildSystem == nullptr) {
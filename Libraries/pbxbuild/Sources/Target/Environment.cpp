@@ -485,6 +485,12 @@ Create(Build::Environment const &buildEnvironment, Build::Context const &buildCo
     auto buildRules = Target::BuildRules::Create(buildEnvironment.specManager(), specDomains, target);
     auto buildFileDisambiguation = BuildFileDisambiguation(target);
 
+    /*
+     * The target's settings are complete. Resolvers query them many times
+     * while creating invocations, so remember what has been resolved.
+     */
+    environment.enableCache();
+
     return Environment(
         sdk,
         toolchains,
@@ -10,11 +10,15 @@
 #include <pbxsetting/Environment.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/ThreadPool.h>
+
+#include <unordered_set>
 
 using pbxbuild::WorkspaceContext;
 using pbxbuild::DerivedDataHash;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::ThreadPool;
 
 WorkspaceContext::
 WorkspaceContext(
@@ -135,19 +139,73 @@ IterateWorkspaceFiles(xcworkspace::XC::Workspace::shared_ptr const &workspace, s
 }
 
 static void
-LoadWorkspaceProjects(Filesystem const *filesystem, std::vector<pbxproj::PBX::Project::shared_ptr> *projects, xcworkspace::XC::Workspace::shared_ptr const &workspace)
+OpenProjects(
+    Filesystem const *filesystem,
+    pbxproj::ProjectCache *projectCache,
+    ThreadPool *pool,
+    std::unordered_set<std::string> *loaded,
+    std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
+    std::vector<std::string> const &projectPaths)
 {
     /*
-     * Load all the projects in the workspace.
+     * Skip projects that are already loaded or listed more than once.
      */
-    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
-        std::string path = ref->resolve(workspace);
+    std::vector<std::string> paths;
+    for (std::string const &path : projectPaths) {
+        if (loaded->insert(FSUtil::NormalizePath(path)).second) {
+            paths.push_back(path);
+        }
+    }
+
+    /*
+     * Open each project on its own worker. Projects only refer to other projects
+     * by path, so they can be parsed independently of each other.
+     */
+    std::vector<pbxproj::PBX::Project::shared_ptr> opened(paths.size());
+    pool->apply(paths.size(), [&](size_t n) {
+        opened[n] = pbxproj::PBX::Project::Open(filesystem, paths[n], projectCache);
+    });
 
-        pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, path);
-        if (project != nullptr) {
+    /*
+     * Merge in the original order. Links between projects, such as container item
+     * proxies, are resolved later through the map of all projects by path.
+     */
+    for (size_t n = 0; n < opened.size(); n++) {
+        pbxproj::PBX::Project::shared_ptr const &project = opened[n];
+        if (project == nullptr) {
+            continue;
+        }
+
+        /* The same project can be reached through different paths. */
+        std::string projectFile = FSUtil::NormalizePath(project->projectFile());
+        if (projectFile == FSUtil::NormalizePath(paths[n]) || loaded->insert(projectFile).second) {
             projects->push_back(project);
         }
+    }
+}
+
+static void
+LoadWorkspaceProjects(
+    Filesystem const *filesystem,
+    pbxproj::ProjectCache *projectCache,
+    ThreadPool *pool,
+    std::unordered_set<std::string> *loaded,
+    std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
+    xcworkspace::XC::Workspace::shared_ptr const &workspace)
+{
+    std::vector<std::string> paths;
+
+    /*
+     * Find all the projects in the workspace.
+     */
+    IterateWorkspaceFiles(workspace, [&](xcworkspace::XC::FileRef::shared_ptr const &ref) {
+        paths.push_back(ref->resolve(workspace));
     });
+
+    /*
+     * Load all the projects in the workspace.
+     */
+    OpenProjects(filesystem, projectCache, pool, loaded, projects, paths);
 }
 
 static void
@@ -179,12 +237,15 @@ LoadConfigurationFiles(
 static void
 LoadNestedProjects(
     Filesystem const *filesystem,
+    pbxproj::ProjectCache *projectCache,
+    ThreadPool *pool,
+    std::unordered_set<std::string> *loaded,
     std::vector<pbxproj::PBX::Project::shared_ptr> *projects,
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> *configs,
     pbxsetting::Environment const &baseEnvironment,
     std::vector<pbxproj::PBX::Project::shared_ptr> const &rootProjects)
 {
-    std::vector<pbxproj::PBX::Project::shared_ptr> nestedProjects;
+    std::vector<std::string> nestedProjectPaths;
 
     /*
      * Load all nested projects recursively.
@@ -211,18 +272,16 @@ LoadNestedProjects(
          */
         for (pbxproj::PBX::Project::ProjectReference const &projectReference : project->projectReferences()) {
             pbxproj::PBX::FileReference::shared_ptr const &projectFileReference = projectReference.projectReference();
-            std::string projectPath = environment.expand(projectFileReference->resolve());
-
-            /*
-             * Load the project.
-             */
-            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, projectPath);
-            if (project != nullptr) {
-                nestedProjects.push_back(project);
-            }
+            nestedProjectPaths.push_back(environment.expand(projectFileReference->resolve()));
         }
     }
 
+    /*
+     * Load the nested projects together.
+     */
+    std::vector<pbxproj::PBX::Project::shared_ptr> nestedProjects;
+    OpenProjects(filesystem, projectCache, pool, loaded, &nestedProjects, nestedProjectPaths);
+
     /*
      * Append the nested projects. This has to be after the loop as `rootProjects` might alias `projects`.
      */
@@ -232,7 +291,7 @@ LoadNestedProjects(
         /*
          * Load nested projects of the nested projects.
          */
-        LoadNestedProjects(filesystem, projects, configs, baseEnvironment, nestedProjects);
+        LoadNestedProjects(filesystem, projectCache, pool, loaded, projects, configs, baseEnvironment, nestedProjects);
     }
 }
 
@@ -265,11 +324,13 @@ CreateProjectMap(std::vector<pbxproj::PBX::Project::shared_ptr> const &projects)
 }
 
 WorkspaceContext WorkspaceContext::
-Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace)
+Workspace(Filesystem const *filesystem, pbxproj::ProjectCache *projectCache, std::string const &userName, pbxsetting::Environment const &baseEnvironment, xcworkspace::XC::Workspace::shared_ptr const &workspace)
 {
     std::vector<pbxproj::PBX::Project::shared_ptr> projects;
     std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> configs;
+    std::unordered_set<std::string> loaded;
+    ThreadPool pool(ThreadPool::DefaultSize());
 
     /*
      * Add the schemes from the workspace itself.
@@ -282,12 +343,12 @@ Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting:
     /*
      * Load projects within the workspace.
      */
-    LoadWorkspaceProjects(filesystem, &projects, workspace);
+    LoadWorkspaceProjects(filesystem, projectCache, &pool, &loaded, &projects, workspace);
 
     /*
      * Recursively load nested projects within those projects.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    LoadNestedProjects(filesystem, projectCache, &pool, &loaded, &projects, &configs, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including nested projects.
@@ -303,21 +364,24 @@ Workspace(Filesystem const *filesystem, std::string const &userName, pbxsetting:
 }
 
 WorkspaceContext WorkspaceContext::
-Project(Filesystem const *filesystem, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project)
+Project(Filesystem const *filesystem, pbxproj::ProjectCache *projectCache, std::string const &userName, pbxsetting::Environment const &baseEnvironment, pbxproj::PBX::Project::shared_ptr const &project)
 {
     std::vector<pbxproj::PBX::Project::shared_ptr> projects;
     std::vector<xcscheme::SchemeGroup::shared_ptr> schemeGroups;
     std::unordered_map<pbxproj::XC::BuildConfiguration::shared_ptr, pbxsetting::XC::Config> configs;
+    std::unordered_set<std::string> loaded;
+    ThreadPool pool(ThreadPool::DefaultSize());
 
     /*
      * The root is a project, so it should be in the projects list.
      */
     projects.push_back(project);
+    loaded.insert(FSUtil::NormalizePath(project->projectFile()));
 
     /*
      * Recursively load nested projects within the project.
      */
-    LoadNestedProjects(filesystem, &projects, &configs, baseEnvironment, projects);
+    LoadNestedProjects(filesystem, projectCache, &pool, &loaded, &projects, &configs, baseEnvironment, projects);
 
     /*
      * Load schemes for all projects, including the root and nested projects.
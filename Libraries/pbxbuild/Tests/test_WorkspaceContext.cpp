@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxbuild/WorkspaceContext.h>
+#include <pbxsetting/Environment.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxbuild::WorkspaceContext;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static MemoryFilesystem::Entry
+ProjectEntry(std::string const &name)
+{
+    return MemoryFilesystem::Entry::Directory(name + ".xcodeproj", {
+        MemoryFilesystem::Entry::File("project.pbxproj", Contents(
+            "{ archiveVersion = 1; objectVersion = 46; rootObject = ROOT; "
+            "objects = { ROOT = { isa = PBXProject; }; }; }")),
+    });
+}
+
+TEST(WorkspaceContext, Workspace)
+{
+    std::vector<MemoryFilesystem::Entry> entries = {
+        MemoryFilesystem::Entry::Directory("W.xcworkspace", {
+            MemoryFilesystem::Entry::File("contents.xcworkspacedata", Contents(
+                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<Workspace version = \"1.0\">\n"
+                "<FileRef location = \"group:P0.xcodeproj\"></FileRef>\n"
+                "<FileRef location = \"group:Missing.xcodeproj\"></FileRef>\n"
+                "<FileRef location = \"group:P1.xcodeproj\"></FileRef>\n"
+                "<FileRef location = \"group:P0.xcodeproj\"></FileRef>\n"
+                "<FileRef location = \"group:P2.xcodeproj\"></FileRef>\n"
+                "</Workspace>\n")),
+        }),
+    };
+    for (int n = 0; n < 3; n++) {
+        entries.push_back(ProjectEntry("P" + std::to_string(n)));
+    }
+    MemoryFilesystem filesystem = MemoryFilesystem(entries);
+
+    auto workspace = xcworkspace::XC::Workspace::Open(&filesystem, "/W.xcworkspace");
+    ASSERT_NE(nullptr, workspace);
+
+    /* Projects load in workspace order, each only once, skipping missing ones. */
+    WorkspaceContext context = WorkspaceContext::Workspace(&filesystem, nullptr, "user", pbxsetting::Environment(), workspace);
+    std::vector<std::string> paths = context.loadedFilePaths();
+    ASSERT_EQ(4u, paths.size());
+    EXPECT_EQ("/W.xcworkspace/contents.xcworkspacedata", paths[0]);
+
+    for (int n = 0; n < 3; n++) {
+        std::string path = "/P" + std::to_string(n) + ".xcodeproj";
+        auto project = context.project(path);
+        ASSERT_NE(nullptr, project);
+        EXPECT_EQ(path, project->projectFile());
+        EXPECT_EQ("P" + std::to_string(n), project->name());
+    }
+    EXPECT_EQ(nullptr, context.project("/Missing.xcodeproj"));
+}
@@ -70,6 +70,8 @@ public:
 
 protected:
     bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check) override;
+    void snapshot(Snapshot::Writer *writer) const override;
+    void restore(Snapshot::Reader *reader) override;
 };
 
 } }
@@ -10,6 +10,7 @@
 #define __pbxproj_PBX_Object_h
 
 #include <pbxproj/ISA.h>
+#include <pbxproj/Snapshot.h>
 
 #include <memory>
 #include <string>
@@ -55,6 +56,17 @@ private:
 protected:
     virtual bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check);
 
+private:
+    friend class pbxproj::Snapshot;
+
+protected:
+    /*
+     * Records or restores the parsed fields, in the same order. Subclasses
+     * call through to their base class first, as with `parse()`.
+     */
+    virtual void snapshot(Snapshot::Writer *writer) const;
+    virtual void restore(Snapshot::Reader *reader);
+
 public:
     template <typename T>
     inline bool isa() const
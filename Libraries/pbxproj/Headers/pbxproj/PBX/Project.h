@@ -15,6 +15,7 @@
 #include <pbxproj/XC/ConfigurationList.h>
 
 namespace libutil { class Filesystem; }
+namespace pbxproj { class ProjectCache; }
 
 namespace pbxproj { namespace PBX {
 
@@ -70,6 +71,17 @@ public:
 public:
     static shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
 
+    /*
+     * Opens a project through a cache of snapshots. If the cache has a
+     * snapshot of the same project file contents, the project is loaded
+     * from it without parsing the project file; otherwise, the project is
+     * parsed and a snapshot of it is added to the cache.
+     */
+    static shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path, ProjectCache *cache);
+
+private:
+    static shared_ptr Parse(std::vector<uint8_t> const &contents, std::string const &projectFileName);
+
 public:
     inline XC::ConfigurationList::shared_ptr const &buildConfigurationList() const
     { return _buildConfigurationList; }
@@ -127,6 +139,7 @@ public:
 
 protected:
     friend class pbxproj::Context;
+    friend class pbxproj::Snapshot;
     inline void cacheObject(Object::shared_ptr const &object)
     { _blueprints[object->blueprintIdentifier()] = object; }
 
@@ -152,6 +165,8 @@ public:
 
 protected:
     bool parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::string> *seen, bool check) override;
+    void snapshot(Snapshot::Writer *writer) const override;
+    void restore(Snapshot::Reader *reader) override;
 
 public:
     static inline char const *Isa()
@@ -0,0 +1,70 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __pbxproj_ProjectCache_h
+#define __pbxproj_ProjectCache_h
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace libutil { class Filesystem; }
+
+namespace pbxproj {
+
+namespace PBX { class Project; }
+
+/*
+ * A directory of project snapshots, keyed by a hash of the contents of
+ * the project file each was parsed from. See `Snapshot`. Safe to use
+ * from several threads, as long as they open different projects.
+ */
+class ProjectCache {
+private:
+    libutil::Filesystem *_filesystem;
+    std::string          _path;
+
+public:
+    ProjectCache(libutil::Filesystem *filesystem, std::string const &path);
+
+public:
+    /*
+     * The directory containing the snapshots.
+     */
+    std::string const &path() const
+    { return _path; }
+
+public:
+    /*
+     * Loads the project snapshot for a key. Returns null if there is no
+     * snapshot for the key, or if it is not valid.
+     */
+    std::shared_ptr<PBX::Project>
+    load(std::string const &key) const;
+
+    /*
+     * Stores a snapshot of a project for a key, replacing any existing
+     * snapshot for the key.
+     */
+    bool
+    store(std::string const &key, PBX::Project const *project);
+
+public:
+    /*
+     * The key for the contents of a project file.
+     */
+    static std::string
+    Key(std::vector<uint8_t> const &contents);
+
+private:
+    std::string snapshotPath(std::string const &key) const;
+};
+
+}
+
+#endif  // !__pbxproj_ProjectCache_h
@@ -0,0 +1,175 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __pbxproj_Snapshot_h
+#define __pbxproj_Snapshot_h
+
+#include <pbxsetting/Level.h>
+#include <pbxsetting/Value.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pbxproj {
+
+namespace PBX {
+
+class Object;
+class Project;
+
+}
+
+/*
+ * A compact binary form of a parsed project. A snapshot holds the resolved
+ * object graph, so loading one skips reading the property list and looking
+ * up object identifiers. Snapshots are keyed by the contents of the project
+ * file, and are only valid for the version of this library that wrote them.
+ */
+class Snapshot {
+public:
+    /*
+     * Records the fields of objects. Each string is stored once, and objects
+     * are stored by index, in the order they are first referenced.
+     */
+    class Writer {
+    private:
+        std::vector<uint8_t>                              _records;
+        std::unordered_map<std::string, uint64_t>        _strings;
+        std::vector<std::string const *>                  _stringTable;
+        std::unordered_map<PBX::Object const *, uint64_t> _indexes;
+        std::vector<PBX::Object const *>                  _objects;
+
+    public:
+        Writer();
+
+    public:
+        void integer(uint64_t value);
+        void boolean(bool value);
+        void string(std::string const &value);
+        void strings(std::vector<std::string> const &values);
+        void value(pbxsetting::Value const &value);
+        void values(std::vector<pbxsetting::Value> const &values);
+        void level(pbxsetting::Level const &level);
+
+    public:
+        /*
+         * Records a reference to an object, which may be null. The object
+         * is itself recorded if it has not been yet.
+         */
+        void object(PBX::Object const *object);
+
+        template <typename T>
+        void objects(std::vector<std::shared_ptr<T>> const &objects)
+        {
+            integer(objects.size());
+            for (std::shared_ptr<T> const &object : objects) {
+                this->object(object.get());
+            }
+        }
+
+    private:
+        friend class Snapshot;
+        uint64_t index(PBX::Object const *object);
+        std::vector<uint8_t> write(std::string const &key);
+    };
+
+    /*
+     * Reads the fields of objects, in the same order they were written. A
+     * read past the end or of an invalid reference marks the reader as
+     * failed and returns an empty value.
+     */
+    class Reader {
+    private:
+        uint8_t const                            *_data;
+        size_t                                    _size;
+        size_t                                    _offset;
+        bool                                      _failed;
+        std::vector<std::string>                  _strings;
+        std::vector<std::shared_ptr<PBX::Object>> _objects;
+        std::shared_ptr<PBX::Project>             _project;
+
+    public:
+        Reader(uint8_t const *data, size_t size);
+
+    public:
+        bool failed() const
+        { return _failed; }
+
+        /*
+         * The project being read, for objects that refer back to it.
+         */
+        std::shared_ptr<PBX::Project> const &project() const
+        { return _project; }
+
+    public:
+        uint64_t integer();
+        bool boolean();
+        std::string const &string();
+        std::vector<std::string> strings();
+        pbxsetting::Value value();
+        std::vector<pbxsetting::Value> values();
+        pbxsetting::Level level();
+
+    public:
+        /*
+         * Reads a reference to an object, which may be null. The type is
+         * not checked: the snapshot checksum ensures it is what was written.
+         */
+        template <typename T>
+        std::shared_ptr<T> object()
+        {
+            uint64_t index = integer();
+            if (index == 0) {
+                return nullptr;
+            } else if (index > _objects.size()) {
+                _failed = true;
+                return nullptr;
+            }
+
+            return std::static_pointer_cast<T>(_objects[index - 1]);
+        }
+
+        template <typename T>
+        std::vector<std::shared_ptr<T>> objects()
+        {
+            std::vector<std::shared_ptr<T>> objects;
+            uint64_t count = integer();
+            for (uint64_t n = 0; n < count && !_failed; n++) {
+                if (std::shared_ptr<T> object = this->object<T>()) {
+                    objects.push_back(object);
+                }
+            }
+            return objects;
+        }
+
+    private:
+        friend class Snapshot;
+        std::shared_ptr<PBX::Project> read(std::string const &key);
+    };
+
+public:
+    /*
+     * Creates a snapshot of a project. The key identifies the project
+     * file contents the project was parsed from.
+     */
+    static std::vector<uint8_t>
+    Write(PBX::Project const *project, std::string const &key);
+
+    /*
+     * Loads a project from a snapshot. Returns null if the snapshot is
+     * corrupt, or if it was written for a different key or version.
+     */
+    static std::shared_ptr<PBX::Project>
+    Read(std::vector<uint8_t> const &contents, std::string const &key);
+};
+
+}
+
+#endif  // !__pbxproj_Snapshot_h
@@ -12,6 +12,7 @@
 #include <pbxproj/PlistHelpers.h>
 #include <pbxproj/ISA.h>
 #include <plist/Dictionary.h>
+#include <plist/Format/Document.h>
 #include <plist/Object.h>
 #include <plist/String.h>
 #include <plist/Keys/Unpack.h>
@@ -64,7 +65,7 @@ public:
     //
     // Parsing context
     //
-    plist::Dictionary const *objects;
+    plist::Format::Document::Node const *objects;
 
     //
     // The main project
@@ -102,6 +103,7 @@ public:
 public:
     Context()
     {
+        objects = nullptr;
         project = nullptr;
     }
 
@@ -130,6 +132,8 @@ public:
         buildConfigurations.clear();
         configurationLists.clear();
         versionGroups.clear();
+
+        _contents.clear();
     }
 
     //
@@ -143,7 +147,12 @@ private:
         if (id != nullptr) {
             *id = key;
         }
-        return PlistDictionaryGetPBXObject(objects, key, isa);
+
+        plist::Format::Document::Node const *object = PlistDictionaryGetPBXObject(objects, key, isa);
+        if (object == nullptr)
+            return nullptr;
+
+        return dictionary(key, object);
     }
 
 public:
@@ -161,10 +170,7 @@ private:
         if (key == nullptr)
             return nullptr;
 
-        if (id != nullptr) {
-            *id = key->value();
-        }
-        return PlistDictionaryGetPBXObject(objects, key->value(), isa);
+        return get(key->value(), isa, id);
     }
 
 public:
@@ -179,7 +185,11 @@ private:
                                              std::string const &isa,
                                              std::string *id = nullptr) const
     {
-        return PlistDictionaryGetIndirectPBXObject(objects, unpack, key, isa, id);
+        auto ID = unpack->cast <plist::String> (key);
+        if (ID == nullptr)
+            return nullptr;
+
+        return get(ID->value(), isa, id);
     }
 
 public:
@@ -201,8 +211,7 @@ private:
         if (key == nullptr)
             return nullptr;
         else
-            return PlistDictionaryGetIndirectPBXObject(objects, unpack,
-                    key->value(), isa, id);
+            return indirect(unpack, key->value(), isa, id);
     }
 
 public:
@@ -221,14 +230,20 @@ public:
                                            plist::Dictionary const *dict)
     {
         auto I = cache.find(id);
-        if (I != cache.end())
+        if (I != cache.end()) {
+            release(id);
             return I->second;
+        }
 
         auto O = std::make_shared <T> ();
         cacheObject(O, id); // cache inside the project
         cache[id] = O; // cache local to the context
 
-        if (!O->parseObject(*this, dict)) {
+        retain(id);
+        bool parsed = O->parseObject(*this, dict);
+        release(id, true);
+
+        if (!parsed) {
             cache.erase(id);
             return std::shared_ptr <T> ();
         }
@@ -250,6 +265,24 @@ public:
 
 private:
     void cacheObject(std::shared_ptr <PBX::Object> const &O, std::string const &id);
+
+    //
+    // Objects are read from the document as they are parsed, and freed once
+    // parsed; an object being parsed is kept until it is finished, even if
+    // it is looked up again meanwhile.
+    //
+private:
+    struct Contents {
+        std::unique_ptr<plist::Dictionary> dictionary;
+        bool                               parsing;
+    };
+
+    mutable std::unordered_map <std::string, Contents> _contents;
+
+private:
+    plist::Dictionary const *dictionary(std::string const &id, plist::Format::Document::Node const *object) const;
+    void retain(std::string const &id);
+    void release(std::string const &id, bool parsed = false);
 };
 
 }
@@ -9,25 +9,17 @@
 #ifndef __pbxproj_JSHelpers_h
 #define __pbxproj_JSHelpers_h
 
-#include <string>
+#include <plist/Format/Document.h>
 
-namespace plist { class Dictionary; }
-namespace plist { namespace Keys { class Unpack; } }
+#include <string>
 
 namespace pbxproj {
 
-plist::Dictionary const *
-PlistDictionaryGetPBXObject(plist::Dictionary const *dict,
+plist::Format::Document::Node const *
+PlistDictionaryGetPBXObject(plist::Format::Document::Node const *dict,
                             std::string const &key,
                             std::string const &isa);
 
-plist::Dictionary const *
-PlistDictionaryGetIndirectPBXObject(plist::Dictionary const *objects,
-                                    plist::Keys::Unpack *unpack,
-                                    std::string const &key,
-                                    std::string const &isa,
-                                    std::string *id);
-
 }
 
 #endif  // !__pbxproj_JSHelpers_h
@@ -25,3 +25,40 @@ cacheObject(PBX::Object::shared_ptr const &O, std::string const &id)
         project->cacheObject(O);
     }
 }
+
+plist::Dictionary const *Context::
+dictionary(std::string const &id, plist::Format::Document::Node const *object) const
+{
+    auto I = _contents.find(id);
+    if (I != _contents.end()) {
+        return I->second.dictionary.get();
+    }
+
+    std::unique_ptr<plist::Object> contents = object->object();
+    if (plist::CastTo<plist::Dictionary>(contents.get()) == nullptr) {
+        return nullptr;
+    }
+
+    std::unique_ptr<plist::Dictionary> dictionary = std::unique_ptr<plist::Dictionary>(static_cast<plist::Dictionary *>(contents.release()));
+    plist::Dictionary const *result = dictionary.get();
+    _contents.insert({ id, Contents { std::move(dictionary), false } });
+    return result;
+}
+
+void Context::
+retain(std::string const &id)
+{
+    auto I = _contents.find(id);
+    if (I != _contents.end()) {
+        I->second.parsing = true;
+    }
+}
+
+void Context::
+release(std::string const &id, bool parsed)
+{
+    auto I = _contents.find(id);
+    if (I != _contents.end() && (parsed || !I->second.parsing)) {
+        _contents.erase(I);
+    }
+}
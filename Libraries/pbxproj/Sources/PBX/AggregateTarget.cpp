@@ -13,6 +13,7 @@
 
 using pbxproj::PBX::AggregateTarget;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 AggregateTarget::
 AggregateTarget() :
@@ -41,3 +42,19 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void AggregateTarget::
+snapshot(Snapshot::Writer *writer) const
+{
+    Target::snapshot(writer);
+
+    writer->string(_productName);
+}
+
+void AggregateTarget::
+restore(Snapshot::Reader *reader)
+{
+    Target::restore(reader);
+
+    _productName = reader->string();
+}
@@ -14,6 +14,7 @@
 
 using pbxproj::PBX::AppleScriptBuildPhase;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 AppleScriptBuildPhase::
 AppleScriptBuildPhase() :
@@ -47,3 +48,21 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void AppleScriptBuildPhase::
+snapshot(Snapshot::Writer *writer) const
+{
+    BuildPhase::snapshot(writer);
+
+    writer->string(_contextName);
+    writer->boolean(_isSharedContext);
+}
+
+void AppleScriptBuildPhase::
+restore(Snapshot::Reader *reader)
+{
+    BuildPhase::restore(reader);
+
+    _contextName     = reader->string();
+    _isSharedContext = reader->boolean();
+}
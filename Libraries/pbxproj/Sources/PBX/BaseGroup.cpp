@@ -20,6 +20,7 @@
 
 using pbxproj::PBX::BaseGroup;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 BaseGroup::
 BaseGroup(std::string const &isa, GroupItem::Type type) :
@@ -98,3 +99,22 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void BaseGroup::
+snapshot(Snapshot::Writer *writer) const
+{
+    GroupItem::snapshot(writer);
+
+    writer->objects(_children);
+}
+
+void BaseGroup::
+restore(Snapshot::Reader *reader)
+{
+    GroupItem::restore(reader);
+
+    _children = reader->objects<GroupItem>();
+    for (GroupItem::shared_ptr const &child : _children) {
+        child->_parent = this;
+    }
+}
@@ -21,6 +21,7 @@
 
 using pbxproj::PBX::BuildFile;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 BuildFile::
 BuildFile() :
@@ -92,3 +93,23 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void BuildFile::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->object(_fileRef.get());
+    writer->strings(_compilerFlags);
+    writer->strings(_attributes);
+}
+
+void BuildFile::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _fileRef       = reader->object<GroupItem>();
+    _compilerFlags = reader->strings();
+    _attributes    = reader->strings();
+}
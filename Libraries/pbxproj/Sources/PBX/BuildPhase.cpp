@@ -17,6 +17,7 @@
 
 using pbxproj::PBX::BuildPhase;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 BuildPhase::
 BuildPhase(std::string const &isa, Type type) :
@@ -73,3 +74,25 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void BuildPhase::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->string(_name);
+    writer->objects(_files);
+    writer->boolean(_runOnlyForDeploymentPostprocessing);
+    writer->integer(_buildActionMask);
+}
+
+void BuildPhase::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _name                               = reader->string();
+    _files                              = reader->objects<BuildFile>();
+    _runOnlyForDeploymentPostprocessing = reader->boolean();
+    _buildActionMask                    = static_cast<uint32_t>(reader->integer());
+}
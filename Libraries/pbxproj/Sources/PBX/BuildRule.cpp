@@ -15,6 +15,7 @@
 
 using pbxproj::PBX::BuildRule;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 BuildRule::BuildRule() :
     Object(Isa())
@@ -72,3 +73,29 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void BuildRule::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->string(_compilerSpec);
+    writer->string(_filePatterns);
+    writer->string(_fileType);
+    writer->string(_script);
+    writer->strings(_outputFiles);
+    writer->boolean(_isEditable);
+}
+
+void BuildRule::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _compilerSpec = reader->string();
+    _filePatterns = reader->string();
+    _fileType     = reader->string();
+    _script       = reader->string();
+    _outputFiles  = reader->strings();
+    _isEditable   = reader->boolean();
+}
@@ -14,6 +14,7 @@
 
 using pbxproj::PBX::ContainerItemProxy;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 ContainerItemProxy::
 ContainerItemProxy() :
@@ -65,3 +66,25 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void ContainerItemProxy::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->object(_containerPortal.get());
+    writer->integer(_proxyType);
+    writer->string(_remoteGlobalIDString);
+    writer->string(_remoteInfo);
+}
+
+void ContainerItemProxy::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _containerPortal      = reader->object<FileReference>();
+    _proxyType            = static_cast<uint32_t>(reader->integer());
+    _remoteGlobalIDString = reader->string();
+    _remoteInfo           = reader->string();
+}
@@ -14,6 +14,7 @@
 
 using pbxproj::PBX::CopyFilesBuildPhase;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 CopyFilesBuildPhase::
 CopyFilesBuildPhase() :
@@ -49,3 +50,21 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void CopyFilesBuildPhase::
+snapshot(Snapshot::Writer *writer) const
+{
+    BuildPhase::snapshot(writer);
+
+    writer->value(_dstPath);
+    writer->integer(static_cast<uint64_t>(_dstSubfolderSpec));
+}
+
+void CopyFilesBuildPhase::
+restore(Snapshot::Reader *reader)
+{
+    BuildPhase::restore(reader);
+
+    _dstPath          = reader->value();
+    _dstSubfolderSpec = static_cast<Destination>(reader->integer());
+}
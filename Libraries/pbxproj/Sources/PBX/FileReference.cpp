@@ -15,6 +15,7 @@
 
 using pbxproj::PBX::FileReference;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 FileReference::
 FileReference() :
@@ -71,3 +72,29 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void FileReference::
+snapshot(Snapshot::Writer *writer) const
+{
+    GroupItem::snapshot(writer);
+
+    writer->string(_lastKnownFileType);
+    writer->string(_explicitFileType);
+    writer->string(_xcLanguageSpecificationIdentifier);
+    writer->boolean(_includeInIndex);
+    writer->integer(static_cast<uint64_t>(_fileEncoding));
+    writer->integer(static_cast<uint64_t>(_lineEnding));
+}
+
+void FileReference::
+restore(Snapshot::Reader *reader)
+{
+    GroupItem::restore(reader);
+
+    _lastKnownFileType                 = reader->string();
+    _explicitFileType                  = reader->string();
+    _xcLanguageSpecificationIdentifier = reader->string();
+    _includeInIndex                    = reader->boolean();
+    _fileEncoding                      = static_cast<FileEncoding>(reader->integer());
+    _lineEnding                        = static_cast<LineEnding>(reader->integer());
+}
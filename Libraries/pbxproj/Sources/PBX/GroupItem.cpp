@@ -13,6 +13,7 @@
 
 using pbxproj::PBX::GroupItem;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 GroupItem::
 GroupItem(std::string const &isa, Type type) :
@@ -75,3 +76,23 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void GroupItem::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->string(_name);
+    writer->string(_path);
+    writer->string(_sourceTree);
+}
+
+void GroupItem::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _name       = reader->string();
+    _path       = reader->string();
+    _sourceTree = reader->string();
+}
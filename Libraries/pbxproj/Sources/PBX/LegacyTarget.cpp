@@ -15,6 +15,7 @@
 
 using pbxproj::PBX::LegacyTarget;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 LegacyTarget::
 LegacyTarget() :
@@ -59,3 +60,25 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void LegacyTarget::
+snapshot(Snapshot::Writer *writer) const
+{
+    Target::snapshot(writer);
+
+    writer->string(_buildWorkingDirectory);
+    writer->string(_buildToolPath);
+    writer->value(_buildArgumentsString);
+    writer->boolean(_passBuildSettingsInEnvironment);
+}
+
+void LegacyTarget::
+restore(Snapshot::Reader *reader)
+{
+    Target::restore(reader);
+
+    _buildWorkingDirectory          = reader->string();
+    _buildToolPath                  = reader->string();
+    _buildArgumentsString           = reader->value();
+    _passBuildSettingsInEnvironment = reader->boolean();
+}
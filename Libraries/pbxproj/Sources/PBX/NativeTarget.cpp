@@ -15,6 +15,7 @@
 
 using pbxproj::PBX::NativeTarget;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 NativeTarget::
 NativeTarget() :
@@ -74,3 +75,25 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void NativeTarget::
+snapshot(Snapshot::Writer *writer) const
+{
+    Target::snapshot(writer);
+
+    writer->string(_productType);
+    writer->object(_productReference.get());
+    writer->string(_productInstallPath);
+    writer->objects(_buildRules);
+}
+
+void NativeTarget::
+restore(Snapshot::Reader *reader)
+{
+    Target::restore(reader);
+
+    _productType        = reader->string();
+    _productReference   = reader->object<FileReference>();
+    _productInstallPath = reader->string();
+    _buildRules         = reader->objects<BuildRule>();
+}
@@ -13,6 +13,7 @@
 
 using pbxproj::PBX::Object;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 Object::
 Object(std::string const &isa) :
@@ -45,3 +46,14 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
     return true;
 }
 
+void Object::
+snapshot(Snapshot::Writer *writer) const
+{
+    writer->string(_blueprintIdentifier);
+}
+
+void Object::
+restore(Snapshot::Reader *reader)
+{
+    _blueprintIdentifier = reader->string();
+}
@@ -11,11 +11,12 @@
 #include <pbxproj/PBX/LegacyTarget.h>
 #include <pbxproj/PBX/NativeTarget.h>
 #include <pbxproj/Context.h>
+#include <pbxproj/ProjectCache.h>
 #include <plist/Array.h>
 #include <plist/Boolean.h>
 #include <plist/Integer.h>
 #include <plist/String.h>
-#include <plist/Format/Any.h>
+#include <plist/Format/Document.h>
 #include <plist/Keys/Unpack.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
@@ -23,6 +24,8 @@
 
 using pbxproj::PBX::Project;
 using pbxproj::Context;
+using pbxproj::ProjectCache;
+using pbxproj::Snapshot;
 using libutil::Filesystem;
 using libutil::FSUtil;
 
@@ -185,6 +188,12 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
 Project::shared_ptr Project::
 Open(Filesystem const *filesystem, std::string const &path)
+{
+    return Open(filesystem, path, nullptr);
+}
+
+Project::shared_ptr Project::
+Open(Filesystem const *filesystem, std::string const &path, ProjectCache *cache)
 {
     if (path.empty()) {
         fprintf(stderr, "error: project path is empty\n");
@@ -210,29 +219,78 @@ Open(Filesystem const *filesystem, std::string const &path)
     }
 
     //
-    // Parse property list
+    // Load the project from the cache, if it has a snapshot of these contents.
+    //
+    std::string key;
+    Project::shared_ptr project;
+    if (cache != nullptr) {
+        key = ProjectCache::Key(contents);
+        project = cache->load(key);
+    }
+
+    if (project == nullptr) {
+        project = Parse(contents, projectFileName);
+        if (project == nullptr) {
+            return nullptr;
+        }
+
+        if (cache != nullptr) {
+            cache->store(key, project.get());
+        }
+    }
+
+    //
+    // Save some useful info
+    //
+    project->_dataFile    = realPath;
+    project->_projectFile = FSUtil::GetDirectoryName(realPath);
+    project->_basePath    = FSUtil::GetDirectoryName(project->_projectFile);
+    project->_name        = FSUtil::GetBaseNameWithoutExtension(project->_projectFile);
+
+    return project;
+}
+
+Project::shared_ptr Project::
+Parse(std::vector<uint8_t> const &contents, std::string const &projectFileName)
+{
+    //
+    // Parse property list. It is read into a document, which the objects are
+    // copied out of one at a time as they are parsed, rather than into one
+    // object for each value in the project; it is freed all at once, when
+    // the project has been created from it.
     //
-    auto result = plist::Format::Any::Deserialize(contents);
+    auto result = plist::Format::Document::Deserialize(contents);
     if (result.first == nullptr) {
         fprintf(stderr, "error: project file %s is not parseable: %s\n", projectFileName.c_str(), result.second.c_str());
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
-    if (plist == nullptr) {
+    plist::Format::Document::Node const *root = result.first->root();
+    if (root->type() != plist::ObjectType::Dictionary) {
         fprintf(stderr, "error: project file %s is not a dictionary\n", projectFileName.c_str());
         return nullptr;
     }
 
+    //
+    // Copy out everything but the objects, which are parsed from the document.
+    //
+    std::unique_ptr<plist::Dictionary> plist = plist::Dictionary::New();
+    for (size_t n = 0; n < root->count(); n++) {
+        std::string key = root->key(n)->string();
+        if (key != "objects") {
+            plist->set(key, root->value(n)->object());
+        }
+    }
+
     //
     // Fetch basic objects
     //
     std::unordered_set<std::string> seen;
-    auto unpack = plist::Keys::Unpack("Root", plist, &seen);
+    auto unpack = plist::Keys::Unpack("Root", plist.get(), &seen);
 
     auto AV = unpack.coerce <plist::Integer> ("archiveVersion");
     auto OV = unpack.coerce <plist::Integer> ("objectVersion");
-    auto Os = unpack.cast <plist::Dictionary> ("objects");
+    auto Os = root->value("objects");
     auto Cs = unpack.cast <plist::Dictionary> ("classes");
 
     //
@@ -262,7 +320,7 @@ Open(Filesystem const *filesystem, std::string const &path)
         fprintf(stderr, "warning: non-empty classes may be unsupported\n");
     }
 
-    if (Os == nullptr) {
+    if (Os == nullptr || Os->type() != plist::ObjectType::Dictionary) {
         return nullptr;
     }
 
@@ -293,14 +351,9 @@ Open(Filesystem const *filesystem, std::string const &path)
     // Parse the project dictionary and create the project object.
     //
     auto project = context.parseObject(context.projects, PID, P);
-
-    //
-    // Save some useful info
-    //
-    project->_dataFile    = realPath;
-    project->_projectFile = FSUtil::GetDirectoryName(realPath);
-    project->_basePath    = FSUtil::GetDirectoryName(project->_projectFile);
-    project->_name        = FSUtil::GetBaseNameWithoutExtension(project->_projectFile);
+    if (project == nullptr) {
+        return nullptr;
+    }
 
     //
     // Transfer all file references from cache.
@@ -351,3 +404,54 @@ parse(Context &context, plist::Dictionary const *dict)
     return true;
 }
 
+void Project::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->object(_buildConfigurationList.get());
+    writer->string(_compatibilityVersion);
+    writer->string(_developmentRegion);
+    writer->boolean(_hasScannedForEncodings);
+    writer->strings(_knownRegions);
+    writer->object(_mainGroup.get());
+    writer->object(_productRefGroup.get());
+    writer->string(_projectDirPath);
+    writer->string(_projectRoot);
+
+    writer->integer(_projectReferences.size());
+    for (ProjectReference const &projectReference : _projectReferences) {
+        writer->object(projectReference._productGroup.get());
+        writer->object(projectReference._projectReference.get());
+    }
+
+    writer->objects(_targets);
+    writer->objects(_fileReferences);
+}
+
+void Project::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _buildConfigurationList = reader->object<XC::ConfigurationList>();
+    _compatibilityVersion   = reader->string();
+    _developmentRegion      = reader->string();
+    _hasScannedForEncodings = reader->boolean();
+    _knownRegions           = reader->strings();
+    _mainGroup              = reader->object<Group>();
+    _productRefGroup        = reader->object<Group>();
+    _projectDirPath         = reader->string();
+    _projectRoot            = reader->string();
+
+    uint64_t projectReferences = reader->integer();
+    for (uint64_t n = 0; n < projectReferences && !reader->failed(); n++) {
+        ProjectReference projectReference;
+        projectReference._productGroup     = reader->object<Group>();
+        projectReference._projectReference = reader->object<FileReference>();
+        _projectReferences.push_back(projectReference);
+    }
+
+    _targets        = reader->objects<Target>();
+    _fileReferences = reader->objects<FileReference>();
+}
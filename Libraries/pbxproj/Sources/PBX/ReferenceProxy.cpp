@@ -11,6 +11,7 @@
 
 using pbxproj::PBX::ReferenceProxy;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 ReferenceProxy::
 ReferenceProxy() :
@@ -49,3 +50,21 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void ReferenceProxy::
+snapshot(Snapshot::Writer *writer) const
+{
+    GroupItem::snapshot(writer);
+
+    writer->string(_fileType);
+    writer->object(_remoteRef.get());
+}
+
+void ReferenceProxy::
+restore(Snapshot::Reader *reader)
+{
+    GroupItem::restore(reader);
+
+    _fileType  = reader->string();
+    _remoteRef = reader->object<ContainerItemProxy>();
+}
@@ -15,6 +15,7 @@
 
 using pbxproj::PBX::ShellScriptBuildPhase;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 ShellScriptBuildPhase::
 ShellScriptBuildPhase() :
@@ -81,3 +82,29 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void ShellScriptBuildPhase::
+snapshot(Snapshot::Writer *writer) const
+{
+    BuildPhase::snapshot(writer);
+
+    writer->string(_name);
+    writer->string(_shellPath);
+    writer->string(_shellScript);
+    writer->values(_inputPaths);
+    writer->values(_outputPaths);
+    writer->boolean(_showEnvVarsInLog);
+}
+
+void ShellScriptBuildPhase::
+restore(Snapshot::Reader *reader)
+{
+    BuildPhase::restore(reader);
+
+    _name             = reader->string();
+    _shellPath        = reader->string();
+    _shellScript      = reader->string();
+    _inputPaths       = reader->values();
+    _outputPaths      = reader->values();
+    _showEnvVarsInLog = reader->boolean();
+}
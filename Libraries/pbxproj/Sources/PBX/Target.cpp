@@ -17,6 +17,7 @@
 
 using pbxproj::PBX::Target;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 Target::
 Target(std::string const &isa, Type type) :
@@ -170,3 +171,28 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void Target::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->string(_name);
+    writer->string(_productName);
+    writer->object(_buildConfigurationList.get());
+    writer->objects(_buildPhases);
+    writer->objects(_dependencies);
+}
+
+void Target::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _project                = reader->project();
+    _name                   = reader->string();
+    _productName            = reader->string();
+    _buildConfigurationList = reader->object<XC::ConfigurationList>();
+    _buildPhases            = reader->objects<BuildPhase>();
+    _dependencies           = reader->objects<TargetDependency>();
+}
@@ -15,6 +15,7 @@
 
 using pbxproj::PBX::TargetDependency;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 TargetDependency::
 TargetDependency() :
@@ -71,3 +72,23 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void TargetDependency::
+snapshot(Snapshot::Writer *writer) const
+{
+    Object::snapshot(writer);
+
+    writer->string(_name);
+    writer->object(_target.get());
+    writer->object(_targetProxy.get());
+}
+
+void TargetDependency::
+restore(Snapshot::Reader *reader)
+{
+    Object::restore(reader);
+
+    _name        = reader->string();
+    _target      = reader->object<Target>();
+    _targetProxy = reader->object<ContainerItemProxy>();
+}
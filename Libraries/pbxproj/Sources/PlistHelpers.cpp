@@ -7,46 +7,26 @@
  */
 
 #include <pbxproj/PlistHelpers.h>
-#include <plist/Dictionary.h>
-#include <plist/String.h>
-#include <plist/Keys/Unpack.h>
 
 namespace pbxproj {
 
-plist::Dictionary const *
-PlistDictionaryGetPBXObject(plist::Dictionary const *dict,
+plist::Format::Document::Node const *
+PlistDictionaryGetPBXObject(plist::Format::Document::Node const *dict,
                             std::string const &key,
                             std::string const &isa)
 {
     if (isa.empty())
         return nullptr;
 
-    plist::Dictionary const *object = dict->value <plist::Dictionary> (key);
-    if (object == nullptr)
+    plist::Format::Document::Node const *object = dict->value(key);
+    if (object == nullptr || object->type() != plist::ObjectType::Dictionary)
         return nullptr;
 
-    plist::String const *isaObject = object->value <plist::String> ("isa");
-    if (isaObject != nullptr && isaObject->value() == isa)
+    plist::Format::Document::Node const *isaObject = object->value("isa");
+    if (isaObject != nullptr && isaObject->equals(isa))
         return object;
     else
         return nullptr;
 }
 
-plist::Dictionary const *
-PlistDictionaryGetIndirectPBXObject(plist::Dictionary const *objects,
-                                    plist::Keys::Unpack *unpack,
-                                    std::string const &key,
-                                    std::string const &isa,
-                                    std::string *id)
-{
-    auto ID = unpack->cast <plist::String> (key);
-    if (ID == nullptr)
-        return nullptr;
-
-    if (id != nullptr) {
-        *id = ID->value();
-    }
-    return PlistDictionaryGetPBXObject(objects, ID->value(), isa);
-}
-
 }
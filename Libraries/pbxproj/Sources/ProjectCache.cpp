@@ -0,0 +1,84 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <pbxproj/ProjectCache.h>
+#include <pbxproj/PBX/Project.h>
+#include <pbxproj/Snapshot.h>
+#include <libutil/Filesystem.h>
+#include <libutil/md5.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using pbxproj::ProjectCache;
+using pbxproj::Snapshot;
+using libutil::Filesystem;
+
+ProjectCache::
+ProjectCache(Filesystem *filesystem, std::string const &path) :
+    _filesystem(filesystem),
+    _path      (path)
+{
+}
+
+std::string ProjectCache::
+snapshotPath(std::string const &key) const
+{
+    return _path + "/" + key + ".pbxsnapshot";
+}
+
+std::shared_ptr<pbxproj::PBX::Project> ProjectCache::
+load(std::string const &key) const
+{
+    std::string path = snapshotPath(key);
+    if (!_filesystem->isReadable(path)) {
+        return nullptr;
+    }
+
+    std::vector<uint8_t> contents;
+    if (!_filesystem->read(&contents, path)) {
+        return nullptr;
+    }
+
+    return Snapshot::Read(contents, key);
+}
+
+bool ProjectCache::
+store(std::string const &key, PBX::Project const *project)
+{
+    if (!_filesystem->createDirectory(_path, true)) {
+        return false;
+    }
+
+    return _filesystem->write(Snapshot::Write(project, key), snapshotPath(key));
+}
+
+std::string ProjectCache::
+Key(std::vector<uint8_t> const &contents)
+{
+    md5_state_t state;
+    md5_init(&state);
+
+    /* Append in parts, as the length is an int. */
+    size_t const chunk = 1024 * 1024;
+    for (size_t offset = 0; offset < contents.size(); offset += chunk) {
+        size_t size = std::min(chunk, contents.size() - offset);
+        md5_append(&state, reinterpret_cast<const md5_byte_t *>(contents.data() + offset), static_cast<int>(size));
+    }
+
+    uint8_t digest[16];
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(&digest));
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (uint8_t c : digest) {
+        ss << std::setw(2) << static_cast<int>(c);
+    }
+    return ss.str();
+}
@@ -0,0 +1,480 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <pbxproj/Snapshot.h>
+#include <pbxproj/pbxproj.h>
+#include <pbxsetting/Setting.h>
+#include <libutil/md5.h>
+
+#include <algorithm>
+#include <cstring>
+
+using pbxproj::Snapshot;
+namespace PBX = pbxproj::PBX;
+namespace XC = pbxproj::XC;
+
+/*
+ * Snapshots start with this, followed by a format version. The version
+ * must change whenever the fields written by any object change.
+ */
+static char const Magic[] = { 'p', 'b', 'x', 's', 'n', 'a', 'p' };
+static uint8_t const Version = 1;
+
+/*
+ * Snapshots end with a digest of everything before it, so a corrupt or
+ * truncated snapshot is rejected before any of it is read.
+ */
+static size_t const DigestSize = 16;
+
+static void
+Digest(uint8_t const *data, size_t size, uint8_t *digest)
+{
+    md5_state_t state;
+    md5_init(&state);
+
+    /* Append in parts, as the length is an int. */
+    size_t const chunk = 1024 * 1024;
+    for (size_t offset = 0; offset < size; offset += chunk) {
+        md5_append(&state, reinterpret_cast<md5_byte_t const *>(data + offset), static_cast<int>(std::min(chunk, size - offset)));
+    }
+
+    md5_finish(&state, reinterpret_cast<md5_byte_t *>(digest));
+}
+
+Snapshot::Writer::
+Writer()
+{
+}
+
+void Snapshot::Writer::
+integer(uint64_t value)
+{
+    /* Seven bits at a time, low bits first. */
+    while (value >= 0x80) {
+        _records.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    _records.push_back(static_cast<uint8_t>(value));
+}
+
+void Snapshot::Writer::
+boolean(bool value)
+{
+    _records.push_back(value ? 1 : 0);
+}
+
+void Snapshot::Writer::
+string(std::string const &value)
+{
+    /* Look up first, to not copy strings that are already recorded. */
+    auto it = _strings.find(value);
+    if (it == _strings.end()) {
+        it = _strings.insert({ value, _stringTable.size() }).first;
+        _stringTable.push_back(&it->first);
+    }
+    integer(it->second);
+}
+
+void Snapshot::Writer::
+strings(std::vector<std::string> const &values)
+{
+    integer(values.size());
+    for (std::string const &value : values) {
+        string(value);
+    }
+}
+
+void Snapshot::Writer::
+value(pbxsetting::Value const &value)
+{
+    integer(value.entries().size());
+    for (pbxsetting::Value::Entry const &entry : value.entries()) {
+        switch (entry.type()) {
+            case pbxsetting::Value::Entry::Type::String:
+                integer(0);
+                string(*entry.string());
+                break;
+            case pbxsetting::Value::Entry::Type::Value:
+                integer(1);
+                this->value(*entry.value());
+                break;
+        }
+    }
+}
+
+void Snapshot::Writer::
+values(std::vector<pbxsetting::Value> const &values)
+{
+    integer(values.size());
+    for (pbxsetting::Value const &value : values) {
+        this->value(value);
+    }
+}
+
+void Snapshot::Writer::
+level(pbxsetting::Level const &level)
+{
+    integer(level.settings().size());
+    for (pbxsetting::Setting const &setting : level.settings()) {
+        string(setting.name());
+
+        integer(setting.condition().values().size());
+        for (auto const &entry : setting.condition().values()) {
+            string(entry.first);
+            string(entry.second);
+        }
+
+        value(setting.value());
+    }
+}
+
+uint64_t Snapshot::Writer::
+index(PBX::Object const *object)
+{
+    auto result = _indexes.insert({ object, _objects.size() });
+    if (result.second) {
+        _objects.push_back(object);
+    }
+    return result.first->second;
+}
+
+void Snapshot::Writer::
+object(PBX::Object const *object)
+{
+    /* Zero is null, so indexes are offset by one. */
+    integer(object != nullptr ? index(object) + 1 : 0);
+}
+
+std::vector<uint8_t> Snapshot::Writer::
+write(std::string const &key)
+{
+    /* Object types are strings too, so record them before the strings. */
+    std::vector<uint64_t> types;
+    types.reserve(_objects.size());
+    for (PBX::Object const *object : _objects) {
+        auto result = _strings.insert({ object->isa(), _stringTable.size() });
+        if (result.second) {
+            _stringTable.push_back(&result.first->first);
+        }
+        types.push_back(result.first->second);
+    }
+
+    /* Write the header through the record functions, then append the records. */
+    std::vector<uint8_t> records = std::move(_records);
+    _records.clear();
+
+    _records.insert(_records.end(), std::begin(Magic), std::end(Magic));
+    _records.push_back(Version);
+
+    integer(key.size());
+    _records.insert(_records.end(), key.begin(), key.end());
+
+    integer(_stringTable.size());
+    for (std::string const *string : _stringTable) {
+        integer(string->size());
+        _records.insert(_records.end(), string->begin(), string->end());
+    }
+
+    integer(types.size());
+    for (uint64_t type : types) {
+        integer(type);
+    }
+
+    _records.insert(_records.end(), records.begin(), records.end());
+
+    uint8_t digest[DigestSize];
+    Digest(_records.data(), _records.size(), digest);
+    _records.insert(_records.end(), std::begin(digest), std::end(digest));
+
+    return std::move(_records);
+}
+
+Snapshot::Reader::
+Reader(uint8_t const *data, size_t size) :
+    _data  (data),
+    _size  (size),
+    _offset(0),
+    _failed(false)
+{
+}
+
+uint64_t Snapshot::Reader::
+integer()
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (_offset >= _size) {
+            break;
+        }
+
+        uint8_t byte = _data[_offset++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    _failed = true;
+    return 0;
+}
+
+bool Snapshot::Reader::
+boolean()
+{
+    if (_offset >= _size) {
+        _failed = true;
+        return false;
+    }
+
+    return (_data[_offset++] != 0);
+}
+
+std::string const &Snapshot::Reader::
+string()
+{
+    static std::string const empty;
+
+    uint64_t index = integer();
+    if (index >= _strings.size()) {
+        _failed = true;
+        return empty;
+    }
+
+    return _strings[index];
+}
+
+std::vector<std::string> Snapshot::Reader::
+strings()
+{
+    std::vector<std::string> strings;
+    uint64_t count = integer();
+    for (uint64_t n = 0; n < count && !_failed; n++) {
+        strings.push_back(string());
+    }
+    return strings;
+}
+
+pbxsetting::Value Snapshot::Reader::
+value()
+{
+    std::vector<pbxsetting::Value::Entry> entries;
+    uint64_t count = integer();
+    for (uint64_t n = 0; n < count && !_failed; n++) {
+        if (integer() == 0) {
+            entries.push_back(pbxsetting::Value::Entry(string()));
+        } else {
+            entries.push_back(pbxsetting::Value::Entry(std::make_shared<pbxsetting::Value>(value())));
+        }
+    }
+    return pbxsetting::Value(entries);
+}
+
+std::vector<pbxsetting::Value> Snapshot::Reader::
+values()
+{
+    std::vector<pbxsetting::Value> values;
+    uint64_t count = integer();
+    for (uint64_t n = 0; n < count && !_failed; n++) {
+        values.push_back(value());
+    }
+    return values;
+}
+
+pbxsetting::Level Snapshot::Reader::
+level()
+{
+    std::vector<pbxsetting::Setting> settings;
+    uint64_t count = integer();
+    for (uint64_t n = 0; n < count && !_failed; n++) {
+        std::string name = string();
+
+        std::unordered_map<std::string, std::string> condition;
+        uint64_t conditions = integer();
+        for (uint64_t c = 0; c < conditions && !_failed; c++) {
+            std::string key = string();
+            condition.insert({ key, string() });
+        }
+
+        settings.push_back(pbxsetting::Setting(name, pbxsetting::Condition(condition), value()));
+    }
+    return pbxsetting::Level(settings);
+}
+
+static std::shared_ptr<PBX::Object>
+CreateObject(std::string const &isa)
+{
+    if (isa == PBX::Project::Isa()) {
+        return std::make_shared<PBX::Project>();
+    } else if (isa == PBX::FileReference::Isa()) {
+        return std::make_shared<PBX::FileReference>();
+    } else if (isa == PBX::ReferenceProxy::Isa()) {
+        return std::make_shared<PBX::ReferenceProxy>();
+    } else if (isa == PBX::Group::Isa()) {
+        return std::make_shared<PBX::Group>();
+    } else if (isa == PBX::VariantGroup::Isa()) {
+        return std::make_shared<PBX::VariantGroup>();
+    } else if (isa == XC::VersionGroup::Isa()) {
+        return std::make_shared<XC::VersionGroup>();
+    } else if (isa == PBX::NativeTarget::Isa()) {
+        return std::make_shared<PBX::NativeTarget>();
+    } else if (isa == PBX::AggregateTarget::Isa()) {
+        return std::make_shared<PBX::AggregateTarget>();
+    } else if (isa == PBX::LegacyTarget::Isa()) {
+        return std::make_shared<PBX::LegacyTarget>();
+    } else if (isa == PBX::TargetDependency::Isa()) {
+        return std::make_shared<PBX::TargetDependency>();
+    } else if (isa == PBX::ContainerItemProxy::Isa()) {
+        return std::make_shared<PBX::ContainerItemProxy>();
+    } else if (isa == PBX::BuildFile::Isa()) {
+        return std::make_shared<PBX::BuildFile>();
+    } else if (isa == PBX::BuildRule::Isa()) {
+        return std::make_shared<PBX::BuildRule>();
+    } else if (isa == PBX::HeadersBuildPhase::Isa()) {
+        return std::make_shared<PBX::HeadersBuildPhase>();
+    } else if (isa == PBX::SourcesBuildPhase::Isa()) {
+        return std::make_shared<PBX::SourcesBuildPhase>();
+    } else if (isa == PBX::ResourcesBuildPhase::Isa()) {
+        return std::make_shared<PBX::ResourcesBuildPhase>();
+    } else if (isa == PBX::FrameworksBuildPhase::Isa()) {
+        return std::make_shared<PBX::FrameworksBuildPhase>();
+    } else if (isa == PBX::CopyFilesBuildPhase::Isa()) {
+        return std::make_shared<PBX::CopyFilesBuildPhase>();
+    } else if (isa == PBX::ShellScriptBuildPhase::Isa()) {
+        return std::make_shared<PBX::ShellScriptBuildPhase>();
+    } else if (isa == PBX::AppleScriptBuildPhase::Isa()) {
+        return std::make_shared<PBX::AppleScriptBuildPhase>();
+    } else if (isa == PBX::RezBuildPhase::Isa()) {
+        return std::make_shared<PBX::RezBuildPhase>();
+    } else if (isa == XC::BuildConfiguration::Isa()) {
+        return std::make_shared<XC::BuildConfiguration>();
+    } else if (isa == XC::ConfigurationList::Isa()) {
+        return std::make_shared<XC::ConfigurationList>();
+    } else {
+        return nullptr;
+    }
+}
+
+std::shared_ptr<PBX::Project> Snapshot::Reader::
+read(std::string const &key)
+{
+    if (_size < sizeof(Magic) + 1 + DigestSize || memcmp(_data, Magic, sizeof(Magic)) != 0 || _data[sizeof(Magic)] != Version) {
+        return nullptr;
+    }
+    _offset = sizeof(Magic) + 1;
+
+    uint8_t digest[DigestSize];
+    _size -= DigestSize;
+    Digest(_data, _size, digest);
+    if (memcmp(_data + _size, digest, DigestSize) != 0) {
+        return nullptr;
+    }
+
+    /* Each count is checked against the remaining size before allocating. */
+    uint64_t keySize = integer();
+    if (_failed || keySize > _size - _offset || std::string(reinterpret_cast<char const *>(_data + _offset), keySize) != key) {
+        return nullptr;
+    }
+    _offset += keySize;
+
+    uint64_t strings = integer();
+    if (_failed || strings > _size - _offset) {
+        return nullptr;
+    }
+    _strings.reserve(strings);
+    for (uint64_t n = 0; n < strings; n++) {
+        uint64_t size = integer();
+        if (_failed || size > _size - _offset) {
+            return nullptr;
+        }
+        _strings.push_back(std::string(reinterpret_cast<char const *>(_data + _offset), size));
+        _offset += size;
+    }
+
+    /* Create every object first, so references can be resolved in any order. */
+    uint64_t objects = integer();
+    if (_failed || objects == 0 || objects > _size - _offset) {
+        return nullptr;
+    }
+    _objects.reserve(objects);
+
+    for (uint64_t n = 0; n < objects; n++) {
+        std::string const &isa = string();
+        std::shared_ptr<PBX::Object> object = (_failed ? nullptr : CreateObject(isa));
+        if (object == nullptr) {
+            return nullptr;
+        }
+        _objects.push_back(object);
+    }
+
+    if (!_objects.front()->isa<PBX::Project>()) {
+        return nullptr;
+    }
+
+    _project = std::static_pointer_cast<PBX::Project>(_objects.front());
+    return _project;
+}
+
+std::vector<uint8_t> Snapshot::
+Write(PBX::Project const *project, std::string const &key)
+{
+    Writer writer;
+    size_t written = 0;
+
+    /* Every other object is in the blueprints, so this avoids rehashing. */
+    writer._indexes.reserve(project->_blueprints.size() + 1);
+    writer._objects.reserve(project->_blueprints.size() + 1);
+
+    /* The project is always the first object. */
+    writer.index(project);
+
+    /* Objects are added as they are referenced, while writing earlier ones. */
+    for (; written < writer._objects.size(); written++) {
+        writer._objects[written]->snapshot(&writer);
+    }
+
+    /* Include objects not reachable from the project, to find by identifier. */
+    for (auto const &entry : project->_blueprints) {
+        writer.index(entry.second.get());
+    }
+    for (; written < writer._objects.size(); written++) {
+        writer._objects[written]->snapshot(&writer);
+    }
+
+    return writer.write(key);
+}
+
+std::shared_ptr<PBX::Project> Snapshot::
+Read(std::vector<uint8_t> const &contents, std::string const &key)
+{
+    Reader reader = Reader(contents.data(), contents.size());
+
+    std::shared_ptr<PBX::Project> project = reader.read(key);
+    if (project == nullptr) {
+        return nullptr;
+    }
+
+    for (std::shared_ptr<PBX::Object> const &object : reader._objects) {
+        object->restore(&reader);
+        if (reader.failed()) {
+            return nullptr;
+        }
+    }
+
+    if (reader._offset != reader._size) {
+        return nullptr;
+    }
+
+    /* Objects can be found by identifier, as after parsing. */
+    for (std::shared_ptr<PBX::Object> const &object : reader._objects) {
+        if (object != project) {
+            project->cacheObject(object);
+        }
+    }
+
+    return project;
+}
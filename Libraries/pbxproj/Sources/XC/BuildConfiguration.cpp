@@ -11,6 +11,7 @@
 
 using pbxproj::XC::BuildConfiguration;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 BuildConfiguration::
 BuildConfiguration() :
@@ -66,3 +67,23 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void BuildConfiguration::
+snapshot(Snapshot::Writer *writer) const
+{
+    PBX::Object::snapshot(writer);
+
+    writer->string(_name);
+    writer->object(_baseConfigurationReference.get());
+    writer->level(_buildSettings);
+}
+
+void BuildConfiguration::
+restore(Snapshot::Reader *reader)
+{
+    PBX::Object::restore(reader);
+
+    _name                       = reader->string();
+    _baseConfigurationReference = reader->object<PBX::FileReference>();
+    _buildSettings              = reader->level();
+}
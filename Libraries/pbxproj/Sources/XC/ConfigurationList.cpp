@@ -18,6 +18,7 @@
 
 using pbxproj::XC::ConfigurationList;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 ConfigurationList::
 ConfigurationList() :
@@ -68,3 +69,23 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void ConfigurationList::
+snapshot(Snapshot::Writer *writer) const
+{
+    PBX::Object::snapshot(writer);
+
+    writer->objects(_buildConfigurations);
+    writer->string(_defaultConfigurationName);
+    writer->boolean(_defaultConfigurationIsVisible);
+}
+
+void ConfigurationList::
+restore(Snapshot::Reader *reader)
+{
+    PBX::Object::restore(reader);
+
+    _buildConfigurations           = reader->objects<BuildConfiguration>();
+    _defaultConfigurationName      = reader->string();
+    _defaultConfigurationIsVisible = reader->boolean();
+}
@@ -12,6 +12,7 @@
 
 using pbxproj::XC::VersionGroup;
 using pbxproj::Context;
+using pbxproj::Snapshot;
 
 VersionGroup::
 VersionGroup() :
@@ -49,3 +50,21 @@ parse(Context &context, plist::Dictionary const *dict, std::unordered_set<std::s
 
     return true;
 }
+
+void VersionGroup::
+snapshot(Snapshot::Writer *writer) const
+{
+    PBX::BaseGroup::snapshot(writer);
+
+    writer->object(_currentVersion.get());
+    writer->string(_versionGroupType);
+}
+
+void VersionGroup::
+restore(Snapshot::Reader *reader)
+{
+    PBX::BaseGroup::restore(reader);
+
+    _currentVersion   = reader->object<PBX::GroupItem>();
+    _versionGroupType = reader->string();
+}
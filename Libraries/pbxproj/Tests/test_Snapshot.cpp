@@ -0,0 +1,177 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxproj/pbxproj.h>
+#include <pbxproj/ProjectCache.h>
+#include <pbxproj/Snapshot.h>
+#include <libutil/MemoryFilesystem.h>
+
+using pbxproj::ProjectCache;
+using pbxproj::Snapshot;
+using libutil::MemoryFilesystem;
+namespace PBX = pbxproj::PBX;
+namespace XC = pbxproj::XC;
+
+static std::string const ProjectContents =
+    "{ archiveVersion = 1; objectVersion = 46; rootObject = ROOT; objects = {\n"
+    "ROOT = { isa = PBXProject; buildConfigurationList = PCL; compatibilityVersion = \"Xcode 3.2\"; "
+        "developmentRegion = English; hasScannedForEncodings = 1; knownRegions = (en, Base); "
+        "mainGroup = MAIN; productRefGroup = PRODUCTS; projectDirPath = \"\"; projectRoot = \"\"; targets = (TARGET); };\n"
+    "MAIN = { isa = PBXGroup; children = (SOURCES_GROUP, PRODUCTS); sourceTree = \"<group>\"; };\n"
+    "SOURCES_GROUP = { isa = PBXGroup; children = (MAIN_C); path = Sources; sourceTree = \"<group>\"; };\n"
+    "MAIN_C = { isa = PBXFileReference; lastKnownFileType = sourcecode.c.c; path = main.c; sourceTree = \"<group>\"; };\n"
+    "PRODUCTS = { isa = PBXGroup; children = (APP); name = Products; sourceTree = \"<group>\"; };\n"
+    "APP = { isa = PBXFileReference; explicitFileType = \"compiled.mach-o.executable\"; includeInIndex = 0; "
+        "path = App; sourceTree = BUILT_PRODUCTS_DIR; };\n"
+    "TARGET = { isa = PBXNativeTarget; buildConfigurationList = TCL; buildPhases = (SOURCES, SCRIPT); "
+        "buildRules = (); dependencies = (); name = App; productName = App; productReference = APP; "
+        "productType = \"com.apple.product-type.tool\"; };\n"
+    "SOURCES = { isa = PBXSourcesBuildPhase; buildActionMask = 2147483647; files = (MAIN_C_BUILD); "
+        "runOnlyForDeploymentPostprocessing = 0; };\n"
+    "MAIN_C_BUILD = { isa = PBXBuildFile; fileRef = MAIN_C; settings = { COMPILER_FLAGS = \"-Wall -O2\"; }; };\n"
+    "SCRIPT = { isa = PBXShellScriptBuildPhase; buildActionMask = 2147483647; files = (); "
+        "inputPaths = (\"$(SRCROOT)/in.txt\"); outputPaths = (\"$(DERIVED_FILE_DIR)/out.txt\"); "
+        "runOnlyForDeploymentPostprocessing = 0; shellPath = /bin/sh; shellScript = \"echo hi\"; };\n"
+    "PCL = { isa = XCConfigurationList; buildConfigurations = (PDEBUG); defaultConfigurationIsVisible = 0; "
+        "defaultConfigurationName = Debug; };\n"
+    "PDEBUG = { isa = XCBuildConfiguration; buildSettings = { \"OTHER_CFLAGS[sdk=macosx*]\" = \"-DMAC\"; "
+        "SDKROOT = macosx; }; name = Debug; };\n"
+    "TCL = { isa = XCConfigurationList; buildConfigurations = (TDEBUG); defaultConfigurationIsVisible = 0; "
+        "defaultConfigurationName = Debug; };\n"
+    "TDEBUG = { isa = XCBuildConfiguration; buildSettings = { PRODUCT_NAME = \"$(TARGET_NAME)\"; }; name = Debug; };\n"
+    "}; }\n";
+
+static MemoryFilesystem
+ProjectFilesystem()
+{
+    return MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("App.xcodeproj", {
+            MemoryFilesystem::Entry::File("project.pbxproj", std::vector<uint8_t>(ProjectContents.begin(), ProjectContents.end())),
+        }),
+    });
+}
+
+static void
+ExpectEqualProjects(PBX::Project const *expected, PBX::Project const *actual)
+{
+    EXPECT_EQ(expected->compatibilityVersion(), actual->compatibilityVersion());
+    EXPECT_EQ(expected->developmentRegion(), actual->developmentRegion());
+    EXPECT_EQ(expected->hasScannedForEncodings(), actual->hasScannedForEncodings());
+    EXPECT_EQ(expected->knownRegions(), actual->knownRegions());
+    EXPECT_EQ(expected->projectFile(), actual->projectFile());
+    EXPECT_EQ(expected->fileReferences().size(), actual->fileReferences().size());
+
+    /* Group structure, including parents. */
+    ASSERT_NE(nullptr, actual->mainGroup());
+    ASSERT_EQ(2u, actual->mainGroup()->children().size());
+    auto sources = std::static_pointer_cast<PBX::Group>(actual->mainGroup()->children()[0]);
+    ASSERT_EQ(1u, sources->children().size());
+    auto main = std::static_pointer_cast<PBX::FileReference>(sources->children()[0]);
+    EXPECT_EQ("main.c", main->path());
+    EXPECT_EQ("sourcecode.c.c", main->lastKnownFileType());
+    EXPECT_EQ("$(SOURCE_ROOT)/Sources/main.c", main->resolve().raw());
+    EXPECT_EQ(actual->mainGroup()->children()[1], actual->productRefGroup());
+
+    /* Targets, build phases, and build files refer to the same objects. */
+    ASSERT_EQ(1u, actual->targets().size());
+    auto target = std::static_pointer_cast<PBX::NativeTarget>(actual->targets()[0]);
+    EXPECT_EQ("App", target->name());
+    EXPECT_EQ("com.apple.product-type.tool", target->productType());
+    EXPECT_EQ(actual->productRefGroup()->children()[0], target->productReference());
+    EXPECT_EQ(actual->resolveBuildableReference("TARGET"), target);
+
+    ASSERT_EQ(2u, target->buildPhases().size());
+    auto phase = target->buildPhases()[0];
+    EXPECT_EQ(PBX::BuildPhase::Type::Sources, phase->type());
+    EXPECT_EQ(2147483647u, phase->buildActionMask());
+    ASSERT_EQ(1u, phase->files().size());
+    EXPECT_EQ(main, phase->files()[0]->fileRef());
+    EXPECT_EQ(std::vector<std::string>({ "-Wall", "-O2" }), phase->files()[0]->compilerFlags());
+
+    auto script = std::static_pointer_cast<PBX::ShellScriptBuildPhase>(target->buildPhases()[1]);
+    EXPECT_EQ("echo hi", script->shellScript());
+    ASSERT_EQ(1u, script->inputPaths().size());
+    EXPECT_EQ("$(SRCROOT)/in.txt", script->inputPaths()[0].raw());
+
+    /* Configurations, including conditional settings. */
+    ASSERT_NE(nullptr, actual->buildConfigurationList());
+    EXPECT_EQ("Debug", actual->buildConfigurationList()->defaultConfigurationName());
+    ASSERT_EQ(1u, actual->buildConfigurationList()->buildConfigurations().size());
+    auto configuration = actual->buildConfigurationList()->buildConfigurations()[0];
+    auto expectedConfiguration = expected->buildConfigurationList()->buildConfigurations()[0];
+    EXPECT_EQ("Debug", configuration->name());
+    ASSERT_EQ(expectedConfiguration->buildSettings().settings().size(), configuration->buildSettings().settings().size());
+    for (size_t n = 0; n < configuration->buildSettings().settings().size(); n++) {
+        pbxsetting::Setting const &expectedSetting = expectedConfiguration->buildSettings().settings()[n];
+        pbxsetting::Setting const &setting = configuration->buildSettings().settings()[n];
+        EXPECT_EQ(expectedSetting.name(), setting.name());
+        EXPECT_EQ(expectedSetting.condition().values(), setting.condition().values());
+        EXPECT_EQ(expectedSetting.value(), setting.value());
+    }
+}
+
+TEST(Snapshot, Roundtrip)
+{
+    MemoryFilesystem filesystem = ProjectFilesystem();
+    auto project = PBX::Project::Open(&filesystem, "/App.xcodeproj");
+    ASSERT_NE(nullptr, project);
+
+    std::vector<uint8_t> snapshot = Snapshot::Write(project.get(), "key");
+    auto restored = Snapshot::Read(snapshot, "key");
+    ASSERT_NE(nullptr, restored);
+
+    /* Paths are not part of the snapshot; they depend on where it is opened. */
+    EXPECT_EQ("", restored->projectFile());
+    EXPECT_EQ(project->fileReferences().size(), restored->fileReferences().size());
+    EXPECT_EQ(project->knownRegions(), restored->knownRegions());
+}
+
+TEST(Snapshot, Invalid)
+{
+    MemoryFilesystem filesystem = ProjectFilesystem();
+    auto project = PBX::Project::Open(&filesystem, "/App.xcodeproj");
+    ASSERT_NE(nullptr, project);
+
+    std::vector<uint8_t> snapshot = Snapshot::Write(project.get(), "key");
+    EXPECT_EQ(nullptr, Snapshot::Read(snapshot, "other"));
+    EXPECT_EQ(nullptr, Snapshot::Read(std::vector<uint8_t>(), "key"));
+
+    std::vector<uint8_t> truncated = std::vector<uint8_t>(snapshot.begin(), snapshot.end() - 1);
+    EXPECT_EQ(nullptr, Snapshot::Read(truncated, "key"));
+
+    std::vector<uint8_t> corrupt = snapshot;
+    corrupt[corrupt.size() / 2] ^= 0xff;
+    EXPECT_EQ(nullptr, Snapshot::Read(corrupt, "key"));
+}
+
+TEST(Snapshot, ProjectCache)
+{
+    MemoryFilesystem filesystem = ProjectFilesystem();
+    ProjectCache cache = ProjectCache(&filesystem, "/Cache");
+
+    auto expected = PBX::Project::Open(&filesystem, "/App.xcodeproj");
+    ASSERT_NE(nullptr, expected);
+
+    /* First open parses the project and stores a snapshot. */
+    auto parsed = PBX::Project::Open(&filesystem, "/App.xcodeproj", &cache);
+    ASSERT_NE(nullptr, parsed);
+    ExpectEqualProjects(expected.get(), parsed.get());
+
+    std::vector<uint8_t> contents = std::vector<uint8_t>(ProjectContents.begin(), ProjectContents.end());
+    std::string key = ProjectCache::Key(contents);
+    EXPECT_TRUE(filesystem.isReadable("/Cache/" + key + ".pbxsnapshot"));
+
+    /* Second open loads the snapshot. */
+    auto loaded = cache.load(key);
+    ASSERT_NE(nullptr, loaded);
+
+    auto cached = PBX::Project::Open(&filesystem, "/App.xcodeproj", &cache);
+    ASSERT_NE(nullptr, cached);
+    ExpectEqualProjects(expected.get(), cached.get());
+}
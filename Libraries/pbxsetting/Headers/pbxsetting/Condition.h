@@ -34,6 +34,10 @@ public:
     bool
     match(Condition const &condition) const;
 
+public:
+    bool operator==(Condition const &rhs) const;
+    bool operator!=(Condition const &rhs) const;
+
 public:
     static Condition const &
     Empty(void);
@@ -46,7 +50,7 @@ template<>
 struct hash<pbxsetting::Condition> {
     size_t operator()(pbxsetting::Condition const &condition) const {
         size_t hash = 0;
-        for (auto pair : condition._values) {
+        for (auto const &pair : condition._values) {
             hash ^= std::hash<std::string>()(pair.first);
             hash ^= std::hash<std::string>()(pair.second);
         }
@@ -13,6 +13,7 @@
 #include <pbxsetting/Level.h>
 
 #include <list>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -24,8 +25,14 @@ namespace pbxsetting {
  */
 class Environment {
 private:
-    std::list<Level> _levels;
-    size_t           _offset;
+    class Cache;
+
+private:
+    std::list<Level>       _levels;
+    size_t                 _offset;
+
+private:
+    std::shared_ptr<Cache> _cache;
 
 public:
     explicit Environment();
@@ -74,6 +81,28 @@ public:
      */
     void insertBack(Level const &level, bool isDefault);
 
+public:
+    /*
+     * Memoizes resolved settings by name and condition. The cache is shared
+     * with copies of the environment until either inserts a level, which
+     * gives that environment a new, empty cache.
+     */
+    void enableCache();
+
+    /*
+     * If resolved settings are being memoized.
+     */
+    bool cacheEnabled() const
+    { return _cache != nullptr; }
+
+public:
+    /*
+     * For debugging: the number of resolutions served from the cache, and
+     * the number that had to be computed, since the cache was last reset.
+     */
+    size_t cacheHits() const;
+    size_t cacheMisses() const;
+
 public:
     /*
      * For debugging: print out the contents of all levels.
@@ -89,6 +118,7 @@ private:
     std::string resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const;
     std::string resolveInheritance(Condition const &condition, InheritanceContext const &context) const;
     std::string resolveAssignment(Condition const &condition, std::string const &setting) const;
+    std::string computeAssignment(Condition const &condition, std::string const &setting) const;
 };
 
 }
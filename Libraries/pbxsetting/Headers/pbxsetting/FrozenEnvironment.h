@@ -0,0 +1,76 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __pbxsetting_FrozenEnvironment_h
+#define __pbxsetting_FrozenEnvironment_h
+
+#include <pbxsetting/Condition.h>
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/Value.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pbxsetting {
+
+/*
+ * An environment that can no longer have levels added. Since its settings
+ * can't change, resolved settings are always memoized, and the values of
+ * all settings are computed once per condition and then reused.
+ */
+class FrozenEnvironment {
+private:
+    Environment                                                                         _environment;
+
+private:
+    mutable std::mutex                                                                  _mutex;
+    mutable std::unordered_map<Condition, std::unordered_map<std::string, std::string>> _values;
+
+public:
+    explicit FrozenEnvironment(Environment const &environment);
+    FrozenEnvironment(FrozenEnvironment const &) = delete;
+    FrozenEnvironment const &operator=(FrozenEnvironment const &) = delete;
+
+public:
+    /*
+     * The underlying environment. Copies of it can have levels added.
+     */
+    Environment const &environment() const
+    { return _environment; }
+
+public:
+    /*
+     * Evaluate a build setting in the environment.
+     */
+    std::string
+    resolve(std::string const &setting, Condition const &condition) const;
+    std::string
+    resolve(std::string const &setting) const;
+
+public:
+    /*
+     * Expand an expression. Any build settings in that expression are evaluated.
+     */
+    std::string
+    expand(Value const &value, Condition const &condition) const;
+    std::string
+    expand(Value const &value) const;
+
+public:
+    /*
+     * All values for all settings present in the environment. Computed on
+     * the first call for a condition; later calls return the same values.
+     */
+    std::unordered_map<std::string, std::string> const &
+    computeValues(Condition const &condition) const;
+};
+
+}
+
+#endif  // !__pbxsetting_FrozenEnvironment_h
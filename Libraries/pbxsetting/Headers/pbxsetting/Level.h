@@ -13,6 +13,8 @@
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Value.h>
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <memory>
@@ -28,6 +30,13 @@ class Level {
 private:
     std::shared_ptr<std::vector<Setting>> _settings;
 
+private:
+    /*
+     * Index from setting name to the positions of its bindings in the
+     * settings, in order. Shared between copies along with the settings.
+     */
+    std::shared_ptr<std::unordered_map<std::string, std::vector<size_t>>> _index;
+
 public:
     /*
      * Creates a level with the given settings.
@@ -49,6 +58,13 @@ public:
      */
     std::pair<bool, Value>
     get(std::string const &setting, Condition const &condition) const;
+
+    /*
+     * Like `get()`, but without copying the value. The value is owned by
+     * the level. Returns null if the setting is not bound for the condition.
+     */
+    Value const *
+    find(std::string const &setting, Condition const &condition) const;
 };
 
 }
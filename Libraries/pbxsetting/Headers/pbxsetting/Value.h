@@ -12,6 +12,7 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <ext/optional>
 
 namespace plist { class Object; }
@@ -64,8 +65,103 @@ public:
         { return _value; }
     };
 
+public:
+    /*
+     * A flat form of the value, compiled once when the value is created
+     * and used to resolve it. Literal strings become spans of a single
+     * string. References with a literal name, the common case, are split
+     * ahead of time into the setting name and the operations to apply to
+     * it, such as `:quote` in `$(PRODUCT_NAME:quote)`. References with a
+     * name built from other references are kept as nested values.
+     */
+    class Program {
+    public:
+        /*
+         * An operation applied to a referenced setting's value.
+         */
+        enum class Operation {
+            Identifier,
+            C99ExtIdentifier,
+            RFC1034Identifier,
+            Quote,
+            Lower,
+            Upper,
+            StandardizePath,
+            Base,
+            Dir,
+            File,
+            Suffix,
+            Unknown,
+        };
+
+        class Instruction {
+        public:
+            enum class Type {
+                /*
+                 * Append `length` characters of the literals from `offset`.
+                 */
+                Literal,
+                /*
+                 * Append the setting named `names()[index]`, after applying
+                 * `length` operations from `operations()[offset]`.
+                 */
+                Reference,
+                /*
+                 * Resolve `values()[index]` to find the setting name and
+                 * operations, then append that setting.
+                 */
+                DynamicReference,
+            };
+
+        public:
+            Type     type;
+            uint32_t offset;
+            uint32_t length;
+            uint32_t index;
+        };
+
+    private:
+        std::string                         _literals;
+        std::vector<Instruction>            _instructions;
+        std::vector<std::string>            _names;
+        std::vector<Operation>              _operations;
+        std::vector<std::string>            _operationNames;
+        std::vector<std::shared_ptr<Value>> _values;
+
+    public:
+        Program(std::vector<Entry> const &entries);
+
+    public:
+        std::string const &literals() const
+        { return _literals; }
+        std::vector<Instruction> const &instructions() const
+        { return _instructions; }
+        std::vector<std::string> const &names() const
+        { return _names; }
+        std::vector<std::shared_ptr<Value>> const &values() const
+        { return _values; }
+
+    public:
+        /*
+         * The operations for references. The names are kept for reporting
+         * unknown operations.
+         */
+        std::vector<Operation> const &operations() const
+        { return _operations; }
+        std::vector<std::string> const &operationNames() const
+        { return _operationNames; }
+
+    public:
+        /*
+         * Determines the operation from its name, e.g. "quote".
+         */
+        static Operation
+        ParseOperation(std::string const &name);
+    };
+
 private:
-    std::vector<Entry> _entries;
+    std::vector<Entry>             _entries;
+    std::shared_ptr<Program const> _program;
 
 public:
     Value(std::vector<Entry> const &entries);
@@ -83,6 +179,12 @@ public:
     std::vector<Entry> const &entries() const
     { return _entries; }
 
+    /*
+     * The compiled form of the value, used to resolve it.
+     */
+    Program const &program() const
+    { return *_program; }
+
 public:
     /*
      * The raw representation of the value. This string will be
@@ -26,7 +26,7 @@ Condition::
 bool Condition::
 match(Condition const &condition) const
 {
-    auto OV = condition._values;
+    auto const &OV = condition._values;
     for (auto const &TE : _values) {
         auto OE = OV.find(TE.first);
         if (OE == OV.end()) {
@@ -41,6 +41,18 @@ match(Condition const &condition) const
     return true;
 }
 
+bool Condition::
+operator==(Condition const &rhs) const
+{
+    return _values == rhs._values;
+}
+
+bool Condition::
+operator!=(Condition const &rhs) const
+{
+    return !(*this == rhs);
+}
+
 Condition const &Condition::
 Empty(void)
 {
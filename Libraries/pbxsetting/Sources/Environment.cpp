@@ -8,8 +8,11 @@
 
 #include <pbxsetting/Environment.h>
 #include <libutil/FSUtil.h>
+#include <ext/optional>
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <sstream>
 
 using pbxsetting::Environment;
@@ -19,6 +22,59 @@ using pbxsetting::Setting;
 using pbxsetting::Value;
 using libutil::FSUtil;
 
+/*
+ * Resolved settings, by condition and then by name. Guarded by a mutex as
+ * the cache can be shared by copies of an environment used on other threads.
+ */
+class Environment::Cache {
+private:
+    std::mutex                                                                  _mutex;
+    std::unordered_map<Condition, std::unordered_map<std::string, std::string>> _values;
+
+private:
+    std::atomic<size_t>                                                         _hits;
+    std::atomic<size_t>                                                         _misses;
+
+public:
+    Cache() :
+        _hits  (0),
+        _misses(0)
+    {
+    }
+
+public:
+    ext::optional<std::string>
+    find(Condition const &condition, std::string const &setting)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto values = _values.find(condition);
+        if (values != _values.end()) {
+            auto value = values->second.find(setting);
+            if (value != values->second.end()) {
+                _hits++;
+                return value->second;
+            }
+        }
+
+        _misses++;
+        return ext::nullopt;
+    }
+
+    void
+    insert(Condition const &condition, std::string const &setting, std::string const &value)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _values[condition].insert({ setting, value });
+    }
+
+public:
+    size_t hits() const
+    { return _hits; }
+    size_t misses() const
+    { return _misses; }
+};
+
 Environment::
 Environment() :
     _offset(0)
@@ -26,12 +82,12 @@ Environment() :
 }
 
 static std::string
-ProcessOperation(std::string const &value, std::string const &operation)
+ProcessOperation(std::string const &value, Value::Program::Operation operation, std::string const &name)
 {
     const std::string alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
     const std::string digits = "0123456789";
 
-    if (operation == "identifier" || operation == "c99extidentifier") {
+    if (operation == Value::Program::Operation::Identifier || operation == Value::Program::Operation::C99ExtIdentifier) {
         // TODO(grp): Support c99extidentifier correctly. Requires Unicode handling.
 
         const std::string begin = alphabet + "_";
@@ -45,7 +101,7 @@ ProcessOperation(std::string const &value, std::string const &operation)
         }
 
         return result;
-    } else if (operation == "rfc1034identifier") {
+    } else if (operation == Value::Program::Operation::RFC1034Identifier) {
         const std::string begin = alphabet;
         const std::string subsequent = alphabet + digits + "-";
         const std::string end = alphabet + digits;
@@ -76,7 +132,7 @@ ProcessOperation(std::string const &value, std::string const &operation)
         }
 
         return result;
-    } else if (operation == "quote") {
+    } else if (operation == Value::Program::Operation::Quote) {
         // FIXME(grp): This is (probably) valid, but not necessarily compatible. Algorithm from Python's shlex.quote().
         if (value.find_first_not_of(alphabet + digits + "@%_-+=:,./") == std::string::npos) {
             return value;
@@ -89,26 +145,26 @@ ProcessOperation(std::string const &value, std::string const &operation)
             }
             return "'" + result + "'";
         }
-    } else if (operation == "lower") {
+    } else if (operation == Value::Program::Operation::Lower) {
         std::string result = value;
         std::transform(result.begin(), result.end(), result.begin(), ::tolower);
         return result;
-    } else if (operation == "upper") {
+    } else if (operation == Value::Program::Operation::Upper) {
         std::string result = value;
         std::transform(result.begin(), result.end(), result.begin(), ::toupper);
         return result;
-    } else if (operation == "standardizepath") {
+    } else if (operation == Value::Program::Operation::StandardizePath) {
         return FSUtil::NormalizePath(value);
-    } else if (operation == "base") {
+    } else if (operation == Value::Program::Operation::Base) {
         return FSUtil::GetBaseNameWithoutExtension(value);
-    } else if (operation == "dir") {
+    } else if (operation == Value::Program::Operation::Dir) {
         return FSUtil::GetDirectoryName(value);
-    } else if (operation == "file") {
+    } else if (operation == Value::Program::Operation::File) {
         return FSUtil::GetBaseName(value);
-    } else if (operation == "suffix") {
+    } else if (operation == Value::Program::Operation::Suffix) {
         return "." + FSUtil::GetFileExtension(value);
     } else {
-        fprintf(stderr, "warning: unknown build setting operation '%s'\n", operation.c_str());
+        fprintf(stderr, "warning: unknown build setting operation '%s'\n", name.c_str());
         return value;
     }
 }
@@ -116,38 +172,50 @@ ProcessOperation(std::string const &value, std::string const &operation)
 std::string Environment::
 resolveValue(Condition const &condition, Value const &value, InheritanceContext const &context) const
 {
+    Value::Program const &program = value.program();
+
     std::string result;
-    for (auto const &entry : value.entries()) {
-        switch (entry.type()) {
-            case Value::Entry::Type::String: {
-                result += *entry.string();
+    for (Value::Program::Instruction const &instruction : program.instructions()) {
+        switch (instruction.type) {
+            case Value::Program::Instruction::Type::Literal: {
+                result.append(program.literals(), instruction.offset, instruction.length);
                 break;
             }
-            case Value::Entry::Type::Value: {
-                std::string resolved = resolveValue(condition, *entry.value(), context);
-                if (context.valid && (resolved == context.setting || resolved == "inherited")) {
+            case Value::Program::Instruction::Type::Reference: {
+                std::string const &setting = program.names()[instruction.index];
+                if (instruction.length == 0 && context.valid && (setting == context.setting || setting == "inherited")) {
                     result += resolveInheritance(condition, context);
-                } else {
-                    std::string setting = resolved;
+                    break;
+                }
 
-                    std::string::size_type colon = resolved.find(':');
-                    if (colon != std::string::npos) {
-                        setting = resolved.substr(0, colon);
-                    }
+                std::string value = resolveAssignment(condition, setting);
+                for (uint32_t i = instruction.offset; i < instruction.offset + instruction.length; ++i) {
+                    value = ProcessOperation(value, program.operations()[i], program.operationNames()[i]);
+                }
 
-                    std::string value = resolveAssignment(condition, setting);
+                result += value;
+                break;
+            }
+            case Value::Program::Instruction::Type::DynamicReference: {
+                std::string resolved = resolveValue(condition, *program.values()[instruction.index], context);
+                if (context.valid && (resolved == context.setting || resolved == "inherited")) {
+                    result += resolveInheritance(condition, context);
+                    break;
+                }
 
-                    while (colon != std::string::npos) {
-                        std::string::size_type next = resolved.find(':', colon + 1);
+                std::string::size_type colon = resolved.find(':');
+                std::string value = resolveAssignment(condition, resolved.substr(0, colon));
 
-                        std::string operation = resolved.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
-                        value = ProcessOperation(value, operation);
+                while (colon != std::string::npos) {
+                    std::string::size_type next = resolved.find(':', colon + 1);
 
-                        colon = next;
-                    }
+                    std::string operation = resolved.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
+                    value = ProcessOperation(value, Value::Program::ParseOperation(operation), operation);
 
-                    result += value;
+                    colon = next;
                 }
+
+                result += value;
                 break;
             }
         }
@@ -160,9 +228,8 @@ resolveInheritance(Condition const &condition, InheritanceContext const &context
 {
     InheritanceContext ctx = context;
     for (++ctx.it; ctx.it != _levels.end(); ++ctx.it) {
-        auto result = ctx.it->get(ctx.setting, condition);
-        if (result.first) {
-            return resolveValue(condition, result.second, ctx);
+        if (Value const *value = ctx.it->find(ctx.setting, condition)) {
+            return resolveValue(condition, *value, ctx);
         }
     }
 
@@ -171,14 +238,29 @@ resolveInheritance(Condition const &condition, InheritanceContext const &context
 
 std::string Environment::
 resolveAssignment(Condition const &condition, std::string const &setting) const
+{
+    if (_cache == nullptr) {
+        return computeAssignment(condition, setting);
+    }
+
+    if (ext::optional<std::string> cached = _cache->find(condition, setting)) {
+        return *cached;
+    }
+
+    std::string value = computeAssignment(condition, setting);
+    _cache->insert(condition, setting, value);
+    return value;
+}
+
+std::string Environment::
+computeAssignment(Condition const &condition, std::string const &setting) const
 {
     InheritanceContext context = { true, setting };
 
     for (context.it = _levels.begin(); context.it != _levels.end(); ++context.it) {
         Level const &level = *context.it;
-        auto result = level.get(setting, condition);
-        if (result.first) {
-            return resolveValue(condition, result.second, context);
+        if (Value const *value = level.find(setting, condition)) {
+            return resolveValue(condition, *value, context);
         }
     }
 
@@ -232,6 +314,10 @@ computeValues(Condition const &condition) const
 void Environment::
 insertFront(Level const &level, bool isDefault)
 {
+    if (_cache != nullptr) {
+        _cache = std::make_shared<Cache>();
+    }
+
     if (!isDefault) {
         _levels.push_front(level);
         ++_offset;
@@ -243,6 +329,10 @@ insertFront(Level const &level, bool isDefault)
 void Environment::
 insertBack(Level const &level, bool isDefault)
 {
+    if (_cache != nullptr) {
+        _cache = std::make_shared<Cache>();
+    }
+
     if (!isDefault) {
         _levels.insert(std::next(_levels.begin(), _offset), level);
         ++_offset;
@@ -251,6 +341,26 @@ insertBack(Level const &level, bool isDefault)
     }
 }
 
+void Environment::
+enableCache()
+{
+    if (_cache == nullptr) {
+        _cache = std::make_shared<Cache>();
+    }
+}
+
+size_t Environment::
+cacheHits() const
+{
+    return (_cache != nullptr ? _cache->hits() : 0);
+}
+
+size_t Environment::
+cacheMisses() const
+{
+    return (_cache != nullptr ? _cache->misses() : 0);
+}
+
 void Environment::
 dump() const
 {
@@ -271,5 +381,12 @@ dump() const
 
         ++offset;
     }
+
+    if (_cache != nullptr) {
+        printf("=== Cache ===\n");
+        printf("Hits: %zu\n", _cache->hits());
+        printf("Misses: %zu\n", _cache->misses());
+        printf("\n");
+    }
 }
 
@@ -0,0 +1,59 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <pbxsetting/FrozenEnvironment.h>
+
+using pbxsetting::FrozenEnvironment;
+using pbxsetting::Environment;
+using pbxsetting::Condition;
+using pbxsetting::Value;
+
+FrozenEnvironment::
+FrozenEnvironment(Environment const &environment) :
+    _environment(environment)
+{
+    _environment.enableCache();
+}
+
+std::string FrozenEnvironment::
+resolve(std::string const &setting, Condition const &condition) const
+{
+    return _environment.resolve(setting, condition);
+}
+
+std::string FrozenEnvironment::
+resolve(std::string const &setting) const
+{
+    return _environment.resolve(setting);
+}
+
+std::string FrozenEnvironment::
+expand(Value const &value, Condition const &condition) const
+{
+    return _environment.expand(value, condition);
+}
+
+std::string FrozenEnvironment::
+expand(Value const &value) const
+{
+    return _environment.expand(value);
+}
+
+std::unordered_map<std::string, std::string> const &FrozenEnvironment::
+computeValues(Condition const &condition) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    auto it = _values.find(condition);
+    if (it == _values.end()) {
+        /* Node-based map, so references to the values stay valid. */
+        it = _values.insert({ condition, _environment.computeValues(condition) }).first;
+    }
+
+    return it->second;
+}
@@ -15,8 +15,13 @@ using pbxsetting::Value;
 
 Level::
 Level(std::vector<Setting> const &settings) :
-    _settings(std::make_shared<std::vector<Setting>>(settings))
+    _settings(std::make_shared<std::vector<Setting>>(settings)),
+    _index   (std::make_shared<std::unordered_map<std::string, std::vector<size_t>>>())
 {
+    _index->reserve(_settings->size());
+    for (size_t i = 0; i < _settings->size(); ++i) {
+        (*_index)[(*_settings)[i].name()].push_back(i);
+    }
 }
 
 Level::
@@ -27,12 +32,28 @@ Level::
 std::pair<bool, Value> Level::
 get(std::string const &setting, Condition const &condition) const
 {
-    for (auto it = _settings->rbegin(); it != _settings->rend(); ++it) {
-        if (it->match(setting, condition)) {
-            return std::make_pair(true, it->value());
-        }
+    if (Value const *value = find(setting, condition)) {
+        return std::make_pair(true, *value);
     }
 
     return std::make_pair(false, Value::Empty());
 }
 
+Value const *Level::
+find(std::string const &setting, Condition const &condition) const
+{
+    auto entry = _index->find(setting);
+    if (entry == _index->end()) {
+        return nullptr;
+    }
+
+    /* Later bindings override earlier ones, so check them first. */
+    for (auto it = entry->second.rbegin(); it != entry->second.rend(); ++it) {
+        Setting const &candidate = (*_settings)[*it];
+        if (candidate.condition().match(condition)) {
+            return &candidate.value();
+        }
+    }
+
+    return nullptr;
+}
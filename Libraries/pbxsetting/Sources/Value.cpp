@@ -53,9 +53,84 @@ operator!=(Entry const &entry) const
     return !(*this == entry);
 }
 
+Value::Program::
+Program(std::vector<Entry> const &entries)
+{
+    for (Entry const &entry : entries) {
+        switch (entry.type()) {
+            case Entry::Type::String: {
+                std::string const &string = *entry.string();
+                _instructions.push_back({ Instruction::Type::Literal, static_cast<uint32_t>(_literals.size()), static_cast<uint32_t>(string.size()), 0 });
+                _literals += string;
+                break;
+            }
+            case Entry::Type::Value: {
+                std::vector<Entry> const &reference = entry.value()->entries();
+                if (reference.size() > 1 || (reference.size() == 1 && reference.front().type() != Entry::Type::String)) {
+                    /* The name depends on other settings, so can only be known when resolving. */
+                    _instructions.push_back({ Instruction::Type::DynamicReference, 0, 0, static_cast<uint32_t>(_values.size()) });
+                    _values.push_back(entry.value());
+                    break;
+                }
+
+                std::string name = (reference.empty() ? std::string() : *reference.front().string());
+                uint32_t offset = static_cast<uint32_t>(_operations.size());
+
+                /* Split off operations, as in $(NAME:operation:operation). */
+                std::string::size_type colon = name.find(':');
+                while (colon != std::string::npos) {
+                    std::string::size_type next = name.find(':', colon + 1);
+
+                    std::string operation = name.substr(colon + 1, next == std::string::npos ? next : next - colon - 1);
+                    _operations.push_back(ParseOperation(operation));
+                    _operationNames.push_back(operation);
+
+                    colon = next;
+                }
+                name = name.substr(0, name.find(':'));
+
+                _instructions.push_back({ Instruction::Type::Reference, offset, static_cast<uint32_t>(_operations.size()) - offset, static_cast<uint32_t>(_names.size()) });
+                _names.push_back(name);
+                break;
+            }
+        }
+    }
+}
+
+Value::Program::Operation Value::Program::
+ParseOperation(std::string const &name)
+{
+    if (name == "identifier") {
+        return Operation::Identifier;
+    } else if (name == "c99extidentifier") {
+        return Operation::C99ExtIdentifier;
+    } else if (name == "rfc1034identifier") {
+        return Operation::RFC1034Identifier;
+    } else if (name == "quote") {
+        return Operation::Quote;
+    } else if (name == "lower") {
+        return Operation::Lower;
+    } else if (name == "upper") {
+        return Operation::Upper;
+    } else if (name == "standardizepath") {
+        return Operation::StandardizePath;
+    } else if (name == "base") {
+        return Operation::Base;
+    } else if (name == "dir") {
+        return Operation::Dir;
+    } else if (name == "file") {
+        return Operation::File;
+    } else if (name == "suffix") {
+        return Operation::Suffix;
+    } else {
+        return Operation::Unknown;
+    }
+}
+
 Value::
 Value(std::vector<Entry> const &entries) :
-    _entries(entries)
+    _entries(entries),
+    _program(std::make_shared<Program>(entries))
 {
 }
 
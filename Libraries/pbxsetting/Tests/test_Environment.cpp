@@ -10,6 +10,7 @@
 #include <pbxsetting/Environment.h>
 
 using pbxsetting::Environment;
+using pbxsetting::Condition;
 using pbxsetting::Level;
 using pbxsetting::Setting;
 using pbxsetting::Value;
@@ -146,6 +147,19 @@ TEST(Environment, Operations)
     EXPECT_EQ(environment.resolve("MULTIPLE"), "___HELLO__");
 }
 
+TEST(Environment, DynamicReference)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("INDEX", "2"),
+        Setting::Parse("NAME_1", "One"),
+        Setting::Parse("NAME_2", "Two"),
+        Setting::Parse("OPERATION", "upper"),
+        Setting::Parse("LIST", "$(NAME_$(INDEX)) $(NAME_$(INDEX):lower) $(NAME_1:$(OPERATION))"),
+    }), false);
+    EXPECT_EQ(env.resolve("LIST"), "Two two ONE");
+}
+
 TEST(Environment, Value)
 {
     Environment env;
@@ -179,3 +193,67 @@ TEST(Environment, Default)
     EXPECT_EQ(env.resolve("THREE"), "3");
 }
 
+
+TEST(Environment, Cache)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("TWO", "$(ONE) two"),
+    }), false);
+    env.enableCache();
+    EXPECT_TRUE(env.cacheEnabled());
+
+    EXPECT_EQ(env.resolve("TWO"), "one two");
+    EXPECT_EQ(env.cacheHits(), 0);
+    EXPECT_EQ(env.cacheMisses(), 2);
+
+    EXPECT_EQ(env.resolve("TWO"), "one two");
+    EXPECT_EQ(env.resolve("ONE"), "one");
+    EXPECT_EQ(env.cacheHits(), 2);
+    EXPECT_EQ(env.cacheMisses(), 2);
+}
+
+TEST(Environment, CacheInvalidation)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+    }), false);
+    env.enableCache();
+    EXPECT_EQ(env.resolve("ONE"), "one");
+
+    /* A copy shares the cache until it changes. */
+    Environment copy = Environment(env);
+    EXPECT_EQ(copy.resolve("ONE"), "one");
+    EXPECT_EQ(copy.cacheHits(), 1);
+
+    copy.insertFront(Level({
+        Setting::Parse("ONE", "1, $(inherited)"),
+    }), false);
+    EXPECT_TRUE(copy.cacheEnabled());
+    EXPECT_EQ(copy.cacheHits(), 0);
+    EXPECT_EQ(copy.resolve("ONE"), "1, one");
+    EXPECT_EQ(env.resolve("ONE"), "one");
+
+    env.insertBack(Level({
+        Setting::Parse("TWO", "two"),
+    }), false);
+    EXPECT_EQ(env.resolve("TWO"), "two");
+}
+
+TEST(Environment, CacheCondition)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("VALUE", "any"),
+        Setting("VALUE", Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos*" } })), Value::String("device")),
+    }), false);
+    env.enableCache();
+
+    Condition device = Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos10.0" } }));
+    EXPECT_EQ(env.resolve("VALUE"), "any");
+    EXPECT_EQ(env.resolve("VALUE", device), "device");
+    EXPECT_EQ(env.resolve("VALUE"), "any");
+    EXPECT_EQ(env.resolve("VALUE", device), "device");
+}
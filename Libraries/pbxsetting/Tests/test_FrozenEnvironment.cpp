@@ -0,0 +1,50 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxsetting/FrozenEnvironment.h>
+
+using pbxsetting::FrozenEnvironment;
+using pbxsetting::Environment;
+using pbxsetting::Condition;
+using pbxsetting::Level;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+
+TEST(FrozenEnvironment, Resolve)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("TWO", "$(ONE) two"),
+    }), false);
+
+    FrozenEnvironment frozen(env);
+    EXPECT_TRUE(frozen.environment().cacheEnabled());
+    EXPECT_EQ(frozen.resolve("TWO"), "one two");
+    EXPECT_EQ(frozen.expand(Value::Parse("$(ONE)-$(TWO)")), "one-one two");
+    EXPECT_GT(frozen.environment().cacheHits(), 0);
+}
+
+TEST(FrozenEnvironment, ComputeValues)
+{
+    Environment env;
+    env.insertBack(Level({
+        Setting::Parse("ONE", "one"),
+        Setting::Parse("TWO", "$(ONE) two"),
+    }), false);
+
+    FrozenEnvironment frozen(env);
+    std::unordered_map<std::string, std::string> const &values = frozen.computeValues(Condition::Empty());
+    EXPECT_EQ(values.size(), 2);
+    EXPECT_EQ(values.at("ONE"), "one");
+    EXPECT_EQ(values.at("TWO"), "one two");
+
+    /* Later calls return the same computed values. */
+    EXPECT_EQ(&frozen.computeValues(Condition::Empty()), &values);
+}
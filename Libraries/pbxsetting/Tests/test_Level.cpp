@@ -0,0 +1,90 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxsetting/Level.h>
+
+using pbxsetting::Level;
+using pbxsetting::Condition;
+using pbxsetting::Setting;
+using pbxsetting::Value;
+
+TEST(Level, Get)
+{
+    Level level = Level({
+        Setting::Create("ONE", "1"),
+        Setting::Create("TWO", "2"),
+    });
+
+    auto one = level.get("ONE", Condition::Empty());
+    EXPECT_TRUE(one.first);
+    EXPECT_EQ("1", one.second.raw());
+
+    auto two = level.get("TWO", Condition::Empty());
+    EXPECT_TRUE(two.first);
+    EXPECT_EQ("2", two.second.raw());
+
+    EXPECT_FALSE(level.get("THREE", Condition::Empty()).first);
+}
+
+TEST(Level, LaterOverrides)
+{
+    Level level = Level({
+        Setting::Create("VALUE", "first"),
+        Setting::Create("OTHER", "other"),
+        Setting::Create("VALUE", "second"),
+    });
+
+    auto value = level.get("VALUE", Condition::Empty());
+    EXPECT_TRUE(value.first);
+    EXPECT_EQ("second", value.second.raw());
+}
+
+TEST(Level, Condition)
+{
+    Level level = Level({
+        Setting::Create("VALUE", "any"),
+        Setting(
+            "VALUE",
+            Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos*" } })),
+            Value::String("device")),
+    });
+
+    Condition device = Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos10.0" } }));
+    Condition simulator = Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphonesimulator10.0" } }));
+
+    EXPECT_EQ("device", level.get("VALUE", device).second.raw());
+    EXPECT_EQ("any", level.get("VALUE", simulator).second.raw());
+    EXPECT_EQ("any", level.get("VALUE", Condition::Empty()).second.raw());
+}
+
+TEST(Level, Copy)
+{
+    Level level = Level({
+        Setting::Create("VALUE", "value"),
+    });
+    Level copy = level;
+
+    EXPECT_EQ(1, copy.settings().size());
+    EXPECT_EQ("value", copy.get("VALUE", Condition::Empty()).second.raw());
+}
+
+TEST(Level, Find)
+{
+    Level level = Level({
+        Setting::Create("VALUE", "first"),
+        Setting::Create("VALUE", "second"),
+    });
+
+    Value const *value = level.find("VALUE", Condition::Empty());
+    ASSERT_NE(nullptr, value);
+    EXPECT_EQ("second", value->raw());
+    EXPECT_EQ(&level.settings().back().value(), value);
+
+    EXPECT_EQ(nullptr, level.find("OTHER", Condition::Empty()));
+}
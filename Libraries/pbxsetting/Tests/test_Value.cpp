@@ -208,3 +208,27 @@ TEST(Value, Add)
     ASSERT_EQ(string_string.entries().at(0).type(), Value::Entry::Type::String);
     EXPECT_EQ(*string_string.entries().at(0).string(), "teststring");
 }
+
+TEST(Value, Program)
+{
+    Value value = Value::Parse("prefix-$(NAME:lower:quote)-$(SUFFIX_$(INDEX))");
+    Value::Program const &program = value.program();
+
+    ASSERT_EQ(program.instructions().size(), 4);
+    EXPECT_EQ(program.instructions().at(0).type, Value::Program::Instruction::Type::Literal);
+    EXPECT_EQ(program.literals().substr(program.instructions().at(0).offset, program.instructions().at(0).length), "prefix-");
+
+    Value::Program::Instruction const &reference = program.instructions().at(1);
+    ASSERT_EQ(reference.type, Value::Program::Instruction::Type::Reference);
+    EXPECT_EQ(program.names().at(reference.index), "NAME");
+    ASSERT_EQ(reference.length, 2);
+    EXPECT_EQ(program.operations().at(reference.offset + 0), Value::Program::Operation::Lower);
+    EXPECT_EQ(program.operations().at(reference.offset + 1), Value::Program::Operation::Quote);
+
+    EXPECT_EQ(program.instructions().at(2).type, Value::Program::Instruction::Type::Literal);
+    EXPECT_EQ(program.literals().substr(program.instructions().at(2).offset, program.instructions().at(2).length), "-");
+
+    Value::Program::Instruction const &dynamic = program.instructions().at(3);
+    ASSERT_EQ(dynamic.type, Value::Program::Instruction::Type::DynamicReference);
+    EXPECT_EQ(program.values().at(dynamic.index)->raw(), "SUFFIX_$(INDEX)");
+}
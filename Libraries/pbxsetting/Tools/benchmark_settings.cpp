@@ -0,0 +1,134 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <pbxsetting/Environment.h>
+#include <pbxsetting/FrozenEnvironment.h>
+#include <pbxsetting/Level.h>
+#include <pbxsetting/Setting.h>
+#include <pbxsetting/Condition.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Resolves every setting in an environment shaped like a typical iOS app
+ * target: a large level of build system and tool defaults, then platform,
+ * SDK, project, configuration file, and target levels that mostly override
+ * or extend the defaults with $(inherited) and conditional settings.
+ */
+
+static std::string
+SettingName(size_t index)
+{
+    return "SETTING_" + std::to_string(index);
+}
+
+static pbxsetting::Level
+CreateLevel(std::string const &label, size_t count, size_t stride, bool inherit, bool conditional)
+{
+    std::vector<pbxsetting::Setting> settings;
+    settings.reserve(count * 2);
+
+    for (size_t i = 0; i < count; i++) {
+        std::string name = SettingName(i * stride);
+
+        if (inherit && i % 3 == 0) {
+            settings.push_back(pbxsetting::Setting::Parse(name, "$(inherited) -" + label + "-" + std::to_string(i)));
+        } else if (i % 5 == 0) {
+            settings.push_back(pbxsetting::Setting::Parse(name, "$(" + SettingName(i * stride + 1) + ")/" + label));
+        } else {
+            settings.push_back(pbxsetting::Setting::Parse(name, label + "-" + std::to_string(i)));
+        }
+
+        if (conditional && i % 7 == 0) {
+            settings.push_back(pbxsetting::Setting(name, pbxsetting::Condition(std::unordered_map<std::string, std::string>({ { "sdk", "iphoneos*" } })), pbxsetting::Value::Parse("$(inherited) -" + label + "-device")));
+            settings.push_back(pbxsetting::Setting(name, pbxsetting::Condition(std::unordered_map<std::string, std::string>({ { "arch", "arm64" } })), pbxsetting::Value::Parse("$(inherited) -" + label + "-arm64")));
+        }
+    }
+
+    return pbxsetting::Level(settings);
+}
+
+static void
+Report(char const *name, size_t count, size_t iterations, double milliseconds)
+{
+    if (iterations == 0) {
+        return;
+    }
+
+    fprintf(stdout, "%s: resolved %zu settings %zu times: %.3f ms per iteration\n", name, count / iterations, iterations, milliseconds / iterations);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t iterations = 20;
+    if (argc > 1) {
+        iterations = static_cast<size_t>(std::strtoul(argv[1], NULL, 10));
+    }
+
+    pbxsetting::Environment environment;
+    environment.insertFront(CreateLevel("defaults", 1600, 1, false, false), true);
+    environment.insertFront(CreateLevel("platform", 250, 5, true, false), false);
+    environment.insertFront(CreateLevel("sdk", 150, 7, true, false), false);
+    environment.insertFront(CreateLevel("project", 120, 11, true, true), false);
+    environment.insertFront(CreateLevel("xcconfig", 200, 3, true, true), false);
+    environment.insertFront(CreateLevel("target", 80, 13, true, true), false);
+    environment.insertFront(CreateLevel("overrides", 4, 17, false, false), false);
+
+    pbxsetting::Condition condition = pbxsetting::Condition(std::unordered_map<std::string, std::string>({
+        { "sdk", "iphoneos10.0" },
+        { "arch", "arm64" },
+        { "variant", "normal" },
+    }));
+
+    /*
+     * Uncached, each resolution walks the levels again.
+     */
+    size_t count = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        count += environment.computeValues(condition).size();
+    }
+    auto end = std::chrono::steady_clock::now();
+    Report("uncached", count, iterations, std::chrono::duration<double, std::milli>(end - start).count());
+
+    /*
+     * Cached, settings shared between computations are only resolved once.
+     */
+    pbxsetting::Environment cached = pbxsetting::Environment(environment);
+    cached.enableCache();
+
+    count = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        count += cached.computeValues(condition).size();
+    }
+    end = std::chrono::steady_clock::now();
+    Report("cached", count, iterations, std::chrono::duration<double, std::milli>(end - start).count());
+    fprintf(stdout, "cache hits: %zu, misses: %zu\n", cached.cacheHits(), cached.cacheMisses());
+
+    /*
+     * Frozen, all values are computed once.
+     */
+    pbxsetting::FrozenEnvironment frozen(environment);
+
+    count = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        count += frozen.computeValues(condition).size();
+    }
+    end = std::chrono::steady_clock::now();
+    Report("frozen", count, iterations, std::chrono::duration<double, std::milli>(end - start).count());
+
+    return 0;
+}
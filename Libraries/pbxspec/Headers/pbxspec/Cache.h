@@ -0,0 +1,102 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __pbxspec_Cache_h
+#define __pbxspec_Cache_h
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <ext/optional>
+
+namespace libutil { class Filesystem; }
+namespace plist { class Array; }
+namespace plist { class Dictionary; }
+
+namespace pbxspec {
+
+/*
+ * The specifications registered for a set of domains, in the order they
+ * were registered, each with the base it inherited from. Stored on disk as
+ * a binary property list, so loading it replaces searching the domains,
+ * parsing each file as text, and resolving inheritance.
+ *
+ * The cache records the modification time of each domain's path, of every
+ * directory searched below it, and of every specification file imported.
+ * It is only used for the same domains, and only if none of those changed:
+ * adding or removing a file modifies its directory, and editing a file in
+ * place modifies the file.
+ */
+class Cache {
+private:
+    std::unique_ptr<plist::Dictionary> _contents;
+
+public:
+    Cache(std::string const &key);
+    ~Cache();
+
+public:
+    Cache(Cache &&other);
+    Cache &operator=(Cache &&other);
+
+private:
+    Cache(std::unique_ptr<plist::Dictionary> contents);
+
+public:
+    /*
+     * The registrations in the cache, in order. Each has the domains and
+     * the specifications registered together.
+     */
+    plist::Array const *
+    registrations() const;
+
+    /*
+     * The paths the specifications in the cache were found from.
+     */
+    std::vector<std::string>
+    paths() const;
+
+    /*
+     * Add the specifications registered together for domains, along with
+     * the modification time of each path they were found from, or none if
+     * the path is missing.
+     */
+    void
+    insert(
+        std::vector<std::string> const &domains,
+        std::vector<std::pair<std::string, ext::optional<uint64_t>>> const &paths,
+        std::unique_ptr<plist::Array> specifications);
+
+public:
+    /*
+     * Write the cache to a path.
+     */
+    bool
+    write(libutil::Filesystem *filesystem, std::string const &path) const;
+
+public:
+    /*
+     * Load a cache from a path. Missing if it does not exist, was written
+     * by an incompatible version or for other domains, or if any path the
+     * specifications were found from has changed since.
+     */
+    static ext::optional<Cache>
+    Load(libutil::Filesystem const *filesystem, std::string const &path, std::string const &key);
+
+public:
+    /*
+     * The key for a cache of registering each list of domains in turn.
+     */
+    static std::string
+    Key(std::vector<std::vector<std::pair<std::string, std::string>>> const &registrations);
+};
+
+}
+
+#endif  // !__pbxspec_Cache_h
@@ -25,23 +25,79 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <unordered_set>
 #include <utility>
 
 namespace libutil { class Filesystem; }
+namespace plist { class Dictionary; }
+namespace plist { class Object; }
 
 namespace pbxspec {
 
+class Cache;
+
 class Manager {
 public:
     typedef std::shared_ptr <Manager> shared_ptr;
 
+public:
+    /*
+     * A specification file found in a domain, read but not yet registered.
+     */
+    struct SpecificationFile {
+        std::string                      domain;
+        std::string                      path;
+        ext::optional<SpecificationType> defaultType;
+        std::unique_ptr<plist::Object>   contents;
+    };
+
+private:
+    /*
+     * A specification registered directly, and what it was created from.
+     */
+    struct RegisteredSpecification {
+        PBX::Specification::shared_ptr   specification;
+        SpecificationFile const         *file;
+        plist::Dictionary const         *contents;
+    };
+
+    /*
+     * A specification registered from a cache. It is created, and inherits
+     * from the base it had when the cache was written, when first found.
+     */
+    struct CachedSpecification {
+        plist::Dictionary const         *contents;
+        std::string                      context;
+        ext::optional<SpecificationType> defaultType;
+        SpecificationType                type;
+        ext::optional<std::string>       baseDomain;
+        ext::optional<std::string>       baseIdentifier;
+        bool                             created;
+        PBX::Specification::shared_ptr   specification;
+    };
+
+    /*
+     * A registered specification, or the cached specification to create.
+     */
+    struct Entry {
+        std::string                      identifier;
+        PBX::Specification::shared_ptr   specification;
+        ext::optional<size_t>            cached;
+    };
+
+private:
+    std::unordered_set<std::string>                                        _domains;
+    std::map<std::string, std::map<SpecificationType, std::vector<Entry>>> _specifications;
+    PBX::BuildRule::vector                                                 _buildRules;
+    std::vector<std::string>                                               _dependencies;
+
 private:
-    std::unordered_set<std::string>                                                _domains;
-    std::map<std::string, std::map<SpecificationType, PBX::Specification::vector>> _specifications;
-    PBX::BuildRule::vector                                                         _buildRules;
+    std::vector<std::shared_ptr<Cache const>>                              _caches;
+    mutable std::vector<CachedSpecification>                               _cached;
+    mutable std::recursive_mutex                                           _cachedMutex;
 
 public:
     Manager();
@@ -125,13 +181,40 @@ public:
     PBX::BuildRule::vector synthesizedBuildRules(std::vector<std::string> const &domains) const;
 
 public:
-    void registerDomains(libutil::Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains);
+    /*
+     * Register the specifications found in each domain's path. If a cache is
+     * provided, the files registered are added to it.
+     */
+    void registerDomains(libutil::Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains, Cache *cache);
+
+    /*
+     * Register the specifications in a cache, as they were registered when
+     * the cache was created. Doesn't access the filesystem. Specifications
+     * are only created from the cached contents when they are first found,
+     * so the cache is kept for as long as the manager.
+     */
+    void registerCache(std::shared_ptr<Cache const> const &cache);
     bool registerBuildRules(libutil::Filesystem const *filesystem, std::string const &path);
 
+public:
+    /*
+     * The files and directories searched and read to register the
+     * specifications and build rules. If none of them have changed,
+     * neither have the specifications.
+     */
+    std::vector<std::string> dependencies() const;
+
 private:
-    void addSpecification(PBX::Specification::shared_ptr const &specification);
+    std::vector<RegisteredSpecification>
+    registerFiles(std::vector<std::string> const &domains, std::vector<SpecificationFile> const &files);
+    bool addSpecification(PBX::Specification::shared_ptr const &specification);
     bool inheritSpecification(PBX::Specification::shared_ptr const &specification, std::vector<PBX::Specification::shared_ptr>);
 
+private:
+    PBX::Specification::shared_ptr resolve(Entry const &entry) const;
+    PBX::Specification::shared_ptr createCached(size_t index) const;
+    Entry const *findEntry(std::string const &domain, SpecificationType type, std::string const &identifier) const;
+
 private:
     template <typename T>
     typename T::shared_ptr
@@ -18,6 +18,7 @@
 #include <ext/optional>
 
 namespace libutil { class Filesystem; }
+namespace plist { class Object; }
 namespace plist { class Dictionary; }
 namespace pbxspec { class Manager; }
 namespace pbxspec { class Context; }
@@ -103,6 +104,15 @@ public:
         std::string const &filename,
         ext::optional<SpecificationType> defaultType = ext::nullopt);
 
+    /*
+     * Creates the specifications from the contents of a specification file.
+     */
+    static ext::optional<Specification::vector> Create(
+        Context *context,
+        std::string const &filename,
+        plist::Object const *plist,
+        ext::optional<SpecificationType> defaultType);
+
 private:
     static Specification::shared_ptr Parse(Context *context, plist::Dictionary const *dict, ext::optional<SpecificationType> defaultType);
 };
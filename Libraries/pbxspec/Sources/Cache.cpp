@@ -0,0 +1,191 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <pbxspec/Cache.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/Object.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
+#include <libutil/Filesystem.h>
+#include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
+
+using pbxspec::Cache;
+using libutil::Filesystem;
+using libutil::FSUtil;
+using libutil::MappedFile;
+
+/*
+ * Increment when the format of the cache or of the cached files changes.
+ */
+static int64_t const CacheVersion = 3;
+
+Cache::
+Cache(std::string const &key) :
+    _contents(plist::Dictionary::New())
+{
+    _contents->set("Version", plist::Integer::New(CacheVersion));
+    _contents->set("Key", plist::String::New(key));
+    _contents->set("Paths", plist::Dictionary::New());
+    _contents->set("Registrations", plist::Array::New());
+}
+
+Cache::
+Cache(std::unique_ptr<plist::Dictionary> contents) :
+    _contents(std::move(contents))
+{
+}
+
+Cache::
+~Cache()
+{
+}
+
+Cache::
+Cache(Cache &&other) = default;
+
+Cache &Cache::
+operator=(Cache &&other) = default;
+
+plist::Array const *Cache::
+registrations() const
+{
+    return _contents->value<plist::Array>("Registrations");
+}
+
+std::vector<std::string> Cache::
+paths() const
+{
+    std::vector<std::string> paths;
+
+    plist::Dictionary const *modificationTimes = _contents->value<plist::Dictionary>("Paths");
+    for (size_t n = 0; n < modificationTimes->count(); n++) {
+        paths.push_back(modificationTimes->key(n));
+    }
+
+    return paths;
+}
+
+void Cache::
+insert(
+    std::vector<std::string> const &domains,
+    std::vector<std::pair<std::string, ext::optional<uint64_t>>> const &paths,
+    std::unique_ptr<plist::Array> specifications)
+{
+    /* A missing path is recorded as such, so the cache is invalid if it appears. */
+    plist::Dictionary *modificationTimes = _contents->value<plist::Dictionary>("Paths");
+    for (std::pair<std::string, ext::optional<uint64_t>> const &path : paths) {
+        modificationTimes->set(path.first, plist::Integer::New(path.second ? static_cast<int64_t>(*path.second) : -1));
+    }
+
+    std::unique_ptr<plist::Array> registrationDomains = plist::Array::New();
+    for (std::string const &domain : domains) {
+        registrationDomains->append(plist::String::New(domain));
+    }
+
+    std::unique_ptr<plist::Dictionary> registration = plist::Dictionary::New();
+    registration->set("Domains", std::move(registrationDomains));
+    registration->set("Specifications", std::move(specifications));
+    _contents->value<plist::Array>("Registrations")->append(std::move(registration));
+}
+
+bool Cache::
+write(Filesystem *filesystem, std::string const &path) const
+{
+    auto serialized = plist::Format::Binary::Serialize(_contents.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr) {
+        fprintf(stderr, "warning: unable to serialize specification cache: %s\n", serialized.second.c_str());
+        return false;
+    }
+
+    if (!filesystem->createDirectory(FSUtil::GetDirectoryName(path), true)) {
+        return false;
+    }
+
+    /* Other builds may have the cache mapped; don't change it under them. */
+    return filesystem->replace(*serialized.first, path);
+}
+
+ext::optional<Cache> Cache::
+Load(Filesystem const *filesystem, std::string const &path, std::string const &key)
+{
+    if (!filesystem->isReadable(path)) {
+        return ext::nullopt;
+    }
+
+    std::unique_ptr<MappedFile> contents = filesystem->map(path);
+    if (contents == nullptr) {
+        return ext::nullopt;
+    }
+
+    auto deserialized = plist::Format::Binary::Deserialize(contents->data(), contents->size(), plist::Format::Binary::Create());
+    if (deserialized.first == nullptr) {
+        return ext::nullopt;
+    }
+
+    plist::Dictionary const *root = plist::CastTo<plist::Dictionary>(deserialized.first.get());
+    if (root == nullptr) {
+        return ext::nullopt;
+    }
+
+    plist::Integer const *version = root->value<plist::Integer>("Version");
+    if (version == nullptr || version->value() != CacheVersion) {
+        return ext::nullopt;
+    }
+
+    plist::String const *cacheKey = root->value<plist::String>("Key");
+    if (cacheKey == nullptr || cacheKey->value() != key) {
+        return ext::nullopt;
+    }
+
+    plist::Dictionary const *paths = root->value<plist::Dictionary>("Paths");
+    if (paths == nullptr || root->value<plist::Array>("Registrations") == nullptr) {
+        return ext::nullopt;
+    }
+
+    /*
+     * Every directory searched and file imported is recorded, so any change
+     * to what registering the domains would find is noticed here.
+     */
+    for (size_t n = 0; n < paths->count(); n++) {
+        plist::Integer const *modificationTime = paths->value<plist::Integer>(n);
+        if (modificationTime == nullptr) {
+            return ext::nullopt;
+        }
+
+        ext::optional<uint64_t> expected;
+        if (modificationTime->value() >= 0) {
+            expected = static_cast<uint64_t>(modificationTime->value());
+        }
+
+        if (filesystem->modificationTime(paths->key(n)) != expected) {
+            return ext::nullopt;
+        }
+    }
+
+    /*
+     * Use the deserialized property list as is, rather than copying each
+     * entry out of it; it is already in the format the cache is written in.
+     */
+    return Cache(plist::static_unique_pointer_cast<plist::Dictionary>(std::move(deserialized.first)));
+}
+
+std::string Cache::
+Key(std::vector<std::vector<std::pair<std::string, std::string>>> const &registrations)
+{
+    std::string key;
+    for (std::vector<std::pair<std::string, std::string>> const &domains : registrations) {
+        for (std::pair<std::string, std::string> const &domain : domains) {
+            key += domain.first + "=" + domain.second + "\n";
+        }
+        key += "\n";
+    }
+    return key;
+}
@@ -7,15 +7,18 @@
  */
 
 #include <pbxspec/Manager.h>
+#include <pbxspec/Cache.h>
 #include <pbxspec/Context.h>
 #include <plist/Array.h>
 #include <plist/Dictionary.h>
 #include <plist/Object.h>
+#include <plist/String.h>
 #include <plist/Format/Any.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 
 using pbxspec::Manager;
+using pbxspec::Cache;
 using pbxspec::Context;
 using pbxspec::SpecificationType;
 using pbxspec::SpecificationTypes;
@@ -39,25 +42,26 @@ findSpecifications(std::vector<std::string> const &domains, SpecificationType ty
 {
     typename T::vector specifications;
 
+    auto add = [&](std::map<SpecificationType, std::vector<Entry>> const &types) {
+        auto const &it = types.find(type);
+        if (it != types.end()) {
+            for (Entry const &entry : it->second) {
+                if (PBX::Specification::shared_ptr specification = resolve(entry)) {
+                    specifications.emplace_back(std::static_pointer_cast<T>(specification));
+                }
+            }
+        }
+    };
+
     for (std::string const &domain : domains) {
         if (domain == AnyDomain()) {
             for (auto const &entry : _specifications) {
-                auto const &it = entry.second.find(type);
-                if (it != entry.second.end()) {
-                    for (auto const &s : it->second) {
-                        specifications.emplace_back(std::static_pointer_cast<T>(s));
-                    }
-                }
+                add(entry.second);
             }
         } else {
             auto const &doit = _specifications.find(domain);
             if (doit != _specifications.end()) {
-                auto const &it = doit->second.find(type);
-                if (it != doit->second.end()) {
-                    for (auto const &s : it->second) {
-                        specifications.emplace_back(std::static_pointer_cast<T>(s));
-                    }
-                }
+                add(doit->second);
             }
         }
     }
@@ -69,19 +73,115 @@ template <typename T>
 typename T::shared_ptr Manager::
 findSpecification(std::vector<std::string> const &domains, std::string const &identifier, SpecificationType type) const
 {
-    typename T::vector vector = findSpecifications <T> (domains, type);
+    /*
+     * Search by identifier before resolving, so only the specification found
+     * is created if it was registered from a cache.
+     */
+    auto find = [&](std::map<SpecificationType, std::vector<Entry>> const &types) -> PBX::Specification::shared_ptr {
+        auto const &it = types.find(type);
+        if (it != types.end()) {
+            for (Entry const &entry : it->second) {
+                if (entry.identifier == identifier) {
+                    if (PBX::Specification::shared_ptr specification = resolve(entry)) {
+                        return specification;
+                    }
+                }
+            }
+        }
 
-    auto I = std::find_if(vector.begin(), vector.end(), [&identifier](PBX::Specification::shared_ptr const &spec) -> bool {
-        return identifier == spec->identifier();
-    });
+        return nullptr;
+    };
 
-    if (I != vector.end()) {
-        return *I;
+    for (std::string const &domain : domains) {
+        if (domain == AnyDomain()) {
+            for (auto const &entry : _specifications) {
+                if (PBX::Specification::shared_ptr specification = find(entry.second)) {
+                    return std::static_pointer_cast<T>(specification);
+                }
+            }
+        } else {
+            auto const &doit = _specifications.find(domain);
+            if (doit != _specifications.end()) {
+                if (PBX::Specification::shared_ptr specification = find(doit->second)) {
+                    return std::static_pointer_cast<T>(specification);
+                }
+            }
+        }
     }
 
     return nullptr;
 }
 
+Manager::Entry const *Manager::
+findEntry(std::string const &domain, SpecificationType type, std::string const &identifier) const
+{
+    auto const &doit = _specifications.find(domain);
+    if (doit == _specifications.end()) {
+        return nullptr;
+    }
+
+    auto const &it = doit->second.find(type);
+    if (it == doit->second.end()) {
+        return nullptr;
+    }
+
+    for (Entry const &entry : it->second) {
+        if (entry.identifier == identifier) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+PBX::Specification::shared_ptr Manager::
+resolve(Entry const &entry) const
+{
+    if (entry.cached) {
+        return createCached(*entry.cached);
+    }
+
+    return entry.specification;
+}
+
+PBX::Specification::shared_ptr Manager::
+createCached(size_t index) const
+{
+    std::lock_guard<std::recursive_mutex> lock(_cachedMutex);
+
+    CachedSpecification &cached = _cached[index];
+    if (cached.created) {
+        return cached.specification;
+    }
+
+    /* Marked first, so a cycle in the cache can't recurse forever. */
+    cached.created = true;
+
+    Context context;
+    context.domain = cached.context;
+
+    PBX::Specification::shared_ptr specification = PBX::Specification::Parse(&context, cached.contents, cached.defaultType);
+    if (specification == nullptr) {
+        return nullptr;
+    }
+
+    /*
+     * Inherit from the base found when the cache was written, rather than
+     * searching for it again, so the result is the same as registering the
+     * specification directly. The base is created first, with its own base.
+     */
+    if (cached.baseDomain && cached.baseIdentifier) {
+        Entry const *baseEntry = findEntry(*cached.baseDomain, cached.type, *cached.baseIdentifier);
+        PBX::Specification::shared_ptr base = (baseEntry != nullptr ? resolve(*baseEntry) : nullptr);
+        if (base == nullptr || !specification->inherit(base)) {
+            fprintf(stderr, "error: could not inherit from base %s specification '%s:%s'\n", SpecificationTypes::Name(cached.type).c_str(), cached.baseDomain->c_str(), cached.baseIdentifier->c_str());
+        }
+    }
+
+    cached.specification = specification;
+    return specification;
+}
+
 PBX::Specification::shared_ptr Manager::
 specification(SpecificationType type, std::string const &identifier, std::vector<std::string> const &domains) const
 {
@@ -255,32 +355,33 @@ synthesizedBuildRules(std::vector<std::string> const &domains) const
     return buildRules;
 }
 
-void Manager::
+bool Manager::
 addSpecification(PBX::Specification::shared_ptr const &spec)
 {
     if (spec == nullptr) {
         fprintf(stderr, "error: registering null specification\n");
-        return;
+        return false;
     }
 
-    if (auto ospec = specification(spec->type(), spec->identifier(), { spec->domain() })) {
+    if (findEntry(spec->domain(), spec->type(), spec->identifier()) != nullptr) {
         /*
          * Workaround for a typo in the default specifications; don't warn.
          */
         if (spec->identifier() == "PlatformStandardUniversal") {
-            return;
+            return false;
         }
 
         fprintf(stderr, "error: registering %s specification '%s' in domain %s twice\n",
                 SpecificationTypes::Name(spec->type()).c_str(), spec->identifier().c_str(), spec->domain().c_str());
-        return;
+        return false;
     }
 
 #if 0
     fprintf(stderr, "adding %s spec to domain %s '%s'\n",
             spec->type(), spec->domain().c_str(), spec->identifier().c_str());
 #endif
-    _specifications[spec->domain()][spec->type()].push_back(spec);
+    _specifications[spec->domain()][spec->type()].push_back({ spec->identifier(), spec, ext::nullopt });
+    return true;
 }
 
 bool Manager::
@@ -360,10 +461,85 @@ inheritSpecification(PBX::Specification::shared_ptr const &specification, std::v
     return true;
 }
 
+static void
+AddSpecificationFile(Filesystem const *filesystem, std::vector<Manager::SpecificationFile> *files, std::string const &domain, std::string const &path, ext::optional<SpecificationType> defaultType)
+{
+#if 0
+    fprintf(stderr, "importing specification '%s'\n", path.c_str());
+#endif
+
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, path)) {
+        fprintf(stderr, "warning: failed to import specification '%s'\n", path.c_str());
+        return;
+    }
+
+    std::unique_ptr<plist::Object> plist = plist::Format::Any::Deserialize(contents).first;
+    if (plist == nullptr) {
+        fprintf(stderr, "warning: failed to import specification '%s'\n", path.c_str());
+        return;
+    }
+
+    files->push_back({ domain, path, defaultType, std::move(plist) });
+}
+
+/*
+ * Parse the specification files for a domain at a path. Each directory
+ * searched and each file imported is added to the paths, with the time it
+ * was last modified, so a cache of the files can tell if any changed.
+ */
+static void
+FindSpecificationFiles(Filesystem const *filesystem, std::vector<Manager::SpecificationFile> *files, std::vector<std::pair<std::string, ext::optional<uint64_t>>> *paths, std::string const &domain, std::string const &realPath)
+{
+    ext::optional<Filesystem::Type> type = filesystem->type(realPath);
+    if (!type) {
+        return;
+    }
+
+    switch (*type) {
+        case Filesystem::Type::Directory: {
+            paths->push_back({ realPath, filesystem->modificationTime(realPath) });
+
+            filesystem->readDirectory(realPath, true, [&](std::string const &filename) -> bool {
+                std::string path = realPath + "/" + filename;
+
+                /* Adding or removing a file below a directory only modifies the directory. */
+                if (filesystem->type(path) == Filesystem::Type::Directory) {
+                    paths->push_back({ path, filesystem->modificationTime(path) });
+                    return true;
+                }
+
+                /* Support both *.xcspec and *.pbfilespec as a few of the latter remain in use. */
+                if (FSUtil::GetFileExtension(path) != "xcspec" && FSUtil::GetFileExtension(path) != "pbfilespec") {
+                    return true;
+                }
+
+                /* For *.pbfilespec files, default to FileType specifications. */
+                ext::optional<SpecificationType> defaultType;
+                if (FSUtil::GetFileExtension(path) == "pbfilespec") {
+                    defaultType = SpecificationType::FileType;
+                }
+
+                paths->push_back({ path, filesystem->modificationTime(path) });
+                AddSpecificationFile(filesystem, files, domain, path, defaultType);
+                return true;
+            });
+            break;
+        }
+        case Filesystem::Type::SymbolicLink:
+        case Filesystem::Type::File: {
+            paths->push_back({ realPath, filesystem->modificationTime(realPath) });
+            AddSpecificationFile(filesystem, files, domain, realPath, ext::nullopt);
+            break;
+        }
+    }
+}
+
 void Manager::
-registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains)
+registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string, std::string>> const &domains, Cache *cache)
 {
-    PBX::Specification::vector specifications;
+    std::vector<SpecificationFile> files;
+    std::vector<std::pair<std::string, ext::optional<uint64_t>>> paths;
 
     for (auto const &domain : domains) {
         /*
@@ -373,65 +549,161 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
             continue;
         }
 
-        Context context;
-        context.domain = domain.first;
+        /* Missing paths are cached too, in case they appear later. */
+        paths.push_back({ domain.second, filesystem->modificationTime(domain.second) });
 
         std::string realPath = filesystem->resolvePath(domain.second);
         if (realPath.empty()) {
             continue;
         }
 
-        ext::optional<Filesystem::Type> type = filesystem->type(realPath);
-        if (!type) {
+        FindSpecificationFiles(filesystem, &files, &paths, domain.first, realPath);
+    }
+
+    std::vector<std::string> names;
+    for (auto const &domain : domains) {
+        names.push_back(domain.first);
+    }
+
+    std::vector<RegisteredSpecification> registered = registerFiles(names, files);
+
+    if (cache != nullptr) {
+        /*
+         * Cache each specification registered with the base it inherited
+         * from. Bases are always registered specifications, and those are
+         * unique by domain, type, and identifier.
+         */
+        std::unique_ptr<plist::Array> specifications = plist::Array::New();
+        for (RegisteredSpecification const &registration : registered) {
+            PBX::Specification::shared_ptr const &specification = registration.specification;
+
+            std::unique_ptr<plist::Dictionary> entry = plist::Dictionary::New();
+            entry->set("Context", plist::String::New(registration.file->domain));
+            if (registration.file->defaultType) {
+                entry->set("DefaultType", plist::String::New(SpecificationTypes::Name(*registration.file->defaultType)));
+            }
+            entry->set("Domain", plist::String::New(specification->domain()));
+            entry->set("Type", plist::String::New(SpecificationTypes::Name(specification->type())));
+            entry->set("Identifier", plist::String::New(specification->identifier()));
+            if (PBX::Specification::shared_ptr const &base = specification->base()) {
+                entry->set("BaseDomain", plist::String::New(base->domain()));
+                entry->set("BaseIdentifier", plist::String::New(base->identifier()));
+            }
+            entry->set("Contents", registration.contents->copy());
+            specifications->append(std::move(entry));
+        }
+
+        cache->insert(names, paths, std::move(specifications));
+    }
+
+    for (auto const &path : paths) {
+        _dependencies.push_back(path.first);
+    }
+}
+
+void Manager::
+registerCache(std::shared_ptr<Cache const> const &cache)
+{
+    std::lock_guard<std::recursive_mutex> lock(_cachedMutex);
+
+    /* The cached specifications refer to the cache's contents. */
+    _caches.push_back(cache);
+
+    std::vector<std::string> paths = cache->paths();
+    _dependencies.insert(_dependencies.end(), paths.begin(), paths.end());
+
+    plist::Array const *registrations = cache->registrations();
+    for (size_t n = 0; n < registrations->count(); n++) {
+        plist::Dictionary const *registration = registrations->value<plist::Dictionary>(n);
+        if (registration == nullptr) {
             continue;
         }
 
-        switch (*type) {
-            case Filesystem::Type::Directory: {
-                filesystem->readDirectory(realPath, true, [&](std::string const &filename) -> bool {
-                    std::string path = realPath + "/" + filename;
+        plist::Array const *domains = registration->value<plist::Array>("Domains");
+        plist::Array const *specifications = registration->value<plist::Array>("Specifications");
+        if (domains == nullptr || specifications == nullptr) {
+            continue;
+        }
 
-                    /* Support both *.xcspec and *.pbfilespec as a few of the latter remain in use. */
-                    if (FSUtil::GetFileExtension(path) != "xcspec" && FSUtil::GetFileExtension(path) != "pbfilespec") {
-                        return true;
-                    }
+        for (size_t m = 0; m < domains->count(); m++) {
+            if (plist::String const *domain = domains->value<plist::String>(m)) {
+                _domains.insert(domain->value());
+            }
+        }
 
-                    /* For *.pbfilespec files, default to FileType specifications. */
-                    ext::optional<SpecificationType> defaultType;
-                    if (FSUtil::GetFileExtension(path) == "pbfilespec") {
-                        defaultType = SpecificationType::FileType;
-                    }
+        /*
+         * Add in the same order as when the cache was created. Nothing is
+         * created until it is found.
+         */
+        for (size_t m = 0; m < specifications->count(); m++) {
+            plist::Dictionary const *entry = specifications->value<plist::Dictionary>(m);
+            if (entry == nullptr) {
+                continue;
+            }
 
-                    if (filesystem->type(path) != Filesystem::Type::Directory) {
-#if 0
-                        fprintf(stderr, "importing specification '%s'\n", path.c_str());
-#endif
+            plist::String const *context = entry->value<plist::String>("Context");
+            plist::String const *domain = entry->value<plist::String>("Domain");
+            plist::String const *type = entry->value<plist::String>("Type");
+            plist::String const *identifier = entry->value<plist::String>("Identifier");
+            plist::Dictionary const *contents = entry->value<plist::Dictionary>("Contents");
+            if (context == nullptr || domain == nullptr || type == nullptr || identifier == nullptr || contents == nullptr) {
+                continue;
+            }
 
-                        ext::optional<PBX::Specification::vector> fileSpecifications = PBX::Specification::Open(filesystem, &context, path, defaultType);
-                        if (fileSpecifications) {
-                            specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
-                        } else {
-                            fprintf(stderr, "warning: failed to import specification '%s'\n", path.c_str());
-                        }
-                    }
-                    return true;
-                });
-                break;
+            ext::optional<SpecificationType> parsedType = SpecificationTypes::Parse(type->value());
+            if (!parsedType) {
+                continue;
             }
-            case Filesystem::Type::SymbolicLink:
-            case Filesystem::Type::File: {
-#if 0
-                fprintf(stderr, "importing specification '%s'\n", realPath.c_str());
-#endif
-                ext::optional<PBX::Specification::vector> fileSpecifications = PBX::Specification::Open(filesystem, &context, realPath);
-                if (fileSpecifications) {
-                    specifications.insert(specifications.end(), fileSpecifications->begin(), fileSpecifications->end());
-                } else {
-                    fprintf(stderr, "warning: failed to import specification '%s'\n", realPath.c_str());
-                }
-                break;
+
+            CachedSpecification cached;
+            cached.contents = contents;
+            cached.context = context->value();
+            if (plist::String const *defaultType = entry->value<plist::String>("DefaultType")) {
+                cached.defaultType = SpecificationTypes::Parse(defaultType->value());
+            }
+            cached.type = *parsedType;
+            if (plist::String const *baseDomain = entry->value<plist::String>("BaseDomain")) {
+                cached.baseDomain = baseDomain->value();
+            }
+            if (plist::String const *baseIdentifier = entry->value<plist::String>("BaseIdentifier")) {
+                cached.baseIdentifier = baseIdentifier->value();
+            }
+            cached.created = false;
+            _cached.push_back(std::move(cached));
+
+            _specifications[domain->value()][*parsedType].push_back({ identifier->value(), nullptr, _cached.size() - 1 });
+        }
+    }
+}
+
+std::vector<Manager::RegisteredSpecification> Manager::
+registerFiles(std::vector<std::string> const &domains, std::vector<SpecificationFile> const &files)
+{
+    std::vector<RegisteredSpecification> specifications;
+
+    for (SpecificationFile const &file : files) {
+        Context context;
+        context.domain = file.domain;
+
+        ext::optional<PBX::Specification::vector> fileSpecifications = PBX::Specification::Create(&context, file.path, file.contents.get(), file.defaultType);
+        if (!fileSpecifications) {
+            fprintf(stderr, "warning: failed to import specification '%s'\n", file.path.c_str());
+            continue;
+        }
+
+        /* Each specification was created from one dictionary, in order. */
+        std::vector<plist::Dictionary const *> contents;
+        if (plist::Dictionary const *dictionary = plist::CastTo<plist::Dictionary>(file.contents.get())) {
+            contents.push_back(dictionary);
+        } else if (plist::Array const *array = plist::CastTo<plist::Array>(file.contents.get())) {
+            for (size_t n = 0; n < array->count(); n++) {
+                contents.push_back(array->value<plist::Dictionary>(n));
             }
         }
+
+        for (size_t n = 0; n < fileSpecifications->size() && n < contents.size(); n++) {
+            specifications.push_back({ fileSpecifications->at(n), &file, contents[n] });
+        }
     }
 
     /*
@@ -439,33 +711,46 @@ registerDomains(Filesystem const *filesystem, std::vector<std::pair<std::string,
      * same domain can be registered multiple times (loaded from multiple paths)
      * in a single registration, but can't be registered twice outside that.
      */
-    for (auto const &domain : domains) {
-        _domains.insert(domain.first);
+    for (std::string const &domain : domains) {
+        _domains.insert(domain);
     }
 
     /*
      * Register all specifications. Must be before inheritance in case specifications
      * inherit from other specifications also being registered at the same time.
      */
-    for (PBX::Specification::shared_ptr const &specification : specifications) {
-        addSpecification(specification);
+    std::vector<RegisteredSpecification> registered;
+    for (RegisteredSpecification const &specification : specifications) {
+        if (addSpecification(specification.specification)) {
+            registered.push_back(specification);
+        }
     }
 
     /*
      * Inherit from existing and newly added specifications.
      */
-    for (PBX::Specification::shared_ptr const &specification : specifications) {
-        std::vector<PBX::Specification::shared_ptr> visited { specification };
-        if (!inheritSpecification(specification, visited)) {
+    for (RegisteredSpecification const &specification : specifications) {
+        std::vector<PBX::Specification::shared_ptr> visited { specification.specification };
+        if (!inheritSpecification(specification.specification, visited)) {
             /* Unfortunately, not much useful error handling to do here. */
             continue;
         }
     }
+
+    return registered;
+}
+
+std::vector<std::string> Manager::
+dependencies() const
+{
+    return _dependencies;
 }
 
 bool Manager::
 registerBuildRules(Filesystem const *filesystem, std::string const &path)
 {
+    _dependencies.push_back(path);
+
     std::vector<uint8_t> contents;
     if (!filesystem->read(&contents, path)) {
         return false;
@@ -227,18 +227,24 @@ Open(Filesystem const *filesystem, Context *context, std::string const &filename
         return ext::nullopt;
     }
 
+    return Create(context, filename, plist.get(), defaultType);
+}
+
+ext::optional<Specification::vector> Specification::
+Create(Context *context, std::string const &filename, plist::Object const *plist, ext::optional<SpecificationType> defaultType)
+{
     //
     // If this is a dictionary, then it's a single specification,
     // if it's an array then multiple specifications are present.
     //
-    if (auto dict = plist::CastTo <plist::Dictionary> (plist.get())) {
+    if (auto dict = plist::CastTo <plist::Dictionary> (plist)) {
         if (auto spec = Parse(context, dict, defaultType)) {
             return Specification::vector({ spec });
         } else {
             fprintf(stderr, "error: single specification failed to parse\n");
             return ext::nullopt;
         }
-    } else if (auto array = plist::CastTo <plist::Array> (plist.get())) {
+    } else if (auto array = plist::CastTo <plist::Array> (plist)) {
         size_t errors = 0;
         Specification::vector specifications;
 
@@ -0,0 +1,129 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <pbxspec/Manager.h>
+#include <pbxspec/Cache.h>
+#include <libutil/MemoryFilesystem.h>
+
+#include <algorithm>
+
+using pbxspec::Manager;
+using pbxspec::Cache;
+using libutil::MemoryFilesystem;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+static MemoryFilesystem
+SpecificationFilesystem()
+{
+    return MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Specifications", {
+            MemoryFilesystem::Entry::File("text.xcspec", Contents("{ Type = FileType; Identifier = text; Extensions = ( txt ); }")),
+            MemoryFilesystem::Entry::Directory("Source", {
+                MemoryFilesystem::Entry::File("source.xcspec", Contents("{ Type = FileType; Identifier = source; BasedOn = text; }")),
+            }),
+            MemoryFilesystem::Entry::File("ignored.plist", Contents("{ Type = FileType; Identifier = ignored; }")),
+        }),
+    });
+}
+
+TEST(Manager, RegisterDomains)
+{
+    auto filesystem = SpecificationFilesystem();
+
+    Manager::shared_ptr manager = Manager::Create();
+    manager->registerDomains(&filesystem, { { "default", filesystem.path("Specifications") } }, nullptr);
+
+    EXPECT_NE(nullptr, manager->fileType("text", { "default" }));
+    EXPECT_EQ(nullptr, manager->fileType("ignored", { "default" }));
+
+    /* Inherited from the base specification. */
+    pbxspec::PBX::FileType::shared_ptr source = manager->fileType("source", { "default" });
+    ASSERT_NE(nullptr, source);
+    ASSERT_NE(nullptr, source->base());
+    EXPECT_EQ("text", source->base()->identifier());
+
+    /* Everything searched and read is a dependency. */
+    std::vector<std::string> dependencies = manager->dependencies();
+    EXPECT_NE(dependencies.end(), std::find(dependencies.begin(), dependencies.end(), filesystem.path("Specifications/Source")));
+    EXPECT_NE(dependencies.end(), std::find(dependencies.begin(), dependencies.end(), filesystem.path("Specifications/Source/source.xcspec")));
+}
+
+TEST(Manager, Cache)
+{
+    auto filesystem = SpecificationFilesystem();
+    std::vector<std::pair<std::string, std::string>> domains = { { "default", filesystem.path("Specifications") } };
+    std::vector<std::pair<std::string, std::string>> missing = { { "missing", filesystem.path("Missing") } };
+    std::string key = Cache::Key({ domains, missing });
+
+    /* Cold, the registered specifications are added to the cache. */
+    Cache cache = Cache(key);
+    Manager::shared_ptr cold = Manager::Create();
+    cold->registerDomains(&filesystem, domains, &cache);
+    cold->registerDomains(&filesystem, missing, &cache);
+    EXPECT_NE(nullptr, cold->fileType("source", { "default" }));
+    ASSERT_TRUE(cache.write(&filesystem, filesystem.path("Cache/specifications.cache")));
+
+    /* Warm, the specifications are registered from the cache unchanged, and created when found. */
+    ext::optional<Cache> loaded = Cache::Load(&filesystem, filesystem.path("Cache/specifications.cache"), key);
+    ASSERT_NE(ext::nullopt, loaded);
+    Manager::shared_ptr warm = Manager::Create();
+    warm->registerCache(std::make_shared<Cache const>(std::move(*loaded)));
+    EXPECT_NE(nullptr, warm->fileType("text", { "default" }));
+    EXPECT_EQ(nullptr, warm->fileType("ignored", { "default" }));
+    ASSERT_NE(nullptr, warm->fileType("source", { "default" }));
+    ASSERT_NE(nullptr, warm->fileType("source", { "default" })->base());
+    EXPECT_EQ("text", warm->fileType("source", { "default" })->base()->identifier());
+    EXPECT_EQ(warm->fileType("text", { "default" }), warm->fileType("source", { "default" })->base());
+    EXPECT_EQ(2u, warm->fileTypes({ "default" }).size());
+
+    /* The dependencies are the same as when the cache was created. */
+    std::vector<std::string> coldDependencies = cold->dependencies();
+    std::vector<std::string> warmDependencies = warm->dependencies();
+    std::sort(coldDependencies.begin(), coldDependencies.end());
+    std::sort(warmDependencies.begin(), warmDependencies.end());
+    coldDependencies.erase(std::unique(coldDependencies.begin(), coldDependencies.end()), coldDependencies.end());
+    EXPECT_EQ(coldDependencies, warmDependencies);
+
+    /* Other domains don't use the cache. */
+    EXPECT_EQ(ext::nullopt, Cache::Load(&filesystem, filesystem.path("Cache/specifications.cache"), Cache::Key({ domains })));
+
+    /* Adding a specification invalidates the cache. */
+    ASSERT_TRUE(filesystem.write(Contents("{ Type = FileType; Identifier = header; BasedOn = source; }"), filesystem.path("Specifications/header.xcspec")));
+    EXPECT_EQ(ext::nullopt, Cache::Load(&filesystem, filesystem.path("Cache/specifications.cache"), key));
+
+    auto recreate = [&]() {
+        Cache updated = Cache(key);
+        Manager::shared_ptr manager = Manager::Create();
+        manager->registerDomains(&filesystem, domains, &updated);
+        manager->registerDomains(&filesystem, missing, &updated);
+        EXPECT_TRUE(updated.write(&filesystem, filesystem.path("Cache/specifications.cache")));
+        EXPECT_NE(ext::nullopt, Cache::Load(&filesystem, filesystem.path("Cache/specifications.cache"), key));
+        return manager;
+    };
+    EXPECT_NE(nullptr, recreate()->fileType("header", { "default" }));
+
+    /* Adding a specification in a nested directory invalidates the cache. */
+    ASSERT_TRUE(filesystem.write(Contents("{ Type = FileType; Identifier = nested; BasedOn = source; }"), filesystem.path("Specifications/Source/nested.xcspec")));
+    EXPECT_EQ(ext::nullopt, Cache::Load(&filesystem, filesystem.path("Cache/specifications.cache"), key));
+    EXPECT_NE(nullptr, recreate()->fileType("nested", { "default" }));
+
+    /* Editing a specification in place invalidates the cache. */
+    ASSERT_TRUE(filesystem.write(Contents("{ Type = FileType; Identifier = text; Extensions = ( text ); }"), filesystem.path("Specifications/text.xcspec")));
+    EXPECT_EQ(ext::nullopt, Cache::Load(&filesystem, filesystem.path("Cache/specifications.cache"), key));
+    recreate();
+
+    /* A domain's path appearing invalidates the cache. */
+    ASSERT_TRUE(filesystem.createDirectory(filesystem.path("Missing"), true));
+    EXPECT_EQ(ext::nullopt, Cache::Load(&filesystem, filesystem.path("Cache/specifications.cache"), key));
+}
@@ -28,7 +28,7 @@ main(int argc, char **argv)
 
     std::string path = argv[1];
     Manager::shared_ptr manager = Manager::Create();
-    manager->registerDomains(&filesystem, { { "xcspec", path } });
+    manager->registerDomains(&filesystem, { { "xcspec", path } }, nullptr);
 
     return 0;
 }
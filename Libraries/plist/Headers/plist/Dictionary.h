@@ -12,16 +12,27 @@
 #include <plist/Base.h>
 #include <plist/Object.h>
 
-#include <algorithm>
+#include <iterator>
+#include <string>
 #include <vector>
-#include <unordered_map>
 
 namespace plist {
 
 class Dictionary : public Object {
 private:
-    std::vector<std::string>                                 _keys;
-    std::unordered_map<std::string, std::unique_ptr<Object>> _map;
+    struct Entry {
+        std::string             key;
+        std::unique_ptr<Object> value;
+    };
+
+private:
+    /*
+     * Entries are kept in order, each storing its key once. Dictionaries
+     * with more than a few entries also have an index: an open addressed
+     * table of entry positions (offset by one, zero is empty) by key hash.
+     */
+    std::vector<Entry>  _entries;
+    std::vector<size_t> _index;
 
 public:
     Dictionary()
@@ -39,27 +50,27 @@ public:
 public:
     inline bool empty() const
     {
-        return _map.empty();
+        return _entries.empty();
     }
 
     inline size_t count() const
     {
-        return _map.size();
+        return _entries.size();
     }
 
     inline std::string const &key(size_t index) const
     {
-        return _keys[index];
+        return _entries[index].key;
     }
 
     inline Object const *value(size_t index) const
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].value.get() : nullptr;
     }
 
     inline Object *value(size_t index)
     {
-        return (index < _keys.size()) ? value(_keys[index]) : nullptr;
+        return (index < _entries.size()) ? _entries[index].value.get() : nullptr;
     }
 
     template <typename T>
@@ -76,14 +87,12 @@ public:
 
     inline Object const *value(std::string const &key) const
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        return value(find(key));
     }
 
     inline Object *value(std::string const &key)
     {
-        auto it = _map.find(key);
-        return (it != _map.end() ? it->second.get() : nullptr);
+        return value(find(key));
     }
 
     template <typename T>
@@ -98,40 +107,72 @@ public:
         return CastTo <T> (value(key));
     }
 
+private:
+    /*
+     * The position of a key, or the count if not present.
+     */
+    size_t find(std::string const &key) const;
+
+    void insertIndex(size_t index);
+    void rebuildIndex();
+
 public:
     inline void clear()
     {
-        _keys.clear();
-        _map.clear();
+        _entries.clear();
+        _index.clear();
     }
 
 public:
-    inline void set(std::string const &key, std::unique_ptr<Object> obj)
-    {
-        remove(key);
-        _keys.push_back(key);
-        _map.insert(std::make_pair(key, std::move(obj)));
-    }
+    void set(std::string const &key, std::unique_ptr<Object> obj);
+    void remove(std::string const &key);
 
-    inline void remove(std::string const &key)
-    {
-        auto it = _map.find(key);
-
-        if (it != _map.end()) {
-            _map.erase(it);
-            _keys.erase(std::find(_keys.begin(), _keys.end(), key));
+public:
+    /*
+     * Iterates the keys, in order.
+     */
+    class const_iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::string               value_type;
+        typedef std::ptrdiff_t            difference_type;
+        typedef std::string const        *pointer;
+        typedef std::string const        &reference;
+
+    private:
+        std::vector<Entry>::const_iterator _it;
+
+    public:
+        explicit const_iterator(std::vector<Entry>::const_iterator it) :
+            _it(it)
+        {
         }
-    }
 
-public:
-    inline std::vector<std::string>::const_iterator begin() const
+    public:
+        inline reference operator*() const
+        { return _it->key; }
+        inline pointer operator->() const
+        { return &_it->key; }
+
+        inline const_iterator &operator++()
+        { ++_it; return *this; }
+        inline const_iterator operator++(int)
+        { const_iterator prev = *this; ++_it; return prev; }
+
+        inline bool operator==(const_iterator const &other) const
+        { return _it == other._it; }
+        inline bool operator!=(const_iterator const &other) const
+        { return _it != other._it; }
+    };
+
+    inline const_iterator begin() const
     {
-        return _keys.begin();
+        return const_iterator(_entries.begin());
     }
 
-    inline std::vector<std::string>::const_iterator end() const
+    inline const_iterator end() const
     {
-        return _keys.end();
+        return const_iterator(_entries.end());
     }
 
 public:
@@ -173,8 +214,8 @@ public:
         if (count() != obj->count())
             return false;
 
-        for (auto const &it : _map) {
-            if (!value(it.first)->equals(obj->value(it.first)))
+        for (Entry const &entry : _entries) {
+            if (!entry.value->equals(obj->value(entry.key)))
                 return false;
         }
 
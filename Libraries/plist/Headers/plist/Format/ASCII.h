@@ -13,6 +13,8 @@
 #include <plist/Format/Type.h>
 #include <plist/Format/Encoding.h>
 
+#include <functional>
+
 namespace plist {
 namespace Format {
 
@@ -35,6 +37,16 @@ public:
 
 public:
     static ASCII Create(bool strings, Encoding encoding);
+
+public:
+    using Format<ASCII>::Serialize;
+
+    /*
+     * Serialize the values the producer passes to the visitor it is given,
+     * writing them to the sink as they arrive. No objects are built.
+     */
+    static std::pair<bool, std::string>
+    Serialize(std::function<bool(Visitor *)> const &producer, ASCII const &format, Sink const &sink);
 };
 
 }
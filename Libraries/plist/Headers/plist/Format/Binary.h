@@ -24,6 +24,36 @@ public:
 
 public:
     static Binary Create();
+
+public:
+    using Format<Binary>::Identify;
+
+    /*
+     * Identify contents already in memory, such as a mapped file.
+     */
+    static std::unique_ptr<Binary>
+    Identify(uint8_t const *data, size_t size);
+
+public:
+    using Format<Binary>::Deserialize;
+
+    /*
+     * Deserialize from contents already in memory, such as a mapped file,
+     * without copying them first. The contents are only used until this
+     * returns.
+     */
+    static std::pair<std::unique_ptr<Object>, std::string>
+    Deserialize(uint8_t const *data, size_t size, Binary const &format);
+
+public:
+    using Format<Binary>::Visit;
+
+    /*
+     * Visit contents already in memory. Objects referenced more than once
+     * are visited each time they are referenced.
+     */
+    static std::pair<bool, std::string>
+    Visit(uint8_t const *data, size_t size, Binary const &format, Visitor *visitor);
 };
 
 }
@@ -0,0 +1,113 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __plist_Format_BinaryDocument_h
+#define __plist_Format_BinaryDocument_h
+
+#include <plist/Object.h>
+#include <plist/ObjectType.h>
+#include <plist/String.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ABPReader;
+
+namespace plist {
+namespace Format {
+
+/*
+ * A binary property list, read on demand. Objects are identified by their
+ * reference, their index in the offset table. Arrays and dictionaries are
+ * read only as far as the references they contain; the objects those refer
+ * to are read when they are looked up. Looking up a few values in a large
+ * property list reads just those values and the collections leading to them.
+ *
+ * The contents must outlive the document.
+ */
+class BinaryDocument {
+public:
+    typedef uint64_t Reference;
+
+private:
+    std::unique_ptr<ABPReader>                                _reader;
+    std::unordered_map<Reference, std::vector<Reference>>    _references;
+
+private:
+    explicit BinaryDocument(std::unique_ptr<ABPReader> reader);
+
+public:
+    ~BinaryDocument();
+
+public:
+    /*
+     * The top level object.
+     */
+    Reference root() const;
+
+    /*
+     * The type of an object, without reading it. None if the reference is
+     * not valid.
+     */
+    ObjectType type(Reference reference);
+
+    /*
+     * The number of values in an array or dictionary. Zero for other types.
+     */
+    size_t count(Reference reference);
+
+public:
+    /*
+     * Look up a value in an array by index.
+     */
+    bool value(Reference array, size_t index, Reference *value);
+
+    /*
+     * Look up a value in a dictionary by key. Keys in binary property lists
+     * are not sorted, so this compares against each key in turn; only the
+     * keys are read, not the values before the one found.
+     */
+    bool value(Reference dictionary, std::string const &key, Reference *value);
+
+    /*
+     * The key at an index in a dictionary.
+     */
+    bool key(Reference dictionary, size_t index, std::string *key);
+
+public:
+    /*
+     * Read an object, and everything it contains, as a copy owned by the
+     * caller. To read the whole document, Binary::Deserialize is faster.
+     */
+    std::unique_ptr<Object> object(Reference reference);
+
+public:
+    /*
+     * A description of the last error.
+     */
+    std::string const &error() const;
+
+private:
+    std::vector<Reference> const *references(Reference reference);
+    String const *readKey(Reference reference);
+
+public:
+    /*
+     * Open a document from contents in memory, such as a mapped file.
+     * Only the header, trailer, and offset table are read.
+     */
+    static std::pair<std::unique_ptr<BinaryDocument>, std::string>
+    Open(uint8_t const *data, size_t size);
+};
+
+}
+}
+
+#endif  // !__plist_Format_BinaryDocument_h
@@ -0,0 +1,146 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __plist_Format_Document_h
+#define __plist_Format_Document_h
+
+#include <plist/Object.h>
+#include <plist/ObjectType.h>
+
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * A property list read into memory owned by the document, rather than into
+ * objects each allocated on their own. Values are allocated one after the
+ * other in large blocks, the values in an array or dictionary next to each
+ * other. Each distinct dictionary key is stored once, however many
+ * dictionaries use it. Nothing in the document has a destructor to run, so
+ * freeing it only frees the blocks.
+ *
+ * Values can't be changed once read. Copy a value out into objects to keep
+ * or change it.
+ */
+class Document {
+private:
+    class Builder;
+
+public:
+    /*
+     * A value in the document. Valid for as long as the document is.
+     */
+    class Node {
+    private:
+        ObjectType              _type;
+        uint32_t                _count;
+        union {
+            int64_t             integer;
+            double              real;
+            bool                boolean;
+            uint32_t            uid;
+            char const         *string;
+            uint8_t const      *data;
+            struct tm const    *date;
+            Node const         *values;
+        }                       _value;
+        Node const * const     *_keys;
+
+    private:
+        friend class Document;
+        friend class Document::Builder;
+
+    public:
+        inline ObjectType type() const
+        { return _type; }
+
+    public:
+        /*
+         * The number of values in an array or dictionary. Zero for other types.
+         */
+        size_t count() const;
+
+        /*
+         * The value at an index in an array or dictionary.
+         */
+        Node const *value(size_t index) const;
+
+        /*
+         * The key at an index in a dictionary; it is a string.
+         */
+        Node const *key(size_t index) const;
+
+        /*
+         * Look up a value in a dictionary by key. If a key is repeated, the
+         * last value for it is found, as when building a dictionary.
+         */
+        Node const *value(std::string const &key) const;
+
+    public:
+        /*
+         * Scalar values. Each is empty, or zero, for values of other types.
+         */
+        std::string string() const;
+        int64_t integer() const;
+        double real() const;
+        bool boolean() const;
+        uint32_t uid() const;
+        std::vector<uint8_t> data() const;
+        struct tm date() const;
+
+        /*
+         * If this is a string with the value, without copying it out.
+         */
+        bool equals(std::string const &value) const;
+
+    public:
+        /*
+         * Copy the value, and everything it contains, into objects owned by
+         * the caller.
+         */
+        std::unique_ptr<Object> object() const;
+    };
+
+private:
+    std::vector<std::unique_ptr<uint8_t[]>> _blocks;
+    uint8_t                                *_next;
+    size_t                                  _available;
+    Node const                             *_root;
+
+private:
+    Document();
+
+public:
+    ~Document();
+
+public:
+    /*
+     * The top level value.
+     */
+    inline Node const *root() const
+    { return _root; }
+
+private:
+    void *allocate(size_t size, size_t alignment);
+
+public:
+    /*
+     * Read a binary, XML, or ASCII property list into a document.
+     */
+    static std::pair<std::unique_ptr<Document>, std::string>
+    Deserialize(std::vector<uint8_t> const &contents);
+};
+
+}
+}
+
+#endif  // !__plist_Format_Document_h
@@ -12,11 +12,20 @@
 #include <plist/Base.h>
 #include <plist/Object.h>
 
+#include <functional>
 #include <vector>
 
 namespace plist {
 namespace Format {
 
+class Visitor;
+
+/*
+ * Receives serialized contents in parts, in order. Returns false to stop
+ * serializing.
+ */
+typedef std::function<bool(uint8_t const *data, size_t size)> Sink;
+
 template<typename T>
 class Format {
 protected:
@@ -42,9 +51,24 @@ public:
         return Deserialize(contents, *format);
     }
 
+public:
+    /*
+     * Read the contents into a visitor, without building objects. Only as
+     * much is kept as is needed to check the structure of the contents.
+     */
+    static std::pair<bool, std::string>
+    Visit(std::vector<uint8_t> const &contents, T const &format, Visitor *visitor);
+
 public:
     static std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string>
     Serialize(Object const *object, T const &format);
+
+    /*
+     * Serialize into a sink as the output is written, rather than into a
+     * buffer holding all of it.
+     */
+    static std::pair<bool, std::string>
+    Serialize(Object const *object, T const &format, Sink const &sink);
 };
 
 }
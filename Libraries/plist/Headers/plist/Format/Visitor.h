@@ -0,0 +1,66 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __plist_Format_Visitor_h
+#define __plist_Format_Visitor_h
+
+#include <plist/Base.h>
+#include <plist/Object.h>
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Receives the contents of a property list as it is read, in document order,
+ * instead of building objects from them. Each value in a dictionary follows
+ * its key; the values in an array or dictionary are between its begin and
+ * end. Nothing passed to a visitor is kept after the call returns.
+ *
+ * Returning false from any of these stops reading, which then fails. The
+ * default implementations accept and ignore everything, so a visitor only
+ * needs to implement what it is interested in.
+ */
+class Visitor {
+public:
+    Visitor();
+    virtual ~Visitor();
+
+public:
+    virtual bool beginArray();
+    virtual bool endArray();
+
+public:
+    virtual bool beginDictionary();
+    virtual bool key(std::string const &key);
+    virtual bool endDictionary();
+
+public:
+    virtual bool string(std::string const &value);
+    virtual bool integer(int64_t value);
+    virtual bool real(double value);
+    virtual bool boolean(bool value);
+    virtual bool null();
+    virtual bool data(std::vector<uint8_t> const &value);
+    virtual bool date(struct tm const &value);
+    virtual bool uid(uint32_t value);
+
+public:
+    /*
+     * Visit an object already in memory, and everything it contains.
+     */
+    static bool Visit(Object const *object, Visitor *visitor);
+};
+
+}
+}
+
+#endif  // !__plist_Format_Visitor_h
@@ -20,16 +20,20 @@ protected:
     unsigned                    _flags;
     abplist_header_t            _header;
     abplist_trailer_t           _trailer;
-    uint64_t                   *_offsets;
 
 protected:
     off_t                       _offset;
-    std::vector<uint8_t> const *_contents;
 
 protected:
-    ABPContext(std::vector<uint8_t> const *contents);
+    ABPContext();
     ~ABPContext();
 
+protected:
+    /*
+     * The size of the contents being read or written.
+     */
+    virtual size_t contentsSize() const = 0;
+
 protected:
     off_t seek(off_t offset, int whence);
     off_t tell();
@@ -10,21 +10,35 @@
 #define __plist_Format_ABPReader_h
 
 #include <plist/Format/ABPContext.h>
+#include <plist/Format/ABPRecordType.h>
+#include <plist/Format/Visitor.h>
 #include <plist/Objects.h>
 
 #include <string>
-#include <unordered_set>
+#include <vector>
 
+/*
+ * Reads directly from the contents, which must outlive the reader. Strings
+ * and data are copied once, from the contents into the objects read.
+ */
 class ABPReader : public ABPContext {
+public:
+    uint8_t const                        *_data;
+    size_t                                _size;
+    size_t                                _offsetTable;
+
 public:
     plist::Object                       **_objects;
-    std::unordered_set<plist::Object *>   _seen;
+    std::vector<bool>                     _taken;
     std::string                           _error;
 
 public:
-    ABPReader(std::vector<uint8_t> const *contents);
+    ABPReader(uint8_t const *data, size_t size);
     ~ABPReader();
 
+protected:
+    virtual size_t contentsSize() const;
+
 public:
     bool open();
     bool close();
@@ -32,6 +46,35 @@ public:
     plist::Object *readTopLevelObject();
     plist::Object *readObject(uint64_t reference);
 
+    uint64_t topLevelReference() const
+    { return _trailer.topLevelObject; }
+
+    /*
+     * Take ownership of an object that was read, by its reference. Each
+     * object is owned by the reader until it is first taken; taking it
+     * again returns a copy.
+     */
+    plist::Object *take(uint64_t reference);
+    plist::Object *takeTopLevelObject();
+
+    /*
+     * Read the type of an object, without reading the object.
+     */
+    ABPRecordType readRecordType(uint64_t reference);
+
+    /*
+     * Read the references in an array or dictionary, without reading the
+     * objects they refer to. A dictionary's keys come before its values.
+     */
+    bool readReferences(uint64_t reference, std::vector<uint64_t> *references);
+
+    /*
+     * Visit an object and everything it contains. Each value is read as it
+     * is visited and released after; nothing read is kept, including the
+     * references in arrays and dictionaries.
+     */
+    bool visit(uint64_t reference, plist::Format::Visitor *visitor);
+
 public:
     std::string const &error() const
     { return _error; }
@@ -40,6 +83,8 @@ private:
     void error(std::string const &error);
 
 private:
+    uint8_t const *consume(size_t length);
+    int readMarker(uint64_t reference);
     int read(void *data, size_t length);
     int readByte();
     bool readWord(size_t nbytes, uint64_t *result);
@@ -51,6 +96,14 @@ private:
     bool readTrailer();
     bool readOffsetTable();
     bool readReference(uint64_t *offset);
+    bool seekObject(uint64_t reference);
+    bool fitsReferences(size_t nrefs);
+
+private:
+    bool visit(uint64_t reference, plist::Format::Visitor *visitor, std::vector<uint64_t> *path);
+    bool visitCollection(uint64_t reference, int marker, plist::Format::Visitor *visitor, std::vector<uint64_t> *path);
+    bool visitKey(uint64_t reference, plist::Format::Visitor *visitor);
+    bool visitValue(uint64_t reference, plist::Format::Visitor *visitor);
 
 private:
     plist::Object *_readObject();
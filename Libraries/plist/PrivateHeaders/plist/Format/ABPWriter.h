@@ -11,25 +11,75 @@
 
 #include <plist/Format/ABPContext.h>
 #include <plist/Format/ABPRecordType.h>
+#include <plist/Format/Format.h>
 #include <plist/Objects.h>
 
+#include <string>
 #include <vector>
 #include <unordered_map>
-#include <unordered_set>
 
+/*
+ * Writes binary property lists. The object tree is walked once to number
+ * each object, uniquing equal values by content; objects are then written
+ * in that order, so references have their final size from the start.
+ */
 class ABPWriter : public ABPContext {
 private:
-    std::unordered_map<plist::Object const *, int>                   _references;
-    std::unordered_map<plist::Object const *, plist::Object const *> _mappings;
-    std::unordered_set<plist::Object const *>                        _written;
-    std::unordered_map<plist::Dictionary const *, std::unordered_map<int, plist::String *>> _keyStrings;
+    /*
+     * A value, for uniquing: scalars by value, others by their bytes.
+     */
+    struct Value {
+        plist::ObjectType  type;
+        uint64_t           scalar;
+        void const        *data;
+        size_t             size;
+    };
+
+    struct ValueHash {
+        size_t operator()(Value const &value) const;
+    };
+
+    struct ValueEqual {
+        bool operator()(Value const &lhs, Value const &rhs) const;
+    };
+
+    /*
+     * An object to write, in reference order. Dictionary keys aren't
+     * objects, so are written from their string. Containers list their
+     * children's references in `_childReferences` from `children`.
+     */
+    struct Record {
+        plist::Object const *object;
+        std::string const   *key;
+        size_t               children;
+    };
+
+private:
+    std::vector<Record>                                         _records;
+    std::vector<uint64_t>                                       _childReferences;
+    std::unordered_map<Value, uint64_t, ValueHash, ValueEqual>  _values;
+    std::vector<uint64_t>                                       _offsets;
 
 public:
-    std::vector<uint8_t>                                            *_mutableContents;
+    std::vector<uint8_t>                                       *_mutableContents;
+
+private:
+    plist::Format::Sink                                         _sink;
+    std::vector<uint8_t>                                        _buffer;
+    size_t                                                      _flushed;
 
 public:
     ABPWriter(std::vector<uint8_t> *contents);
 
+    /*
+     * Write to a sink. Written parts are passed to the sink once they
+     * reach a bounded size, and when the writer is closed.
+     */
+    ABPWriter(plist::Format::Sink const &sink);
+
+protected:
+    virtual size_t contentsSize() const;
+
 public:
     bool open();
     bool finalize();
@@ -40,6 +90,9 @@ public:
 public:
     int write(void const *data, size_t length);
 
+private:
+    bool flush(bool final);
+
 private:
     bool writeByte(uint8_t byte);
     bool writeWord0(size_t nbytes, uint64_t value, bool swap);
@@ -54,7 +107,11 @@ private:
     bool writeOffsetTable();
 
 private:
-    bool writeObject(plist::Object const *object, uint32_t flags);
+    uint64_t flattenString(std::string const *string);
+    uint64_t flattenObject(plist::Object const *object);
+
+private:
+    bool writeRecord(Record const &record);
     bool writeNull(plist::Null const *null);
     bool writeBool(plist::Boolean const *boolean);
     bool writeDate(plist::Date const *date);
@@ -64,24 +121,9 @@ private:
     bool writeUID(plist::UID const *uid);
     bool writeStringASCII(char const *chars, size_t nchars);
     bool writeStringUnicode(uint16_t const *chars, size_t nchars);
-    bool writeString(plist::String const *string);
-    plist::String const *dictionaryKeyString(plist::Dictionary const *dict, int key);
-    void writeArrayReferences(plist::Array const *array);
-    void writeArrayValues(plist::Array const *array);
-    bool writeArray(plist::Array const *array);
-    void writeDictionaryReferences(plist::Dictionary const *dict);
-    void writeDictionaryValues(plist::Dictionary const *dict);
-    bool writeDictionary(plist::Dictionary const *dict);
-
-private:
-    bool writePreflightObject(plist::Object const *object, uint32_t flags);
-    void writePreflightArrayReferences(plist::Array const *array);
-    bool writePreflightArray(plist::Array const *array);
-    void writePreflightDictionaryReferences(plist::Dictionary const *dict);
-    bool writePreflightDictionary(plist::Dictionary const *dict);
-
-private:
-    bool processObject(plist::Object const **object, uint32_t *refno, bool userProcess);
+    bool writeString(std::string const &string);
+    bool writeArray(plist::Array const *array, size_t children);
+    bool writeDictionary(plist::Dictionary const *dict, size_t children);
 };
 
 #endif  /* !__plist_Format_ABPWriter_h */
@@ -23,6 +23,7 @@ typedef struct ASCIIPListLexer {
     int         line;
     int         tokenBegin;
     int         tokenLength;
+    int         vectorized; /* scan 16 bytes at a time, where supported */
 } ASCIIPListLexer;
 
 enum {
@@ -9,29 +9,46 @@
 #ifndef __plist_Format_ASCIIWriter_h
 #define __plist_Format_ASCIIWriter_h
 
-#include <plist/Objects.h>
+#include <plist/Format/Format.h>
+#include <plist/Format/Visitor.h>
 
 namespace plist {
 namespace Format {
 
-class ASCIIWriter {
+/*
+ * Writes the contents it visits as ASCII, as they are visited. Nothing is
+ * kept but the output not yet passed to the sink and the open collections.
+ */
+class ASCIIWriter : public Visitor {
+private:
+    struct Collection {
+        bool   dictionary;
+        bool   root;
+        size_t count;
+    };
+
 private:
-    Object const         *_root;
-    bool                  _strings;
-    std::vector<uint8_t>  _contents;
-    int                   _indent;
-    bool                  _lastKey;
+    bool                     _strings;
+    Sink                     _sink;
+    std::vector<uint8_t>     _contents;
+    int                      _indent;
+    bool                     _lastKey;
+    std::vector<Collection>  _collections;
+    bool                     _written;
 
 public:
-    ASCIIWriter(Object const *root, bool strings);
+    ASCIIWriter(bool strings, Sink const &sink);
     ~ASCIIWriter();
 
 public:
-    std::vector<uint8_t> contents() const
-    { return _contents; }
+    /*
+     * Finish writing once the root has been visited, passing the rest of
+     * the output to the sink. Parts are passed in bounded sizes.
+     */
+    bool finish();
 
-public:
-    bool write();
+private:
+    bool flush(bool final);
 
 private:
     bool primitiveWriteString(std::string const &string);
@@ -42,16 +59,28 @@ private:
     bool writeEscapedString(std::string const &string, bool final);
 
 private:
-    bool handleObject(Object const *object, bool root);
-    bool handleArray(Array const *array, bool root);
-    bool handleDictionary(Dictionary const *dictionary, bool root);
-    bool handleBoolean(Boolean const *boolean, bool root);
-    bool handleReal(Real const *real, bool root);
-    bool handleInteger(Integer const *integer, bool root);
-    bool handleString(String const *string, bool root);
-    bool handleDate(Date const *date, bool root);
-    bool handleData(Data const *data, bool root);
-    bool handleUID(UID const *uid, bool root);
+    bool beginValue();
+    bool endValue();
+    bool writeValue(std::string const &string, bool escaped);
+
+public:
+    virtual bool beginArray();
+    virtual bool endArray();
+
+public:
+    virtual bool beginDictionary();
+    virtual bool key(std::string const &key);
+    virtual bool endDictionary();
+
+public:
+    virtual bool string(std::string const &value);
+    virtual bool integer(int64_t value);
+    virtual bool real(double value);
+    virtual bool boolean(bool value);
+    virtual bool null();
+    virtual bool data(std::vector<uint8_t> const &value);
+    virtual bool date(struct tm const &value);
+    virtual bool uid(uint32_t value);
 };
 
 }
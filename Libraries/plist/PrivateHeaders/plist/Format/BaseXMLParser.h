@@ -42,6 +42,7 @@ public:
 
 protected:
     bool parse(std::vector<uint8_t> const &contents);
+    bool parse(uint8_t const *data, size_t size);
 
 protected:
     virtual void onBeginParse();
@@ -54,6 +55,8 @@ protected:
 
 protected:
     void error(std::string format, ...);
+    bool errored() const
+    { return _errored; }
 };
 
 }
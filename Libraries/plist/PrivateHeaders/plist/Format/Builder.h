@@ -0,0 +1,73 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#ifndef __plist_Format_Builder_h
+#define __plist_Format_Builder_h
+
+#include <plist/Format/Visitor.h>
+#include <plist/Object.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace plist {
+namespace Format {
+
+/*
+ * Builds objects from what is visited. The parsers deserialize with this;
+ * they check the structure is valid before visiting.
+ */
+class Builder : public Visitor {
+private:
+    struct Container {
+        std::unique_ptr<Object> object;
+        std::string             key;
+    };
+
+private:
+    std::unique_ptr<Object> _root;
+    std::vector<Container>  _stack;
+
+public:
+    Builder();
+    ~Builder();
+
+public:
+    std::unique_ptr<Object> &root()
+    { return _root; }
+
+public:
+    virtual bool beginArray();
+    virtual bool endArray();
+
+public:
+    virtual bool beginDictionary();
+    virtual bool key(std::string const &key);
+    virtual bool endDictionary();
+
+public:
+    virtual bool string(std::string const &value);
+    virtual bool integer(int64_t value);
+    virtual bool real(double value);
+    virtual bool boolean(bool value);
+    virtual bool null();
+    virtual bool data(std::vector<uint8_t> const &value);
+    virtual bool date(struct tm const &value);
+    virtual bool uid(uint32_t value);
+
+private:
+    bool begin(std::unique_ptr<Object> container);
+    bool end();
+    bool store(std::unique_ptr<Object> value);
+};
+
+}
+}
+
+#endif  // !__plist_Format_Builder_h
@@ -9,6 +9,7 @@
 #ifndef __plist_Format_JSONWriter_h
 #define __plist_Format_JSONWriter_h
 
+#include <plist/Format/Format.h>
 #include <plist/Objects.h>
 
 namespace plist {
@@ -17,21 +18,24 @@ namespace Format {
 class JSONWriter {
 private:
     Object const         *_root;
+    Sink                  _sink;
     std::vector<uint8_t>  _contents;
     int                   _indent;
     bool                  _lastKey;
 
 public:
-    JSONWriter(Object const *root);
+    JSONWriter(Object const *root, Sink const &sink);
     ~JSONWriter();
 
 public:
-    std::vector<uint8_t> contents() const
-    { return _contents; }
-
-public:
+    /*
+     * Write the root object to the sink, in parts of bounded size.
+     */
     bool write();
 
+private:
+    bool flush(bool final);
+
 private:
     bool primitiveWriteString(std::string const &string);
     bool primitiveWriteEscapedString(std::string const &string);
@@ -10,37 +10,59 @@
 #define __plist_Format_XMLParser_h
 
 #include <plist/Format/BaseXMLParser.h>
-#include <plist/Object.h>
+#include <plist/Format/Visitor.h>
 
 namespace plist {
 namespace Format {
 
 class XMLParser : public BaseXMLParser {
 private:
-    struct Key {
-        std::string value;
-        bool        valid;
-        bool        active;
+    enum class Element {
+        Array,
+        Dictionary,
+        String,
+        Integer,
+        Real,
+        Boolean,
+        Null,
+        Data,
+        Date,
+        Key,
     };
 
     struct State {
         typedef std::vector <State> vector;
 
-        Object *current;
-        Key     key;
+        Element element;
+        bool    key;
+    };
+
+    /*
+     * Dictionaries with just a CF$UID integer are UIDs. So the visitor sees
+     * a UID, a dictionary is only visited once it is known not to be one.
+     */
+    enum class Pending {
+        None,
+        Dictionary,
+        Key,
+        Value,
     };
 
 private:
-    Object        *_root;
+    Visitor       *_visitor;
+    bool           _root;
     State::vector  _stack;
-    State          _state;
     std::string    _cdata;
 
+private:
+    Pending        _pending;
+    int64_t        _pendingValue;
+
 public:
-    XMLParser();
+    explicit XMLParser(Visitor *visitor);
 
 public:
-    Object *parse(std::vector<uint8_t> const &contents);
+    bool parse(uint8_t const *data, size_t size);
 
 private:
     virtual void onBeginParse();
@@ -52,7 +74,7 @@ private:
     void onCharacterData(std::string const &cdata, size_t depth);
 
 private:
-    void push(Object *object);
+    void push(Element element);
     void pop();
 
 private:
@@ -62,17 +84,15 @@ private:
     inline bool isExpectingKey() const;
     inline bool isExpectingCDATA() const;
 
+private:
+    bool visited(bool result);
+    bool flush();
+
 private:
     bool beginObject(std::string const &name, size_t depth);
     bool beginArray();
     bool beginDictionary();
-    bool beginString();
-    bool beginInteger();
-    bool beginReal();
-    bool beginBoolean(bool value);
-    bool beginNull();
-    bool beginData();
-    bool beginDate();
+    bool beginValue(Element element);
     bool beginKey();
 
 private:
@@ -82,7 +102,7 @@ private:
     bool endString();
     bool endInteger();
     bool endReal();
-    bool endBoolean();
+    bool endBoolean(bool value);
     bool endNull();
     bool endData();
     bool endDate();
@@ -10,6 +10,7 @@
 #define __plist_Format_XMLWriter_h
 
 #include <plist/Format/BaseXMLParser.h>
+#include <plist/Format/Format.h>
 #include <plist/Objects.h>
 
 namespace plist {
@@ -18,20 +19,23 @@ namespace Format {
 class XMLWriter {
 private:
     Object const         *_root;
+    Sink                  _sink;
     std::vector<uint8_t>  _contents;
     int                   _indent;
 
 public:
-    XMLWriter(Object const *root);
+    XMLWriter(Object const *root, Sink const &sink);
     ~XMLWriter();
 
 public:
-    std::vector<uint8_t> contents() const
-    { return _contents; }
-
-public:
+    /*
+     * Write the root object to the sink, in parts of bounded size.
+     */
     bool write();
 
+private:
+    bool flush(bool final);
+
 private:
     bool primitiveWriteString(std::string const &string);
     bool primitiveWriteEscapedString(std::string const &string);
@@ -8,15 +8,114 @@
 
 #include <plist/Dictionary.h>
 
+#include <functional>
+
 using plist::Object;
 using plist::Dictionary;
 
+/*
+ * Smaller dictionaries are searched in order, which is faster than hashing
+ * each key looked up.
+ */
+static size_t const IndexThreshold = 8;
+
 std::unique_ptr<Dictionary> Dictionary::
 New()
 {
     return std::unique_ptr<Dictionary>(new Dictionary());
 }
 
+size_t Dictionary::
+find(std::string const &key) const
+{
+    if (_index.empty()) {
+        for (size_t n = 0; n < _entries.size(); n++) {
+            if (_entries[n].key == key) {
+                return n;
+            }
+        }
+
+        return _entries.size();
+    }
+
+    size_t mask = _index.size() - 1;
+    for (size_t slot = std::hash<std::string>()(key) & mask; _index[slot] != 0; slot = (slot + 1) & mask) {
+        if (_entries[_index[slot] - 1].key == key) {
+            return _index[slot] - 1;
+        }
+    }
+
+    return _entries.size();
+}
+
+void Dictionary::
+insertIndex(size_t index)
+{
+    size_t mask = _index.size() - 1;
+    size_t slot = std::hash<std::string>()(_entries[index].key) & mask;
+    while (_index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+
+    _index[slot] = index + 1;
+}
+
+void Dictionary::
+rebuildIndex()
+{
+    _index.clear();
+    if (_entries.size() <= IndexThreshold) {
+        return;
+    }
+
+    /*
+     * Start at most a quarter full, and rebuild once half full. That keeps
+     * probe sequences short, and rebuilding amortized over the insertions.
+     */
+    size_t size = 1;
+    while (size < _entries.size() * 4) {
+        size <<= 1;
+    }
+
+    _index.assign(size, 0);
+    for (size_t n = 0; n < _entries.size(); n++) {
+        insertIndex(n);
+    }
+}
+
+void Dictionary::
+set(std::string const &key, std::unique_ptr<Object> obj)
+{
+    remove(key);
+
+    /* Most dictionaries are small; skip growing one entry at a time. */
+    if (_entries.capacity() == 0) {
+        _entries.reserve(4);
+    }
+    _entries.push_back(Entry { key, std::move(obj) });
+
+    if (!_index.empty() && _entries.size() * 2 <= _index.size()) {
+        insertIndex(_entries.size() - 1);
+    } else if (_entries.size() > IndexThreshold) {
+        rebuildIndex();
+    }
+}
+
+void Dictionary::
+remove(std::string const &key)
+{
+    size_t index = find(key);
+    if (index == _entries.size()) {
+        return;
+    }
+
+    /* Later entries move down, so their positions in the index change. */
+    _entries.erase(_entries.begin() + index);
+    if (!_index.empty()) {
+        rebuildIndex();
+    }
+}
+
 std::unique_ptr<Object> Dictionary::
 _copy() const
 {
@@ -34,7 +133,7 @@ merge(Dictionary const *dict, bool replace)
         return;
 
     for (auto const &key : *dict) {
-        if (replace || _map.find(key) == _map.end()) {
+        if (replace || find(key) == count()) {
             set(key, dict->value(key)->copy());
         }
     }
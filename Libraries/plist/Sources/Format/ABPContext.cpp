@@ -11,20 +11,15 @@
 #include <cstring>
 
 ABPContext::
-ABPContext(std::vector<uint8_t> const *contents) :
+ABPContext() :
     _flags   (0),
-    _offsets (nullptr),
-    _offset  (0),
-    _contents(contents)
+    _offset  (0)
 {
 }
 
 ABPContext::
 ~ABPContext()
 {
-    if (this->_offsets != NULL) {
-        delete[] this->_offsets;
-    }
 }
 
 off_t ABPContext::
@@ -38,7 +33,7 @@ seek(off_t offset, int whence)
             this->_offset += offset;
             break;
         case SEEK_END:
-            this->_offset = this->_contents->size() + offset;
+            this->_offset = this->contentsSize() + offset;
         default:
             break;
     }
@@ -50,8 +45,8 @@ seek(off_t offset, int whence)
     }
 
     /* Error if past the end. */
-    if (this->_offset > static_cast<off_t>(this->_contents->size())) {
-        this->_offset = static_cast<off_t>(this->_contents->size());
+    if (this->_offset > static_cast<off_t>(this->contentsSize())) {
+        this->_offset = static_cast<off_t>(this->contentsSize());
         return -1;
     }
 
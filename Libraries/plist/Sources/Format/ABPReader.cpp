@@ -8,9 +8,11 @@
 
 #include <plist/Format/ABPReader.h>
 #include <plist/Format/ABPRecordType.h>
-#include <plist/Format/Encoding.h>
+#include <plist/Format/unicode.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 #if 0
 #define dprintf(...) fprintf(stderr, __VA_ARGS__)
@@ -27,38 +29,38 @@ error(std::string const &error)
 bool ABPReader::
 readOffsetTable()
 {
-    off_t        offset;
-    uint64_t     n, *offsets;
-    plist::Object **objects;
-
-    offset = -static_cast<off_t>(sizeof(this->_trailer) + this->_trailer.offsetIntByteSize * this->_trailer.objectsCount);
-
-    if (this->seek(offset, SEEK_END) < 0)
+    /* The offset table must fit in the contents, before the trailer. */
+    if (this->_trailer.offsetIntByteSize == 0 ||
+        this->_trailer.objectsCount > (this->_size - sizeof(this->_trailer)) / this->_trailer.offsetIntByteSize)
         return false;
 
-    size_t objectsCount = static_cast<size_t>(this->_trailer.objectsCount);
-    offsets = new uint64_t[objectsCount];
-    objects = new plist::Object *[objectsCount];
+    /*
+     * Offsets are read from the table as each object is read, rather than
+     * copied up front, so opening takes the same memory for any size.
+     */
+    this->_offsetTable = this->_size - sizeof(this->_trailer) - this->_trailer.offsetIntByteSize * this->_trailer.objectsCount;
 
-    for (n = 0; n < this->_trailer.objectsCount; n++) {
-        objects[n] = nullptr;
-        if (!this->readOffset(offsets + n)) {
-            delete[] objects;
-            delete[] offsets;
-            return false;
-        }
+    return true;
+}
 
-#if 1
-        dprintf("Object #%-5llu: %llx%s\n",
-                (unsigned long long)n,
-                (unsigned long long)offsets[n],
-                (n == this->_trailer.topLevelObject)
-                ? " [TOP LEVEL OBJECT]" : "");
-#endif
+bool ABPReader::
+seekObject(uint64_t reference)
+{
+    uint64_t offset;
+
+    if (this->seek(static_cast<off_t>(this->_offsetTable + reference * this->_trailer.offsetIntByteSize), SEEK_SET) < 0 ||
+        !this->readOffset(&offset) ||
+        offset >= this->_size ||
+        this->seek(static_cast<off_t>(offset), SEEK_SET) < 0) {
+        this->error("object reference's offset out of range");
+        return false;
     }
 
-    this->_offsets = offsets;
-    this->_objects = objects;
+    dprintf("Object #%-5llu: %llx%s\n",
+            (unsigned long long)reference,
+            (unsigned long long)offset,
+            (reference == this->_trailer.topLevelObject)
+            ? " [TOP LEVEL OBJECT]" : "");
 
     return true;
 }
@@ -131,17 +133,12 @@ readData(size_t nbytes)
 
     dprintf("data - %zu bytes\n", nbytes);
 
-    std::vector<uint8_t> bytes;
-
-    if (nbytes > 0) {
-        bytes.resize(nbytes);
-        size_t nread = this->read(bytes.data(), nbytes);
-        if (nread < nbytes) {
-            return nullptr;
-        }
+    uint8_t const *bytes = this->consume(nbytes);
+    if (bytes == nullptr) {
+        return nullptr;
     }
 
-    return plist::Data::New(std::move(bytes)).release();
+    return plist::Data::New(std::vector<uint8_t>(bytes, bytes + nbytes)).release();
 }
 
 plist::UID *ABPReader::
@@ -177,18 +174,12 @@ readStringASCII(size_t nchars)
 
     dprintf("ascii string - %zu(0x%zx) chars\n", nchars, nchars);
 
-    std::string string;
-
-    if (nchars > 0) {
-        size_t nbytes = sizeof(char) * nchars;
-        string.resize(nbytes);
-        size_t nread = this->read(&string[0], nbytes);
-        if (nread < nbytes) {
-            return nullptr;
-        }
+    uint8_t const *chars = this->consume(sizeof(char) * nchars);
+    if (chars == nullptr) {
+        return nullptr;
     }
 
-    return plist::String::New(std::move(string)).release();
+    return plist::String::New(std::string(reinterpret_cast<char const *>(chars), nchars)).release();
 }
 
 plist::String *ABPReader::
@@ -201,20 +192,30 @@ readStringUnicode(size_t nchars)
 
     dprintf("unicode string - %zu chars\n", nchars);
 
-    std::vector<uint8_t> buffer;
+    uint8_t const *bytes = this->consume(sizeof(uint16_t) * nchars);
+    if (bytes == nullptr) {
+        return nullptr;
+    }
 
-    if (nchars > 0) {
-        size_t nbytes = sizeof(uint16_t) * nchars;
-        buffer.resize(nbytes);
-        size_t nread = this->read(buffer.data(), nbytes);
-        if (nread < nbytes) {
-            return nullptr;
+    /* Big endian in the file; a leading byte order mark is dropped. */
+    std::vector<uint16_t> units;
+    units.reserve(nchars);
+    for (size_t n = 0; n < nchars; n++) {
+        uint16_t unit = static_cast<uint16_t>((bytes[n * 2] << 8) | bytes[n * 2 + 1]);
+        if (n == 0 && unit == 0xfeff) {
+            continue;
         }
+        units.push_back(unit);
     }
 
-    buffer = plist::Format::Encodings::Convert(buffer, plist::Format::Encoding::UTF16BE, plist::Format::Encoding::UTF8);
+    /* Measure first, so the string is allocated at its exact length. */
+    size_t length = ::utf16_to_utf8(nullptr, 0, units.data(), units.size(), 0, nullptr);
+    std::string string;
+    string.resize(length);
+    if (length > 0) {
+        ::utf16_to_utf8(&string[0], string.size(), units.data(), units.size(), 0, nullptr);
+    }
 
-    std::string string = std::string(buffer.begin(), buffer.end());
     return plist::String::New(std::move(string)).release();
 }
 
@@ -230,6 +231,11 @@ readArray(size_t nitems)
 
     dprintf("array - %zu items\n", nitems);
 
+    if (!this->fitsReferences(nitems)) {
+        this->error("corrupted array's object references table");
+        return NULL;
+    }
+
     auto objrefs = new uint64_t[nitems];
     for (size_t n = 0; n < nitems; n++) {
         uint64_t objref;
@@ -253,13 +259,10 @@ readArray(size_t nitems)
         }
 
         //
-        // Due to the memory layout of the `plist' objects,
-        // we must always copy objects.
+        // The first reference to an object moves it into its container.
+        // Objects can be referenced more than once, so copy it after that.
         //
-        if (this->_seen.find(object) != this->_seen.end()) {
-            this->_seen.insert(object);
-        }
-        object = object->copy().release();
+        object = this->take(objref);
 
         array->append(std::unique_ptr<plist::Object>(object));
     }
@@ -279,6 +282,11 @@ readDictionary(size_t nitems)
         return NULL;
     }
 
+    if (!this->fitsReferences(nitems) || !this->fitsReferences(nitems * 2)) {
+        this->error("corrupted dictionary's references table");
+        return NULL;
+    }
+
     uint64_t *kvrefs = new uint64_t[nitems * 2];
     dprintf("dictionary - %zu items\n", nitems);
 
@@ -325,13 +333,10 @@ readDictionary(size_t nitems)
         }
 
         //
-        // Due to the memory layout of the `plist' objects,
-        // we must always copy objects.
+        // The first reference to an object moves it into its container.
+        // Objects can be referenced more than once, so copy it after that.
         //
-        if (this->_seen.find(object) != this->_seen.end()) {
-            this->_seen.insert(object);
-        }
-        object = object->copy().release();
+        object = this->take(kvrefs[n * 2 + 1]);
 
         dict->set(keyString->value(), std::unique_ptr<plist::Object>(object));
     }
@@ -399,18 +404,28 @@ _readObject()
 }
 
 ABPReader::
-ABPReader(std::vector<uint8_t> const *contents) :
-    ABPContext(contents),
-    _objects (nullptr)
+ABPReader(uint8_t const *data, size_t size) :
+    ABPContext(),
+    _data       (data),
+    _size       (size),
+    _offsetTable(0),
+    _objects    (nullptr)
 {
 }
 
+size_t ABPReader::
+contentsSize() const
+{
+    return this->_size;
+}
+
 ABPReader::
 ~ABPReader()
 {
     if (this->_objects != NULL) {
         for (size_t n = 0; n < this->_trailer.objectsCount; n++) {
-            if (this->_objects[n] != NULL) {
+            /* Objects taken are owned by their container. */
+            if (this->_objects[n] != NULL && !this->_taken[n]) {
                 this->_objects[n]->release();
             }
         }
@@ -469,10 +484,16 @@ readObject(uint64_t reference)
         return NULL;
     }
 
+    /* Only readers that keep objects need space for them. */
+    if (this->_objects == NULL) {
+        size_t objectsCount = static_cast<size_t>(this->_trailer.objectsCount);
+        this->_objects = new plist::Object *[objectsCount]();
+        this->_taken.assign(objectsCount, false);
+    }
+
     object = this->_objects[reference];
     if (object == NULL) {
-        if (this->seek(static_cast<size_t>(this->_offsets[reference]), SEEK_SET) < 0) {
-            this->error("object reference's offset out of range");
+        if (!this->seekObject(reference)) {
             return NULL;
         }
 
@@ -488,23 +509,285 @@ readObject(uint64_t reference)
     return object;
 }
 
+int ABPReader::
+readMarker(uint64_t reference)
+{
+    int byte;
+
+    /* Fail if complete, or not opened. */
+    if ((this->_flags & kABPContextComplete) != 0 ||
+        (this->_flags & kABPContextOpened) == 0)
+        return EOF;
+
+    if (reference >= this->_trailer.objectsCount) {
+        this->error("reference out of range");
+        return EOF;
+    }
+
+    if (!this->seekObject(reference)) {
+        return EOF;
+    }
+
+    do {
+        byte = this->readByte();
+    } while (byte != EOF && __ABPByteToRecordType(byte) == kABPRecordTypeFill);
+
+    return byte;
+}
+
+ABPRecordType ABPReader::
+readRecordType(uint64_t reference)
+{
+    int byte = this->readMarker(reference);
+    if (byte == EOF) {
+        return kABPRecordTypeInvalid;
+    }
+
+    return __ABPByteToRecordType(byte);
+}
+
+bool ABPReader::
+readReferences(uint64_t reference, std::vector<uint64_t> *references)
+{
+    int byte = this->readMarker(reference);
+    if (byte == EOF) {
+        return false;
+    }
+
+    ABPRecordType type = __ABPByteToRecordType(byte);
+    if (type != kABPRecordTypeArray && type != kABPRecordTypeDictionary) {
+        this->error("not an array or dictionary");
+        return false;
+    }
+
+    size_t nitems = byte & 0x0f;
+    if (!this->readLength(&nitems)) {
+        this->error("EOF reading collection count value");
+        return false;
+    }
+
+    size_t nrefs = (type == kABPRecordTypeDictionary ? nitems * 2 : nitems);
+    if (!this->fitsReferences(nitems) || !this->fitsReferences(nrefs)) {
+        this->error("corrupted collection's references table");
+        return false;
+    }
+
+    references->resize(nrefs);
+    for (size_t n = 0; n < nrefs; n++) {
+        if (!this->readReference(&(*references)[n])) {
+            this->error("corrupted collection's references table");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ABPReader::
+visit(uint64_t reference, plist::Format::Visitor *visitor)
+{
+    std::vector<uint64_t> path;
+    return this->visit(reference, visitor, &path);
+}
+
+bool ABPReader::
+visit(uint64_t reference, plist::Format::Visitor *visitor, std::vector<uint64_t> *path)
+{
+    int byte = this->readMarker(reference);
+    if (byte == EOF) {
+        this->error("failed to read object");
+        return false;
+    }
+
+    ABPRecordType type = __ABPByteToRecordType(byte);
+    if (type != kABPRecordTypeArray && type != kABPRecordTypeDictionary) {
+        return this->visitValue(reference, visitor);
+    }
+
+    /* Only the collections being visited are kept, to find cycles. */
+    if (std::find(path->begin(), path->end(), reference) != path->end()) {
+        this->error("collection contains itself");
+        return false;
+    }
+
+    path->push_back(reference);
+    bool success = this->visitCollection(reference, byte, visitor, path);
+    path->pop_back();
+    return success;
+}
+
+bool ABPReader::
+visitCollection(uint64_t reference, int marker, plist::Format::Visitor *visitor, std::vector<uint64_t> *path)
+{
+    bool dictionary = (__ABPByteToRecordType(marker) == kABPRecordTypeDictionary);
+
+    size_t nitems = marker & 0x0f;
+    if (!this->readLength(&nitems)) {
+        this->error("EOF reading collection count value");
+        return false;
+    }
+
+    size_t nrefs = (dictionary ? nitems * 2 : nitems);
+    if (!this->fitsReferences(nitems) || !this->fitsReferences(nrefs)) {
+        this->error("corrupted collection's references table");
+        return false;
+    }
+
+    if (!(dictionary ? visitor->beginDictionary() : visitor->beginArray())) {
+        this->error("stopped reading");
+        return false;
+    }
+
+    /*
+     * Each reference is read just before it is visited, rather than all at
+     * once: visiting moves to the object referred to.
+     */
+    off_t table = this->_offset;
+    for (size_t n = 0; n < nitems; n++) {
+        uint64_t objref;
+
+        if (dictionary) {
+            uint64_t keyref;
+
+            if (this->seek(table + static_cast<off_t>(n * this->_trailer.objectRefByteSize), SEEK_SET) < 0 ||
+                !this->readReference(&keyref)) {
+                this->error("corrupted dictionary's key references table");
+                return false;
+            }
+
+            if (!this->visitKey(keyref, visitor)) {
+                return false;
+            }
+        }
+
+        size_t index = (dictionary ? nitems + n : n);
+        if (this->seek(table + static_cast<off_t>(index * this->_trailer.objectRefByteSize), SEEK_SET) < 0 ||
+            !this->readReference(&objref)) {
+            this->error("corrupted collection's object references table");
+            return false;
+        }
+
+        if (!this->visit(objref, visitor, path)) {
+            return false;
+        }
+    }
+
+    if (!(dictionary ? visitor->endDictionary() : visitor->endArray())) {
+        this->error("stopped reading");
+        return false;
+    }
+
+    return true;
+}
+
+bool ABPReader::
+visitKey(uint64_t reference, plist::Format::Visitor *visitor)
+{
+    /* Check the type first: reading a collection would read its contents. */
+    ABPRecordType type = this->readRecordType(reference);
+    if (type != kABPRecordTypeStringASCII && type != kABPRecordTypeStringUnicode) {
+        this->error("dictionary key is not a string");
+        return false;
+    }
+
+    if (!this->seekObject(reference)) {
+        return false;
+    }
+
+    plist::Object *object = this->_readObject();
+    if (object == NULL) {
+        this->error("failed to create object");
+        return false;
+    }
+
+    bool success = visitor->key(plist::CastTo<plist::String>(object)->value());
+    object->release();
+
+    if (!success) {
+        this->error("stopped reading");
+        return false;
+    }
+
+    return true;
+}
+
+bool ABPReader::
+visitValue(uint64_t reference, plist::Format::Visitor *visitor)
+{
+    if (!this->seekObject(reference)) {
+        return false;
+    }
+
+    plist::Object *object = this->_readObject();
+    if (object == NULL) {
+        this->error("failed to create object");
+        return false;
+    }
+
+    bool success = plist::Format::Visitor::Visit(object, visitor);
+    object->release();
+
+    if (!success) {
+        this->error("stopped reading");
+        return false;
+    }
+
+    return true;
+}
+
 plist::Object *ABPReader::
 readTopLevelObject()
 {
     return this->readObject(this->_trailer.topLevelObject);
 }
 
+plist::Object *ABPReader::
+takeTopLevelObject()
+{
+    if (this->readTopLevelObject() == NULL)
+        return NULL;
+
+    return this->take(this->_trailer.topLevelObject);
+}
+
+plist::Object *ABPReader::
+take(uint64_t reference)
+{
+    plist::Object *object = this->_objects[reference];
+
+    if (!this->_taken[reference]) {
+        this->_taken[reference] = true;
+        return object;
+    } else {
+        return object->copy().release();
+    }
+}
+
+uint8_t const *ABPReader::
+consume(size_t length)
+{
+    /* Fail without reading if not enough contents remain. */
+    size_t remaining = this->_size - this->_offset;
+    if (remaining < length) {
+        return nullptr;
+    }
+
+    uint8_t const *data = this->_data + this->_offset;
+    this->_offset += length;
+    return data;
+}
+
 int ABPReader::
 read(void *data, size_t length)
 {
     /* Adjust size for remaining contents. */
-    size_t remaining = this->_contents->size() - this->_offset;
+    size_t remaining = this->_size - this->_offset;
     if (remaining < length) {
         length = remaining;
     }
 
     /* Copy into read buffer. */
-    ::memcpy(data, this->_contents->data() + this->_offset, length);
+    ::memcpy(data, this->_data + this->_offset, length);
 
     this->_offset += length;
     return length;
@@ -513,24 +796,26 @@ read(void *data, size_t length)
 int ABPReader::
 readByte()
 {
-    uint8_t byte;
-
-    if (this->read(&byte, sizeof(byte)) != sizeof(byte))
+    uint8_t const *byte = this->consume(sizeof(uint8_t));
+    if (byte == nullptr)
         return EOF;
 
-    return byte;
+    return *byte;
 }
 
 bool ABPReader::
 readWord(size_t nbytes, uint64_t *result)
 {
-    uint8_t  *p, bytes[8];
-    uint64_t  v;
+    uint8_t const *p;
+    uint64_t       v;
 
-    if (this->read(bytes, nbytes) != nbytes)
+    if (nbytes > 8)
+        return false;
+
+    p = this->consume(nbytes), v = 0;
+    if (p == nullptr)
         return false;
 
-    p = bytes, v = 0;
     switch (nbytes) {
         default: return false;
         case 8: v |= (uint64_t)*p++ << 56;
@@ -584,6 +869,14 @@ readReference(uint64_t *offset)
     return this->readWord(this->_trailer.objectRefByteSize, offset);
 }
 
+bool ABPReader::
+fitsReferences(size_t nrefs)
+{
+    /* Checked before allocating space for the references. */
+    size_t remaining = this->_size - this->_offset;
+    return (this->_trailer.objectRefByteSize > 0 && nrefs <= remaining / this->_trailer.objectRefByteSize);
+}
+
 bool ABPReader::
 readHeader()
 {
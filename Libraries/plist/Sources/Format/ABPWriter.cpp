@@ -27,12 +27,6 @@ using plist::UID;
 using plist::Array;
 using plist::Dictionary;
 
-enum {
-    kABPWriteObjectTopLevel  = (1 << 0), /* Object is top level. */
-    kABPWriteObjectReference = (1 << 1), /* Write only the reference, even if not written yet. */
-    kABPWriteObjectValue     = (1 << 2)  /* Write only the value if not yet written. */
-};
-
 bool ABPWriter::
 writeOffsetTable()
 {
@@ -58,7 +52,7 @@ writeOffsetTable()
 
     /* Write out the offsets. */
     for (n = 0; n < this->_trailer.objectsCount; n++) {
-        if (!this->writeOffset(this->_offsets[n])) {
+        if (!this->writeOffset(this->_offsets[static_cast<size_t>(n)])) {
             return false;
         }
     }
@@ -204,22 +198,22 @@ writeStringUnicode(uint16_t const *chars, size_t nchars)
 }
 
 bool ABPWriter::
-writeString(String const *string)
+writeString(std::string const &string)
 {
     bool success;
 
     bool ascii = true;
-    for (uint8_t c : string->value()) {
-        if (c > 0x80) {
+    for (uint8_t c : string) {
+        if (c > 0x7F) {
             ascii = false;
             break;
         }
     }
 
     if (ascii) {
-        success = this->writeStringASCII(string->value().c_str(), string->value().size());
+        success = this->writeStringASCII(string.c_str(), string.size());
     } else {
-        std::vector<uint8_t> buffer = std::vector<uint8_t>(string->value().begin(), string->value().end());
+        std::vector<uint8_t> buffer = std::vector<uint8_t>(string.begin(), string.end());
         buffer = Encodings::Convert(buffer, Encoding::UTF8, Encoding::UTF16BE);
         success = this->writeStringUnicode(reinterpret_cast<uint16_t *>(buffer.data()), buffer.size() / sizeof(uint16_t));
     }
@@ -227,319 +221,179 @@ writeString(String const *string)
     return success;
 }
 
-void ABPWriter::
-writeArrayReferences(Array const *array)
-{
-    for (size_t i = 0; i < array->count(); ++i) {
-        this->writeObject(array->value(i), kABPWriteObjectReference);
-    }
-}
-
-void ABPWriter::
-writeArrayValues(Array const *array)
-{
-    for (size_t i = 0; i < array->count(); ++i) {
-        this->writeObject(array->value(i), kABPWriteObjectValue);
-    }
-}
-
 bool ABPWriter::
-writeArray(Array const *array)
+writeArray(Array const *array, size_t children)
 {
-    int length = array->count();
+    size_t length = array->count();
 
     /* Write the object type and the length. */
     if (!this->writeTypeAndLength(kABPRecordTypeArray, length))
         return false;
 
-    if (length > 0) {
-        /* Write all the references and all the values. */
-        this->writeArrayReferences(array);
-        this->writeArrayValues(array);
+    /* Write the references to each value. */
+    for (size_t n = 0; n < length; n++) {
+        if (!this->writeReference(this->_childReferences[children + n]))
+            return false;
     }
 
     return true;
 }
 
-/*
- * Workaround for Dictionaries not having keys with identity. Map from integer key
- * index to key value to use as the identity when writing the key object out.
- */
-String const *ABPWriter::
-dictionaryKeyString(Dictionary const *dict, int key)
-{
-    std::unordered_map<int, String *> *map = &this->_keyStrings[dict];
-
-    auto it = map->find(key);
-    if (it != map->end()) {
-        return it->second;
-    } else {
-        auto string = String::New(dict->key(key));
-        map->insert({ key, string.get() });
-        return string.release();
-    }
-}
-
-void ABPWriter::
-writeDictionaryReferences(Dictionary const *dict)
-{
-    for (size_t i = 0; i < dict->count(); ++i) {
-        String const *key = this->dictionaryKeyString(dict, i);
-        this->writeObject(key, kABPWriteObjectReference);
-    }
-
-    for (size_t i = 0; i < dict->count(); ++i) {
-        this->writeObject(dict->value(i), kABPWriteObjectReference);
-    }
-}
-
-void ABPWriter::
-writeDictionaryValues(Dictionary const *dict)
-{
-    for (size_t i = 0; i < dict->count(); ++i) {
-        String const *key = this->dictionaryKeyString(dict, i);
-        this->writeObject(key, kABPWriteObjectValue);
-    }
-
-    for (size_t i = 0; i < dict->count(); ++i) {
-        this->writeObject(dict->value(i), kABPWriteObjectValue);
-    }
-}
-
 bool ABPWriter::
-writeDictionary(Dictionary const *dict)
+writeDictionary(Dictionary const *dict, size_t children)
 {
-    int length = dict->count();
+    size_t length = dict->count();
 
     /* Write the object type and the length. */
     if (!this->writeTypeAndLength(kABPRecordTypeDictionary, length))
         return false;
 
-    if (length > 0) {
-        /* Write all the reference and value pairs. */
-        this->writeDictionaryReferences(dict);
-        this->writeDictionaryValues(dict);
+    /* Write the references to all the keys, then all the values. */
+    for (size_t n = 0; n < length * 2; n++) {
+        if (!this->writeReference(this->_childReferences[children + n]))
+            return false;
     }
 
     return true;
 }
 
-/* Preflighting */
+/* Uniquing */
 
-void ABPWriter::
-writePreflightArrayReferences(Array const *array)
+size_t ABPWriter::ValueHash::
+operator()(Value const &value) const
 {
-    for (size_t i = 0; i < array->count(); ++i) {
-        this->writePreflightObject(array->value(i), 0);
+    /* FNV-1a, over the scalar and then any bytes. */
+    uint64_t hash = 0xcbf29ce484222325ULL ^ static_cast<uint64_t>(value.type);
+    for (size_t n = 0; n < sizeof(value.scalar); n++) {
+        hash = (hash ^ ((value.scalar >> (n * 8)) & 0xFF)) * 0x100000001b3ULL;
     }
-}
 
-bool ABPWriter::
-writePreflightArray(Array const *array)
-{
-    /* Preflight all the values. */
-    this->writePreflightArrayReferences(array);
-    return true;
-}
-
-void ABPWriter::
-writePreflightDictionaryReferences(Dictionary const *dict)
-{
-    for (size_t i = 0; i < dict->count(); ++i) {
-        String const *key = this->dictionaryKeyString(dict, i);
-        this->writePreflightObject(key, 0);
+    uint8_t const *bytes = static_cast<uint8_t const *>(value.data);
+    for (size_t n = 0; n < value.size; n++) {
+        hash = (hash ^ bytes[n]) * 0x100000001b3ULL;
     }
 
-    for (size_t i = 0; i < dict->count(); ++i) {
-        this->writePreflightObject(dict->value(i), 0);
-    }
+    return static_cast<size_t>(hash);
 }
 
-bool ABPWriter::
-writePreflightDictionary(Dictionary const *dict)
+bool ABPWriter::ValueEqual::
+operator()(Value const &lhs, Value const &rhs) const
 {
-    /* Preflight all the keys and values. */
-    this->writePreflightDictionaryReferences(dict);
-    return true;
+    return (lhs.type == rhs.type &&
+            lhs.scalar == rhs.scalar &&
+            lhs.size == rhs.size &&
+            (lhs.size == 0 || ::memcmp(lhs.data, rhs.data, lhs.size) == 0));
 }
 
 /*
- * Process an object, calls the user callback in order to
- * return a suitable object for the encoding; the object
- * is added to the mapping table if different from the original
- * and a reference is associated with the object; valid references
- * are always non-zero.
- * If 'userProcess' is set, when an object is cached, the object
- * field is set to null and only the reference number is returned.
+ * Number a string, or find the number of an equal string. Strings and
+ * dictionary keys are written the same way, so are uniqued together.
  */
-bool ABPWriter::
-processObject(Object const **object, uint32_t *refno, bool userProcess)
+uint64_t ABPWriter::
+flattenString(std::string const *string)
 {
-    Object const *newObject;
-    Object const *origObject = *object;
+    Value value = { String::Type(), 0, string->data(), string->size() };
 
-    /* Is this object already mapped? */
-    auto mit = this->_mappings.find(origObject);
-    if (mit != this->_mappings.end()) {
-        newObject = mit->second;
-    } else {
-        newObject = origObject;
-
-        /* Process the object for mapping. */
-        if (userProcess) {
-            ObjectType type = newObject->type();
-            /*
-             * Cache mapping, but do so only if newObject is different
-             * than the origObject or origObject is not a container.
-             */
-            if (newObject != origObject || (type != Array::Type() &&
-                                            type != Dictionary::Type() &&
-                                            type != Null::Type() &&
-                                            type != Boolean::Type())) {
-                this->_mappings.insert({ origObject, newObject });
-            }
-        } else {
-            /*
-             * The user callback can't handle this object, supposedly because
-             * we can.
-             */
-        }
+    auto result = this->_values.insert({ value, this->_records.size() });
+    if (result.second) {
+        this->_records.push_back({ nullptr, string, 0 });
     }
 
-    assert(newObject != NULL);
-
-    /* Is this new object already written? */
-    auto it = this->_references.find(newObject);
-    if (it != this->_references.end()) {
-        *refno = it->second;
-
-        /*
-         * Yes, invalidate newObject so the caller knows that this is
-         * a reference.
-         */
-        if (userProcess) {
-            newObject = NULL;
-        }
-    } else {
-        /*
-         * No, add a new reference for this newObject.
-         */
-        *refno = this->_references.size();
-        this->_references.insert({ newObject, *refno });
-    }
-
-    /* Return the new object to the user. */
-    *object = newObject;
-
-    return true;
+    return result.first->second;
 }
 
 /*
- * Preflight objects so that we emit them ordered; this is needed in
- * order to create binary property lists compatible with standard format;
- * failing to do so will result in an a property list that cannot be
- * opened by any tool (although you can simply use our own which are
- * more than happy to process a "broken" plist).
+ * Number an object and, for containers, everything in it. Objects are
+ * numbered in the order they are first reached, which is the order they
+ * are written in; equal values share one number.
  */
-bool ABPWriter::
-writePreflightObject(Object const *object, uint32_t flags)
+uint64_t ABPWriter::
+flattenObject(Object const *object)
 {
-    bool success = true;
-    uint32_t refno = 0;
-
-    /*
-     * Process the object; if returned object is non-null, it
-     * is the first time the object has been seen, otherwise
-     * only refno is valid.
-     */
-    if (!this->processObject(&object, &refno, true))
-        return false;
-
-    if (object == NULL)
-        return true;
-
-    /* If this is the top level object, store reference in the header. */
-    if (flags & kABPWriteObjectTopLevel) {
-        this->_trailer.topLevelObject = refno;
-    }
-
-    /* Add this object to the offsets table. */
-    if (refno >= this->_trailer.objectsCount) {
-        this->_trailer.objectsCount = refno + 1;
-    }
+    Value value = { object->type(), 0, nullptr, 0 };
+    uint64_t refno = this->_records.size();
 
-    /* Preflight dictionaries and arrays. */
     if (auto array = plist::CastTo<Array>(object)) {
-        success = this->writePreflightArray(array);
-    } else if (auto dict = plist::CastTo<Dictionary>(object)) {
-        success = this->writePreflightDictionary(dict);
-    }
+        /* Reserve the references, as values add their own. */
+        size_t children = this->_childReferences.size();
+        this->_records.push_back({ object, nullptr, children });
+        this->_childReferences.resize(children + array->count());
 
-    if (!success) abort();
-    return success;
-}
+        for (size_t n = 0; n < array->count(); n++) {
+            this->_childReferences[children + n] = this->flattenObject(array->value(n));
+        }
 
-bool ABPWriter::
-writeObject(Object const *object, uint32_t flags)
-{
-    off_t        offset;
-    bool         success;
-    uint32_t     refno = 0;
+        return refno;
+    } else if (auto dict = plist::CastTo<Dictionary>(object)) {
+        size_t children = this->_childReferences.size();
+        this->_records.push_back({ object, nullptr, children });
+        this->_childReferences.resize(children + dict->count() * 2);
 
-    /*
-     * Process the object; if returned object is non-null, it
-     * is the first time the object has been seen, otherwise
-     * only refno is valid.
-     */
-    if (!this->processObject(&object, &refno, false))
-        return false;
+        for (size_t n = 0; n < dict->count(); n++) {
+            this->_childReferences[children + n] = this->flattenString(&dict->key(n));
+        }
 
-    if (this->_written.find(object) != this->_written.end()) {
-        if (flags & kABPWriteObjectValue)
-            return true;
+        for (size_t n = 0; n < dict->count(); n++) {
+            this->_childReferences[children + dict->count() + n] = this->flattenObject(dict->value(n));
+        }
 
-        flags |= kABPWriteObjectReference;
+        return refno;
+    } else if (auto string = plist::CastTo<String>(object)) {
+        return this->flattenString(&string->value());
+    } else if (auto integer = plist::CastTo<Integer>(object)) {
+        value.scalar = static_cast<uint64_t>(integer->value());
+    } else if (auto real = plist::CastTo<Real>(object)) {
+        double d = real->value();
+        memcpy(&value.scalar, &d, sizeof(d));
+    } else if (auto boolean = plist::CastTo<Boolean>(object)) {
+        value.scalar = boolean->value();
+    } else if (auto data = plist::CastTo<Data>(object)) {
+        value.data = data->value().data();
+        value.size = data->value().size();
+    } else if (auto date = plist::CastTo<Date>(object)) {
+        value.scalar = date->unixTimeValue();
+    } else if (auto uid = plist::CastTo<UID>(object)) {
+        value.scalar = uid->value();
     }
 
-    if (flags & kABPWriteObjectReference) {
-        return this->writeReference(refno);
+    auto result = this->_values.insert({ value, refno });
+    if (result.second) {
+        this->_records.push_back({ object, nullptr, 0 });
     }
 
-    /* Cache written object. */
-    this->_written.insert(object);
+    return result.first->second;
+}
 
-    offset = this->tell();
+bool ABPWriter::
+writeRecord(Record const &record)
+{
+    Object const *object = record.object;
 
-    if (auto array = plist::CastTo<Array>(object)) {
-        success = this->writeArray(array);
+    if (object == nullptr) {
+        return this->writeString(*record.key);
+    } else if (auto array = plist::CastTo<Array>(object)) {
+        return this->writeArray(array, record.children);
     } else if (auto dict = plist::CastTo<Dictionary>(object)) {
-        success = this->writeDictionary(dict);
+        return this->writeDictionary(dict, record.children);
     } else if (auto integer = plist::CastTo<Integer>(object)) {
-        success = this->writeInteger(integer);
+        return this->writeInteger(integer);
     } else if (auto real = plist::CastTo<Real>(object)) {
-        success = this->writeReal(real);
+        return this->writeReal(real);
     } else if (auto string = plist::CastTo<String>(object)) {
-        success = this->writeString(string);
+        return this->writeString(string->value());
     } else if (auto boolean = plist::CastTo<Boolean>(object)) {
-        success = this->writeBool(boolean);
+        return this->writeBool(boolean);
     } else if (auto null = plist::CastTo<Null>(object)) {
-        success = this->writeNull(null);
+        return this->writeNull(null);
     } else if (auto data = plist::CastTo<Data>(object)) {
-        success = this->writeData(data);
+        return this->writeData(data);
     } else if (auto date = plist::CastTo<Date>(object)) {
-        success = this->writeDate(date);
+        return this->writeDate(date);
     } else if (auto uid = plist::CastTo<UID>(object)) {
-        success = this->writeUID(uid);
+        return this->writeUID(uid);
     } else {
         abort();
     }
-
-    if (success) {
-        /* Update offsets table. */
-        this->_offsets[refno] = offset;
-    }
-
-    return success;
 }
 
 /*
@@ -548,11 +402,27 @@ writeObject(Object const *object, uint32_t flags)
 
 ABPWriter::
 ABPWriter(std::vector<uint8_t> *contents) :
-    ABPContext      (contents),
-    _mutableContents(contents)
+    ABPContext      (),
+    _mutableContents(contents),
+    _flushed        (0)
 {
 }
 
+ABPWriter::
+ABPWriter(plist::Format::Sink const &sink) :
+    ABPContext      (),
+    _mutableContents(&_buffer),
+    _sink           (sink),
+    _flushed        (0)
+{
+}
+
+size_t ABPWriter::
+contentsSize() const
+{
+    return this->_flushed + this->_mutableContents->size();
+}
+
 bool ABPWriter::
 open()
 {
@@ -610,11 +480,8 @@ close()
             return false;
     }
 
-    for (auto const &map : this->_keyStrings) {
-        for (auto const &item : map.second) {
-            item.second->release();
-        }
-    }
+    if (!this->flush(true))
+        return false;
 
     return true;
 }
@@ -622,8 +489,6 @@ close()
 bool ABPWriter::
 writeTopLevelObject(Object const *object)
 {
-    bool success;
-
     if (object == NULL)
         return false;
 
@@ -632,50 +497,78 @@ writeTopLevelObject(Object const *object)
         return false;
 
     /*
-     * Preflight objects... the standard seems to support only binary plists
-     * whose offsets are increasing *sigh*
+     * Number every object first: the reference size depends on how many
+     * there are, and offsets must increase with the reference number.
      */
-    success = this->writePreflightObject(object, kABPWriteObjectTopLevel);
-    if (success) {
-        /* Estimate the object reference size. */
-        uint64_t nrefs = this->_references.size();
-        if (nrefs > UINT32_MAX) {
-            this->_trailer.objectRefByteSize = sizeof(uint64_t);
-        } else if (nrefs > UINT16_MAX) {
-            this->_trailer.objectRefByteSize = sizeof(uint32_t);
-        } else if (nrefs > UINT8_MAX) {
-            this->_trailer.objectRefByteSize = sizeof(uint16_t);
-        } else {
-            this->_trailer.objectRefByteSize = sizeof(uint8_t);
-        }
+    this->flattenObject(object);
+    this->_trailer.topLevelObject = 0;
+    this->_trailer.objectsCount = this->_records.size();
+
+    uint64_t nrefs = this->_records.size();
+    if (nrefs > UINT32_MAX) {
+        this->_trailer.objectRefByteSize = sizeof(uint64_t);
+    } else if (nrefs > UINT16_MAX) {
+        this->_trailer.objectRefByteSize = sizeof(uint32_t);
+    } else if (nrefs > UINT8_MAX) {
+        this->_trailer.objectRefByteSize = sizeof(uint16_t);
+    } else {
+        this->_trailer.objectRefByteSize = sizeof(uint8_t);
+    }
 
-        /* Allocate enough space for the offsets table. */
-        this->_offsets = static_cast<uint64_t *>(calloc(static_cast<size_t>(this->_trailer.objectsCount), sizeof(uint64_t)));
-        if (this->_offsets == NULL)
-            return false;
+    /* Write all the objects, in order. */
+    this->_offsets.reserve(this->_records.size());
+    for (Record const &record : this->_records) {
+        this->_offsets.push_back(this->tell());
 
-        /* Write all the objects. */
-        success = this->writeObject(object, kABPWriteObjectTopLevel);
-        if (success) {
-            this->_flags |= kABPContextComplete;
-        }
+        if (!this->writeRecord(record))
+            return false;
     }
 
-    return success;
+    this->_flags |= kABPContextComplete;
+    return true;
+}
+
+/*
+ * When writing to a sink, the buffer is passed on once it reaches this size.
+ */
+static size_t const ChunkSize = 64 * 1024;
+
+bool ABPWriter::
+flush(bool final)
+{
+    if (!this->_sink || this->_mutableContents->empty())
+        return true;
+
+    /* Only pass on parts that won't be written again. */
+    if (!final && (this->_mutableContents->size() < ChunkSize || this->_offset != static_cast<off_t>(this->contentsSize())))
+        return true;
+
+    bool result = this->_sink(this->_mutableContents->data(), this->_mutableContents->size());
+    this->_flushed += this->_mutableContents->size();
+    this->_mutableContents->clear();
+    return result;
 }
 
 int ABPWriter::
 write(void const *data, size_t length)
 {
-    int needed = (this->_mutableContents->size() - this->_offset + length);
-    if (needed > 0) {
-        this->_mutableContents->resize(this->_mutableContents->size() + needed);
+    /* Parts already passed to the sink can't be written again. */
+    if (this->_offset < static_cast<off_t>(this->_flushed))
+        return -1;
+
+    size_t offset = static_cast<size_t>(this->_offset) - this->_flushed;
+    if (offset + length > this->_mutableContents->size()) {
+        this->_mutableContents->resize(offset + length);
     }
 
     /* Copy into write buffer. */
-    ::memcpy(this->_mutableContents->data() + this->_offset, data, length);
+    ::memcpy(this->_mutableContents->data() + offset, data, length);
 
     this->_offset += length;
+
+    if (!this->flush(false))
+        return -1;
+
     return length;
 }
 
@@ -9,12 +9,19 @@
 #include <plist/Format/ASCII.h>
 #include <plist/Format/ASCIIParser.h>
 #include <plist/Format/ASCIIWriter.h>
+#include <plist/Format/Builder.h>
 #include <plist/Objects.h>
 
+#include <algorithm>
+
 using plist::Format::Type;
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Sink;
 using plist::Format::ASCII;
+using plist::Format::Builder;
+using plist::Format::ASCIIWriter;
+using plist::Format::Visitor;
 using plist::Object;
 
 ASCII::
@@ -218,45 +225,80 @@ Identify(std::vector<uint8_t> const &contents)
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<ASCII>::
-Deserialize(std::vector<uint8_t> const &contents, ASCII const &format)
+std::pair<bool, std::string> Format<ASCII>::
+Visit(std::vector<uint8_t> const &contents, ASCII const &format, Visitor *visitor)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
-
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+    /* UTF-8 contents are read in place; only other encodings are copied. */
+    std::vector<uint8_t> converted;
+    uint8_t const *data = contents.data();
+    size_t size = contents.size();
+    if (format.encoding() != Encoding::UTF8) {
+        converted = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+        data = converted.data();
+        size = converted.size();
+    } else {
+        std::vector<uint8_t> BOM = Encodings::BOM(Encoding::UTF8);
+        if (size >= BOM.size() && std::equal(BOM.begin(), BOM.end(), data)) {
+            data += BOM.size();
+            size -= BOM.size();
+        }
+    }
 
     /* Create lexer. */
     ASCIIPListLexer lexer;
-    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data.data()), data.size(), kASCIIPListLexerStyleASCII);
+    ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(data), size, kASCIIPListLexerStyleASCII);
 
     /* Parse contents. */
-    ASCIIParser parser;
-    if (parser.parse(&lexer, format.strings())) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    ASCIIParser parser = ASCIIParser(visitor);
+    if (!parser.parse(&lexer, format.strings())) {
+        return std::make_pair(false, parser.error());
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(true, std::string());
 }
 
 template<>
-std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> Format<ASCII>::
-Serialize(Object const *object, ASCII const &format)
+std::pair<std::unique_ptr<Object>, std::string> Format<ASCII>::
+Deserialize(std::vector<uint8_t> const &contents, ASCII const &format)
 {
-    if (object == nullptr) {
-        return std::make_pair(nullptr, "object was null");
+    Builder builder;
+
+    auto result = Visit(contents, format, &builder);
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    ASCIIWriter writer = ASCIIWriter(object, format.strings());
-    if (!writer.write()) {
-        return std::make_pair(nullptr, "serialization failed");
+    return std::make_pair(std::move(builder.root()), std::string());
+}
+
+template<>
+std::pair<bool, std::string> Format<ASCII>::
+Serialize(Object const *object, ASCII const &format, Sink const &sink)
+{
+    if (object == nullptr) {
+        return std::make_pair(false, "object was null");
     }
 
-    std::vector<uint8_t> const data = Encodings::Convert(writer.contents(), Encoding::UTF8, format.encoding());
+    return ASCII::Serialize([object](Visitor *visitor) -> bool {
+        return Visitor::Visit(object, visitor);
+    }, format, sink);
+}
 
-    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(data.begin(), data.end())), std::string());
+template<>
+std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> Format<ASCII>::
+Serialize(Object const *object, ASCII const &format)
+{
+    auto contents = std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>());
+
+    auto result = Serialize(object, format, [&contents](uint8_t const *data, size_t size) -> bool {
+        contents->insert(contents->end(), data, data + size);
+        return true;
+    });
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
+    }
+
+    return std::make_pair(std::move(contents), std::string());
 }
 
 } }
@@ -266,3 +308,29 @@ Create(bool strings, Encoding encoding)
 {
     return ASCII(strings, encoding);
 }
+
+std::pair<bool, std::string> ASCII::
+Serialize(std::function<bool(Visitor *)> const &producer, ASCII const &format, Sink const &sink)
+{
+    /*
+     * Written as UTF-8, then converted part by part. Parts end between
+     * characters, so each converts on its own.
+     */
+    bool written = true;
+    Sink output = [&](uint8_t const *data, size_t size) -> bool {
+        if (format.encoding() == Encoding::UTF8) {
+            written = sink(data, size);
+        } else {
+            std::vector<uint8_t> const converted = Encodings::Convert(std::vector<uint8_t>(data, data + size), Encoding::UTF8, format.encoding());
+            written = sink(converted.data(), converted.size());
+        }
+        return written;
+    };
+
+    ASCIIWriter writer = ASCIIWriter(format.strings(), output);
+    if (!producer(&writer) || !writer.finish()) {
+        return std::make_pair(false, written ? "serialization failed" : "write failed");
+    }
+
+    return std::make_pair(true, std::string());
+}
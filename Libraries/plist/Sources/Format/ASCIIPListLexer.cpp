@@ -13,6 +13,10 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /*
  * Syntax:
  *
@@ -100,14 +104,91 @@ hex2bin(char ch)
         return (ch - '0');
 }
 
+/*
+ * Skip to the first of three bytes, or a NUL byte, or the end of the input.
+ * The scanners below only use this to pass over bytes they would otherwise
+ * skip one at a time; they then handle the byte it stops at as before.
+ */
+static inline char const *
+ASCIIPListLexerSkipUntil(ASCIIPListLexer const *lexer, char const *p, char a, char b, char c)
+{
+#if defined(__SSE2__)
+    if (lexer->vectorized) {
+        __m128i const va = _mm_set1_epi8(a);
+        __m128i const vb = _mm_set1_epi8(b);
+        __m128i const vc = _mm_set1_epi8(c);
+        __m128i const vz = _mm_setzero_si128();
+
+        while (lexer->endBuffer - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+            __m128i found = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, vc), _mm_cmpeq_epi8(chunk, vz)));
+
+            int mask = _mm_movemask_epi8(found);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+    }
+#endif
+
+    while (p < lexer->endBuffer && *p != a && *p != b && *p != c && *p != '\0') {
+        p++;
+    }
+    return p;
+}
+
+/*
+ * Skip over characters allowed in an unquoted string: letters, digits, and
+ * any of "_.$-:/". Like ASCIIPListLexerSkipUntil, only passes over bytes the
+ * caller would otherwise skip.
+ */
+static inline char const *
+ASCIIPListLexerSkipUnquoted(ASCIIPListLexer const *lexer, char const *p)
+{
+#if defined(__SSE2__)
+    if (lexer->vectorized) {
+        /* Signed comparisons: bytes 0x80 and above are never in range. */
+        __m128i const punctuationLow = _mm_set1_epi8('-' - 1); /* "-./0123456789:" */
+        __m128i const punctuationHigh = _mm_set1_epi8(':' + 1);
+        __m128i const upperLow = _mm_set1_epi8('A' - 1);
+        __m128i const upperHigh = _mm_set1_epi8('Z' + 1);
+        __m128i const lowerLow = _mm_set1_epi8('a' - 1);
+        __m128i const lowerHigh = _mm_set1_epi8('z' + 1);
+        __m128i const underscore = _mm_set1_epi8('_');
+        __m128i const dollar = _mm_set1_epi8('$');
+
+        while (lexer->endBuffer - p >= 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+            __m128i punctuation = _mm_and_si128(_mm_cmpgt_epi8(chunk, punctuationLow), _mm_cmplt_epi8(chunk, punctuationHigh));
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, upperLow), _mm_cmplt_epi8(chunk, upperHigh));
+            __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(chunk, lowerLow), _mm_cmplt_epi8(chunk, lowerHigh));
+            __m128i allowed = _mm_or_si128(
+                _mm_or_si128(punctuation, _mm_or_si128(upper, lower)),
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, underscore), _mm_cmpeq_epi8(chunk, dollar)));
+
+            int mask = ~_mm_movemask_epi8(allowed) & 0xffff;
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+    }
+#endif
+
+    return p;
+}
+
 static int
 ASCIIPListLexerReadInlineComment(ASCIIPListLexer *lexer)
 {
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0' && *p != '\n' && *p != '\r'; p++)
-        ;
+    b = p;
+    p = ASCIIPListLexerSkipUntil(lexer, p, '\n', '\r', '\n');
     lexer->tokenLength = p - b;
     lexer->pointer = p;
 
@@ -120,11 +201,11 @@ ASCIIPListLexerReadLongComment(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 2;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\0'; p++) {
+    for (b = p; (p = ASCIIPListLexerSkipUntil(lexer, p, '\n', '*', '\n')) < lexer->endBuffer && *p != '\0'; p++) {
         if (p[0] == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
-        } else if (p[0] == '*' && p[1] == '/') {
+        } else if (p[0] == '*' && p + 1 < lexer->endBuffer && p[1] == '/') {
             lexer->tokenLength = p - b;
             lexer->pointer = p + 2;
             return kASCIIPListLexerTokenLongComment;
@@ -140,14 +221,14 @@ ASCIIPListLexerReadSingleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\'' && *p != '\0'; p++) {
+    for (b = p; (p = ASCIIPListLexerSkipUntil(lexer, p, '\'', '\n', '\n')) < lexer->endBuffer && *p != '\'' && *p != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
         }
     }
 
-    if (*p != '\'') {
+    if (p >= lexer->endBuffer || *p != '\'') {
         return kASCIIPListLexerUnterminatedQuotedString;
     }
 
@@ -163,7 +244,7 @@ ASCIIPListLexerReadDoubleQuotedString(ASCIIPListLexer *lexer)
     char const *b, *p = lexer->pointer + 1;
 
     lexer->tokenBegin = (p - lexer->inputBuffer);
-    for (b = p; *p != '\"' && *p != '\0'; p++) {
+    for (b = p; (p = ASCIIPListLexerSkipUntil(lexer, p, '\"', '\n', '\\')) < lexer->endBuffer && *p != '\"' && *p != '\0'; p++) {
         if (*p == '\n') {
             lexer->line++;
             lexer->lineStart = p + 1;
@@ -172,7 +253,7 @@ ASCIIPListLexerReadDoubleQuotedString(ASCIIPListLexer *lexer)
         }
     }
 
-    if (*p != '\"') {
+    if (p >= lexer->endBuffer || *p != '\"') {
         return kASCIIPListLexerUnterminatedQuotedString;
     }
 
@@ -315,8 +396,10 @@ ASCIIPListLexerReadKeyword(ASCIIPListLexer *lexer)
         /*
             * '$' is encountered in pbxproj files.
             */
-        while (isalnum(*p) || *p == '_' || *p == '.' || *p == '$' ||
-                              *p == '-' || *p == ':' || *p == '/') {
+        p = ASCIIPListLexerSkipUnquoted(lexer, p);
+        while (p < lexer->endBuffer &&
+               (isalnum(*p) || *p == '_' || *p == '.' || *p == '$' ||
+                              *p == '-' || *p == ':' || *p == '/')) {
             if (*p & 0x80) {
                 rc = kASCIIPListLexerInvalidToken;
                 break;
@@ -480,6 +563,7 @@ ASCIIPListLexerInit(ASCIIPListLexer *lexer, char const *buffer, int length,
     lexer->endBuffer = lexer->inputBuffer + length;
     lexer->style = style;
     lexer->line = 1;
+    lexer->vectorized = 1;
 }
 
 /* Convert sequence \xXX */
@@ -13,24 +13,15 @@
 #include <cinttypes>
 
 using plist::Format::ASCIIWriter;
-using plist::Object;
-using plist::String;
-using plist::Integer;
-using plist::Real;
-using plist::Boolean;
-using plist::Data;
 using plist::Date;
-using plist::Array;
-using plist::UID;
-using plist::Dictionary;
-using plist::CastTo;
 
 ASCIIWriter::
-ASCIIWriter(Object const *root, bool strings) :
-    _root   (root),
+ASCIIWriter(bool strings, Sink const &sink) :
     _strings(strings),
+    _sink   (sink),
     _indent (0),
-    _lastKey(false)
+    _lastKey(false),
+    _written(false)
 {
 }
 
@@ -56,13 +47,9 @@ NeedsQuoting(std::string const &string)
 }
 
 bool ASCIIWriter::
-write()
+finish()
 {
-    if (_strings && _root->type() != Dictionary::Type()) {
-        return false;
-    }
-
-    if (!handleObject(_root, true)) {
+    if (!_written || !_collections.empty()) {
         return false;
     }
 
@@ -72,18 +59,36 @@ write()
         }
     }
 
-    return true;
+    return flush(true);
 }
 
 /*
  * Low level functions.
  */
 
+/*
+ * Parts are passed on once they reach this size, so the whole output is
+ * never held at once. Parts end between characters.
+ */
+static size_t const ChunkSize = 64 * 1024;
+
+bool ASCIIWriter::
+flush(bool final)
+{
+    if (_contents.empty() || (!final && _contents.size() < ChunkSize)) {
+        return true;
+    }
+
+    bool result = _sink(_contents.data(), _contents.size());
+    _contents.clear();
+    return result;
+}
+
 bool ASCIIWriter::
 primitiveWriteString(std::string const &string)
 {
     _contents.insert(_contents.end(), string.begin(), string.end());
-    return true;
+    return flush(false);
 }
 
 bool ASCIIWriter::
@@ -194,54 +199,73 @@ writeEscapedString(std::string const &string, bool final)
  */
 
 bool ASCIIWriter::
-handleObject(Object const *object, bool root)
+beginValue()
 {
-    if (Dictionary const *dictionary = CastTo<Dictionary>(object)) {
-        if (!handleDictionary(dictionary, root)) {
-            return false;
-        }
-    } else if (Array const *array = CastTo<Array>(object)) {
-        if (!handleArray(array, root)) {
-            return false;
-        }
-    } else if (Boolean const *boolean = CastTo<Boolean>(object)) {
-        if (!handleBoolean(boolean, root)) {
-            return false;
-        }
-    } else if (Integer const *integer = CastTo<Integer>(object)) {
-        if (!handleInteger(integer, root)) {
-            return false;
-        }
-    } else if (Real const *real = CastTo<Real>(object)) {
-        if (!handleReal(real, root)) {
-            return false;
-        }
-    } else if (String const *string = CastTo<String>(object)) {
-        if (!handleString(string, root)) {
-            return false;
-        }
-    } else if (Data const *data = CastTo<Data>(object)) {
-        if (!handleData(data, root)) {
-            return false;
-        }
-    } else if (Date const *date = CastTo<Date>(object)) {
-        if (!handleDate(date, root)) {
+    if (_collections.empty()) {
+        /* Only one root, which for strings must be a dictionary. */
+        return !_written;
+    }
+
+    Collection const &collection = _collections.back();
+    if (collection.dictionary) {
+        /* Each value in a dictionary must follow its key. */
+        return _lastKey;
+    }
+
+    /* Write ',' if not first entry. */
+    if (collection.count != 0) {
+        if (!writeString(",\n", false)) {
             return false;
         }
-    } else if (UID const *uid = CastTo<UID>(object)) {
-        if (!handleUID(uid, root)) {
+    }
+
+    return true;
+}
+
+bool ASCIIWriter::
+endValue()
+{
+    _lastKey = false;
+
+    if (_collections.empty()) {
+        _written = true;
+        return true;
+    }
+
+    Collection &collection = _collections.back();
+    collection.count++;
+
+    if (collection.dictionary) {
+        if (!writeString(";\n", false)) {
             return false;
         }
-    } else {
-        return false;
     }
 
     return true;
 }
 
 bool ASCIIWriter::
-handleDictionary(Dictionary const *dictionary, bool root)
+writeValue(std::string const &string, bool escaped)
 {
+    if (!beginValue() || (_strings && _collections.empty())) {
+        return false;
+    }
+
+    if (!(escaped ? writeEscapedString(string, !_lastKey) : writeString(string, !_lastKey))) {
+        return false;
+    }
+
+    return endValue();
+}
+
+bool ASCIIWriter::
+beginDictionary()
+{
+    if (!beginValue()) {
+        return false;
+    }
+
+    bool root = _collections.empty();
     if (!_strings || !root) {
         /* Write '{'. */
         if (!writeString("{\n", !_lastKey)) {
@@ -252,29 +276,39 @@ handleDictionary(Dictionary const *dictionary, bool root)
     }
 
     _lastKey = false;
+    _collections.push_back({ true, root, 0 });
+    return true;
+}
 
-    for (size_t i = 0; i < dictionary->count(); ++i) {
-        _lastKey = false;
-
-        if (!writeEscapedString(dictionary->key(i), !_lastKey)) {
-            return false;
-        }
+bool ASCIIWriter::
+key(std::string const &key)
+{
+    if (_collections.empty() || !_collections.back().dictionary || _lastKey) {
+        return false;
+    }
 
-        if (!writeString(" = ", false)) {
-            return false;
-        }
+    if (!writeEscapedString(key, true)) {
+        return false;
+    }
 
-        _lastKey = true;
+    if (!writeString(" = ", false)) {
+        return false;
+    }
 
-        if (!handleObject(dictionary->value(i), false)) {
-            return false;
-        }
+    _lastKey = true;
+    return true;
+}
 
-        if (!writeString(";\n", false)) {
-            return false;
-        }
+bool ASCIIWriter::
+endDictionary()
+{
+    if (_collections.empty() || !_collections.back().dictionary || _lastKey) {
+        return false;
     }
 
+    bool root = _collections.back().root;
+    _collections.pop_back();
+
     if (!_strings || !root) {
         _indent--;
         if (!writeString("}", true)) {
@@ -282,12 +316,16 @@ handleDictionary(Dictionary const *dictionary, bool root)
         }
     }
 
-    return true;
+    return endValue();
 }
 
 bool ASCIIWriter::
-handleArray(Array const *array, bool root)
+beginArray()
 {
+    if (!beginValue() || (_strings && _collections.empty())) {
+        return false;
+    }
+
     /* Write '('. */
     if (!writeString("(\n", !_lastKey)) {
         return false;
@@ -296,61 +334,55 @@ handleArray(Array const *array, bool root)
     _lastKey = false;
 
     _indent++;
+    _collections.push_back({ false, false, 0 });
+    return true;
+}
 
-    for (size_t i = 0; i < array->count(); ++i) {
-        /* Write ',' if not first entry. */
-        if (i != 0) {
-            if (!writeString(",\n", false)) {
-                return false;
-            }
-        }
-
-        if (!handleObject(array->value(i), false)) {
-            return false;
-        }
+bool ASCIIWriter::
+endArray()
+{
+    if (_collections.empty() || _collections.back().dictionary) {
+        return false;
     }
 
+    _collections.pop_back();
+
     /* Write ')'. */
     if (!writeString("\n", false)) {
         return false;
     }
 
     _indent--;
-    return writeString(")", true);
-}
-
-bool ASCIIWriter::
-handleBoolean(Boolean const *boolean, bool root)
-{
-    if (!writeString(boolean->value() ? "YES" : "NO", !_lastKey)) {
+    if (!writeString(")", true)) {
         return false;
     }
 
-    _lastKey = false;
-    return true;
+    return endValue();
 }
 
 bool ASCIIWriter::
-handleString(String const *string, bool root)
+boolean(bool value)
 {
-    if (!writeEscapedString(string->value(), !_lastKey)) {
-        return false;
-    }
+    return writeValue(value ? "YES" : "NO", false);
+}
 
-    _lastKey = false;
-    return true;
+bool ASCIIWriter::
+string(std::string const &value)
+{
+    return writeValue(value, true);
 }
 
 bool ASCIIWriter::
-handleData(Data const *data, bool root)
+data(std::vector<uint8_t> const &value)
 {
-    if (!writeString("<", !_lastKey)) {
+    if (!beginValue() || (_strings && _collections.empty())) {
         return false;
     }
 
-    _lastKey = false;
+    if (!writeString("<", !_lastKey)) {
+        return false;
+    }
 
-    std::vector<uint8_t> const &value = data->value();
     for (auto it : value) {
         char buf[3];
         int  rc = snprintf(buf, sizeof(buf), "%02x", it);
@@ -362,61 +394,57 @@ handleData(Data const *data, bool root)
         }
     }
 
-    return writeString(">", false);
+    if (!writeString(">", false)) {
+        return false;
+    }
+
+    return endValue();
 }
 
 bool ASCIIWriter::
-handleReal(Real const *real, bool root)
+real(double value)
 {
     char buf[64];
-    int rc = snprintf(buf, sizeof(buf), "%g", real->value());
+    int rc = snprintf(buf, sizeof(buf), "%g", value);
     assert(rc < (int)sizeof(buf));
     (void)rc;
 
-    if (!writeString(buf, !_lastKey)) {
-        return false;
-    }
-
-    _lastKey = false;
-
-    return true;
+    return writeValue(buf, false);
 }
 
 bool ASCIIWriter::
-handleInteger(Integer const *integer, bool root)
+integer(int64_t value)
 {
     int               rc;
     char              buf[32];
 
-    rc = snprintf(buf, sizeof(buf), "%" PRId64, integer->value());
+    rc = snprintf(buf, sizeof(buf), "%" PRId64, value);
     assert(rc < (int)sizeof(buf));
     (void)rc;
 
-    if (!writeString(buf, !_lastKey)) {
-        return false;
-    }
-
-    _lastKey = false;
-
-    return true;
+    return writeValue(buf, false);
 }
 
 bool ASCIIWriter::
-handleDate(Date const *date, bool root)
+null()
 {
-    if (!writeEscapedString(date->stringValue(), !_lastKey)) {
-        return false;
-    }
+    /* ASCII has no null. */
+    return false;
+}
 
-    _lastKey = false;
-    return true;
+bool ASCIIWriter::
+date(struct tm const &value)
+{
+    return writeValue(Date::New(value)->stringValue(), true);
 }
 
 bool ASCIIWriter::
-handleUID(UID const *uid, bool root)
+uid(uint32_t value)
 {
+    if (_strings && _collections.empty()) {
+        return false;
+    }
+
     /* Write a CF$UID dictionary. */
-    std::unique_ptr<Dictionary> dictionary = Dictionary::New();
-    dictionary->set("CF$UID", Integer::New(uid->value()));
-    return handleDictionary(dictionary.get(), root);
+    return beginDictionary() && key("CF$UID") && integer(value) && endDictionary();
 }
@@ -9,6 +9,7 @@
 #include <plist/Format/Any.h>
 
 using plist::Format::Format;
+using plist::Format::Sink;
 using plist::Format::Any;
 using plist::Format::Type;
 using plist::Object;
@@ -110,6 +111,29 @@ Deserialize(std::vector<uint8_t> const &contents, Any const &format)
     abort();
 }
 
+template<typename T>
+static std::pair<bool, std::string>
+VisitImpl(std::vector<uint8_t> const &contents, Any const &format, Visitor *visitor)
+{
+    return T::Visit(contents, *format.format<T>(), visitor);
+}
+
+template<>
+std::pair<bool, std::string> Format<Any>::
+Visit(std::vector<uint8_t> const &contents, Any const &format, Visitor *visitor)
+{
+    switch (format.type()) {
+        case Type::Binary:
+            return VisitImpl<Binary>(contents, format, visitor);
+        case Type::XML:
+            return VisitImpl<XML>(contents, format, visitor);
+        case Type::ASCII:
+            return VisitImpl<ASCII>(contents, format, visitor);
+    }
+
+    abort();
+}
+
 template<typename T>
 static std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string>
 SerializeImpl(Object const *object, Any const &format)
@@ -137,4 +161,31 @@ Serialize(Object const *object, Any const &format)
     abort();
 }
 
+template<typename T>
+static std::pair<bool, std::string>
+SerializeImpl(Object const *object, Any const &format, Sink const &sink)
+{
+    return T::Serialize(object, *format.format<T>(), sink);
+}
+
+template<>
+std::pair<bool, std::string> Format<Any>::
+Serialize(Object const *object, Any const &format, Sink const &sink)
+{
+    if (object == nullptr) {
+        return std::make_pair(false, "invalid object to serialize");
+    }
+
+    switch (format.type()) {
+        case Type::Binary:
+            return SerializeImpl<Binary>(object, format, sink);
+        case Type::XML:
+            return SerializeImpl<XML>(object, format, sink);
+        case Type::ASCII:
+            return SerializeImpl<ASCII>(object, format, sink);
+    }
+
+    abort();
+}
+
 } }
@@ -25,8 +25,18 @@ BaseXMLParser::BaseXMLParser() :
 bool BaseXMLParser::
 parse(std::vector<uint8_t> const &contents)
 {
+    return parse(contents.data(), contents.size());
+}
+
+bool BaseXMLParser::
+parse(uint8_t const *data, size_t size)
+{
+    /* libxml2 must be initialized once before parsing on several threads. */
+    static std::once_flag initialized;
+    std::call_once(initialized, [] { ::xmlInitParser(); });
+
     _errored = false;
-    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(contents.data()), contents.size(), nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
+    _parser = ::xmlReaderForMemory(reinterpret_cast<char const *>(data), size, nullptr, nullptr, XML_PARSE_NOENT | XML_PARSE_NONET);
     if (_parser == nullptr) {
         return false;
     }
@@ -18,6 +18,8 @@
 using plist::Format::Type;
 using plist::Format::Format;
 using plist::Format::Binary;
+using plist::Format::Sink;
+using plist::Format::Visitor;
 using plist::Object;
 
 Binary::
@@ -37,35 +39,21 @@ template<>
 std::unique_ptr<Binary> Format<Binary>::
 Identify(std::vector<uint8_t> const &contents)
 {
-    size_t length = strlen(ABPLIST_MAGIC ABPLIST_VERSION);
-
-    if (contents.size() < length) {
-        return nullptr;
-    }
-
-    if (std::memcmp(contents.data(), ABPLIST_MAGIC ABPLIST_VERSION, length) == 0) {
-        return std::unique_ptr<Binary>(new Binary(Binary::Create()));
-    }
-
-    return nullptr;
+    return Binary::Identify(contents.data(), contents.size());
 }
 
 template<>
 std::pair<std::unique_ptr<Object>, std::string> Format<Binary>::
 Deserialize(std::vector<uint8_t> const &contents, Binary const &format)
 {
-    ABPReader reader = ABPReader(&contents);
-
-    std::unique_ptr<Object> object = nullptr;
-    if (reader.open()) {
-        Object *topObject = reader.readTopLevelObject();
-        if (topObject != nullptr) {
-            object = topObject->copy();
-        }
-        reader.close();
-    }
+    return Binary::Deserialize(contents.data(), contents.size(), format);
+}
 
-    return std::make_pair(std::move(object), reader.error());
+template<>
+std::pair<bool, std::string> Format<Binary>::
+Visit(std::vector<uint8_t> const &contents, Binary const &format, Visitor *visitor)
+{
+    return Binary::Visit(contents.data(), contents.size(), format, visitor);
 }
 
 template<>
@@ -100,6 +88,32 @@ Serialize(Object const *object, Binary const &format)
     return std::make_pair(std::move(contents), std::string());
 }
 
+template<>
+std::pair<bool, std::string> Format<Binary>::
+Serialize(Object const *object, Binary const &format, Sink const &sink)
+{
+    /* The offset table and trailer are written last, so all of it streams. */
+    ABPWriter writer(sink);
+
+    if (!writer.open()) {
+        return std::make_pair(false, "open failed");
+    }
+
+    if (!writer.writeTopLevelObject(object)) {
+        return std::make_pair(false, "write failed");
+    }
+
+    if (!writer.finalize()) {
+        return std::make_pair(false, "finalize failed");
+    }
+
+    if (!writer.close()) {
+        return std::make_pair(false, "close failed");
+    }
+
+    return std::make_pair(true, std::string());
+}
+
 } }
 
 Binary Binary::
@@ -107,3 +121,47 @@ Create()
 {
     return Binary();
 }
+
+std::unique_ptr<Binary> Binary::
+Identify(uint8_t const *data, size_t size)
+{
+    size_t length = strlen(ABPLIST_MAGIC ABPLIST_VERSION);
+
+    if (size < length) {
+        return nullptr;
+    }
+
+    if (std::memcmp(data, ABPLIST_MAGIC ABPLIST_VERSION, length) == 0) {
+        return std::unique_ptr<Binary>(new Binary(Binary::Create()));
+    }
+
+    return nullptr;
+}
+
+std::pair<std::unique_ptr<Object>, std::string> Binary::
+Deserialize(uint8_t const *data, size_t size, Binary const &format)
+{
+    ABPReader reader = ABPReader(data, size);
+
+    std::unique_ptr<Object> object = nullptr;
+    if (reader.open()) {
+        object = std::unique_ptr<Object>(reader.takeTopLevelObject());
+        reader.close();
+    }
+
+    return std::make_pair(std::move(object), reader.error());
+}
+
+std::pair<bool, std::string> Binary::
+Visit(uint8_t const *data, size_t size, Binary const &format, Visitor *visitor)
+{
+    ABPReader reader = ABPReader(data, size);
+
+    bool success = false;
+    if (reader.open()) {
+        success = reader.visit(reader.topLevelReference(), visitor);
+        reader.close();
+    }
+
+    return std::make_pair(success, reader.error());
+}
@@ -0,0 +1,202 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <plist/Format/BinaryDocument.h>
+#include <plist/Format/ABPReader.h>
+#include <plist/Objects.h>
+
+using plist::Format::BinaryDocument;
+using plist::Object;
+using plist::ObjectType;
+
+BinaryDocument::
+BinaryDocument(std::unique_ptr<ABPReader> reader) :
+    _reader(std::move(reader))
+{
+}
+
+BinaryDocument::
+~BinaryDocument()
+{
+}
+
+BinaryDocument::Reference BinaryDocument::
+root() const
+{
+    return _reader->topLevelReference();
+}
+
+ObjectType BinaryDocument::
+type(Reference reference)
+{
+    switch (_reader->readRecordType(reference)) {
+        case kABPRecordTypeNull:
+            return ObjectType::Null;
+        case kABPRecordTypeBoolTrue:
+        case kABPRecordTypeBoolFalse:
+            return ObjectType::Boolean;
+        case kABPRecordTypeDate:
+            return ObjectType::Date;
+        case kABPRecordTypeInteger:
+            return ObjectType::Integer;
+        case kABPRecordTypeReal:
+            return ObjectType::Real;
+        case kABPRecordTypeData:
+            return ObjectType::Data;
+        case kABPRecordTypeStringASCII:
+        case kABPRecordTypeStringUnicode:
+            return ObjectType::String;
+        case kABPRecordTypeUid:
+            return ObjectType::UID;
+        case kABPRecordTypeArray:
+            return ObjectType::Array;
+        case kABPRecordTypeDictionary:
+            return ObjectType::Dictionary;
+        default:
+            return ObjectType::None;
+    }
+}
+
+std::vector<BinaryDocument::Reference> const *BinaryDocument::
+references(Reference reference)
+{
+    auto it = _references.find(reference);
+    if (it != _references.end()) {
+        return &it->second;
+    }
+
+    std::vector<Reference> references;
+    if (!_reader->readReferences(reference, &references)) {
+        return nullptr;
+    }
+
+    return &_references.insert({ reference, std::move(references) }).first->second;
+}
+
+size_t BinaryDocument::
+count(Reference reference)
+{
+    ObjectType type = this->type(reference);
+    if (type != ObjectType::Array && type != ObjectType::Dictionary) {
+        return 0;
+    }
+
+    std::vector<Reference> const *references = this->references(reference);
+    if (references == nullptr) {
+        return 0;
+    }
+
+    return (type == ObjectType::Dictionary ? references->size() / 2 : references->size());
+}
+
+bool BinaryDocument::
+value(Reference array, size_t index, Reference *value)
+{
+    if (type(array) != ObjectType::Array) {
+        return false;
+    }
+
+    std::vector<Reference> const *references = this->references(array);
+    if (references == nullptr || index >= references->size()) {
+        return false;
+    }
+
+    *value = (*references)[index];
+    return true;
+}
+
+plist::String const *BinaryDocument::
+readKey(Reference reference)
+{
+    /* Check the type first: reading a collection would read its contents. */
+    if (type(reference) != ObjectType::String) {
+        return nullptr;
+    }
+
+    /* Strings read are kept by the reader, so keys are only read once. */
+    return plist::CastTo<plist::String>(_reader->readObject(reference));
+}
+
+bool BinaryDocument::
+value(Reference dictionary, std::string const &key, Reference *value)
+{
+    if (type(dictionary) != ObjectType::Dictionary) {
+        return false;
+    }
+
+    std::vector<Reference> const *references = this->references(dictionary);
+    if (references == nullptr) {
+        return false;
+    }
+
+    /* Keys are first, then values in the same order. */
+    size_t count = references->size() / 2;
+    for (size_t n = 0; n < count; n++) {
+        plist::String const *current = readKey((*references)[n]);
+        if (current == nullptr) {
+            return false;
+        }
+
+        if (current->value() == key) {
+            *value = (*references)[count + n];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BinaryDocument::
+key(Reference dictionary, size_t index, std::string *key)
+{
+    if (type(dictionary) != ObjectType::Dictionary) {
+        return false;
+    }
+
+    std::vector<Reference> const *references = this->references(dictionary);
+    if (references == nullptr || index >= references->size() / 2) {
+        return false;
+    }
+
+    plist::String const *string = readKey((*references)[index]);
+    if (string == nullptr) {
+        return false;
+    }
+
+    *key = string->value();
+    return true;
+}
+
+std::unique_ptr<Object> BinaryDocument::
+object(Reference reference)
+{
+    Object *object = _reader->readObject(reference);
+    if (object == nullptr) {
+        return nullptr;
+    }
+
+    /* The reader keeps what it reads, as later lookups can use it again. */
+    return object->copy();
+}
+
+std::string const &BinaryDocument::
+error() const
+{
+    return _reader->error();
+}
+
+std::pair<std::unique_ptr<BinaryDocument>, std::string> BinaryDocument::
+Open(uint8_t const *data, size_t size)
+{
+    std::unique_ptr<ABPReader> reader = std::unique_ptr<ABPReader>(new ABPReader(data, size));
+    if (!reader->open()) {
+        return std::make_pair(nullptr, reader->error());
+    }
+
+    return std::make_pair(std::unique_ptr<BinaryDocument>(new BinaryDocument(std::move(reader))), std::string());
+}
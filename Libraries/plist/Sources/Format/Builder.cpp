@@ -0,0 +1,152 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <plist/Format/Builder.h>
+#include <plist/Objects.h>
+
+using plist::Format::Builder;
+using plist::Object;
+using plist::Array;
+using plist::Dictionary;
+
+Builder::
+Builder()
+{
+}
+
+Builder::
+~Builder()
+{
+}
+
+bool Builder::
+begin(std::unique_ptr<Object> container)
+{
+    _stack.push_back({ std::move(container), std::string() });
+    return true;
+}
+
+bool Builder::
+end()
+{
+    if (_stack.empty()) {
+        return false;
+    }
+
+    std::unique_ptr<Object> container = std::move(_stack.back().object);
+    _stack.pop_back();
+    return store(std::move(container));
+}
+
+bool Builder::
+store(std::unique_ptr<Object> value)
+{
+    if (_stack.empty()) {
+        /* Only one top level object. */
+        if (_root != nullptr) {
+            return false;
+        }
+
+        _root = std::move(value);
+        return true;
+    }
+
+    Container *container = &_stack.back();
+    if (Array *array = CastTo<Array>(container->object.get())) {
+        array->append(std::move(value));
+    } else if (Dictionary *dict = CastTo<Dictionary>(container->object.get())) {
+        dict->set(container->key, std::move(value));
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+bool Builder::
+beginArray()
+{
+    return begin(Array::New());
+}
+
+bool Builder::
+endArray()
+{
+    return end();
+}
+
+bool Builder::
+beginDictionary()
+{
+    return begin(Dictionary::New());
+}
+
+bool Builder::
+key(std::string const &key)
+{
+    if (_stack.empty()) {
+        return false;
+    }
+
+    _stack.back().key = key;
+    return true;
+}
+
+bool Builder::
+endDictionary()
+{
+    return end();
+}
+
+bool Builder::
+string(std::string const &value)
+{
+    return store(plist::String::New(value));
+}
+
+bool Builder::
+integer(int64_t value)
+{
+    return store(plist::Integer::New(value));
+}
+
+bool Builder::
+real(double value)
+{
+    return store(plist::Real::New(value));
+}
+
+bool Builder::
+boolean(bool value)
+{
+    return store(plist::Boolean::New(value));
+}
+
+bool Builder::
+null()
+{
+    return store(plist::Null::New());
+}
+
+bool Builder::
+data(std::vector<uint8_t> const &value)
+{
+    return store(plist::Data::New(value));
+}
+
+bool Builder::
+date(struct tm const &value)
+{
+    return store(plist::Date::New(value));
+}
+
+bool Builder::
+uid(uint32_t value)
+{
+    return store(plist::UID::New(value));
+}
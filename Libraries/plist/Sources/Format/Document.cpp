@@ -0,0 +1,519 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <plist/Format/Document.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Visitor.h>
+#include <plist/Objects.h>
+
+#include <algorithm>
+#include <cstring>
+
+using plist::Format::Document;
+using plist::Format::Visitor;
+using plist::Format::Any;
+using plist::Object;
+using plist::ObjectType;
+
+/*
+ * Size of the blocks values are allocated from. Larger values get a block
+ * of their own.
+ */
+static size_t const BlockSize = 64 * 1024;
+
+/*
+ * Dictionaries with more keys than this also store the order of their keys
+ * when sorted, to look them up by binary search.
+ */
+static size_t const IndexThreshold = 8;
+
+static int
+CompareKey(char const *a, size_t aSize, char const *b, size_t bSize)
+{
+    int result = ::memcmp(a, b, std::min(aSize, bSize));
+    if (result != 0) {
+        return result;
+    }
+
+    return (aSize < bSize ? -1 : (aSize > bSize ? 1 : 0));
+}
+
+/*
+ * Receives the parsed property list and copies it into the document. The
+ * values in each array or dictionary are collected here until it ends,
+ * then copied next to each other into the document.
+ */
+class Document::Builder : public Visitor {
+private:
+    struct Frame {
+        ObjectType  type;
+        size_t      values;
+        size_t      keys;
+    };
+
+private:
+    Document                 *_document;
+    std::vector<Frame>        _frames;
+    std::vector<Node>         _values;
+    std::vector<Node const *> _keys;
+    std::vector<Node const *> _interned;
+    size_t                    _internedCount;
+
+public:
+    explicit Builder(Document *document) :
+        _document     (document),
+        _interned     (1024, nullptr),
+        _internedCount(0)
+    {
+    }
+
+public:
+    bool complete() const
+    { return _frames.empty() && _document->_root != nullptr; }
+
+private:
+    char const *copy(std::string const &value)
+    {
+        char *string = static_cast<char *>(_document->allocate(value.size() + 1, 1));
+        ::memcpy(string, value.data(), value.size());
+        string[value.size()] = '\0';
+        return string;
+    }
+
+    static size_t hash(char const *data, size_t size)
+    {
+        /* FNV-1a */
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t n = 0; n < size; n++) {
+            hash = (hash ^ static_cast<uint8_t>(data[n])) * 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    /*
+     * The key with a value, stored the first time it is seen.
+     */
+    Node const *intern(std::string const &value)
+    {
+        if ((_internedCount + 1) * 2 > _interned.size()) {
+            std::vector<Node const *> interned = std::vector<Node const *>(_interned.size() * 2, nullptr);
+            for (Node const *key : _interned) {
+                if (key != nullptr) {
+                    size_t slot = hash(key->_value.string, key->_count) & (interned.size() - 1);
+                    while (interned[slot] != nullptr) {
+                        slot = (slot + 1) & (interned.size() - 1);
+                    }
+                    interned[slot] = key;
+                }
+            }
+            _interned = std::move(interned);
+        }
+
+        size_t slot = hash(value.data(), value.size()) & (_interned.size() - 1);
+        while (_interned[slot] != nullptr) {
+            if (_interned[slot]->equals(value)) {
+                return _interned[slot];
+            }
+            slot = (slot + 1) & (_interned.size() - 1);
+        }
+
+        Node *key = static_cast<Node *>(_document->allocate(sizeof(Node), alignof(Node)));
+        key->_type = ObjectType::String;
+        key->_count = static_cast<uint32_t>(value.size());
+        key->_value.string = copy(value);
+        key->_keys = nullptr;
+
+        _interned[slot] = key;
+        _internedCount++;
+        return key;
+    }
+
+    bool store(Node const &value)
+    {
+        if (_frames.empty()) {
+            /* Only one top level value. */
+            if (_document->_root != nullptr) {
+                return false;
+            }
+
+            Node *root = static_cast<Node *>(_document->allocate(sizeof(Node), alignof(Node)));
+            *root = value;
+            _document->_root = root;
+            return true;
+        }
+
+        /* Each value in a dictionary follows its key. */
+        Frame const &frame = _frames.back();
+        if (frame.type == ObjectType::Dictionary && _keys.size() - frame.keys != _values.size() - frame.values + 1) {
+            return false;
+        }
+
+        _values.push_back(value);
+        return true;
+    }
+
+    Node scalar(ObjectType type)
+    {
+        Node node;
+        node._type = type;
+        node._count = 0;
+        node._value.integer = 0;
+        node._keys = nullptr;
+        return node;
+    }
+
+    bool begin(ObjectType type)
+    {
+        _frames.push_back({ type, _values.size(), _keys.size() });
+        return true;
+    }
+
+    bool end(ObjectType type)
+    {
+        if (_frames.empty() || _frames.back().type != type) {
+            return false;
+        }
+
+        Frame frame = _frames.back();
+        _frames.pop_back();
+
+        size_t count = _values.size() - frame.values;
+        if (type == ObjectType::Dictionary && _keys.size() - frame.keys != count) {
+            return false;
+        }
+
+        Node node = scalar(type);
+        node._count = static_cast<uint32_t>(count);
+
+        Node *values = static_cast<Node *>(_document->allocate(sizeof(Node) * count, alignof(Node)));
+        std::copy(_values.begin() + frame.values, _values.end(), values);
+        _values.resize(frame.values);
+        node._value.values = values;
+
+        if (type == ObjectType::Dictionary) {
+            /* The keys, followed by their sorted order if there are many. */
+            size_t size = sizeof(Node const *) * count;
+            if (count > IndexThreshold) {
+                size += sizeof(uint32_t) * count;
+            }
+
+            Node const **keys = static_cast<Node const **>(_document->allocate(size, alignof(Node const *)));
+            std::copy(_keys.begin() + frame.keys, _keys.end(), keys);
+            _keys.resize(frame.keys);
+            node._keys = keys;
+
+            if (count > IndexThreshold) {
+                uint32_t *index = reinterpret_cast<uint32_t *>(keys + count);
+                for (size_t n = 0; n < count; n++) {
+                    index[n] = static_cast<uint32_t>(n);
+                }
+
+                /* Stable, so the last of any repeated key is found last. */
+                std::stable_sort(index, index + count, [keys](uint32_t a, uint32_t b) {
+                    Node const *ka = keys[a];
+                    Node const *kb = keys[b];
+                    return CompareKey(ka->_value.string, ka->_count, kb->_value.string, kb->_count) < 0;
+                });
+            }
+        }
+
+        return store(node);
+    }
+
+public:
+    virtual bool beginArray()
+    { return begin(ObjectType::Array); }
+
+    virtual bool endArray()
+    { return end(ObjectType::Array); }
+
+    virtual bool beginDictionary()
+    { return begin(ObjectType::Dictionary); }
+
+    virtual bool key(std::string const &key)
+    {
+        if (_frames.empty() || _frames.back().type != ObjectType::Dictionary) {
+            return false;
+        }
+
+        Frame const &frame = _frames.back();
+        if (_keys.size() - frame.keys != _values.size() - frame.values) {
+            return false;
+        }
+
+        _keys.push_back(intern(key));
+        return true;
+    }
+
+    virtual bool endDictionary()
+    { return end(ObjectType::Dictionary); }
+
+public:
+    virtual bool string(std::string const &value)
+    {
+        Node node = scalar(ObjectType::String);
+        node._count = static_cast<uint32_t>(value.size());
+        node._value.string = copy(value);
+        return store(node);
+    }
+
+    virtual bool integer(int64_t value)
+    {
+        Node node = scalar(ObjectType::Integer);
+        node._value.integer = value;
+        return store(node);
+    }
+
+    virtual bool real(double value)
+    {
+        Node node = scalar(ObjectType::Real);
+        node._value.real = value;
+        return store(node);
+    }
+
+    virtual bool boolean(bool value)
+    {
+        Node node = scalar(ObjectType::Boolean);
+        node._value.boolean = value;
+        return store(node);
+    }
+
+    virtual bool null()
+    {
+        return store(scalar(ObjectType::Null));
+    }
+
+    virtual bool data(std::vector<uint8_t> const &value)
+    {
+        uint8_t *data = static_cast<uint8_t *>(_document->allocate(value.size(), 1));
+        std::copy(value.begin(), value.end(), data);
+
+        Node node = scalar(ObjectType::Data);
+        node._count = static_cast<uint32_t>(value.size());
+        node._value.data = data;
+        return store(node);
+    }
+
+    virtual bool date(struct tm const &value)
+    {
+        struct tm *date = static_cast<struct tm *>(_document->allocate(sizeof(struct tm), alignof(struct tm)));
+        *date = value;
+
+        Node node = scalar(ObjectType::Date);
+        node._value.date = date;
+        return store(node);
+    }
+
+    virtual bool uid(uint32_t value)
+    {
+        Node node = scalar(ObjectType::UID);
+        node._value.uid = value;
+        return store(node);
+    }
+};
+
+size_t Document::Node::
+count() const
+{
+    return (_type == ObjectType::Array || _type == ObjectType::Dictionary ? _count : 0);
+}
+
+Document::Node const *Document::Node::
+value(size_t index) const
+{
+    if ((_type != ObjectType::Array && _type != ObjectType::Dictionary) || index >= _count) {
+        return nullptr;
+    }
+
+    return &_value.values[index];
+}
+
+Document::Node const *Document::Node::
+key(size_t index) const
+{
+    if (_type != ObjectType::Dictionary || index >= _count) {
+        return nullptr;
+    }
+
+    return _keys[index];
+}
+
+Document::Node const *Document::Node::
+value(std::string const &key) const
+{
+    if (_type != ObjectType::Dictionary) {
+        return nullptr;
+    }
+
+    if (_count <= IndexThreshold) {
+        for (size_t n = _count; n > 0; n--) {
+            if (_keys[n - 1]->equals(key)) {
+                return &_value.values[n - 1];
+            }
+        }
+
+        return nullptr;
+    }
+
+    /* Find the last key not after the one looked up. */
+    uint32_t const *index = reinterpret_cast<uint32_t const *>(_keys + _count);
+    uint32_t const *found = std::upper_bound(index, index + _count, key, [this](std::string const &key, uint32_t n) {
+        return CompareKey(_keys[n]->_value.string, _keys[n]->_count, key.data(), key.size()) > 0;
+    });
+
+    if (found == index || !_keys[*(found - 1)]->equals(key)) {
+        return nullptr;
+    }
+
+    return &_value.values[*(found - 1)];
+}
+
+std::string Document::Node::
+string() const
+{
+    return (_type == ObjectType::String ? std::string(_value.string, _count) : std::string());
+}
+
+int64_t Document::Node::
+integer() const
+{
+    return (_type == ObjectType::Integer ? _value.integer : 0);
+}
+
+double Document::Node::
+real() const
+{
+    return (_type == ObjectType::Real ? _value.real : 0.0);
+}
+
+bool Document::Node::
+boolean() const
+{
+    return (_type == ObjectType::Boolean ? _value.boolean : false);
+}
+
+uint32_t Document::Node::
+uid() const
+{
+    return (_type == ObjectType::UID ? _value.uid : 0);
+}
+
+std::vector<uint8_t> Document::Node::
+data() const
+{
+    return (_type == ObjectType::Data ? std::vector<uint8_t>(_value.data, _value.data + _count) : std::vector<uint8_t>());
+}
+
+struct tm Document::Node::
+date() const
+{
+    return (_type == ObjectType::Date ? *_value.date : tm());
+}
+
+bool Document::Node::
+equals(std::string const &value) const
+{
+    return _type == ObjectType::String && CompareKey(_value.string, _count, value.data(), value.size()) == 0;
+}
+
+std::unique_ptr<Object> Document::Node::
+object() const
+{
+    switch (_type) {
+        case ObjectType::Integer:
+            return plist::Integer::New(_value.integer);
+        case ObjectType::Real:
+            return plist::Real::New(_value.real);
+        case ObjectType::String:
+            return plist::String::New(string());
+        case ObjectType::Boolean:
+            return plist::Boolean::New(_value.boolean);
+        case ObjectType::Null:
+            return plist::Null::New();
+        case ObjectType::Data:
+            return plist::Data::New(_value.data, _count);
+        case ObjectType::Date:
+            return plist::Date::New(*_value.date);
+        case ObjectType::UID:
+            return plist::UID::New(_value.uid);
+        case ObjectType::Array: {
+            std::unique_ptr<plist::Array> array = plist::Array::New();
+            for (size_t n = 0; n < _count; n++) {
+                array->append(_value.values[n].object());
+            }
+            return std::move(array);
+        }
+        case ObjectType::Dictionary: {
+            std::unique_ptr<plist::Dictionary> dict = plist::Dictionary::New();
+            for (size_t n = 0; n < _count; n++) {
+                dict->set(_keys[n]->string(), _value.values[n].object());
+            }
+            return std::move(dict);
+        }
+        case ObjectType::None:
+            break;
+    }
+
+    return nullptr;
+}
+
+Document::
+Document() :
+    _next     (nullptr),
+    _available(0),
+    _root     (nullptr)
+{
+}
+
+Document::
+~Document()
+{
+}
+
+void *Document::
+allocate(size_t size, size_t alignment)
+{
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(_next) % alignment) % alignment;
+    if (_next == nullptr || padding + size > _available) {
+        /* New blocks are aligned for any value. */
+        /* Values don't span blocks; a large one gets its own. */
+        size_t blockSize = std::max(BlockSize, size);
+        _blocks.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[blockSize]));
+        _next = _blocks.back().get();
+        _available = blockSize;
+        padding = 0;
+    }
+
+    void *result = _next + padding;
+    _next += padding + size;
+    _available -= padding + size;
+    return result;
+}
+
+std::pair<std::unique_ptr<Document>, std::string> Document::
+Deserialize(std::vector<uint8_t> const &contents)
+{
+    std::unique_ptr<Any> format = Any::Identify(contents);
+    if (format == nullptr) {
+        return std::make_pair(nullptr, "couldn't identify format");
+    }
+
+    std::unique_ptr<Document> document = std::unique_ptr<Document>(new Document());
+    Builder builder = Builder(document.get());
+
+    std::pair<bool, std::string> result = Any::Visit(contents, *format, &builder);
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
+    }
+
+    if (!builder.complete()) {
+        return std::make_pair(nullptr, "incomplete property list");
+    }
+
+    return std::make_pair(std::move(document), std::string());
+}
@@ -7,14 +7,18 @@
  */
 
 #include <plist/Format/JSON.h>
+#include <plist/Format/Builder.h>
 #include <plist/Format/JSONParser.h>
 #include <plist/Format/JSONWriter.h>
 
+using plist::Format::Builder;
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Sink;
 using plist::Format::JSON;
 using plist::Format::JSONParser;
 using plist::Format::JSONWriter;
+using plist::Format::Visitor;
 using plist::Object;
 
 JSON::
@@ -33,41 +37,73 @@ Identify(std::vector<uint8_t> const &contents)
 }
 
 template<>
-std::pair<std::unique_ptr<Object>, std::string> Format<JSON>::
-Deserialize(std::vector<uint8_t> const &contents, JSON const &format)
+std::pair<bool, std::string> Format<JSON>::
+Visit(std::vector<uint8_t> const &contents, JSON const &format, Visitor *visitor)
 {
-    std::unique_ptr<Object> root = nullptr;
-    std::string             error;
-
     /* Create lexer. */
     ASCIIPListLexer lexer;
     ASCIIPListLexerInit(&lexer, reinterpret_cast<char const *>(contents.data()), contents.size(), kASCIIPListLexerStyleJSON);
 
     /* Parse contents. */
-    JSONParser parser;
-    if (parser.parse(&lexer)) {
-        root = std::move(parser.root());
-    } else {
-        error = parser.error();
+    JSONParser parser = JSONParser(visitor);
+    if (!parser.parse(&lexer)) {
+        return std::make_pair(false, parser.error());
     }
 
-    return std::make_pair(std::move(root), error);
+    return std::make_pair(true, std::string());
 }
 
 template<>
-std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> Format<JSON>::
-Serialize(Object const *object, JSON const &format)
+std::pair<std::unique_ptr<Object>, std::string> Format<JSON>::
+Deserialize(std::vector<uint8_t> const &contents, JSON const &format)
+{
+    Builder builder;
+
+    auto result = Visit(contents, format, &builder);
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
+    }
+
+    return std::make_pair(std::move(builder.root()), std::string());
+}
+
+template<>
+std::pair<bool, std::string> Format<JSON>::
+Serialize(Object const *object, JSON const &format, Sink const &sink)
 {
     if (object == nullptr) {
-        return std::make_pair(nullptr, "object was null");
+        return std::make_pair(false, "object was null");
     }
 
-    JSONWriter writer = JSONWriter(object);
+    bool written = true;
+    Sink output = [&](uint8_t const *data, size_t size) -> bool {
+        written = sink(data, size);
+        return written;
+    };
+
+    JSONWriter writer = JSONWriter(object, output);
     if (!writer.write()) {
-        return std::make_pair(nullptr, "serialization failed");
+        return std::make_pair(false, written ? "serialization failed" : "write failed");
+    }
+
+    return std::make_pair(true, std::string());
+}
+
+template<>
+std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> Format<JSON>::
+Serialize(Object const *object, JSON const &format)
+{
+    auto contents = std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>());
+
+    auto result = Serialize(object, format, [&contents](uint8_t const *data, size_t size) -> bool {
+        contents->insert(contents->end(), data, data + size);
+        return true;
+    });
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(writer.contents())), std::string());
+    return std::make_pair(std::move(contents), std::string());
 }
 
 } }
@@ -7,18 +7,10 @@
  */
 
 #include <plist/Format/JSONParser.h>
-#include <plist/Objects.h>
 
 #include <cstdlib>
 
 using plist::Format::JSONParser;
-using plist::Object;
-using plist::String;
-using plist::Boolean;
-using plist::Real;
-using plist::Integer;
-using plist::Array;
-using plist::Dictionary;
 
 #if 0
 #define JSONDebug(...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
@@ -27,12 +19,10 @@ using plist::Dictionary;
 #endif
 
 JSONParser::
-JSONParser() :
-    _root(nullptr),
+JSONParser(Visitor *visitor) :
+    _visitor(visitor),
     _level(0),
     _state(ValueState::Init),
-    _container(nullptr),
-    _key(nullptr),
     _contextState(ContextState::Parsing)
 {
 }
@@ -84,7 +74,7 @@ abort(std::string const &error)
 }
 
 bool JSONParser::
-push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr<plist::String> key)
+push(ValueState state)
 {
     if (isAborted()) {
         return false;
@@ -93,25 +83,10 @@ push(ValueState state, std::unique_ptr<plist::Object> container, std::unique_ptr
     /* If valid state, push, otherwise just set the new state. */
     if (_state != ValueState::Init) {
         /* Push the old state */
-        _containerStack.push(std::move(_container));
-        _keyStack.push(std::move(_key));
         _stateStack.push(_state);
     }
 
     _state = state;
-
-    if (container != nullptr) {
-        _container = std::move(container);
-    } else {
-        _container = nullptr;
-    }
-
-    if (key != nullptr) {
-        _key = std::move(key);
-    } else {
-        _key = nullptr;
-    }
-
     return true;
 }
 
@@ -125,9 +100,6 @@ pop()
             return false; /* Underflow! */
 
         /* Reset current state. */
-        _container = nullptr;
-        _key = nullptr;
-
         _state = ValueState::Init;
         return true;
     }
@@ -136,12 +108,6 @@ pop()
     _state = std::move(_stateStack.top());
     _stateStack.pop();
 
-    _container = std::move(_containerStack.top());
-    _containerStack.pop();
-
-    _key = std::move(_keyStack.top());
-    _keyStack.pop();
-
     return true;
 }
 
@@ -149,17 +115,14 @@ pop()
  * Generic container handling.
  */
 bool JSONParser::
-beginContainer(std::unique_ptr<plist::Object> object)
+beginContainer(bool isArray)
 {
-    ValueState state;
-
-    if (object->type() == Array::Type()) {
-        state = ValueState::Array;
-    } else {
-        state = ValueState::Dictionary;
+    if (!(isArray ? _visitor->beginArray() : _visitor->beginDictionary())) {
+        abort("Stopped reading array/dictionary.");
+        return false;
     }
 
-    if (!push(state, std::move(object), nullptr)) {
+    if (!push(isArray ? ValueState::Array : ValueState::Dictionary)) {
         abort("Cannot push the current state.");
         return false;
     }
@@ -167,105 +130,27 @@ beginContainer(std::unique_ptr<plist::Object> object)
     return true;
 }
 
-bool JSONParser::
-storeKeyValue(std::unique_ptr<plist::String> key, std::unique_ptr<plist::Object> value)
-{
-    if (_container == nullptr) {
-        if (_key != nullptr) {
-            abort("Storing key/value pair with no container.");
-            return false;
-        }
-
-        /* Make current value the root. */
-        if (_root != nullptr) {
-            abort("Double root.");
-            return false;
-        }
-
-        _root = std::move(value);
-        return true;
-    }
-
-    if (key != nullptr) {
-        if (_container->type() != Dictionary::Type()) {
-            abort("Storing key/value with no dictionary container.");
-            return false;
-        }
-
-        plist::Dictionary *dict = static_cast<plist::Dictionary *>(_container.get());
-        dict->set(key->value(), std::move(value));
-
-        _state = ValueState::Dictionary;
-    } else {
-        if (_container->type() != Array::Type()) {
-            abort("Storing value with no array container.");
-            return false;
-        }
-
-        plist::Array *array = static_cast<plist::Array *>(_container.get());
-        array->append(std::move(value));
-
-        _state = ValueState::Array;
-    }
-
-    return true;
-}
-
 bool JSONParser::
 endContainer(bool isArray)
 {
-    std::unique_ptr<plist::String> key;
-    std::unique_ptr<plist::Object> value;
-    bool success;
-
     /* Check state is consistant. */
     if (_state != (isArray ? ValueState::Array : ValueState::Dictionary)) {
         abort("Closing array/dictionary in wrong state.");
         return false;
     }
 
-    if (_container == nullptr) {
-        abort("Closing non-opened container.");
-        return false;
-    }
-
-    value = std::move(_container);
-    if (value == nullptr) {
-        abort("Couldn't copy container.");
-        return false;
-    }
-
-    /* Is this the right type of container? */
-    if (value->type() != (isArray ? Array::Type() : Dictionary::Type())) {
-        abort("Closing wrong kind of container.");
-        return false;
-    }
-
     if (!pop()) {
         abort("Parser stack underflow.");
         return false;
     }
 
-    /* Take ownership of the saved key. */
-    key = std::move(_key);
-    _key = nullptr;
-
-    success = storeKeyValue(std::move(key), std::move(value));
-
-    return success;
+    return storeValue(isArray ? _visitor->endArray() : _visitor->endDictionary());
 }
 
 bool JSONParser::
 beginArray()
 {
-    std::unique_ptr<plist::Array> array = Array::New();
-    if (array == nullptr) {
-        abort("Cannot create an array.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(array));
-    return success;
+    return beginContainer(true);
 }
 
 bool JSONParser::
@@ -277,14 +162,7 @@ endArray()
 bool JSONParser::
 beginDictionary()
 {
-    std::unique_ptr<plist::Dictionary> dict = Dictionary::New();
-    if (dict == nullptr) {
-        abort("Cannot create a dictionary.");
-        return false;
-    }
-
-    bool success = beginContainer(std::move(dict));
-    return success;
+    return beginContainer(false);
 }
 
 bool JSONParser::
@@ -297,41 +175,38 @@ endDictionary()
  * Store the key of the current dictionary.
  */
 bool JSONParser::
-storeKey(std::unique_ptr<plist::String> key)
+storeKey(std::string const &key)
 {
-    if (key == nullptr) {
-        key = String::New();
-
-        if (key == nullptr) {
-            abort("Cannot create empty key.");
-            return false;
-        }
-    }
-
     if (_state != ValueState::Dictionary) {
         abort("Storing key in wrong state.");
         return false;
     }
 
-    _key = std::move(key);
+    if (!_visitor->key(key)) {
+        abort("Stopped reading key.");
+        return false;
+    }
 
     _state = ValueState::DictionaryValue;
     return true;
 }
 
+/*
+ * After a value is visited, expect the next key or value.
+ */
 bool JSONParser::
-storeValue(std::unique_ptr<plist::Object> value)
+storeValue(bool visited)
 {
-    bool success;
-
-    success = storeKeyValue(std::move(_key), std::move(value));
-    _key = nullptr;
+    if (!visited) {
+        abort("Stopped reading value.");
+        return false;
+    }
 
     if (_state == ValueState::DictionaryValue) {
         _state = ValueState::Dictionary;
     }
 
-    return success;
+    return true;
 }
 
 bool JSONParser::
@@ -452,10 +327,9 @@ parse(ASCIIPListLexer *lexer)
                         }
 
                         bool value = (token == kASCIIPListLexerTokenBoolTrue);
-                        std::unique_ptr<Boolean> boolean = Boolean::New(value);
 
                         JSONDebug("Storing boolean");
-                        if (!storeValue(std::move(boolean))) {
+                        if (!storeValue(_visitor->boolean(value))) {
                             return false;
                         }
                     } else if (token == kASCIIPListLexerTokenNull) {
@@ -464,10 +338,8 @@ parse(ASCIIPListLexer *lexer)
                             return false;
                         }
 
-                        std::unique_ptr<Null> null = Null::New();
-
                         JSONDebug("Storing null");
-                        if (!storeValue(std::move(null))) {
+                        if (!storeValue(_visitor->null())) {
                             return false;
                         }
                     } else if (token == kASCIIPListLexerTokenNumberInteger) {
@@ -483,10 +355,8 @@ parse(ASCIIPListLexer *lexer)
                         free(contents);
 
                         if (success) {
-                            std::unique_ptr<Integer> integer = Integer::New(value);
-
                             JSONDebug("Storing integer");
-                            if (!storeValue(std::move(integer))) {
+                            if (!storeValue(_visitor->integer(value))) {
                                 return false;
                             }
                         } else {
@@ -506,10 +376,8 @@ parse(ASCIIPListLexer *lexer)
                         free(contents);
 
                         if (success) {
-                            std::unique_ptr<Real> real = Real::New(value);
-
                             JSONDebug("Storing real");
-                            if (!storeValue(std::move(real))) {
+                            if (!storeValue(_visitor->real(value))) {
                                 return false;
                             }
                         } else {
@@ -518,23 +386,23 @@ parse(ASCIIPListLexer *lexer)
                         }
                     } else if (token == kASCIIPListLexerTokenQuotedString) {
                         char *contents = ASCIIPListCopyUnquotedString(lexer, '?');
-                        std::unique_ptr<String> string = String::New(std::string(contents));
-                        free(contents);
-
-                        if (string == NULL) {
+                        if (contents == NULL) {
                             abort("OOM when copying string");
                             return false;
                         }
 
+                        std::string string = std::string(contents);
+                        free(contents);
+
                         /* Container context */
                         if (isDictionary) {
-                            JSONDebug("Storing string %s as key", string->value().c_str());
-                            if (!storeKey(std::move(string))) {
+                            JSONDebug("Storing string %s as key", string.c_str());
+                            if (!storeKey(string)) {
                                 return false;
                             }
                         } else {
-                            JSONDebug("Storing string %s", string->value().c_str());
-                            if (!storeValue(std::move(string))) {
+                            JSONDebug("Storing string %s", string.c_str());
+                            if (!storeValue(_visitor->string(string))) {
                                 return false;
                             }
                         }
@@ -26,8 +26,9 @@ using plist::Dictionary;
 using plist::CastTo;
 
 JSONWriter::
-JSONWriter(Object const *root) :
+JSONWriter(Object const *root, Sink const &sink) :
     _root   (root),
+    _sink   (sink),
     _indent (0),
     _lastKey(false)
 {
@@ -45,18 +46,33 @@ write()
         return false;
     }
 
-    return true;
+    return flush(true);
 }
 
 /*
  * Low level functions.
  */
 
+/* Bytes collected before they are passed to the sink. */
+static size_t const ChunkSize = 64 * 1024;
+
+bool JSONWriter::
+flush(bool final)
+{
+    if (_contents.empty() || (!final && _contents.size() < ChunkSize)) {
+        return true;
+    }
+
+    bool result = _sink(_contents.data(), _contents.size());
+    _contents.clear();
+    return result;
+}
+
 bool JSONWriter::
 primitiveWriteString(std::string const &string)
 {
     _contents.insert(_contents.end(), string.begin(), string.end());
-    return true;
+    return flush(false);
 }
 
 bool JSONWriter::
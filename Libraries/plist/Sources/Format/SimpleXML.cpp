@@ -11,6 +11,7 @@
 
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Sink;
 using plist::Format::SimpleXML;
 using plist::Format::SimpleXMLParser;
 using plist::Object;
@@ -93,6 +94,13 @@ Serialize(Object const *object, SimpleXML const &format)
     return std::make_pair(nullptr, "not yet implemented");
 }
 
+template<>
+std::pair<bool, std::string> Format<SimpleXML>::
+Serialize(Object const *object, SimpleXML const &format, Sink const &sink)
+{
+    return std::make_pair(false, "not yet implemented");
+}
+
 } }
 
 SimpleXML SimpleXML::
@@ -0,0 +1,154 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <plist/Format/Visitor.h>
+#include <plist/Objects.h>
+
+using plist::Format::Visitor;
+using plist::Object;
+
+Visitor::
+Visitor()
+{
+}
+
+Visitor::
+~Visitor()
+{
+}
+
+bool Visitor::
+beginArray()
+{
+    return true;
+}
+
+bool Visitor::
+endArray()
+{
+    return true;
+}
+
+bool Visitor::
+beginDictionary()
+{
+    return true;
+}
+
+bool Visitor::
+key(std::string const &key)
+{
+    return true;
+}
+
+bool Visitor::
+endDictionary()
+{
+    return true;
+}
+
+bool Visitor::
+string(std::string const &value)
+{
+    return true;
+}
+
+bool Visitor::
+integer(int64_t value)
+{
+    return true;
+}
+
+bool Visitor::
+real(double value)
+{
+    return true;
+}
+
+bool Visitor::
+boolean(bool value)
+{
+    return true;
+}
+
+bool Visitor::
+null()
+{
+    return true;
+}
+
+bool Visitor::
+data(std::vector<uint8_t> const &value)
+{
+    return true;
+}
+
+bool Visitor::
+date(struct tm const &value)
+{
+    return true;
+}
+
+bool Visitor::
+uid(uint32_t value)
+{
+    return true;
+}
+
+bool Visitor::
+Visit(Object const *object, Visitor *visitor)
+{
+    if (object == nullptr) {
+        return false;
+    }
+
+    switch (object->type()) {
+        case ObjectType::Array: {
+            Array const *array = CastTo<Array>(object);
+            if (!visitor->beginArray()) {
+                return false;
+            }
+            for (size_t n = 0; n < array->count(); n++) {
+                if (!Visit(array->value(n), visitor)) {
+                    return false;
+                }
+            }
+            return visitor->endArray();
+        }
+        case ObjectType::Dictionary: {
+            Dictionary const *dict = CastTo<Dictionary>(object);
+            if (!visitor->beginDictionary()) {
+                return false;
+            }
+            for (size_t n = 0; n < dict->count(); n++) {
+                if (!visitor->key(dict->key(n)) || !Visit(dict->value(n), visitor)) {
+                    return false;
+                }
+            }
+            return visitor->endDictionary();
+        }
+        case ObjectType::String:
+            return visitor->string(CastTo<String>(object)->value());
+        case ObjectType::Integer:
+            return visitor->integer(CastTo<Integer>(object)->value());
+        case ObjectType::Real:
+            return visitor->real(CastTo<Real>(object)->value());
+        case ObjectType::Boolean:
+            return visitor->boolean(CastTo<Boolean>(object)->value());
+        case ObjectType::Null:
+            return visitor->null();
+        case ObjectType::Data:
+            return visitor->data(CastTo<Data>(object)->value());
+        case ObjectType::Date:
+            return visitor->date(CastTo<Date>(object)->value());
+        case ObjectType::UID:
+            return visitor->uid(CastTo<UID>(object)->value());
+        default:
+            return false;
+    }
+}
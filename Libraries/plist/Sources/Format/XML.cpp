@@ -7,15 +7,19 @@
  */
 
 #include <plist/Format/XML.h>
+#include <plist/Format/Builder.h>
 #include <plist/Format/XMLParser.h>
 #include <plist/Format/XMLWriter.h>
 
 using plist::Format::Type;
+using plist::Format::Builder;
 using plist::Format::Encoding;
 using plist::Format::Format;
+using plist::Format::Sink;
 using plist::Format::XML;
 using plist::Format::XMLParser;
 using plist::Format::XMLWriter;
+using plist::Format::Visitor;
 using plist::Object;
 
 XML::
@@ -80,37 +84,85 @@ Identify(std::vector<uint8_t> const &contents)
     return nullptr;
 }
 
+template<>
+std::pair<bool, std::string> Format<XML>::
+Visit(std::vector<uint8_t> const &contents, XML const &format, Visitor *visitor)
+{
+    /* UTF-8 contents are read in place; only other encodings are copied. */
+    std::vector<uint8_t> converted;
+    uint8_t const *data = contents.data();
+    size_t size = contents.size();
+    if (format.encoding() != Encoding::UTF8) {
+        converted = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+        data = converted.data();
+        size = converted.size();
+    }
+
+    XMLParser parser = XMLParser(visitor);
+    if (!parser.parse(data, size)) {
+        return std::make_pair(false, parser.error());
+    }
+
+    return std::make_pair(true, std::string());
+}
+
 template<>
 std::pair<std::unique_ptr<Object>, std::string> Format<XML>::
 Deserialize(std::vector<uint8_t> const &contents, XML const &format)
 {
-    std::vector<uint8_t> const data = Encodings::Convert(contents, format.encoding(), Encoding::UTF8);
+    Builder builder;
 
-    XMLParser parser;
-    std::unique_ptr<Object> root = std::unique_ptr<Object>(parser.parse(data));
-    if (root == nullptr) {
-        return std::make_pair(nullptr, parser.error());
+    auto result = Visit(contents, format, &builder);
+    if (!result.first || builder.root() == nullptr) {
+        return std::make_pair(nullptr, result.second);
     }
 
-    return std::make_pair(std::move(root), std::string());
+    return std::make_pair(std::move(builder.root()), std::string());
 }
 
 template<>
-std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> Format<XML>::
-Serialize(Object const *object, XML const &format)
+std::pair<bool, std::string> Format<XML>::
+Serialize(Object const *object, XML const &format, Sink const &sink)
 {
     if (object == nullptr) {
-        return std::make_pair(nullptr, "object was null");
+        return std::make_pair(false, "object was null");
     }
 
-    XMLWriter writer = XMLWriter(object);
+    /* The writer produces UTF-8; convert each part as it's written. */
+    bool written = true;
+    Sink output = [&](uint8_t const *data, size_t size) -> bool {
+        if (format.encoding() == Encoding::UTF8) {
+            written = sink(data, size);
+        } else {
+            std::vector<uint8_t> const converted = Encodings::Convert(std::vector<uint8_t>(data, data + size), Encoding::UTF8, format.encoding());
+            written = sink(converted.data(), converted.size());
+        }
+        return written;
+    };
+
+    XMLWriter writer = XMLWriter(object, output);
     if (!writer.write()) {
-        return std::make_pair(nullptr, "serialization failed");
+        return std::make_pair(false, written ? "serialization failed" : "write failed");
     }
 
-    std::vector<uint8_t> const data = Encodings::Convert(writer.contents(), Encoding::UTF8, format.encoding());
+    return std::make_pair(true, std::string());
+}
+
+template<>
+std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> Format<XML>::
+Serialize(Object const *object, XML const &format)
+{
+    auto contents = std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>());
+
+    auto result = Serialize(object, format, [&contents](uint8_t const *data, size_t size) -> bool {
+        contents->insert(contents->end(), data, data + size);
+        return true;
+    });
+    if (!result.first) {
+        return std::make_pair(nullptr, result.second);
+    }
 
-    return std::make_pair(std::unique_ptr<std::vector<uint8_t>>(new std::vector<uint8_t>(data.begin(), data.end())), std::string());
+    return std::make_pair(std::move(contents), std::string());
 }
 
 } }
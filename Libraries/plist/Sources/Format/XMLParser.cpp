@@ -7,60 +7,47 @@
  */
 
 #include <plist/Format/XMLParser.h>
+#include <plist/Base64.h>
+#include <plist/ISODate.h>
 
-#include <plist/Objects.h>
+#include <cstdlib>
 
 using plist::Format::XMLParser;
-using plist::Object;
+using plist::Base64;
+using plist::ISODate;
 
-XMLParser::XMLParser() :
+XMLParser::XMLParser(Visitor *visitor) :
     BaseXMLParser(),
-    _root        (nullptr)
+    _visitor     (visitor),
+    _root        (false),
+    _pending     (Pending::None),
+    _pendingValue(0)
 {
 }
 
-Object *XMLParser::
-parse(std::vector<uint8_t> const &contents)
+bool XMLParser::
+parse(uint8_t const *data, size_t size)
 {
-    if (_root != nullptr)
-        return nullptr;
-
-    if (!BaseXMLParser::parse(contents))
-        return nullptr;
+    if (_root)
+        return false;
 
-    return _root;
+    return BaseXMLParser::parse(data, size);
 }
 
 void XMLParser::
 onBeginParse()
 {
-    _root             = nullptr;
-    _state.current    = nullptr;
-    _state.key.valid  = false;
-    _state.key.active = false;
+    _root    = false;
+    _pending = Pending::None;
+    _stack.clear();
+    _cdata.clear();
 }
 
 void XMLParser::
 onEndParse(bool success)
 {
-    if (!success) {
-        if (_state.current != nullptr && _state.current != _root) {
-            _state.current->release();
-        }
-        for (auto const &s : _stack) {
-            if (s.current != _state.current && s.current != _root) {
-                s.current->release();
-            }
-        }
-        _stack.clear();
-        if (_root != nullptr) {
-            _root->release();
-            _root = nullptr;
-        }
-    }
-    _state.current    = nullptr;
-    _state.key.valid  = false;
-    _state.key.active = false;
+    _pending = Pending::None;
+    _stack.clear();
     _cdata.clear();
 }
 
@@ -78,11 +65,22 @@ onStartElement(std::string const &name, std::unordered_map<std::string, std::str
     // If we have a root, and depth == 1 there's an extra
     // entry after the first element, bail out.
     //
-    if (depth == 1 && _root != nullptr) {
+    if (depth == 1 && _root) {
         error("unexpected element '%s' after root element", name.c_str());
         return;
     }
 
+    //
+    // Anything but the key and value of a CF$UID means the
+    // dictionary being read is a dictionary after all.
+    //
+    if (!(_pending == Pending::Dictionary && name == "key") &&
+        !(_pending == Pending::Key && name == "integer")) {
+        if (!flush()) {
+            return;
+        }
+    }
+
     if (!beginObject(name, depth)) {
         return;
     }
@@ -91,7 +89,7 @@ onStartElement(std::string const &name, std::unordered_map<std::string, std::str
 void XMLParser::
 onEndElement(std::string const &name, size_t)
 {
-    if (!endObject(name)) {
+    if (!endObject(name) && !errored()) {
         error("unexpected end element: " + name);
     }
 }
@@ -120,30 +118,77 @@ inContainer(size_t depth) const
 inline bool XMLParser::
 inArray() const
 {
-    return (CastTo <Array> (_state.current) != nullptr);
+    return (!_stack.empty() && _stack.back().element == Element::Array);
 }
 
 inline bool XMLParser::
 inDictionary() const
 {
-    return (CastTo <Dictionary> (_state.current) != nullptr);
+    return (!_stack.empty() && _stack.back().element == Element::Dictionary);
 }
 
 inline bool XMLParser::
 isExpectingKey() const
 {
-    return (inDictionary() && !_state.key.valid);
+    return (inDictionary() && !_stack.back().key);
 }
 
 inline bool XMLParser::
 isExpectingCDATA() const
 {
-    return (CastTo <Integer> (_state.current) != nullptr ||
-            CastTo <Real> (_state.current) != nullptr ||
-            CastTo <String> (_state.current) != nullptr ||
-            CastTo <Data> (_state.current) != nullptr ||
-            CastTo <Date> (_state.current) != nullptr ||
-            (inDictionary() && _state.key.active));
+    if (_stack.empty()) {
+        return false;
+    }
+
+    switch (_stack.back().element) {
+        case Element::Integer:
+        case Element::Real:
+        case Element::String:
+        case Element::Data:
+        case Element::Date:
+        case Element::Key:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool XMLParser::
+visited(bool result)
+{
+    if (!result) {
+        error("stopped reading");
+    }
+    return result;
+}
+
+bool XMLParser::
+flush()
+{
+    Pending pending = _pending;
+    _pending = Pending::None;
+
+    if (pending == Pending::None) {
+        return true;
+    }
+
+    if (!visited(_visitor->beginDictionary())) {
+        return false;
+    }
+
+    if (pending == Pending::Key || pending == Pending::Value) {
+        if (!visited(_visitor->key("CF$UID"))) {
+            return false;
+        }
+    }
+
+    if (pending == Pending::Value) {
+        if (!visited(_visitor->integer(_pendingValue))) {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 bool XMLParser::
@@ -172,27 +217,24 @@ beginObject(std::string const &name, size_t depth)
         return false;
     }
 
-
     if (name == "array") {
         return beginArray();
     } else if (name == "dict") {
         return beginDictionary();
     } else if (name == "string") {
-        return beginString();
+        return beginValue(Element::String);
     } else if (name == "integer") {
-        return beginInteger();
+        return beginValue(Element::Integer);
     } else if (name == "real") {
-        return beginReal();
-    } else if (name == "true") {
-        return beginBoolean(true);
-    } else if (name == "false") {
-        return beginBoolean(false);
+        return beginValue(Element::Real);
+    } else if (name == "true" || name == "false") {
+        return beginValue(Element::Boolean);
     } else if (name == "null") {
-        return beginNull();
+        return beginValue(Element::Null);
     } else if (name == "data") {
-        return beginData();
+        return beginValue(Element::Data);
     } else if (name == "date") {
-        return beginDate();
+        return beginValue(Element::Date);
     }
 
     error("unexpected element '%s'", name.c_str());
@@ -217,7 +259,7 @@ endObject(std::string const &name)
     } else if (name == "real") {
         return endReal();
     } else if (name == "true" || name == "false") {
-        return endBoolean();
+        return endBoolean(name == "true");
     } else if (name == "null") {
         return endNull();
     } else if (name == "data") {
@@ -231,41 +273,27 @@ endObject(std::string const &name)
 }
 
 void XMLParser::
-push(Object *object)
+push(Element element)
 {
-    if (_state.current != nullptr) {
-        _stack.push_back(_state);
-    }
-    _state.current    = object;
-    _state.key.valid  = false;
-    _state.key.active = false;
-    if (_root == nullptr) {
-        _root = _state.current;
-    }
+    _stack.push_back({ element, false });
+    _root = true;
+    _cdata.clear();
 }
 
 void XMLParser::
 pop()
 {
-    if (_stack.empty() && _state.current == nullptr) {
+    if (_stack.empty()) {
         error("stack underflow");
         return;
     }
 
-    if (_state.current != _root) {
-        State old = _state;
-        _state = _stack.back();
-        _stack.pop_back();
+    Element element = _stack.back().element;
+    _stack.pop_back();
 
-        if (auto array = CastTo <Array> (_state.current)) {
-            array->append(std::unique_ptr<Object>(old.current));
-        } else if (auto dict = CastTo <Dictionary> (_state.current)) {
-            if (!isExpectingKey()) {
-                dict->set(_state.key.value, std::unique_ptr<Object>(old.current));
-                _state.key.valid  = false;
-                _state.key.active = false;
-            }
-        }
+    /* After a value, a dictionary expects the next key. */
+    if (element != Element::Key && inDictionary()) {
+        _stack.back().key = false;
     }
 
     _cdata.clear();
@@ -274,70 +302,57 @@ pop()
 bool XMLParser::
 beginArray()
 {
-    push(Array::New().release());
-    return true;
+    push(Element::Array);
+    return visited(_visitor->beginArray());
 }
 
 bool XMLParser::
 endArray()
 {
     pop();
-    return true;
+    return visited(_visitor->endArray());
 }
 
 bool XMLParser::
 beginDictionary()
 {
-    push(Dictionary::New().release());
-    _state.key.valid  = false;
-    _state.key.active = false;
+    /* Not visited until known not to be a CF$UID. */
+    push(Element::Dictionary);
+    _pending = Pending::Dictionary;
     return true;
 }
 
 bool XMLParser::
 endDictionary()
 {
-    if (auto dict = CastTo<Dictionary>(_state.current)) {
-        /* Convert CF$UID dictionaries into UID objects. */
-        if (dict->count() == 1) {
-            std::string const &key = dict->key(0);
-            Object const *value = dict->value(0);
-            if (key == "CF$UID" && value->type() == Integer::Type()) {
-                Integer const *integer = CastTo<Integer>(value);
-
-                uint32_t value = static_cast<uint32_t>(integer->value());
-                _state.current->release();
-                _state.current = UID::New(value).release();
-            }
-        }
+    pop();
+
+    /* Convert CF$UID dictionaries into UIDs. */
+    if (_pending == Pending::Value) {
+        _pending = Pending::None;
+        return visited(_visitor->uid(static_cast<uint32_t>(_pendingValue)));
     }
 
-    pop();
-    return true;
+    if (!flush()) {
+        return false;
+    }
+
+    return visited(_visitor->endDictionary());
 }
 
 bool XMLParser::
-beginString()
+beginValue(Element element)
 {
-    push(String::New().release());
-    _cdata.clear();
+    push(element);
     return true;
 }
 
 bool XMLParser::
 endString()
 {
-    CastTo <String> (_state.current)->setValue(_cdata);
+    bool result = visited(_visitor->string(_cdata));
     pop();
-    return true;
-}
-
-bool XMLParser::
-beginInteger()
-{
-    push(Integer::New().release());
-    _cdata.clear();
-    return true;
+    return result;
 }
 
 bool XMLParser::
@@ -345,22 +360,20 @@ endInteger()
 {
     char *end = NULL;
     long long integer = ::strtoll(_cdata.c_str(), &end, 0);
-    if (end != _cdata.c_str()) {
-        CastTo <Integer> (_state.current)->setValue(integer);
-        pop();
-        return true;
-    } else {
+    if (end == _cdata.c_str()) {
         pop();
         return false;
     }
-}
 
-bool XMLParser::
-beginReal()
-{
-    push(Real::New().release());
-    _cdata.clear();
-    return true;
+    pop();
+
+    if (_pending == Pending::Key) {
+        _pending = Pending::Value;
+        _pendingValue = integer;
+        return true;
+    }
+
+    return visited(_visitor->integer(integer));
 }
 
 bool XMLParser::
@@ -368,91 +381,71 @@ endReal()
 {
     char *end = NULL;
     double real = ::strtod(_cdata.c_str(), &end);
-    if (end != _cdata.c_str()) {
-        CastTo <Real> (_state.current)->setValue(real);
-        pop();
-        return true;
-    } else {
+    if (end == _cdata.c_str()) {
         pop();
         return false;
     }
-}
 
-bool XMLParser::
-beginNull()
-{
-    push(Null::New().release());
-    return true;
+    pop();
+    return visited(_visitor->real(real));
 }
 
 bool XMLParser::
 endNull()
 {
     pop();
-    return true;
+    return visited(_visitor->null());
 }
 
 bool XMLParser::
-beginBoolean(bool value)
-{
-    push(Boolean::New(value).release());
-    return true;
-}
-
-bool XMLParser::
-endBoolean()
+endBoolean(bool value)
 {
     pop();
-    return true;
-}
-
-bool XMLParser::
-beginData()
-{
-    push(Data::New().release());
-    _cdata.clear();
-    return true;
+    return visited(_visitor->boolean(value));
 }
 
 bool XMLParser::
 endData()
 {
-    CastTo <Data> (_state.current)->setBase64Value(_cdata);
+    std::vector<uint8_t> data;
+    Base64::Decode(_cdata, data);
     pop();
-    return true;
-}
-
-bool XMLParser::
-beginDate()
-{
-    push(Date::New().release());
-    _cdata.clear();
-    return true;
+    return visited(_visitor->data(data));
 }
 
 bool XMLParser::
 endDate()
 {
-    CastTo <Date> (_state.current)->setStringValue(_cdata);
+    struct tm date = tm();
+    ISODate::Decode(_cdata, date);
     pop();
-    return true;
+    return visited(_visitor->date(date));
 }
 
 bool XMLParser::
 beginKey()
 {
-    _state.key.valid = false;
-    _state.key.active = true;
-    _cdata.clear();
+    push(Element::Key);
     return true;
 }
 
 bool XMLParser::
 endKey()
 {
-    _state.key.active = false;
-    _state.key.valid = true;
-    _state.key.value = _cdata;
-    _cdata.clear();
-    return true;
+    std::string key = std::move(_cdata);
+    pop();
+
+    /* The key has been read; its value is next. */
+    _stack.back().key = true;
+
+    if (_pending == Pending::Dictionary && key == "CF$UID") {
+        _pending = Pending::Key;
+        return true;
+    }
+
+    if (!flush()) {
+        return false;
+    }
+
+    return visited(_visitor->key(key));
 }
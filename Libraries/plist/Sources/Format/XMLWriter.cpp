@@ -26,8 +26,9 @@ using plist::Dictionary;
 using plist::CastTo;
 
 XMLWriter::
-XMLWriter(Object const *root) :
+XMLWriter(Object const *root, Sink const &sink) :
     _root   (root),
+    _sink   (sink),
     _indent (0)
 {
 }
@@ -60,18 +61,36 @@ write()
         return false;
     }
 
-    return true;
+    return flush(true);
 }
 
 /*
  * Low level functions.
  */
 
+/*
+ * Output is passed to the sink in parts of about this size. A part only
+ * ends after a whole string, so it can be converted on its own.
+ */
+static size_t const ChunkSize = 64 * 1024;
+
+bool XMLWriter::
+flush(bool final)
+{
+    if (_contents.empty() || (!final && _contents.size() < ChunkSize)) {
+        return true;
+    }
+
+    bool result = _sink(_contents.data(), _contents.size());
+    _contents.clear();
+    return result;
+}
+
 bool XMLWriter::
 primitiveWriteString(std::string const &string)
 {
     _contents.insert(_contents.end(), string.begin(), string.end());
-    return true;
+    return flush(false);
 }
 
 bool XMLWriter::
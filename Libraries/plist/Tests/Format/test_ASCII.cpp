@@ -145,3 +145,44 @@ TEST(ASCII, CommentWithStarAndSlash)
     dictionary->set("key", String::New("value"));
     EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
 }
+
+TEST(ASCII, LongTokens)
+{
+    /* Longer than the sixteen bytes scanned at a time, with boundaries at each offset. */
+    std::string unquoted = "0123456789ABCDEFabcdef_.$-:/Z";
+    std::string quoted = "a quoted string, long enough to span \\\"chunks\\\" of input";
+    std::string comment = "/* a comment * with / stars\n and slashes ** over lines */";
+
+    for (size_t n = 0; n < 17; n++) {
+        std::string padding = std::string(n, ' ');
+        auto contents = Contents(
+            padding + comment + "{\n" +
+            "\t" + unquoted + " = \"" + quoted + "\"; // a comment to the end of the line\n" +
+            "\tsingle = '" + padding + "single quoted, also longer than sixteen bytes';\n" +
+            "\tlist = (" + unquoted + padding + ", " + comment + unquoted.substr(n) + ");\n" +
+            "}" + padding);
+
+        auto deserialize = ASCII::Deserialize(contents, ASCII::Create(false, Encoding::UTF8));
+        ASSERT_NE(deserialize.first, nullptr);
+
+        auto list = Array::New();
+        list->append(String::New(unquoted));
+        list->append(String::New(unquoted.substr(n)));
+
+        auto dictionary = Dictionary::New();
+        dictionary->set(unquoted, String::New("a quoted string, long enough to span \"chunks\" of input"));
+        dictionary->set("single", String::New(padding + "single quoted, also longer than sixteen bytes"));
+        dictionary->set("list", std::move(list));
+        EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
+    }
+}
+
+TEST(ASCII, Unterminated)
+{
+    /* None of these may be read past the end of the input. */
+    EXPECT_EQ(nullptr, ASCII::Deserialize(Contents("{ key = \"value that is not terminated"), ASCII::Create(false, Encoding::UTF8)).first);
+    EXPECT_EQ(nullptr, ASCII::Deserialize(Contents("{ key = \"value ending in an escape\\"), ASCII::Create(false, Encoding::UTF8)).first);
+    EXPECT_EQ(nullptr, ASCII::Deserialize(Contents("{ key = 'value that is not terminated"), ASCII::Create(false, Encoding::UTF8)).first);
+    EXPECT_EQ(nullptr, ASCII::Deserialize(Contents("{ key = value; } /* comment that is not terminated *"), ASCII::Create(false, Encoding::UTF8)).first);
+    EXPECT_EQ(nullptr, ASCII::Deserialize(Contents("{ key = valuethatisnotterminatedbyanything"), ASCII::Create(false, Encoding::UTF8)).first);
+}
@@ -56,3 +56,106 @@ TEST(Binary, UnicodeString)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+TEST(Binary, SharedObjects)
+{
+    /*
+     * Equal strings are written once and referenced from each use.
+     */
+    auto dictionary = Dictionary::New();
+    auto array = plist::Array::New();
+    array->append(String::New("value"));
+    array->append(String::New("value"));
+    dictionary->set("first", String::New("value"));
+    dictionary->set("second", std::move(array));
+    dictionary->set("value", String::New("value"));
+
+    auto serialize = Binary::Serialize(dictionary.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    auto deserialize = Binary::Deserialize(*serialize.first, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
+}
+
+TEST(Binary, UniqueValues)
+{
+    /*
+     * Keys, numbers and data with equal contents share one object.
+     */
+    auto array = plist::Array::New();
+    for (int n = 0; n < 3; n++) {
+        auto dictionary = Dictionary::New();
+        dictionary->set("integer", plist::Integer::New(1));
+        dictionary->set("data", plist::Data::New(std::vector<uint8_t>({ 0x00 })));
+        array->append(std::move(dictionary));
+    }
+
+    auto serialize = Binary::Serialize(array.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+    std::vector<uint8_t> const &contents = *serialize.first;
+
+    /* The object count is a big-endian integer in the trailer. */
+    ASSERT_LT(32u, contents.size());
+    uint64_t objects = 0;
+    for (size_t n = contents.size() - 24; n < contents.size() - 16; n++) {
+        objects = (objects << 8) | contents[n];
+    }
+    EXPECT_EQ(8u, objects);
+
+    auto deserialize = Binary::Deserialize(contents, Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(array.get()));
+}
+
+TEST(Binary, DeserializeBuffer)
+{
+    auto dictionary = Dictionary::New();
+    dictionary->set("ascii", String::New("value"));
+    dictionary->set("unicode", String::New("caf\xc3\xa9"));
+    dictionary->set("data", plist::Data::New(std::vector<uint8_t>({ 0x00, 0x01, 0xff })));
+    dictionary->set("integer", plist::Integer::New(1 << 20));
+
+    auto serialize = Binary::Serialize(dictionary.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+    std::vector<uint8_t> const &contents = *serialize.first;
+
+    auto deserialize = Binary::Deserialize(contents.data(), contents.size(), Binary::Create());
+    ASSERT_NE(deserialize.first, nullptr);
+    EXPECT_TRUE(deserialize.first->equals(dictionary.get()));
+
+    /* Reading stops at the end of the contents, even when truncated. */
+    for (size_t size = 0; size < contents.size(); size++) {
+        auto truncated = Binary::Deserialize(contents.data(), size, Binary::Create());
+        EXPECT_FALSE(truncated.first != nullptr && truncated.first->equals(dictionary.get()));
+    }
+}
+
+TEST(Binary, SerializeSink)
+{
+    /* Large enough to be written in several parts. */
+    auto array = plist::Array::New();
+    for (int n = 0; n < 20000; n++) {
+        array->append(String::New("value " + std::to_string(n)));
+    }
+
+    auto serialize = Binary::Serialize(array.get(), Binary::Create());
+    ASSERT_NE(serialize.first, nullptr);
+
+    std::vector<uint8_t> contents;
+    size_t parts = 0;
+    auto stream = Binary::Serialize(array.get(), Binary::Create(), [&](uint8_t const *data, size_t size) -> bool {
+        contents.insert(contents.end(), data, data + size);
+        parts++;
+        return true;
+    });
+    EXPECT_TRUE(stream.first);
+    EXPECT_LT(1u, parts);
+    EXPECT_EQ(*serialize.first, contents);
+
+    /* A failing sink stops the write. */
+    stream = Binary::Serialize(array.get(), Binary::Create(), [](uint8_t const *data, size_t size) -> bool {
+        return false;
+    });
+    EXPECT_FALSE(stream.first);
+}
@@ -0,0 +1,139 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/BinaryDocument.h>
+#include <plist/Objects.h>
+
+#include <algorithm>
+
+using plist::Format::Binary;
+using plist::Format::BinaryDocument;
+using plist::ObjectType;
+
+static std::vector<uint8_t>
+Serialize(plist::Object const *object)
+{
+    auto serialize = Binary::Serialize(object, Binary::Create());
+    return (serialize.first != nullptr ? *serialize.first : std::vector<uint8_t>());
+}
+
+static std::unique_ptr<plist::Dictionary>
+Document()
+{
+    auto nested = plist::Dictionary::New();
+    nested->set("Enabled", plist::Boolean::New(true));
+
+    auto items = plist::Array::New();
+    items->append(plist::Integer::New(1));
+    items->append(plist::String::New("two"));
+    items->append(std::move(nested));
+
+    auto root = plist::Dictionary::New();
+    root->set("CFBundleIdentifier", plist::String::New("com.example.app"));
+    root->set("Items", std::move(items));
+    root->set("Blob", plist::Data::New(std::vector<uint8_t>({ 'Z', 'Z', 'Z', 'Z' })));
+    root->set("Name", plist::String::New("\xc3\xa9t\xc3\xa9"));
+    return root;
+}
+
+TEST(BinaryDocument, Lookup)
+{
+    auto root = Document();
+    std::vector<uint8_t> contents = Serialize(root.get());
+
+    auto open = BinaryDocument::Open(contents.data(), contents.size());
+    ASSERT_NE(nullptr, open.first);
+    BinaryDocument *document = open.first.get();
+
+    EXPECT_EQ(ObjectType::Dictionary, document->type(document->root()));
+    EXPECT_EQ(4u, document->count(document->root()));
+
+    BinaryDocument::Reference identifier;
+    ASSERT_TRUE(document->value(document->root(), "CFBundleIdentifier", &identifier));
+    EXPECT_EQ(ObjectType::String, document->type(identifier));
+    EXPECT_TRUE(document->object(identifier)->equals(plist::String::New("com.example.app").get()));
+
+    BinaryDocument::Reference name;
+    ASSERT_TRUE(document->value(document->root(), "Name", &name));
+    EXPECT_TRUE(document->object(name)->equals(root->value("Name")));
+
+    BinaryDocument::Reference missing;
+    EXPECT_FALSE(document->value(document->root(), "Missing", &missing));
+
+    /* Arrays are indexed, and nested collections are also read on demand. */
+    BinaryDocument::Reference items;
+    ASSERT_TRUE(document->value(document->root(), "Items", &items));
+    EXPECT_EQ(ObjectType::Array, document->type(items));
+    EXPECT_EQ(3u, document->count(items));
+
+    BinaryDocument::Reference nested;
+    ASSERT_TRUE(document->value(items, 2, &nested));
+    EXPECT_FALSE(document->value(items, 3, &missing));
+    EXPECT_FALSE(document->value(items, "Enabled", &missing));
+
+    std::string key;
+    ASSERT_TRUE(document->key(nested, 0, &key));
+    EXPECT_EQ("Enabled", key);
+
+    BinaryDocument::Reference enabled;
+    ASSERT_TRUE(document->value(nested, "Enabled", &enabled));
+    EXPECT_EQ(ObjectType::Boolean, document->type(enabled));
+
+    /* Reading a collection reads everything in it; the reader keeps its own. */
+    EXPECT_TRUE(document->object(items)->equals(root->value("Items")));
+    EXPECT_TRUE(document->object(items)->equals(root->value("Items")));
+    EXPECT_TRUE(document->object(document->root())->equals(root.get()));
+}
+
+TEST(BinaryDocument, UnreadValues)
+{
+    auto root = Document();
+    std::vector<uint8_t> contents = Serialize(root.get());
+
+    /* Corrupt the data value's marker, so reading it fails. */
+    std::vector<uint8_t> blob = { 'Z', 'Z', 'Z', 'Z' };
+    auto it = std::search(contents.begin(), contents.end(), blob.begin(), blob.end());
+    ASSERT_NE(contents.end(), it);
+    ASSERT_EQ(0x44, *(it - 1));
+    *(it - 1) = 0x70;
+
+    /* Values other than the corrupted one are still available. */
+    auto open = BinaryDocument::Open(contents.data(), contents.size());
+    ASSERT_NE(nullptr, open.first);
+    BinaryDocument *document = open.first.get();
+
+    BinaryDocument::Reference identifier;
+    ASSERT_TRUE(document->value(document->root(), "CFBundleIdentifier", &identifier));
+    EXPECT_NE(nullptr, document->object(identifier));
+
+    BinaryDocument::Reference data;
+    ASSERT_TRUE(document->value(document->root(), "Blob", &data));
+    EXPECT_EQ(ObjectType::None, document->type(data));
+    EXPECT_EQ(nullptr, document->object(data));
+}
+
+TEST(BinaryDocument, Invalid)
+{
+    std::vector<uint8_t> contents = { 'n', 'o', 't', ' ', 'b', 'i', 'n', 'a', 'r', 'y' };
+    EXPECT_EQ(nullptr, BinaryDocument::Open(contents.data(), contents.size()).first);
+
+    auto root = Document();
+    contents = Serialize(root.get());
+    for (size_t n = 0; n < contents.size(); n++) {
+        /* No truncated document may be read past its end. */
+        auto open = BinaryDocument::Open(contents.data(), n);
+        if (open.first != nullptr) {
+            BinaryDocument::Reference identifier;
+            if (open.first->value(open.first->root(), "CFBundleIdentifier", &identifier)) {
+                open.first->object(identifier);
+            }
+        }
+    }
+}
@@ -0,0 +1,155 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/Document.h>
+#include <plist/Format/XML.h>
+#include <plist/Objects.h>
+
+using plist::Format::Any;
+using plist::Format::ASCII;
+using plist::Format::Binary;
+using plist::Format::Document;
+using plist::Format::XML;
+using plist::ObjectType;
+
+static std::unique_ptr<plist::Dictionary>
+Contents()
+{
+    auto first = plist::Dictionary::New();
+    first->set("isa", plist::String::New("PBXFileReference"));
+    first->set("path", plist::String::New("first.c"));
+
+    auto second = plist::Dictionary::New();
+    second->set("isa", plist::String::New("PBXFileReference"));
+    second->set("path", plist::String::New("second.c"));
+
+    auto items = plist::Array::New();
+    items->append(plist::Integer::New(1));
+    items->append(plist::Real::New(2.5));
+    items->append(plist::Boolean::New(true));
+    items->append(plist::Data::New(std::vector<uint8_t>({ 'Z', 'Z' })));
+
+    auto root = plist::Dictionary::New();
+    root->set("first", std::move(first));
+    root->set("second", std::move(second));
+    root->set("items", std::move(items));
+    for (int n = 0; n < 16; n++) {
+        root->set("key" + std::to_string(n), plist::String::New("value" + std::to_string(n)));
+    }
+    return root;
+}
+
+static void
+ExpectContents(plist::Dictionary const *root, std::vector<uint8_t> const &contents)
+{
+    auto result = Document::Deserialize(contents);
+    ASSERT_NE(nullptr, result.first) << result.second;
+    Document::Node const *document = result.first->root();
+
+    /* The same as reading it into objects. */
+    auto deserialize = Any::Deserialize(contents);
+    ASSERT_NE(nullptr, deserialize.first);
+    EXPECT_EQ(ObjectType::Dictionary, document->type());
+    EXPECT_EQ(root->count(), document->count());
+    EXPECT_TRUE(document->object()->equals(deserialize.first.get()));
+
+    /* Looked up by binary search, as there are many keys. */
+    for (int n = 0; n < 16; n++) {
+        Document::Node const *value = document->value("key" + std::to_string(n));
+        ASSERT_NE(nullptr, value);
+        EXPECT_EQ("value" + std::to_string(n), value->string());
+    }
+    EXPECT_EQ(nullptr, document->value("key"));
+    EXPECT_EQ(nullptr, document->value("key99"));
+
+    /* Looked up in order, as there are few. */
+    Document::Node const *first = document->value("first");
+    Document::Node const *second = document->value("second");
+    ASSERT_NE(nullptr, first);
+    ASSERT_NE(nullptr, second);
+    EXPECT_TRUE(first->value("isa")->equals("PBXFileReference"));
+    EXPECT_TRUE(second->value("path")->equals("second.c"));
+    EXPECT_EQ(nullptr, first->value("missing"));
+    EXPECT_EQ(nullptr, first->value(size_t(2)));
+
+    /* Keys are stored once, however many dictionaries have them. */
+    ASSERT_EQ(2u, first->count());
+    ASSERT_EQ(2u, second->count());
+    for (size_t n = 0; n < 2; n++) {
+        EXPECT_EQ(ObjectType::String, first->key(n)->type());
+        EXPECT_EQ(first->key(n), second->key(n));
+    }
+}
+
+TEST(Document, ASCII)
+{
+    auto root = Contents();
+    /* ASCII has no other scalar types. */
+    root->remove("items");
+
+    auto serialize = ASCII::Serialize(root.get(), ASCII::Create(false, plist::Format::Encoding::UTF8));
+    ASSERT_NE(nullptr, serialize.first);
+    ExpectContents(root.get(), *serialize.first);
+}
+
+TEST(Document, XML)
+{
+    auto root = Contents();
+    auto serialize = XML::Serialize(root.get(), XML::Create(plist::Format::Encoding::UTF8));
+    ASSERT_NE(nullptr, serialize.first);
+    ExpectContents(root.get(), *serialize.first);
+}
+
+TEST(Document, Binary)
+{
+    auto root = Contents();
+    auto serialize = Binary::Serialize(root.get(), Binary::Create());
+    ASSERT_NE(nullptr, serialize.first);
+    ExpectContents(root.get(), *serialize.first);
+
+    auto result = Document::Deserialize(*serialize.first);
+    ASSERT_NE(nullptr, result.first);
+    EXPECT_TRUE(result.first->root()->object()->equals(root.get()));
+
+    Document::Node const *items = result.first->root()->value("items");
+    ASSERT_NE(nullptr, items);
+    EXPECT_EQ(4u, items->count());
+    EXPECT_EQ(1, items->value(size_t(0))->integer());
+    EXPECT_EQ(2.5, items->value(1)->real());
+    EXPECT_TRUE(items->value(2)->boolean());
+    EXPECT_EQ(std::vector<uint8_t>({ 'Z', 'Z' }), items->value(3)->data());
+    EXPECT_EQ(nullptr, items->value(4));
+    EXPECT_EQ(nullptr, items->key(0));
+    EXPECT_EQ("", items->value(size_t(0))->string());
+}
+
+TEST(Document, RepeatedKey)
+{
+    std::string contents = "{ a = 1; b = 2; a = 3; }";
+    auto result = Document::Deserialize(std::vector<uint8_t>(contents.begin(), contents.end()));
+    ASSERT_NE(nullptr, result.first);
+    EXPECT_EQ("3", result.first->root()->value("a")->string());
+
+    contents = "{ a = 1; b = 2; c = 3; d = 4; e = 5; f = 6; g = 7; h = 8; i = 9; a = 10; }";
+    result = Document::Deserialize(std::vector<uint8_t>(contents.begin(), contents.end()));
+    ASSERT_NE(nullptr, result.first);
+    EXPECT_EQ("10", result.first->root()->value("a")->string());
+}
+
+TEST(Document, Invalid)
+{
+    std::string contents = "{ a = ( 1, 2; }";
+    EXPECT_EQ(nullptr, Document::Deserialize(std::vector<uint8_t>(contents.begin(), contents.end())).first);
+
+    contents = "<?xml version=\"1.0\"?><plist version=\"1.0\"><array><string>a</string></plist>";
+    EXPECT_EQ(nullptr, Document::Deserialize(std::vector<uint8_t>(contents.begin(), contents.end())).first);
+}
@@ -0,0 +1,211 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Format/ASCII.h>
+#include <plist/Format/Any.h>
+#include <plist/Format/Binary.h>
+#include <plist/Format/JSON.h>
+#include <plist/Format/Visitor.h>
+#include <plist/Format/XML.h>
+#include <plist/Objects.h>
+
+using plist::Format::ASCII;
+using plist::Format::Any;
+using plist::Format::Binary;
+using plist::Format::Encoding;
+using plist::Format::JSON;
+using plist::Format::Visitor;
+using plist::Format::XML;
+
+static std::vector<uint8_t>
+Contents(std::string const &string)
+{
+    return std::vector<uint8_t>(string.begin(), string.end());
+}
+
+/*
+ * Records each event, to compare between formats.
+ */
+class Recorder : public Visitor {
+public:
+    std::string events;
+    std::string stop;
+
+public:
+    virtual bool beginArray()
+    { events += "( "; return true; }
+    virtual bool endArray()
+    { events += ") "; return true; }
+    virtual bool beginDictionary()
+    { events += "{ "; return true; }
+    virtual bool key(std::string const &key)
+    { events += key + "= "; return key != stop; }
+    virtual bool endDictionary()
+    { events += "} "; return true; }
+    virtual bool string(std::string const &value)
+    { events += "\"" + value + "\" "; return true; }
+    virtual bool integer(int64_t value)
+    { events += std::to_string(value) + " "; return true; }
+    virtual bool real(double value)
+    { events += std::to_string(value) + " "; return true; }
+    virtual bool boolean(bool value)
+    { events += (value ? "true " : "false "); return true; }
+    virtual bool null()
+    { events += "null "; return true; }
+    virtual bool data(std::vector<uint8_t> const &value)
+    { events += "<" + std::string(value.begin(), value.end()) + "> "; return true; }
+    virtual bool date(struct tm const &value)
+    { events += "date "; return true; }
+    virtual bool uid(uint32_t value)
+    { events += "uid(" + std::to_string(value) + ") "; return true; }
+};
+
+static std::unique_ptr<plist::Dictionary>
+Document()
+{
+    auto nested = plist::Dictionary::New();
+    nested->set("Enabled", plist::Boolean::New(true));
+    nested->set("Reference", plist::UID::New(7));
+
+    auto items = plist::Array::New();
+    items->append(plist::Integer::New(-1));
+    items->append(plist::Real::New(0.5));
+    items->append(plist::String::New("two"));
+    items->append(std::move(nested));
+    items->append(plist::Array::New());
+
+    auto root = plist::Dictionary::New();
+    root->set("Name", plist::String::New("\xc3\xa9t\xc3\xa9"));
+    root->set("Items", std::move(items));
+    root->set("Blob", plist::Data::New(std::vector<uint8_t>({ 'Z', 'Z', 'Z' })));
+    root->set("Empty", plist::Dictionary::New());
+    return root;
+}
+
+static char const *const Expected =
+    "{ Name= \"\xc3\xa9t\xc3\xa9\" Items= ( -1 0.500000 \"two\" { Enabled= true Reference= uid(7) } ( ) ) "
+    "Blob= <ZZZ> Empty= { } } ";
+
+TEST(Visitor, Object)
+{
+    auto root = Document();
+
+    Recorder recorder;
+    EXPECT_TRUE(Visitor::Visit(root.get(), &recorder));
+    EXPECT_EQ(Expected, recorder.events);
+}
+
+TEST(Visitor, Binary)
+{
+    auto root = Document();
+    auto serialize = Binary::Serialize(root.get(), Binary::Create());
+    ASSERT_NE(nullptr, serialize.first);
+
+    Recorder recorder;
+    auto visit = Binary::Visit(*serialize.first, Binary::Create(), &recorder);
+    EXPECT_TRUE(visit.first);
+    EXPECT_EQ(Expected, recorder.events);
+
+    /* Values referenced more than once are visited each time. */
+    auto shared = plist::Array::New();
+    shared->append(plist::String::New("same"));
+    shared->append(plist::String::New("same"));
+    serialize = Binary::Serialize(shared.get(), Binary::Create());
+    ASSERT_NE(nullptr, serialize.first);
+
+    recorder.events.clear();
+    EXPECT_TRUE(Binary::Visit(*serialize.first, Binary::Create(), &recorder).first);
+    EXPECT_EQ("( \"same\" \"same\" ) ", recorder.events);
+}
+
+TEST(Visitor, XML)
+{
+    auto root = Document();
+    auto serialize = XML::Serialize(root.get(), XML::Create(Encoding::UTF8));
+    ASSERT_NE(nullptr, serialize.first);
+
+    /* UIDs are written as CF$UID dictionaries, and read back as UIDs. */
+    Recorder recorder;
+    auto visit = XML::Visit(*serialize.first, XML::Create(Encoding::UTF8), &recorder);
+    EXPECT_TRUE(visit.first);
+    EXPECT_EQ(Expected, recorder.events);
+
+    /* Only a dictionary with just a CF$UID integer is a UID. */
+    auto contents = Contents(
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<plist version=\"1.0\">\n"
+        "<array>\n"
+        "\t<dict><key>CF$UID</key><integer>1</integer><key>Other</key><integer>2</integer></dict>\n"
+        "\t<dict><key>CF$UID</key><string>3</string></dict>\n"
+        "\t<dict><key>CF$UID</key><integer>4</integer></dict>\n"
+        "</array>\n"
+        "</plist>\n");
+    recorder.events.clear();
+    EXPECT_TRUE(XML::Visit(contents, XML::Create(Encoding::UTF8), &recorder).first);
+    EXPECT_EQ("( { CF$UID= 1 Other= 2 } { CF$UID= \"3\" } uid(4) ) ", recorder.events);
+}
+
+TEST(Visitor, ASCII)
+{
+    auto contents = Contents("{ Name = \"\xc3\xa9t\xc3\xa9\"; Items = ( one, \"two\", { Enabled = YES; }, () ); Blob = <5a5a>; Empty = {}; }");
+
+    Recorder recorder;
+    auto visit = ASCII::Visit(contents, ASCII::Create(false, Encoding::UTF8), &recorder);
+    EXPECT_TRUE(visit.first);
+    EXPECT_EQ("{ Name= \"\xc3\xa9t\xc3\xa9\" Items= ( \"one\" \"two\" { Enabled= \"YES\" } ( ) ) Blob= <ZZ> Empty= { } } ", recorder.events);
+
+    /* Strings files are a dictionary without braces. */
+    recorder.events.clear();
+    visit = ASCII::Visit(Contents("\"key\" = \"value\";"), ASCII::Create(true, Encoding::UTF8), &recorder);
+    EXPECT_TRUE(visit.first);
+    EXPECT_EQ("{ key= \"value\" } ", recorder.events);
+}
+
+TEST(Visitor, JSON)
+{
+    auto contents = Contents("{ \"Name\": \"value\", \"Items\": [ -1, 0.5, true, null, {}, [] ] }");
+
+    Recorder recorder;
+    auto visit = JSON::Visit(contents, JSON::Create(), &recorder);
+    EXPECT_TRUE(visit.first);
+    EXPECT_EQ("{ Name= \"value\" Items= ( -1 0.500000 true null { } ( ) ) } ", recorder.events);
+}
+
+TEST(Visitor, Stop)
+{
+    auto root = Document();
+
+    /* Returning false stops reading, for every format. */
+    std::vector<std::pair<std::vector<uint8_t>, Any>> documents = {
+        { *Binary::Serialize(root.get(), Binary::Create()).first, Any::Create(Binary::Create()) },
+        { *XML::Serialize(root.get(), XML::Create(Encoding::UTF8)).first, Any::Create(XML::Create(Encoding::UTF8)) },
+        { *ASCII::Serialize(root.get(), ASCII::Create(false, Encoding::UTF8)).first, Any::Create(ASCII::Create(false, Encoding::UTF8)) },
+    };
+
+    for (auto const &document : documents) {
+        Recorder recorder;
+        recorder.stop = "Items";
+
+        auto visit = Any::Visit(document.first, document.second, &recorder);
+        EXPECT_FALSE(visit.first);
+        EXPECT_FALSE(visit.second.empty());
+        ASSERT_LE(7u, recorder.events.size());
+        EXPECT_EQ("Items= ", recorder.events.substr(recorder.events.size() - 7));
+    }
+}
+
+TEST(Visitor, Invalid)
+{
+    /* Invalid contents fail, even with a visitor that accepts everything. */
+    Visitor visitor;
+    EXPECT_FALSE(ASCII::Visit(Contents("{ a = b; "), ASCII::Create(false, Encoding::UTF8), &visitor).first);
+    EXPECT_FALSE(JSON::Visit(Contents("[ 1, 2 "), JSON::Create(), &visitor).first);
+    EXPECT_FALSE(XML::Visit(Contents("<plist><dict><string>a</string></dict></plist>"), XML::Create(Encoding::UTF8), &visitor).first);
+    EXPECT_FALSE(Binary::Visit(Contents("bplist00"), Binary::Create(), &visitor).first);
+}
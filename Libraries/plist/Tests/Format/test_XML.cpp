@@ -7,11 +7,13 @@
  */
 
 #include <gtest/gtest.h>
+#include <plist/Format/Encoding.h>
 #include <plist/Format/XML.h>
 #include <plist/Objects.h>
 
 using plist::Format::XML;
 using plist::Format::Encoding;
+using plist::Format::Encodings;
 using plist::String;
 using plist::Boolean;
 using plist::Integer;
@@ -69,3 +71,29 @@ TEST(XML, UID)
     EXPECT_EQ(*serialize.first, contents);
 }
 
+
+TEST(XML, SerializeSink)
+{
+    /* Large enough to be written in several parts. */
+    auto array = Array::New();
+    for (int n = 0; n < 20000; n++) {
+        array->append(String::New("caf\xc3\xa9 <" + std::to_string(n) + ">"));
+    }
+
+    auto serialize = XML::Serialize(array.get(), XML::Create(Encoding::UTF8));
+    ASSERT_NE(serialize.first, nullptr);
+
+    /* Each part is converted on its own, matching a whole conversion. */
+    for (Encoding encoding : { Encoding::UTF8, Encoding::UTF16LE }) {
+        std::vector<uint8_t> contents;
+        size_t parts = 0;
+        auto stream = XML::Serialize(array.get(), XML::Create(encoding), [&](uint8_t const *data, size_t size) -> bool {
+            contents.insert(contents.end(), data, data + size);
+            parts++;
+            return true;
+        });
+        EXPECT_TRUE(stream.first);
+        EXPECT_LT(1u, parts);
+        EXPECT_EQ(Encodings::Convert(*serialize.first, Encoding::UTF8, encoding), contents);
+    }
+}
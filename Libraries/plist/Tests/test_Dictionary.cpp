@@ -0,0 +1,83 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <plist/Objects.h>
+
+using plist::Dictionary;
+using plist::Integer;
+using plist::String;
+
+TEST(Dictionary, Order)
+{
+    auto d1 = Dictionary::New();
+    d1->set("b", Integer::New(1));
+    d1->set("a", Integer::New(2));
+    d1->set("c", Integer::New(3));
+    ASSERT_EQ(3u, d1->count());
+    EXPECT_EQ("b", d1->key(0));
+    EXPECT_EQ("a", d1->key(1));
+    EXPECT_EQ("c", d1->key(2));
+
+    /* Replacing a value moves its key to the end. */
+    d1->set("b", Integer::New(4));
+    ASSERT_EQ(3u, d1->count());
+    EXPECT_EQ("b", d1->key(2));
+    EXPECT_EQ(4, d1->value<Integer>("b")->value());
+
+    std::vector<std::string> keys;
+    for (std::string const &key : *d1) {
+        keys.push_back(key);
+    }
+    EXPECT_EQ(std::vector<std::string>({ "a", "c", "b" }), keys);
+
+    d1->remove("a");
+    d1->remove("missing");
+    ASSERT_EQ(2u, d1->count());
+    EXPECT_EQ(nullptr, d1->value("a"));
+    EXPECT_EQ("c", d1->key(0));
+    EXPECT_EQ(nullptr, d1->value(2));
+}
+
+TEST(Dictionary, Large)
+{
+    /* Enough entries to be looked up by hash rather than in order. */
+    auto d1 = Dictionary::New();
+    for (int n = 0; n < 1000; n++) {
+        d1->set(std::to_string(n), Integer::New(n));
+    }
+    ASSERT_EQ(1000u, d1->count());
+
+    for (int n = 0; n < 1000; n++) {
+        ASSERT_NE(nullptr, d1->value<Integer>(std::to_string(n)));
+        EXPECT_EQ(n, d1->value<Integer>(std::to_string(n))->value());
+        EXPECT_EQ(std::to_string(n), d1->key(n));
+    }
+    EXPECT_EQ(nullptr, d1->value("1000"));
+
+    for (int n = 0; n < 1000; n += 2) {
+        d1->remove(std::to_string(n));
+    }
+    ASSERT_EQ(500u, d1->count());
+
+    for (int n = 0; n < 1000; n++) {
+        EXPECT_EQ(n % 2 == 0, d1->value(std::to_string(n)) == nullptr);
+    }
+    EXPECT_EQ("1", d1->key(0));
+
+    auto d2 = d1->copy();
+    EXPECT_TRUE(d1->equals(d2.get()));
+    d2->set("1", String::New("1"));
+    EXPECT_FALSE(d1->equals(d2.get()));
+
+    d1->clear();
+    EXPECT_TRUE(d1->empty());
+    EXPECT_EQ(nullptr, d1->value("1"));
+    d1->set("1", Integer::New(1));
+    EXPECT_NE(nullptr, d1->value("1"));
+}
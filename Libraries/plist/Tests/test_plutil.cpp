@@ -0,0 +1,130 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Runs the plutil built alongside the tests, in a directory of its own.
+ */
+class plutil : public ::testing::Test {
+protected:
+    std::string _directory;
+
+protected:
+    virtual void SetUp()
+    {
+        char const *tmpdir = getenv("TMPDIR");
+        std::string pattern = std::string(tmpdir != nullptr ? tmpdir : "/tmp") + "/test_plutil.XXXXXX";
+        std::vector<char> buffer = std::vector<char>(pattern.begin(), pattern.end());
+        buffer.push_back('\0');
+        ASSERT_NE(nullptr, mkdtemp(buffer.data()));
+        _directory = buffer.data();
+    }
+
+    virtual void TearDown()
+    {
+        std::string command = "rm -rf '" + _directory + "'";
+        EXPECT_EQ(0, system(command.c_str()));
+    }
+
+protected:
+    std::string path(std::string const &name) const
+    { return _directory + "/" + name; }
+
+    void write(std::string const &name, std::string const &contents) const
+    {
+        std::ofstream stream = std::ofstream(path(name), std::ios::binary);
+        stream << contents;
+    }
+
+    /*
+     * Run plutil with the arguments, returning its exit status and what
+     * it printed to the standard output; the standard error is dropped.
+     */
+    std::pair<int, std::string> run(std::string const &arguments) const
+    {
+        std::string command = "cd '" + _directory + "' && '" PLUTIL_PATH "' " + arguments + " 2>/dev/null";
+        FILE *fp = popen(command.c_str(), "r");
+        if (fp == nullptr) {
+            return std::make_pair(-1, std::string());
+        }
+
+        std::string output;
+        char buffer[4096];
+        size_t size;
+        while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+            output.append(buffer, size);
+        }
+
+        int status = pclose(fp);
+        return std::make_pair(WIFEXITED(status) ? WEXITSTATUS(status) : -1, output);
+    }
+};
+
+TEST_F(plutil, BatchInputOrder)
+{
+    /* Enough files that jobs finish out of order. */
+    std::string list;
+    std::string expected;
+    for (int n = 0; n < 64; n++) {
+        std::string name = "file" + std::to_string(n) + ".plist";
+        std::string contents = "{ key = value" + std::to_string(n) + "; array = (";
+        for (int m = 0; m < (n % 8) * 500; m++) {
+            contents += " " + std::to_string(m) + ",";
+        }
+        contents += " ); }";
+        write(name, contents);
+
+        list += name + "\n";
+        expected += name + ": OK\n";
+    }
+    write("list", list);
+
+    /* Each file's result is reported in the order listed. */
+    std::pair<int, std::string> result = run("-lint -s -batch list -jobs 8");
+    EXPECT_EQ(0, result.first);
+    EXPECT_EQ("", result.second);
+
+    result = run("-lint -batch list -jobs 8");
+    EXPECT_EQ(0, result.first);
+    EXPECT_EQ(expected, result.second);
+}
+
+TEST_F(plutil, BatchFailure)
+{
+    write("first.plist", "{ key = value; }");
+    write("bad.plist", "{ key = ");
+    write("last.plist", "{ key = value; }");
+    write("list", "first.plist\nbad.plist\nmissing.plist\nlast.plist\n");
+
+    /* The other files are still checked, but the batch fails. */
+    std::pair<int, std::string> result = run("-lint -batch list -jobs 2");
+    EXPECT_NE(0, result.first);
+    EXPECT_EQ("first.plist: OK\nlast.plist: OK\n", result.second);
+
+    write("list", "first.plist\nlast.plist\n");
+    result = run("-lint -batch list -jobs 2");
+    EXPECT_EQ(0, result.first);
+}
+
+TEST_F(plutil, JobsRequiresBatch)
+{
+    write("file.plist", "{ key = value; }");
+
+    EXPECT_NE(0, run("-lint -jobs 2 file.plist").first);
+    EXPECT_EQ(0, run("-lint file.plist").first);
+}
@@ -18,11 +18,13 @@
 #include <plist/Format/Any.h>
 #include <plist/Format/ASCII.h>
 #include <plist/Format/Binary.h>
+#include <plist/Format/BinaryDocument.h>
 #include <plist/Format/Encoding.h>
 #include <plist/Format/XML.h>
 #include <libutil/Options.h>
 #include <libutil/Filesystem.h>
 #include <libutil/DefaultFilesystem.h>
+#include <libutil/MappedFile.h>
 
 #include <iostream>
 #include <iterator>
@@ -36,6 +38,7 @@
 
 using libutil::Filesystem;
 using libutil::DefaultFilesystem;
+using libutil::MappedFile;
 
 class Options {
 private:
@@ -321,7 +324,7 @@ Save(plist::Object *root, plist::Format::Any const &format, Filesystem *filesyst
         return false;
     }
 
-    if (!filesystem->write(*serialize.first, path)) {
+    if (!filesystem->replace(*serialize.first, path)) {
         fprintf(stderr, "Could not write to output\n");
         return false;
     }
@@ -349,6 +352,68 @@ Print(plist::Object *object, std::queue<std::string> *keyPath, plist::Format::An
     return true;
 }
 
+/*
+ * Print from a binary property list, reading only the objects along the key
+ * path and the object printed. Missing if the input is not binary.
+ */
+static ext::optional<bool>
+PrintBinary(Filesystem const *filesystem, std::string const &path, std::queue<std::string> *keyPath, plist::Format::Any const &format)
+{
+    std::unique_ptr<MappedFile> contents = filesystem->map(path);
+    if (contents == nullptr) {
+        return ext::nullopt;
+    }
+
+    auto open = plist::Format::BinaryDocument::Open(contents->data(), contents->size());
+    if (open.first == nullptr) {
+        return ext::nullopt;
+    }
+
+    plist::Format::BinaryDocument *document = open.first.get();
+    plist::Format::BinaryDocument::Reference reference = document->root();
+    while (!keyPath->empty()) {
+        std::string const &key = keyPath->front();
+
+        plist::ObjectType type = document->type(reference);
+        if (type == plist::ObjectType::Dictionary) {
+            if (!document->value(reference, key, &reference)) {
+                if (keyPath->size() > 1) {
+                    fprintf(stderr, "Invalid key path (indexing into null object)\n");
+                } else {
+                    fprintf(stderr, "Invalid key path (no object at key path)\n");
+                }
+                return false;
+            }
+        } else if (type == plist::ObjectType::Array) {
+            char *end = NULL;
+            long long index = std::strtoll(key.c_str(), &end, 0);
+            if (end == key.c_str() || index < 0) {
+                fprintf(stderr, "Invalid array index\n");
+                return false;
+            }
+
+            if (!document->value(reference, static_cast<size_t>(index), &reference)) {
+                fprintf(stderr, "Invalid array index\n");
+                return false;
+            }
+        } else {
+            /* Reached a non-collection object with remaining key path, error. */
+            fprintf(stderr, "Invalid key path (indexing into non-collection object)\n");
+            return false;
+        }
+
+        keyPath->pop();
+    }
+
+    std::unique_ptr<plist::Object> object = document->object(reference);
+    if (object == nullptr) {
+        fprintf(stderr, "Error: %s\n", document->error().c_str());
+        return false;
+    }
+
+    return Print(object.get(), keyPath, format);
+}
+
 static bool
 Revert(std::unique_ptr<plist::Object> *root, Filesystem const *filesystem, std::string const &path, ext::optional<plist::Format::Any> *format = nullptr)
 {
@@ -714,6 +779,39 @@ main(int argc, char **argv)
         return 0;
     }
 
+    /*
+     * Determine format for printing.
+     */
+    ext::optional<plist::Format::Any> printFormat;
+    if (options.xml()) {
+        plist::Format::XML xml = plist::Format::XML::Create(plist::Format::Encoding::UTF8);
+        printFormat = plist::Format::Any::Create<plist::Format::XML>(xml);
+    } else {
+        plist::Format::ASCII ascii = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
+        printFormat = plist::Format::Any::Create<plist::Format::ASCII>(ascii);
+    }
+
+    /*
+     * Printing from a binary input doesn't need to read all of it.
+     */
+    if (options.command() && !options.input().empty() && filesystem.exists(options.input())) {
+        std::vector<std::string> tokens;
+        std::stringstream sstream(*options.command());
+        std::copy(std::istream_iterator<std::string>(sstream), std::istream_iterator<std::string>(), std::back_inserter(tokens));
+
+        if (!tokens.empty() && tokens[0] == "Print") {
+            std::queue<std::string> keyPath;
+            if (tokens.size() > 1) {
+                ParseCommandKeyPathString(tokens[1], &keyPath);
+            }
+
+            ext::optional<bool> printed = PrintBinary(&filesystem, options.input(), &keyPath, *printFormat);
+            if (printed) {
+                return (*printed ? 0 : 1);
+            }
+        }
+    }
+
     /*
      * Read input, and determine format for saving.
      */
@@ -736,18 +834,6 @@ main(int argc, char **argv)
         saveFormat = plist::Format::Any::Create<plist::Format::XML>(xml);
     }
 
-    /*
-     * Determine format for printing.
-     */
-    ext::optional<plist::Format::Any> printFormat;
-    if (options.xml()) {
-        plist::Format::XML xml = plist::Format::XML::Create(plist::Format::Encoding::UTF8);
-        printFormat = plist::Format::Any::Create<plist::Format::XML>(xml);
-    } else {
-        plist::Format::ASCII ascii = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
-        printFormat = plist::Format::Any::Create<plist::Format::ASCII>(ascii);
-    }
-
     bool success = true;
     if (options.command()) {
         /*
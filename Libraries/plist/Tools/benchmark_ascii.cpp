@@ -0,0 +1,170 @@
+/**
+ Copyright (c) 2015-present, Facebook, Inc.
+ All rights reserved.
+
+ This source code is licensed under the BSD-style license found in the
+ LICENSE file in the root directory of this source tree.
+ */
+
+#include <plist/Format/ASCII.h>
+#include <plist/Format/ASCIIPListLexer.h>
+#include <plist/Object.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Lexes and parses a synthetic project.pbxproj: mostly 24 character object
+ * identifiers, each followed by a short comment, in file references, build
+ * files, and groups, like a large Xcode project. Compares scanning a byte at
+ * a time against scanning sixteen bytes at a time.
+ */
+
+static std::string
+Identifier(std::mt19937_64 *random)
+{
+    static char const digits[] = "0123456789ABCDEF";
+
+    std::string identifier;
+    for (int n = 0; n < 24; n++) {
+        identifier += digits[(*random)() % 16];
+    }
+    return identifier;
+}
+
+static std::string
+CreateProject(size_t count)
+{
+    std::mt19937_64 random = std::mt19937_64(1);
+
+    std::string project = "// !$*UTF8*$!\n{\n\tarchiveVersion = 1;\n\tclasses = {\n\t};\n\tobjectVersion = 46;\n\tobjects = {\n";
+    for (size_t n = 0; n < count; n++) {
+        std::string file = "File" + std::to_string(n) + ".m";
+        switch (n % 3) {
+            case 0:
+                project += "\t\t" + Identifier(&random) + " /* " + file + " */ = {isa = PBXFileReference; fileEncoding = 4; lastKnownFileType = sourcecode.c.objc; path = " + file + "; sourceTree = \"<group>\"; };\n";
+                break;
+            case 1:
+                project += "\t\t" + Identifier(&random) + " /* " + file + " in Sources */ = {isa = PBXBuildFile; fileRef = " + Identifier(&random) + " /* " + file + " */; settings = {COMPILER_FLAGS = \"-fno-objc-arc\"; }; };\n";
+                break;
+            case 2:
+                project += "\t\t" + Identifier(&random) + " /* Group" + std::to_string(n) + " */ = {\n\t\t\tisa = PBXGroup;\n\t\t\tchildren = (\n";
+                for (int child = 0; child < 6; child++) {
+                    project += "\t\t\t\t" + Identifier(&random) + " /* " + file + " */,\n";
+                }
+                project += "\t\t\t);\n\t\t\tname = Group" + std::to_string(n) + ";\n\t\t\tsourceTree = \"<group>\";\n\t\t};\n";
+                break;
+        }
+    }
+    project += "\t};\n\trootObject = " + Identifier(&random) + " /* Project object */;\n}\n";
+
+    return project;
+}
+
+struct Token {
+    int type;
+    int begin;
+    int length;
+};
+
+/*
+ * Lex all of the contents, returning the number of tokens. Optionally also
+ * records each token, to compare.
+ */
+static size_t
+Lex(std::string const &contents, bool vectorized, std::vector<Token> *tokens)
+{
+    ASCIIPListLexer lexer;
+    ASCIIPListLexerInit(&lexer, contents.data(), contents.size(), kASCIIPListLexerStyleASCII);
+    lexer.vectorized = vectorized;
+
+    size_t count = 0;
+    for (;;) {
+        int type = ASCIIPListLexerReadToken(&lexer);
+        count++;
+
+        if (tokens != nullptr) {
+            tokens->push_back({ type, lexer.tokenBegin, lexer.tokenLength });
+        }
+
+        if (type < 0) {
+            break;
+        }
+    }
+    return count;
+}
+
+static void
+Report(char const *name, size_t bytes, size_t iterations, double milliseconds)
+{
+    if (iterations == 0) {
+        return;
+    }
+
+    double megabytes = static_cast<double>(bytes) / (1024 * 1024);
+    fprintf(stdout, "%s: %.3f ms per iteration, %.1f MB/s\n", name, milliseconds / iterations, megabytes * iterations / (milliseconds / 1000));
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t count = 100000;
+    if (argc > 1) {
+        count = static_cast<size_t>(std::strtoul(argv[1], NULL, 10));
+    }
+
+    size_t iterations = 10;
+    if (argc > 2) {
+        iterations = static_cast<size_t>(std::strtoul(argv[2], NULL, 10));
+    }
+
+    std::string contents = CreateProject(count);
+    fprintf(stdout, "project: %zu objects, %.1f MB\n", count, static_cast<double>(contents.size()) / (1024 * 1024));
+
+    /*
+     * Both lexers must produce the same tokens.
+     */
+    std::vector<Token> scalar;
+    Lex(contents, false, &scalar);
+    std::vector<Token> vector;
+    Lex(contents, true, &vector);
+    bool same = (scalar.size() == vector.size());
+    for (size_t n = 0; same && n < scalar.size(); n++) {
+        same = (scalar[n].type == vector[n].type && scalar[n].begin == vector[n].begin && scalar[n].length == vector[n].length);
+    }
+    if (!same) {
+        fprintf(stderr, "error: lexers produced different tokens\n");
+        return 1;
+    }
+    fprintf(stdout, "tokens: %zu\n", scalar.size());
+
+    for (bool vectorized : { false, true }) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            Lex(contents, vectorized, nullptr);
+        }
+        auto end = std::chrono::steady_clock::now();
+        Report(vectorized ? "lex (vectorized)" : "lex (bytewise)", contents.size(), iterations, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    /*
+     * The whole parse, including creating objects, for comparison.
+     */
+    std::vector<uint8_t> bytes = std::vector<uint8_t>(contents.begin(), contents.end());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        auto deserialize = plist::Format::ASCII::Deserialize(bytes, plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8));
+        if (deserialize.first == nullptr) {
+            fprintf(stderr, "error: %s\n", deserialize.second.c_str());
+            return 1;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    Report("parse", contents.size(), iterations, std::chrono::duration<double, std::milli>(end - start).count());
+
+    return 0;
+}
@@ -21,20 +21,26 @@
 #include <plist/Format/Encoding.h>
 #include <plist/Format/JSON.h>
 #include <plist/Format/XML.h>
+#include <plist/Format/Visitor.h>
 #include <libutil/Options.h>
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
+#include <libutil/ThreadPool.h>
 #include <process/DefaultContext.h>
 #include <process/Context.h>
 
 #include <algorithm>
+#include <chrono>
 #include <iterator>
 #include <iostream>
+#include <sstream>
 
 using libutil::Filesystem;
 using libutil::DefaultFilesystem;
 using libutil::FSUtil;
+using libutil::MappedFile;
 
 class Options {
 public:
@@ -106,6 +112,10 @@ private:
     ext::optional<bool>        _silent;
     ext::optional<bool>        _humanReadable;
 
+private:
+    ext::optional<std::string> _batch;
+    ext::optional<int>         _jobs;
+
 public:
     Options();
     ~Options();
@@ -140,6 +150,12 @@ public:
     bool humanReadable() const
     { return _humanReadable.value_or(false); }
 
+public:
+    ext::optional<std::string> const &batch() const
+    { return _batch; }
+    ext::optional<int> const &jobs() const
+    { return _jobs; }
+
 private:
     friend class libutil::Options;
     std::pair<bool, std::string>
@@ -408,6 +424,10 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Current<bool>(&_silent, arg);
     } else if (arg == "-r") {
         return libutil::Options::Current<bool>(&_humanReadable, arg);
+    } else if (arg == "-batch") {
+        return libutil::Options::Next<std::string>(&_batch, args, it);
+    } else if (arg == "-jobs") {
+        return libutil::Options::Next<int>(&_jobs, args, it);
     } else if (arg == "--") {
         return libutil::Options::Current<bool>(&_separator, arg);
     } else if (!arg.empty() && arg[0] != '-') {
@@ -438,6 +458,13 @@ Help(std::string const &error = std::string())
     fprintf(stderr, INDENT "-remove <key>\n");
     fprintf(stderr, INDENT "-extract <key> <format>\n");
 
+    fprintf(stderr, "\noptions:\n");
+    fprintf(stderr, INDENT "-o <path> (output path)\n");
+    fprintf(stderr, INDENT "-e <extension> (output extension)\n");
+    fprintf(stderr, INDENT "-s (silent)\n");
+    fprintf(stderr, INDENT "-batch <list> (files to process, one per line; - for stdin)\n");
+    fprintf(stderr, INDENT "-jobs <count> (files processed at once with -batch)\n");
+
     fprintf(stderr, "\nvalues:\n");
     fprintf(stderr, INDENT "-bool <YES|NO>\n");
     fprintf(stderr, INDENT "-integer <number>\n");
@@ -458,69 +485,92 @@ Help(std::string const &error = std::string())
     return (error.empty() ? 0 : -1);
 }
 
-static std::pair<bool, std::vector<uint8_t>>
+/*
+ * Map the input, so binary property lists can be read in place.
+ */
+static std::unique_ptr<MappedFile>
 Read(Filesystem const *filesystem, std::string const &path = "-")
 {
-    std::vector<uint8_t> contents;
-
     if (path == "-") {
         /* - means read from stdin. */
-        contents = std::vector<uint8_t>(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        std::vector<uint8_t> contents = std::vector<uint8_t>(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        return std::unique_ptr<MappedFile>(new MappedFile(std::move(contents)));
     } else {
         /* Read from file. */
-        if (!filesystem->read(&contents, path)) {
-            return std::make_pair(false, std::vector<uint8_t>());
-        }
+        return filesystem->map(path);
     }
-
-    return std::make_pair(true, std::move(contents));
 }
 
+/*
+ * Write output as it is produced, rather than holding all of it first.
+ */
 static bool
-Write(Filesystem *filesystem, std::vector<uint8_t> const &contents, std::string const &path = "-")
+Write(Filesystem *filesystem, std::function<bool(plist::Format::Sink const &sink)> const &producer, std::string const &path = "-")
 {
     if (path == "-") {
         /* - means write to stdout. */
-        std::copy(contents.begin(), contents.end(), std::ostream_iterator<char>(std::cout));
+        return producer([](uint8_t const *data, size_t size) -> bool {
+            std::cout.write(reinterpret_cast<char const *>(data), size);
+            return static_cast<bool>(std::cout);
+        });
     } else {
-        /* Read from file. */
-        if (!filesystem->write(contents, path)) {
-            return false;
-        }
+        /* Write to file. This is usually the input, which is still mapped. */
+        return filesystem->replace(producer, path);
     }
-
-    return true;
 }
 
-static bool
-Lint(Options const &options, std::string const &file)
+static std::pair<bool, std::string>
+Lint(std::string const &file, MappedFile const &input)
 {
-    if (!options.silent()) {
-        /* Already linted by virtue of getting this far. */
-        printf("%s: OK\n", file.c_str());
+    /* Only check the input is valid; no objects are created. */
+    plist::Format::Visitor visitor;
+
+    if (auto binary = plist::Format::Binary::Identify(input.data(), input.size())) {
+        auto visit = plist::Format::Binary::Visit(input.data(), input.size(), *binary, &visitor);
+        if (!visit.first) {
+            return std::make_pair(false, visit.second);
+        }
+
+        return std::make_pair(true, std::string());
     }
 
-    return true;
+    /* The text parsers need their own copy. */
+    std::vector<uint8_t> const contents = std::vector<uint8_t>(input.data(), input.data() + input.size());
+
+    if (auto any = plist::Format::Any::Identify(contents)) {
+        auto visit = plist::Format::Any::Visit(contents, *any, &visitor);
+        if (!visit.first) {
+            return std::make_pair(false, visit.second);
+        }
+    } else {
+        auto visit = plist::Format::JSON::Visit(contents, plist::Format::JSON::Create(), &visitor);
+        if (!visit.first) {
+            return std::make_pair(false, "input " + file + " not a plist or json");
+        }
+    }
+
+    return std::make_pair(true, std::string());
 }
 
-static bool
+static std::pair<bool, std::string>
 Print(Filesystem *filesystem, Options const &options, std::unique_ptr<plist::Object> object)
 {
     /* Convert to ASCII. */
     plist::Format::ASCII out = plist::Format::ASCII::Create(false, plist::Format::Encoding::UTF8);
-    auto serialize = plist::Format::ASCII::Serialize(object.get(), out);
-    if (serialize.first == nullptr) {
-        fprintf(stderr, "error: %s\n", serialize.second.c_str());
-        return false;
-    }
+    std::pair<bool, std::string> serialize = std::make_pair(true, std::string());
 
     /* Print. */
-    if (!Write(filesystem, *serialize.first)) {
-        fprintf(stderr, "error: unable to write\n");
-        return false;
+    bool written = Write(filesystem, [&](plist::Format::Sink const &sink) -> bool {
+        serialize = plist::Format::ASCII::Serialize(object.get(), out, sink);
+        return serialize.first;
+    });
+    if (!serialize.first) {
+        return serialize;
+    } else if (!written) {
+        return std::make_pair(false, "unable to write");
     }
 
-    return true;
+    return std::make_pair(true, std::string());
 }
 
 static std::string
@@ -533,7 +583,9 @@ OutputPath(Options const &options, std::string const &file)
 
     if (file != "-" && options.extension()) {
         /* Replace the file extension with the provided one. */
-        return FSUtil::GetDirectoryName(file) + "/" + FSUtil::GetBaseNameWithoutExtension(file) + "." + *options.extension();
+        std::string directory = FSUtil::GetDirectoryName(file);
+        std::string name = FSUtil::GetBaseNameWithoutExtension(file) + "." + *options.extension();
+        return (directory.empty() ? name : directory + "/" + name);
     }
 
     /* Default to overwriting the input. */
@@ -599,7 +651,7 @@ PerformAdjustment(plist::Object *object, plist::Object **rootObject, std::string
     }
 }
 
-static bool
+static std::pair<bool, std::string>
 Modify(Filesystem *filesystem, Options const &options, std::string const &file, std::unique_ptr<plist::Object> object, Options::Format const &inputFormat)
 {
     plist::Object *writeObject = object.get();
@@ -630,41 +682,193 @@ Modify(Filesystem *filesystem, Options const &options, std::string const &file,
             }
 
             if (currentObject == nullptr) {
-                fprintf(stderr, "error: invalid key path\n");
-                return false;
+                return std::make_pair(false, "invalid key path");
             }
 
             start = end + 1;
         } while (end != std::string::npos);
     }
 
-    /* Convert to desired format. */
-    std::pair<std::unique_ptr<std::vector<uint8_t>>, std::string> serialize;
+    /* Convert to desired format, straight into the output. */
+    std::pair<bool, std::string> serialize = std::make_pair(true, std::string());
 
     Options::Format outputFormat = options.convert().value_or(inputFormat);
-    if (ext::optional<plist::Format::Any> any = outputFormat.any()) {
-        serialize = plist::Format::Any::Serialize(writeObject, *any);
-    } else if (ext::optional<plist::Format::JSON> json = outputFormat.json()) {
-        serialize = plist::Format::JSON::Serialize(writeObject, *json);
+    std::string output = OutputPath(options, file);
+    bool written = Write(filesystem, [&](plist::Format::Sink const &sink) -> bool {
+        if (ext::optional<plist::Format::Any> any = outputFormat.any()) {
+            serialize = plist::Format::Any::Serialize(writeObject, *any, sink);
+        } else if (ext::optional<plist::Format::JSON> json = outputFormat.json()) {
+            serialize = plist::Format::JSON::Serialize(writeObject, *json, sink);
+        } else {
+            abort();
+        }
+
+        return serialize.first;
+    }, output);
+
+    if (!serialize.first) {
+        return serialize;
+    } else if (!written) {
+        return std::make_pair(false, "unable to write");
+    }
+
+    return std::make_pair(true, std::string());
+}
+
+/*
+ * Perform the requested action on one input file.
+ */
+static std::pair<bool, std::string>
+Process(Filesystem *filesystem, Options const &options, std::string const &file)
+{
+    std::unique_ptr<MappedFile> input = Read(filesystem, file);
+    if (input == nullptr) {
+        return std::make_pair(false, "unable to read " + file);
+    }
+
+    /* Linting is the default action. */
+    bool modify = (options.convert() || !options.adjustments().empty());
+    if (!modify && !options.print()) {
+        return Lint(file, *input);
+    }
+
+    /* Deserialize input, storing input format. */
+    ext::optional<Options::Format> format;
+    std::unique_ptr<plist::Object> root;
+
+    if (auto binary = plist::Format::Binary::Identify(input->data(), input->size())) {
+        /* Binary is read in place. */
+        auto deserialize = plist::Format::Binary::Deserialize(input->data(), input->size(), *binary);
+        if (deserialize.first == nullptr) {
+            return std::make_pair(false, deserialize.second);
+        }
+
+        root = std::move(deserialize.first);
+        format = Options::Format(plist::Format::Any::Create(*binary));
+    } else {
+        /* The text parsers need their own copy. */
+        std::vector<uint8_t> const contents = std::vector<uint8_t>(input->data(), input->data() + input->size());
+
+        if (auto any = plist::Format::Any::Identify(contents)) {
+            auto deserialize = plist::Format::Any::Deserialize(contents, *any);
+            if (deserialize.first == nullptr) {
+                return std::make_pair(false, deserialize.second);
+            }
+
+            root = std::move(deserialize.first);
+            format = Options::Format(*any);
+        } else {
+            auto json = plist::Format::JSON::Create();
+            auto deserialize = plist::Format::JSON::Deserialize(contents, json);
+            if (deserialize.first == nullptr) {
+                return std::make_pair(false, "input " + file + " not a plist or json");
+            }
+
+            root = std::move(deserialize.first);
+            format = Options::Format(json);
+        }
+    }
+
+    /* Nothing refers to the input once deserialized. */
+    input.reset();
+
+    /* Perform the specific action. */
+    if (modify) {
+        return Modify(filesystem, options, file, std::move(root), *format);
     } else {
-        abort();
+        return Print(filesystem, options, std::move(root));
     }
+}
 
-    if (serialize.first == nullptr) {
-        fprintf(stderr, "error: %s\n", serialize.second.c_str());
+static bool
+Report(Options const &options, std::string const &file, std::pair<bool, std::string> const &result, bool batch)
+{
+    if (!result.first) {
+        if (batch) {
+            /* Many files are reported together; say which one failed. */
+            fprintf(stderr, "error: %s: %s\n", file.c_str(), result.second.c_str());
+        } else {
+            fprintf(stderr, "error: %s\n", result.second.c_str());
+        }
         return false;
     }
 
-    /* Write to output. */
-    std::string output = OutputPath(options, file);
-    if (!Write(filesystem, *serialize.first, output)) {
-        fprintf(stderr, "error: unable to write\n");
-        return false;
+    bool modify = (options.convert() || !options.adjustments().empty());
+    if (!modify && !options.print() && !options.silent()) {
+        printf("%s: OK\n", file.c_str());
     }
 
     return true;
 }
 
+static std::pair<bool, std::vector<std::string>>
+ReadList(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<MappedFile> contents = Read(filesystem, path);
+    if (contents == nullptr) {
+        return std::make_pair(false, std::vector<std::string>());
+    }
+
+    /* One path per line; blank lines are ignored. */
+    std::vector<std::string> files;
+    std::istringstream stream(std::string(reinterpret_cast<char const *>(contents->data()), contents->size()));
+    for (std::string line; std::getline(stream, line);) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (!line.empty()) {
+            files.push_back(line);
+        }
+    }
+
+    return std::make_pair(true, std::move(files));
+}
+
+/*
+ * Process many files in one process, on a pool of threads. Results are
+ * reported in input order once all files are done, then the throughput.
+ */
+static bool
+Batch(Filesystem *filesystem, Options const &options, std::vector<std::string> const &files)
+{
+    size_t jobs = libutil::ThreadPool::DefaultSize();
+    if (options.jobs() && *options.jobs() > 0) {
+        jobs = static_cast<size_t>(*options.jobs());
+    }
+
+    libutil::ThreadPool pool(jobs);
+    std::vector<std::pair<bool, std::string>> results = std::vector<std::pair<bool, std::string>>(files.size());
+
+    auto start = std::chrono::steady_clock::now();
+    pool.apply(files.size(), [&](size_t n) {
+        if (files[n] == "-") {
+            /* Standard input may hold the file list itself. */
+            results[n] = std::make_pair(false, "standard input can't be used with -batch");
+        } else {
+            results[n] = Process(filesystem, options, files[n]);
+        }
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t failed = 0;
+    for (size_t n = 0; n < files.size(); n++) {
+        if (!Report(options, files[n], results[n], true)) {
+            failed++;
+        }
+    }
+
+    if (!options.silent()) {
+        double seconds = elapsed.count();
+        fprintf(stderr, "%zu files (%zu failed) in %.3fs with %zu jobs: %.1f files/s, %.3fms per file\n",
+            files.size(), failed, seconds, jobs,
+            (seconds > 0 ? files.size() / seconds : 0.0),
+            (seconds * 1000.0) / files.size());
+    }
+
+    return (failed == 0);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -688,60 +892,44 @@ main(int argc, char **argv)
         return Help("conflicting options specified");
     }
 
+    /* Each file in a batch is written on its own. */
+    if (options.batch() && (options.print() || options.output())) {
+        return Help("-p and -o can't be used with -batch");
+    }
+
+    /* Only a batch is processed in parallel. */
+    if (options.jobs() && !options.batch()) {
+        return Help("-jobs can only be used with -batch");
+    }
+
     /* Perform actions. */
     if (options.help()) {
         return Help();
     } else {
-        bool success = true;
+        std::vector<std::string> inputs = options.inputs();
 
-        if (options.inputs().empty()) {
-            return Help("no input files");
-        }
-
-        /* Actions applied to each input file separately. */
-        for (std::string const &file : options.inputs()) {
-            std::pair<bool, std::vector<uint8_t>> _result = Read(&filesystem, file);
-            if (!result.first) {
-                fprintf(stderr, "error: unable to read %s\n", file.c_str());
-                success = false;
-                continue;
+        if (options.batch()) {
+            std::pair<bool, std::vector<std::string>> list = ReadList(&filesystem, *options.batch());
+            if (!list.first) {
+                fprintf(stderr, "error: unable to read %s\n", options.batch()->c_str());
+                return 1;
             }
 
-            /* Deserialize input, storing input format. */
-            ext::optional<Options::Format> format;
-            std::unique_ptr<plist::Object> root;
+            inputs.insert(inputs.end(), list.second.begin(), list.second.end());
+        }
 
-            if (auto any = plist::Format::Any::Identify(_result.second)) {
-                auto deserialize = plist::Format::Any::Deserialize(_result.second, *any);
-                if (deserialize.first != nullptr) {
-                    root = std::move(deserialize.first);
-                    format = Options::Format(*any);
-                } else {
-                    fprintf(stderr, "error: %s\n", deserialize.second.c_str());
-                    success = false;
-                    continue;
-                }
-            } else {
-                auto json = plist::Format::JSON::Create();
-                auto deserialize = plist::Format::JSON::Deserialize(_result.second, json);
-                if (deserialize.first != nullptr) {
-                    root = std::move(deserialize.first);
-                    format = Options::Format(json);
-                } else {
-                    fprintf(stderr, "error: input %s not a plist or json\n", file.c_str());
-                    success = false;
-                    continue;
-                }
-            }
+        if (inputs.empty()) {
+            return Help("no input files");
+        }
 
-            /* Perform the specific action. */
-            if (modify) {
-                success &= Modify(&filesystem, options, file, std::move(root), *format);
-            } else if (options.print()) {
-                success &= Print(&filesystem, options, std::move(root));
-            } else if (options.lint() || true) {
-                success &= Lint(options, file);
-            }
+        if (options.batch()) {
+            return (Batch(&filesystem, options, inputs) ? 0 : 1);
+        }
+
+        /* Actions applied to each input file separately. */
+        bool success = true;
+        for (std::string const &file : inputs) {
+            success &= Report(options, file, Process(&filesystem, options, file), false);
         }
 
         return (success ? 0 : 1);
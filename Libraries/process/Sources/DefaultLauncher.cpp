@@ -10,6 +10,8 @@
 #include <process/Context.h>
 #include <libutil/Filesystem.h>
 
+#include <mutex>
+
 #include <fcntl.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -17,6 +19,10 @@
 // In most cases, size of pipe will be greater than one page,
 #define PIPE_BUFFER_SIZE 4096
 
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define HAVE_PIPE2 1
+#endif
+
 using process::DefaultLauncher;
 using process::Context;
 using libutil::Filesystem;
@@ -29,6 +35,34 @@ using libutil::Filesystem;
    return pc; 
 }
 
+#if !defined(HAVE_PIPE2)
+/*
+ * Held from creating a pipe until it is close-on-exec and the child is
+ * forked, so a launch on another thread can't fork in between.
+ */
+static std::mutex ForkMutex;
+#endif
+
+/*
+ * Creates a pipe that other children, launched at the same time from
+ * other threads, don't inherit: if one held the write end open, the
+ * reader would never see the end of the output.
+ */
+static int
+CreatePipe(int pfd[2])
+{
+#if defined(HAVE_PIPE2)
+    return ::pipe2(pfd, O_CLOEXEC);
+#else
+    if (::pipe(pfd) == -1) {
+        return -1;
+    }
+    ::fcntl(pfd[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(pfd[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
+
 DefaultLauncher::
 DefaultLauncher() :
     Launcher()
@@ -96,7 +130,10 @@ launch(Filesystem *filesystem, Context const *context)
     /* Setup parent-child stdout/stderr pipe. */
     int pfd[2];
     bool pipe_setup_success = true;
-    if (pipe(pfd) == -1) {
+#if !defined(HAVE_PIPE2)
+    std::unique_lock<std::mutex> forkLock(ForkMutex);
+#endif
+    if (CreatePipe(pfd) == -1) {
         ::perror("pipe");
         pipe_setup_success = false;
     }
@@ -105,6 +142,11 @@ launch(Filesystem *filesystem, Context const *context)
      * Fork new process.
      */
     pid_t pid = fork();
+#if !defined(HAVE_PIPE2)
+    if (pid != 0) {
+        forkLock.unlock();
+    }
+#endif
     if (pid < 0) {
         /* Fork failed. */
         return ext::nullopt;
@@ -24,7 +24,7 @@ private:
 
 public:
     static int
-    Run(process::User const *user, process::Context const *processContext, libutil::Filesystem const *filesystem, Options const &options);
+    Run(process::User const *user, process::Context const *processContext, libutil::Filesystem *filesystem, Options const &options);
 };
 
 }
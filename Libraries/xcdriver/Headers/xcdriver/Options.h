@@ -48,6 +48,8 @@ private:
     ext::optional<std::string> _formatter;
     ext::optional<std::string> _executor;
     ext::optional<bool>        _generate;
+    ext::optional<bool>        _ninjaSingleManifest;
+    ext::optional<std::string> _projectCache;
 
 private:
     ext::optional<bool>        _parallelizeTargets;
@@ -157,6 +159,12 @@ public:
     /* Extension. */
     bool generate() const
     { return _generate.value_or(false); }
+    /* Extension. */
+    bool ninjaSingleManifest() const
+    { return _ninjaSingleManifest.value_or(false); }
+    /* Extension. */
+    ext::optional<std::string> const &projectCache() const
+    { return _projectCache; }
 
 public:
     bool parallelizeTargets() const
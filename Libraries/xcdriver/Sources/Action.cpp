@@ -77,7 +77,8 @@ CreateParameters(Options const &options, std::vector<pbxsetting::Level> const &o
         options.allTargets(),
         options.actions(),
         options.configuration(),
-        overrideLevels);
+        overrideLevels,
+        options.projectCache());
 }
 
 bool Action::
@@ -16,6 +16,7 @@
 #include <builtin/Registry.h>
 #include <libutil/Base.h>
 #include <libutil/Filesystem.h>
+#include <libutil/ThreadPool.h>
 #include <process/Context.h>
 
 #include <unistd.h>
@@ -55,14 +56,17 @@ CreateExecutor(
     ext::optional<std::string> const &executor,
     std::shared_ptr<xcformatter::Formatter> const &formatter,
     bool dryRun,
-    bool generate)
+    bool generate,
+    size_t jobs,
+    bool parallelizeTargets,
+    bool ninjaSingleManifest)
 {
     if (!executor || *executor == "simple") {
         auto registry = builtin::Registry::Default();
-        auto _executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry);
+        auto _executor = xcexecution::SimpleExecutor::Create(formatter, dryRun, registry, jobs, parallelizeTargets);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(_executor));
     } else if (*executor == "ninja") {
-        auto _executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate);
+        auto _executor = xcexecution::NinjaExecutor::Create(formatter, dryRun, generate, ninjaSingleManifest);
         return libutil::static_unique_pointer_cast<xcexecution::Executor>(std::move(_executor));
     }
 
@@ -84,8 +88,9 @@ VerifySupportedOptions(Options const &options)
         fprintf(stderr, "warning: destination option not implemented\n");
     }
 
-    if (options.parallelizeTargets() || options.jobs()) {
-        fprintf(stderr, "warning: job control option not implemented\n");
+    if (options.jobs() && *options.jobs() < 1) {
+        fprintf(stderr, "error: jobs must be at least one\n");
+        return false;
     }
 
     if (options.enableAddressSanitizer() || options.enableThreadSanitizer() || options.enableCodeCoverage()) {
@@ -138,7 +143,15 @@ Run(process::User const *user, process::Context const *processContext, process::
     /*
      * Create the executor used to perform the build.
      */
-    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate());
+    size_t jobs = 1;
+    if (options.jobs()) {
+        jobs = static_cast<size_t>(*options.jobs());
+    } else if (options.parallelizeTargets()) {
+        /* Building targets in parallel needs jobs to share; default to one per core. */
+        jobs = libutil::ThreadPool::DefaultSize();
+    }
+
+    std::unique_ptr<xcexecution::Executor> executor = CreateExecutor(options.executor(), formatter, options.dryRun(), options.generate(), jobs, options.parallelizeTargets(), options.ninjaSingleManifest());
     if (executor == nullptr) {
         fprintf(stderr, "error: unknown executor '%s'\n", options.executor()->c_str());
         return -1;
@@ -71,6 +71,16 @@ Run(process::Context const *processContext)
         "    -generate                                   "
         "specify that an execution engine based on generating another build "
         "language should regenerate\n");
+    fprintf(
+        stdout,
+        "    -ninja-single-manifest                      "
+        "with the 'ninja' executor, write all targets into one Ninja file "
+        "instead of one per target\n");
+    fprintf(
+        stdout,
+        "    -projectCache PATH                          "
+        "cache parsed projects in the directory PATH, to load them faster "
+        "when unchanged\n");
     fprintf(
         stdout,
         "    -project NAME                               "
@@ -124,11 +134,11 @@ Run(process::Context const *processContext)
     fprintf(
         stdout,
         "    -parallelizeTargets                         "
-        "not yet implemented\n");
+        "build independent targets at the same time\n");
     fprintf(
         stdout,
         "    -jobs NUMBER                                "
-        "not yet implemented\n");
+        "run up to NUMBER build commands at once\n");
     fprintf(
         stdout,
         "    -dry-run                                    "
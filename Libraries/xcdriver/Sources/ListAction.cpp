@@ -19,7 +19,7 @@ using xcdriver::Options;
 using libutil::Filesystem;
 
 int ListAction::
-Run(process::User const *user, process::Context const *processContext, Filesystem const *filesystem, Options const &options)
+Run(process::User const *user, process::Context const *processContext, Filesystem *filesystem, Options const &options)
 {
     ext::optional<pbxbuild::Build::Environment> buildEnvironment = pbxbuild::Build::Environment::Default(user, processContext, filesystem);
     if (!buildEnvironment) {
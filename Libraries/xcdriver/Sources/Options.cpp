@@ -129,6 +129,10 @@ parseArgument(std::vector<std::string> const &args, std::vector<std::string>::co
         return libutil::Options::Next<std::string>(&_formatter, args, it);
     } else if (arg == "-generate") {
         return libutil::Options::Current<bool>(&_generate, arg);
+    } else if (arg == "-ninja-single-manifest") {
+        return libutil::Options::Current<bool>(&_ninjaSingleManifest, arg);
+    } else if (arg == "-projectCache") {
+        return libutil::Options::Next<std::string>(&_projectCache, args, it);
     } else if (!arg.empty() && arg[0] != '-') {
         if (arg.find('=') != std::string::npos) {
             if (ext::optional<pbxsetting::Setting> setting = pbxsetting::Setting::Parse(arg)) {
@@ -28,7 +28,7 @@ ShowBuildSettingsAction::
 }
 
 int ShowBuildSettingsAction::
-Run(process::User const *user, process::Context const *processContext, Filesystem const *filesystem, Options const &options)
+Run(process::User const *user, process::Context const *processContext, Filesystem *filesystem, Options const &options)
 {
     if (!Action::VerifyBuildActions(options.actions())) {
         return -1;
@@ -10,10 +10,15 @@
 #define __xcexecution_Executor_h
 
 #include <xcformatter/Formatter.h>
+#include <pbxbuild/Target/Environment.h>
+#include <pbxbuild/Phase/PhaseInvocations.h>
 
 #include <memory>
+#include <vector>
+#include <ext/optional>
 
 namespace libutil { class Filesystem; }
+namespace libutil { class ThreadPool; }
 namespace process { class Context; }
 namespace process { class Launcher; }
 namespace process { class User; }
@@ -21,7 +26,6 @@ namespace process { class User; }
 namespace pbxbuild {
 namespace Build { class Context; }
 namespace Build { class Environment; }
-namespace Target { class Environment; }
 }
 
 namespace xcexecution {
@@ -56,6 +60,32 @@ public:
         libutil::Filesystem *filesystem,
         pbxbuild::Build::Environment const &buildEnvironment,
         Parameters const &buildParameters) = 0;
+
+protected:
+    /*
+     * Creates the environment for each target, in parallel on the pool.
+     * Results are in the same order as the targets; a result is missing
+     * if that target's environment could not be created.
+     */
+    static std::vector<ext::optional<pbxbuild::Target::Environment>>
+    CreateTargetEnvironments(
+        libutil::ThreadPool *pool,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &targets);
+
+    /*
+     * Creates the invocations for each target, in parallel on the pool.
+     * Results are in the same order as the targets; a result is missing
+     * if that target has no environment.
+     */
+    static std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>>
+    CreatePhaseInvocations(
+        libutil::ThreadPool *pool,
+        pbxbuild::Build::Environment const &buildEnvironment,
+        pbxbuild::Build::Context const &buildContext,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &targets,
+        std::vector<ext::optional<pbxbuild::Target::Environment>> const &targetEnvironments);
 };
 
 }
@@ -19,11 +19,17 @@ namespace ninja { class Writer; }
 namespace xcexecution {
 
 /*
- * Concrete executor that generates Ninja files.
+ * Concrete executor that generates Ninja files. By default, each target gets
+ * its own Ninja file, loaded from the top-level Ninja file. With a single
+ * manifest, every target is written into the top-level Ninja file, and each
+ * tool gets its own rule rather than repeating the full command per edge.
  */
 class NinjaExecutor : public Executor {
+private:
+    bool _singleManifest;
+
 public:
-    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool singleManifest);
     ~NinjaExecutor();
 
 public:
@@ -54,11 +60,14 @@ private:
     bool buildTargetInvocations(
         process::Context const *processContext,
         libutil::Filesystem *filesystem,
+        ninja::Writer *writer,
+        std::unordered_map<std::string, std::string> *toolRules,
         std::string const &dependencyInfoToolPath,
         pbxproj::PBX::Target::shared_ptr const &target,
         pbxbuild::Target::Environment const &targetEnvironment,
         std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
-        std::vector<pbxbuild::Tool::Invocation> const &invocations);
+        std::vector<pbxbuild::Tool::Invocation> const &invocations,
+        std::vector<std::string> *generatedPaths);
 
 private:
     bool buildAuxiliaryFile(
@@ -69,6 +78,7 @@ private:
         std::map<std::string, pbxbuild::Tool::AuxiliaryFile::Chunk const *> &auxiliaryFileChunks);
     bool buildInvocation(
         ninja::Writer *writer,
+        std::unordered_map<std::string, std::string> *toolRules,
         pbxbuild::Tool::Invocation const &invocation,
         std::string const &executablePath,
         std::string const &dependencyInfoToolPath,
@@ -77,7 +87,7 @@ private:
 
 public:
     static std::unique_ptr<NinjaExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool singleManifest);
 };
 
 }
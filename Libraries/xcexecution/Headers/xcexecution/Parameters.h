@@ -37,6 +37,7 @@ private:
     std::vector<std::string>       _actions;
     ext::optional<std::string>     _configuration;
     std::vector<pbxsetting::Level> _overrideLevels;
+    ext::optional<std::string>     _projectCachePath;
 
 public:
     Parameters(
@@ -47,7 +48,8 @@ public:
         bool allTargets,
         std::vector<std::string> const &actions,
         ext::optional<std::string> const &configuration,
-        std::vector<pbxsetting::Level> const &overrideLevels);
+        std::vector<pbxsetting::Level> const &overrideLevels,
+        ext::optional<std::string> const &projectCachePath);
 
 public:
     /*
@@ -98,6 +100,12 @@ public:
     std::vector<pbxsetting::Level> const &overrideLevels() const
     { return _overrideLevels; }
 
+    /*
+     * Directory to cache parsed projects in, if any.
+     */
+    ext::optional<std::string> const &projectCachePath() const
+    { return _projectCachePath; }
+
 public:
     /*
      * The canonical set of arguments to reproduce these parameters.
@@ -111,10 +119,11 @@ public:
 
 public:
     /*
-     * Loads the workspace from the build parameters.
+     * Loads the workspace from the build parameters. Projects are loaded
+     * through the project cache, if there is one.
      */
     ext::optional<pbxbuild::WorkspaceContext> loadWorkspace(
-        libutil::Filesystem const *filesystem,
+        libutil::Filesystem *filesystem,
         std::string const &userName,
         pbxbuild::Build::Environment const &buildEnvironment,
         std::string const &workingDirectory) const;
@@ -11,20 +11,38 @@
 
 #include <xcexecution/Executor.h>
 #include <pbxbuild/Tool/AuxiliaryFile.h>
+#include <pbxbuild/DirectedGraph.h>
 #include <builtin/Registry.h>
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace libutil { class ThreadPool; }
+
 namespace xcexecution {
 
 /*
- * Simple executor that simply runs invocations in sequence. Advanced features
- * like incremental builds, dependency info, and such are not supported.
+ * Simple executor that runs invocations directly. With more than one job,
+ * invocations are scheduled as soon as the invocations they depend on have
+ * finished, up to `jobs` at a time; otherwise they run in sequence. When
+ * parallelizing targets, targets likewise start once their dependencies are
+ * built, sharing the same job limit. Advanced features like incremental
+ * builds, dependency info, and such are not supported.
  */
 class SimpleExecutor : public Executor {
 private:
-    builtin::Registry _builtins;
+    builtin::Registry                    _builtins;
+    size_t                               _jobs;
+    bool                                 _parallelizeTargets;
+    std::unique_ptr<libutil::ThreadPool> _pool;
+
+private:
+    std::atomic<bool>                    _cancelled;
+    std::mutex                           _formatterMutex;
 
 public:
-    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets);
     ~SimpleExecutor();
 
 public:
@@ -36,6 +54,19 @@ public:
         pbxbuild::Build::Environment const &buildEnvironment,
         Parameters const &buildParameters);
 
+public:
+    /*
+     * The maximum number of invocations run at once.
+     */
+    size_t jobs() const
+    { return _jobs; }
+
+    /*
+     * If independent targets build at the same time.
+     */
+    bool parallelizeTargets() const
+    { return _parallelizeTargets; }
+
 public:
     bool writeAuxiliaryFiles(
         libutil::Filesystem *filesystem,
@@ -56,9 +87,72 @@ public:
         std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
         std::vector<pbxbuild::Tool::Invocation> const &invocations);
 
+public:
+    /*
+     * Build each target with the builder once the targets it depends on are
+     * built, up to `jobs` targets at a time. After a target fails, no more
+     * targets start and those running are cancelled; the first failure is
+     * returned.
+     */
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTargetsInParallel(
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+        std::function<std::pair<bool, std::vector<pbxbuild::Tool::Invocation>>(pbxproj::PBX::Target::shared_ptr const &)> const &targetBuilder);
+
+    /*
+     * If invocations are being cancelled after another target failed.
+     */
+    bool cancelled() const
+    { return _cancelled; }
+
+private:
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> buildTargetInContext(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        pbxbuild::Build::Context const &buildContext,
+        pbxproj::PBX::Target::shared_ptr const &target,
+        ext::optional<pbxbuild::Target::Environment> const &targetEnvironment,
+        ext::optional<pbxbuild::Phase::PhaseInvocations> const &phaseInvocations);
+
+private:
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> performInvocationsSerially(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        std::vector<std::string> const &executablePaths,
+        std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
+        bool createProductStructure);
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> performInvocationsInParallel(
+        process::Context const *processContext,
+        process::Launcher *processLauncher,
+        libutil::Filesystem *filesystem,
+        std::vector<std::string> const &executablePaths,
+        std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
+        bool createProductStructure);
+
+private:
+    /*
+     * Prints the output of a formatter call. Targets building in parallel
+     * report from their own threads, so formatter calls are serialized.
+     */
+    void print(std::function<std::string()> const &format);
+
+public:
+    /*
+     * The targets planned together in a serial build, as indexes into the
+     * ordered targets. Each wave is planned just before its first target
+     * builds, and holds every target not yet planned whose dependencies are
+     * built by then, in build order.
+     */
+    static std::vector<std::vector<size_t>>
+    PlanningWaves(
+        pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+        std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets);
+
 public:
     static std::unique_ptr<SimpleExecutor>
-    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins);
+    Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets);
 };
 
 }
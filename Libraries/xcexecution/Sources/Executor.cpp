@@ -7,6 +7,9 @@
  */
 
 #include <xcexecution/Executor.h>
+#include <pbxbuild/Build/Context.h>
+#include <pbxbuild/Phase/Environment.h>
+#include <libutil/ThreadPool.h>
 
 using xcexecution::Executor;
 
@@ -22,3 +25,43 @@ Executor::
 ~Executor()
 {
 }
+
+std::vector<ext::optional<pbxbuild::Target::Environment>> Executor::
+CreateTargetEnvironments(
+    libutil::ThreadPool *pool,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &targets)
+{
+    /*
+     * Each target's result goes in its own slot, so no locking is needed
+     * and the results don't depend on which target finishes first.
+     */
+    std::vector<ext::optional<pbxbuild::Target::Environment>> targetEnvironments = std::vector<ext::optional<pbxbuild::Target::Environment>>(targets.size());
+    pool->apply(targets.size(), [&](size_t i) {
+        targetEnvironments[i] = buildContext.targetEnvironment(buildEnvironment, targets[i]);
+    });
+
+    return targetEnvironments;
+}
+
+std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>> Executor::
+CreatePhaseInvocations(
+    libutil::ThreadPool *pool,
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &targets,
+    std::vector<ext::optional<pbxbuild::Target::Environment>> const &targetEnvironments)
+{
+    std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>> phaseInvocations = std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>>(targets.size());
+    pool->apply(targets.size(), [&](size_t i) {
+        if (!targetEnvironments[i]) {
+            return;
+        }
+
+        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, targets[i], *targetEnvironments[i]);
+        phaseInvocations[i] = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, targets[i]);
+    });
+
+    return phaseInvocations;
+}
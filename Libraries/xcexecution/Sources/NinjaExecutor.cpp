@@ -11,18 +11,22 @@
 #include <xcexecution/Parameters.h>
 #include <pbxbuild/Phase/Environment.h>
 #include <pbxbuild/Phase/PhaseInvocations.h>
+#include <pbxsetting/XC/Config.h>
+#include <xcsdk/SDK/Manager.h>
 #include <ninja/Writer.h>
 #include <ninja/Value.h>
 #include <plist/Data.h>
 #include <libutil/Escape.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/ThreadPool.h>
 #include <process/Context.h>
 #include <process/MemoryContext.h>
 #include <process/Launcher.h>
 #include <process/User.h>
 #include <libutil/md5.h>
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 
@@ -36,8 +40,9 @@ using libutil::Filesystem;
 using libutil::FSUtil;
 
 NinjaExecutor::
-NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate) :
-    Executor(formatter, dryRun, generate)
+NinjaExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool singleManifest) :
+    Executor       (formatter, dryRun, generate),
+    _singleManifest(singleManifest)
 {
 }
 
@@ -96,6 +101,26 @@ NinjaRuleName()
     return "invoke";
 }
 
+static std::string
+NinjaToolRuleName(std::string const &executablePath, std::unordered_map<std::string, std::string> const &toolRules)
+{
+    /*
+     * Name the rule after the tool, keeping only characters Ninja allows in
+     * rule names. Different tools with the same name get a numeric suffix.
+     */
+    std::string name = "invoke-";
+    for (char c : FSUtil::GetBaseName(executablePath)) {
+        name += (isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-' || c == '.' ? c : '_');
+    }
+
+    std::string unique = name;
+    for (size_t i = 2; std::any_of(toolRules.begin(), toolRules.end(), [&unique](std::pair<std::string const, std::string> const &entry) { return entry.second == unique; }); i++) {
+        unique = name + "-" + std::to_string(i);
+    }
+
+    return unique;
+}
+
 static std::string
 NinjaDescription(std::string const &description)
 {
@@ -126,6 +151,169 @@ NinjaHash(char const *data, size_t size)
     return ss.str();
 }
 
+static std::string
+NinjaFileHash(Filesystem const *filesystem, std::unordered_map<std::string, std::string> *fileHashes, std::string const &path)
+{
+    auto it = fileHashes->find(path);
+    if (it != fileHashes->end()) {
+        return it->second;
+    }
+
+    /* A missing file still hashes, so it changes the fingerprint once created. */
+    std::string hash;
+    std::vector<uint8_t> contents;
+    if (filesystem->read(&contents, path)) {
+        hash = NinjaHash(reinterpret_cast<char const *>(contents.data()), contents.size());
+    }
+
+    fileHashes->insert({ path, hash });
+    return hash;
+}
+
+static std::string
+TargetNinjaFingerprintPath(std::string const &intermediatesDirectory, Parameters const &buildParameters, pbxproj::PBX::Target::shared_ptr const &target)
+{
+    /*
+     * The fingerprint is checked before the target is resolved, so it can't go in the
+     * target's temp dir. Instead, it is named for the target and the build parameters,
+     * so each configuration of a target keeps its own, as the temp dir would.
+     */
+    pbxproj::PBX::Project::shared_ptr project = target->project();
+    std::string identity = buildParameters.canonicalHash() + '\n' + (project != nullptr ? project->dataFile() : std::string()) + '\n' + target->blueprintIdentifier();
+
+    return intermediatesDirectory + "/" + ".ninja-fingerprints" + "/" + NinjaHash(identity.data(), identity.size());
+}
+
+static std::string
+BuildNinjaFingerprint(
+    Filesystem const *filesystem,
+    Parameters const &buildParameters,
+    std::string const &executablePath,
+    pbxbuild::Build::Environment const &buildEnvironment)
+{
+    /*
+     * The part of every target's fingerprint shared by the whole build: the build
+     * parameters, the generator, the settings from the system, the SDKs and
+     * toolchains found, and the specifications registered. Both record what they
+     * searched and read, so their modification times stand in for the contents.
+     */
+    std::ostringstream ss;
+    ss << buildParameters.canonicalHash() << '\n';
+    ss << executablePath << ' ' << filesystem->modificationTime(executablePath).value_or(0) << '\n';
+
+    std::unordered_map<std::string, std::string> values = buildEnvironment.baseEnvironment().computeValues(pbxsetting::Condition::Empty());
+    std::map<std::string, std::string> orderedValues = std::map<std::string, std::string>(values.begin(), values.end());
+    for (auto const &entry : orderedValues) {
+        ss << entry.first << '=' << entry.second << '\n';
+    }
+
+    std::vector<std::string> dependencies = buildEnvironment.sdkManager()->dependencies();
+    std::vector<std::string> specDependencies = buildEnvironment.specManager()->dependencies();
+    dependencies.insert(dependencies.end(), specDependencies.begin(), specDependencies.end());
+    std::sort(dependencies.begin(), dependencies.end());
+    for (std::string const &dependency : dependencies) {
+        ss << dependency << ' ' << filesystem->modificationTime(dependency).value_or(0) << '\n';
+    }
+
+    std::string contents = ss.str();
+    return NinjaHash(contents.data(), contents.size());
+}
+
+static void
+ConfigurationPaths(pbxsetting::XC::Config const &config, std::vector<std::string> *paths)
+{
+    paths->push_back(config.path());
+    for (pbxsetting::XC::Config::Entry const &entry : config.contents()) {
+        if (entry.type() == pbxsetting::XC::Config::Entry::Type::Include && entry.config() != nullptr) {
+            ConfigurationPaths(*entry.config(), paths);
+        }
+    }
+}
+
+static std::string
+TargetNinjaFingerprint(
+    Filesystem const *filesystem,
+    std::unordered_map<std::string, std::string> *fileHashes,
+    std::string const &buildFingerprint,
+    pbxbuild::WorkspaceContext const &workspaceContext,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    std::vector<std::string> const &dependencyFingerprints)
+{
+    /*
+     * The fingerprint covers everything the target's Ninja is generated from, so
+     * it can be checked without resolving the target: what is shared by the build,
+     * the project file, and the configuration files and what they include. The
+     * fingerprints of dependencies are included since a target's invocations can
+     * depend on the products of the targets it depends on.
+     */
+    std::ostringstream ss;
+    ss << buildFingerprint << '\n';
+
+    pbxproj::PBX::Project::shared_ptr project = target->project();
+    if (project != nullptr) {
+        ss << project->dataFile() << ' ' << NinjaFileHash(filesystem, fileHashes, project->dataFile()) << '\n';
+    }
+
+    std::vector<std::string> configurationPaths;
+    for (auto const &entry : workspaceContext.configs()) {
+        pbxproj::XC::BuildConfiguration::shared_ptr const &buildConfiguration = entry.first;
+        for (pbxproj::XC::ConfigurationList::shared_ptr const &configurationList : {
+            target->buildConfigurationList(),
+            (project != nullptr ? project->buildConfigurationList() : nullptr),
+        }) {
+            if (configurationList != nullptr && std::find(configurationList->buildConfigurations().begin(), configurationList->buildConfigurations().end(), buildConfiguration) != configurationList->buildConfigurations().end()) {
+                ConfigurationPaths(entry.second, &configurationPaths);
+            }
+        }
+    }
+    std::sort(configurationPaths.begin(), configurationPaths.end());
+    configurationPaths.erase(std::unique(configurationPaths.begin(), configurationPaths.end()), configurationPaths.end());
+    for (std::string const &configurationPath : configurationPaths) {
+        ss << configurationPath << ' ' << NinjaFileHash(filesystem, fileHashes, configurationPath) << '\n';
+    }
+
+    for (std::string const &dependencyFingerprint : dependencyFingerprints) {
+        ss << dependencyFingerprint << '\n';
+    }
+
+    std::string contents = ss.str();
+    return NinjaHash(contents.data(), contents.size());
+}
+
+static ext::optional<std::string>
+LoadTargetNinjaFingerprint(Filesystem const *filesystem, std::string const &fingerprintPath, std::string const &fingerprint)
+{
+    /*
+     * The fingerprint file holds the fingerprint on the first line, then the files
+     * generated along with the target's Ninja that its build needs, one per line,
+     * then an empty line and the target's section of the top-level Ninja file. Only
+     * reuse it if those files are all still there too.
+     */
+    std::vector<uint8_t> contents;
+    if (!filesystem->read(&contents, fingerprintPath)) {
+        return ext::nullopt;
+    }
+
+    std::string text = std::string(contents.begin(), contents.end());
+    std::string::size_type newline = text.find('\n');
+    if (newline == std::string::npos || text.compare(0, newline, fingerprint) != 0) {
+        return ext::nullopt;
+    }
+
+    std::string::size_type start = newline + 1;
+    while ((newline = text.find('\n', start)) != std::string::npos && newline != start) {
+        if (!filesystem->exists(text.substr(start, newline - start))) {
+            return ext::nullopt;
+        }
+        start = newline + 1;
+    }
+    if (newline == std::string::npos) {
+        return ext::nullopt;
+    }
+
+    return text.substr(newline + 1);
+}
+
 static ext::optional<std::string>
 NinjaBuiltinExecutablePath(
     process::Context const *processContext,
@@ -224,13 +412,17 @@ WriteNinjaRegenerate(
     std::string const &workingDirectory,
     std::string const &ninjaPath,
     std::string const &configurationHashPath,
-    std::vector<std::string> const &inputPaths)
+    std::vector<std::string> const &inputPaths,
+    bool singleManifest)
 {
     /*
      * Regenerate using this executor. Force regeneration to avoid recursively
      * executing Ninja when Ninja itself calls this generate command.
      */
     std::vector<std::string> generateArguments = { "-generate", "-executor", "ninja" };
+    if (singleManifest) {
+        generateArguments.push_back("-ninja-single-manifest");
+    }
 
     /*
      * Add arguments necessary to recreate the same set of build parameters.
@@ -295,10 +487,33 @@ WriteNinja(Filesystem *filesystem, ninja::Writer const &writer, std::string cons
     return true;
 }
 
+static bool
+WriteNinjaIfChanged(Filesystem *filesystem, ninja::Writer const &writer, std::string const &path)
+{
+    /*
+     * Leave the file alone if it already has the same contents, so its
+     * modification time only changes when the target's Ninja does.
+     */
+    std::vector<uint8_t> existing;
+    if (filesystem->read(&existing, path)) {
+        std::string contents = writer.serialize();
+        if (existing.size() == contents.size() && std::equal(existing.begin(), existing.end(), contents.begin())) {
+            return true;
+        }
+    }
+
+    return WriteNinja(filesystem, writer, path);
+}
+
 static bool
 WriteAuxiliaryFiles(Filesystem *filesystem, std::map<std::string, pbxbuild::Tool::AuxiliaryFile::Chunk const *> &auxiliaryFileChunks)
 {
     for (auto it : auxiliaryFileChunks) {
+        /* Chunk paths include a hash of their contents, so existing chunks are up to date. */
+        if (filesystem->exists(it.first)) {
+            continue;
+        }
+
         if (!filesystem->createDirectory(FSUtil::GetDirectoryName(it.first), true)) {
             return false;
         }
@@ -529,7 +744,7 @@ buildAction(
 {
     /*
      * Write out a Ninja file for the build as a whole. Note each target will have a separate
-     * file, this is to coordinate the build between targets.
+     * file unless using a single manifest, this is to coordinate the build between targets.
      */
     ninja::Writer writer;
     writer.comment("xcbuild ninja");
@@ -558,11 +773,92 @@ buildAction(
      */
     writer.rule(NinjaRuleName(), ninja::Value::Expression("cd $dir && env $env $exec && $depexec"));
 
+    /*
+     * With a single manifest, invocations use a rule per tool, shared across targets.
+     */
+    std::unordered_map<std::string, std::string> toolRules;
+
+    /*
+     * Without a single manifest, each target's Ninja is fingerprinted so targets whose
+     * inputs have not changed can reuse what was generated for them last time.
+     */
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, std::string> targetFingerprints;
+    std::unordered_map<std::string, std::string> fileHashes;
+
+    /*
+     * The targets are ordered so that dependency fingerprints are available; Ninja itself
+     * does the ordering of the build.
+     */
+    ext::optional<std::vector<pbxproj::PBX::Target::shared_ptr>> orderedTargets = targetGraph.ordered();
+    if (!orderedTargets) {
+        fprintf(stderr, "error: cycle detected in target dependencies\n");
+        return false;
+    }
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &targets = *orderedTargets;
+
+    /*
+     * If nothing a target's Ninja depends on has changed, reuse it without resolving
+     * the target or generating its invocations again.
+     */
+    std::vector<std::string> fingerprints = std::vector<std::string>(targets.size());
+    std::vector<std::string> fingerprintPaths = std::vector<std::string>(targets.size());
+    std::vector<ext::optional<std::string>> cachedSections = std::vector<ext::optional<std::string>>(targets.size());
+    std::vector<pbxproj::PBX::Target::shared_ptr> pendingTargets;
+    std::vector<size_t> pendingIndexes;
+    if (!_singleManifest) {
+        std::string buildFingerprint = BuildNinjaFingerprint(filesystem, buildParameters, processContext->executablePath(), buildEnvironment);
+
+        for (size_t i = 0; i < targets.size(); i++) {
+            pbxproj::PBX::Target::shared_ptr const &target = targets[i];
+
+            std::vector<std::string> dependencyFingerprints;
+            for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
+                auto it = targetFingerprints.find(dependency);
+                if (it != targetFingerprints.end()) {
+                    dependencyFingerprints.push_back(it->second);
+                }
+            }
+            std::sort(dependencyFingerprints.begin(), dependencyFingerprints.end());
+
+            fingerprints[i] = TargetNinjaFingerprint(filesystem, &fileHashes, buildFingerprint, buildContext.workspaceContext(), target, dependencyFingerprints);
+            targetFingerprints.insert({ target, fingerprints[i] });
+
+            fingerprintPaths[i] = TargetNinjaFingerprintPath(intermediatesDirectory, buildParameters, target);
+            cachedSections[i] = LoadTargetNinjaFingerprint(filesystem, fingerprintPaths[i], fingerprints[i]);
+            if (!cachedSections[i]) {
+                pendingTargets.push_back(target);
+                pendingIndexes.push_back(i);
+            }
+        }
+    } else {
+        pendingTargets = targets;
+        for (size_t i = 0; i < targets.size(); i++) {
+            pendingIndexes.push_back(i);
+        }
+    }
+
+    /*
+     * Resolve the targets that need generating and create their invocations. This only
+     * reads the workspace and specifications, so targets are resolved in parallel.
+     */
+    std::vector<ext::optional<pbxbuild::Target::Environment>> targetEnvironments = std::vector<ext::optional<pbxbuild::Target::Environment>>(targets.size());
+    std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>> targetPhaseInvocations = std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>>(targets.size());
+    if (!pendingTargets.empty()) {
+        libutil::ThreadPool planningPool(libutil::ThreadPool::DefaultSize());
+        std::vector<ext::optional<pbxbuild::Target::Environment>> pendingEnvironments = CreateTargetEnvironments(&planningPool, buildEnvironment, buildContext, pendingTargets);
+        std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>> pendingInvocations = CreatePhaseInvocations(&planningPool, buildEnvironment, buildContext, pendingTargets, pendingEnvironments);
+        for (size_t k = 0; k < pendingIndexes.size(); k++) {
+            targetEnvironments[pendingIndexes[k]] = std::move(pendingEnvironments[k]);
+            targetPhaseInvocations[pendingIndexes[k]] = std::move(pendingInvocations[k]);
+        }
+    }
+
     /*
      * Go over each target and write out Ninja targets for the start and end of each.
-     * Don't bother topologically sorting the targets now, since Ninja will do that for us.
+     * This is in target order, so the output doesn't depend on the planning above.
      */
-    for (pbxproj::PBX::Target::shared_ptr const &target : targetGraph.nodes()) {
+    for (size_t i = 0; i < targets.size(); i++) {
+        pbxproj::PBX::Target::shared_ptr const &target = targets[i];
 
         /*
          * Beginning target depends on finishing the targets before that. This is implemented
@@ -581,24 +877,42 @@ buildAction(
          * previous targets.
          */
 
-        /*
-         * Resolve this target and generate its invocations.
-         */
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+        if (cachedSections[i]) {
+            writer.append(*cachedSections[i]);
+            continue;
+        }
+
+        ext::optional<pbxbuild::Target::Environment> const &targetEnvironment = targetEnvironments[i];
         if (!targetEnvironment) {
             fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
             continue;
         }
 
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+        std::string targetPath = TargetNinjaPath(target, *targetEnvironment);
+        pbxbuild::Phase::PhaseInvocations const &phaseInvocations = *targetPhaseInvocations[i];
+
+        /*
+         * Files generated with the target's Ninja that its build can't recreate.
+         */
+        std::vector<std::string> generatedPaths;
+
+        /*
+         * The target's section of the top-level Ninja file. This is kept separately so
+         * it can be stored with the fingerprint and reused by later generations.
+         */
+        ninja::Writer targetSection;
 
         /*
          * As described above, the target's begin depends on all of the target dependencies.
          */
-        std::vector<ninja::Value> dependenciesFinished;
+        std::vector<std::string> dependencyNames;
         for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(target)) {
-            std::string targetFinished = TargetNinjaFinish(dependency);
+            dependencyNames.push_back(TargetNinjaFinish(dependency));
+        }
+        std::sort(dependencyNames.begin(), dependencyNames.end());
+
+        std::vector<ninja::Value> dependenciesFinished;
+        for (std::string const &targetFinished : dependencyNames) {
             dependenciesFinished.push_back(ninja::Value::String(targetFinished));
         }
 
@@ -606,7 +920,7 @@ buildAction(
          * Add the phony target for beginning this target's build.
          */
         std::string targetBegin = TargetNinjaBegin(target);
-        writer.build({ ninja::Value::String(targetBegin) }, "phony", dependenciesFinished);
+        targetSection.build({ ninja::Value::String(targetBegin) }, "phony", dependenciesFinished);
 
         /*
          * Add the phony target for the checkpoint after writing auxiliary files.
@@ -616,21 +930,49 @@ buildAction(
         for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : phaseInvocations.auxiliaryFiles()) {
             auxiliaryFileOutputs.push_back(ninja::Value::String(auxiliaryFile.path()));
         }
-        writer.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
+        targetSection.build({ ninja::Value::String(targetWriteAuxiliaryFiles) }, "phony", auxiliaryFileOutputs);
 
-        /*
-         * Write out the Ninja file to build this target.
-         */
-        if (!buildTargetInvocations(processContext, filesystem, dependencyInfoToolPath, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), phaseInvocations.invocations())) {
-            fprintf(stderr, "error: failed to build target ninja\n");
-            return false;
-        }
+        if (_singleManifest) {
+            /*
+             * Write this target's invocations directly into the top-level Ninja file.
+             */
+            targetSection.newline();
+            targetSection.comment("Target: " + target->name());
+            if (!buildTargetInvocations(processContext, filesystem, &targetSection, &toolRules, dependencyInfoToolPath, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), phaseInvocations.invocations(), &generatedPaths)) {
+                fprintf(stderr, "error: failed to build target ninja\n");
+                return false;
+            }
+        } else {
+            /*
+             * Start building the Ninja file for this target.
+             */
+            ninja::Writer targetWriter;
+            targetWriter.comment("xcbuild ninja");
+            targetWriter.comment("Target: " + target->name());
+            targetWriter.newline();
 
-        /*
-         * Load the Ninja file generated for this target.
-         */
-        std::string targetPath = TargetNinjaPath(target, *targetEnvironment);
-        writer.subninja(ninja::Value::String(targetPath));
+            /*
+             * Write out the Ninja file to build this target.
+             */
+            if (!buildTargetInvocations(processContext, filesystem, &targetWriter, nullptr, dependencyInfoToolPath, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), phaseInvocations.invocations(), &generatedPaths)) {
+                fprintf(stderr, "error: failed to build target ninja\n");
+                return false;
+            }
+
+            /*
+             * Serialize the Ninja file into the target's temporary directory.
+             */
+            if (!WriteNinjaIfChanged(filesystem, targetWriter, targetPath)) {
+                fprintf(stderr, "error: unable to write target ninja: %s\n", targetPath.c_str());
+                return false;
+            }
+
+            /*
+             * Load the Ninja file generated for this target.
+             */
+            targetSection.subninja(ninja::Value::String(targetPath));
+            generatedPaths.push_back(targetPath);
+        }
 
         /*
          * As described above, the target's finish depends on all of the invocation outputs.
@@ -655,7 +997,7 @@ buildAction(
         for (pbxbuild::Tool::Invocation const &invocation : phaseInvocations.invocations()) {
             for (std::string const &phonyInput : invocation.phonyInputs()) {
                 if (invocationOutputs.find(phonyInput) == invocationOutputs.end()) {
-                    writer.build({ ninja::Value::String(phonyInput) }, "phony", { });
+                    targetSection.build({ ninja::Value::String(phonyInput) }, "phony", { });
                 }
             }
         }
@@ -668,7 +1010,27 @@ buildAction(
             maxInvocationPriority = std::max(maxInvocationPriority, invocation.priority());
         }
         std::string targetFinish = TargetNinjaFinish(target);
-        writer.build({ ninja::Value::String(targetFinish) }, "phony", { ninja::Value::String(TargetPhaseNinjaFinish(target, maxInvocationPriority)) });
+        targetSection.build({ ninja::Value::String(targetFinish) }, "phony", { ninja::Value::String(TargetPhaseNinjaFinish(target, maxInvocationPriority)) });
+
+        std::string section = targetSection.serialize();
+        writer.append(section);
+
+        /*
+         * Record the fingerprint along with the target's section, for the next generation.
+         */
+        if (!_singleManifest) {
+            std::string fingerprintContents = fingerprints[i] + "\n";
+            for (std::string const &generatedPath : generatedPaths) {
+                fingerprintContents += generatedPath + "\n";
+            }
+            fingerprintContents += "\n" + section;
+
+            if (!filesystem->createDirectory(FSUtil::GetDirectoryName(fingerprintPaths[i]), true) ||
+                !filesystem->write(std::vector<uint8_t>(fingerprintContents.begin(), fingerprintContents.end()), fingerprintPaths[i])) {
+                fprintf(stderr, "error: unable to write target ninja fingerprint: %s\n", fingerprintPaths[i].c_str());
+                return false;
+            }
+        }
     }
 
     /*
@@ -686,7 +1048,8 @@ buildAction(
         processContext->currentDirectory(),
         ninjaPath,
         configurationHashPath,
-        inputPaths);
+        inputPaths,
+        _singleManifest);
 
     /*
      * Serialize the Ninja file into the build root.
@@ -708,20 +1071,15 @@ bool NinjaExecutor::
 buildTargetInvocations(
     process::Context const *processContext,
     Filesystem *filesystem,
+    ninja::Writer *writer,
+    std::unordered_map<std::string, std::string> *toolRules,
     std::string const &dependencyInfoToolPath,
     pbxproj::PBX::Target::shared_ptr const &target,
     pbxbuild::Target::Environment const &targetEnvironment,
     std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
-    std::vector<pbxbuild::Tool::Invocation> const &invocations)
+    std::vector<pbxbuild::Tool::Invocation> const &invocations,
+    std::vector<std::string> *generatedPaths)
 {
-    /*
-     * Start building the Ninja file for this target.
-     */
-    ninja::Writer writer;
-    writer.comment("xcbuild ninja");
-    writer.comment("Target: " + target->name());
-    writer.newline();
-
     std::string targetBegin = TargetNinjaBegin(target);
     std::string targetWriteAuxiliaryFiles = TargetNinjaWriteAuxiliaryFiles(target);
 
@@ -733,7 +1091,7 @@ buildTargetInvocations(
      */
     std::map<std::string, pbxbuild::Tool::AuxiliaryFile::Chunk const *> auxiliaryFileChunks;
     for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : auxiliaryFiles) {
-        if (!buildAuxiliaryFile(&writer, auxiliaryFile, targetBegin, temporaryDirectory, auxiliaryFileChunks)) {
+        if (!buildAuxiliaryFile(writer, auxiliaryFile, targetBegin, temporaryDirectory, auxiliaryFileChunks)) {
             return false;
         }
     }
@@ -756,7 +1114,7 @@ buildTargetInvocations(
     for (auto const &priorityMappedOutputs : priorityToOutputs) {
         // begin phase phony target.
         ninja::Value targetPhaseBegin = ninja::Value::String(TargetPhaseNinjaBegin(target, priorityMappedOutputs.first));
-        writer.build({ targetPhaseBegin }, "phony", { previousPhase });
+        writer->build({ targetPhaseBegin }, "phony", { previousPhase });
 
         // finish phase phony target.
         ninja::Value targetPhaseFinish = ninja::Value::String(TargetPhaseNinjaFinish(target, priorityMappedOutputs.first));
@@ -768,7 +1126,7 @@ buildTargetInvocations(
         for (std::string const &output: priorityMappedOutputs.second) {
             phaseFinishDependency.push_back(ninja::Value::String(output));
         }
-        writer.build({ targetPhaseFinish }, "phony", phaseFinishDependency);
+        writer->build({ targetPhaseFinish }, "phony", phaseFinishDependency);
 
         // update previous phase so that next phase can depend upon it.
         previousPhase = targetPhaseFinish;
@@ -789,25 +1147,21 @@ buildTargetInvocations(
             }
 
             /* Write invocations to run after auxiliary files. */
-            if (!buildInvocation(&writer, invocation, *executablePath, dependencyInfoToolPath, temporaryDirectory, TargetPhaseNinjaBegin(target, invocation.priority()))) {
+            if (!buildInvocation(writer, toolRules, invocation, *executablePath, dependencyInfoToolPath, temporaryDirectory, TargetPhaseNinjaBegin(target, invocation.priority()))) {
                 return false;
             }
         }
     }
 
-    /*
-     * Serialize the Ninja file into the build root.
-     */
-    std::string path = TargetNinjaPath(target, targetEnvironment);
-    if (!WriteNinja(filesystem, writer, path)) {
-        fprintf(stderr, "error: unable to write target ninja: %s\n", path.c_str());
-        return false;
-    }
     if (!WriteAuxiliaryFiles(filesystem, auxiliaryFileChunks)) {
         fprintf(stderr, "error: unable to write auxiliary files\n");
         return false;
     }
 
+    for (auto const &entry : auxiliaryFileChunks) {
+        generatedPaths->push_back(entry.first);
+    }
+
     return true;
 }
 
@@ -876,6 +1230,7 @@ buildAuxiliaryFile(
 bool NinjaExecutor::
 buildInvocation(
     ninja::Writer *writer,
+    std::unordered_map<std::string, std::string> *toolRules,
     pbxbuild::Tool::Invocation const &invocation,
     std::string const &executablePath,
     std::string const &dependencyInfoToolPath,
@@ -886,9 +1241,27 @@ buildInvocation(
      * Build the invocation arguments. Must escape for shell arguments as Ninja passes
      * the command string directly to the shell, which would interpret spaces, etc as meaningful.
      */
-    std::string exec = Escape::Shell(executablePath);
+    std::string arguments;
     for (std::string const &arg : invocation.arguments()) {
-        exec += " " + Escape::Shell(arg);
+        arguments += " " + Escape::Shell(arg);
+    }
+
+    /*
+     * Find the rule to run the invocation with. With a rule per tool, the executable is part
+     * of the rule and only the arguments are bound; otherwise, bind the whole command.
+     */
+    std::string ruleName = NinjaRuleName();
+    std::string exec = Escape::Shell(executablePath) + arguments;
+    if (toolRules != nullptr) {
+        auto it = toolRules->find(executablePath);
+        if (it == toolRules->end()) {
+            std::string toolRuleName = NinjaToolRuleName(executablePath, *toolRules);
+            ninja::Value command = ninja::Value::Expression("cd $dir && env $env ") + ninja::Value::String(Escape::Shell(executablePath)) + ninja::Value::Expression("$args && $depexec");
+            writer->rule(toolRuleName, command);
+            it = toolRules->insert({ executablePath, toolRuleName }).first;
+        }
+
+        ruleName = it->second;
     }
 
     /*
@@ -955,8 +1328,12 @@ buildInvocation(
     std::vector<ninja::Binding> bindings = {
         { "description", ninja::Value::String(description) },
         { "dir", ninja::Value::String(Escape::Shell(invocation.workingDirectory())) },
-        { "exec", ninja::Value::String(exec) },
     };
+    if (toolRules != nullptr) {
+        bindings.push_back({ "args", ninja::Value::String(arguments) });
+    } else {
+        bindings.push_back({ "exec", ninja::Value::String(exec) });
+    }
     if (!environment.empty()) {
         bindings.push_back({ "env", ninja::Value::String(environment) });
     }
@@ -1007,17 +1384,18 @@ buildInvocation(
     /*
      * Add the rule to build this invocation.
      */
-    writer->build(outputs, NinjaRuleName(), inputs, bindings, inputDependencies, orderDependencies);
+    writer->build(outputs, ruleName, inputs, bindings, inputDependencies, orderDependencies);
 
     return true;
 }
 
 std::unique_ptr<NinjaExecutor> NinjaExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, bool generate, bool singleManifest)
 {
     return std::unique_ptr<NinjaExecutor>(new NinjaExecutor(
         formatter,
         dryRun,
-        generate
+        generate,
+        singleManifest
     ));
 }
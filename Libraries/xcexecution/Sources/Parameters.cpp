@@ -9,6 +9,7 @@
 #include <xcexecution/Parameters.h>
 
 #include <pbxbuild/Build/DependencyResolver.h>
+#include <pbxproj/ProjectCache.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
 #include <libutil/md5.h>
@@ -29,15 +30,17 @@ Parameters(
     bool allTargets,
     std::vector<std::string> const &actions,
     ext::optional<std::string> const &configuration,
-    std::vector<pbxsetting::Level> const &overrideLevels) :
-    _workspace     (workspace),
-    _project       (project),
-    _scheme        (scheme),
-    _target        (target),
-    _allTargets    (allTargets),
-    _actions       (actions),
-    _configuration (configuration),
-    _overrideLevels(overrideLevels)
+    std::vector<pbxsetting::Level> const &overrideLevels,
+    ext::optional<std::string> const &projectCachePath) :
+    _workspace       (workspace),
+    _project         (project),
+    _scheme          (scheme),
+    _target          (target),
+    _allTargets      (allTargets),
+    _actions         (actions),
+    _configuration   (configuration),
+    _overrideLevels  (overrideLevels),
+    _projectCachePath(projectCachePath)
 {
 }
 
@@ -77,6 +80,11 @@ canonicalArguments() const
         arguments.push_back(*_configuration);
     }
 
+    if (_projectCachePath) {
+        arguments.push_back("-projectCache");
+        arguments.push_back(*_projectCachePath);
+    }
+
     for (std::string const &action : _actions) {
         arguments.push_back(action);
     }
@@ -114,10 +122,10 @@ canonicalHash() const
 }
 
 static pbxproj::PBX::Project::shared_ptr
-OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &projectPath, std::string const &directory)
+OpenProject(Filesystem const *filesystem, pbxproj::ProjectCache *projectCache, ext::optional<std::string> const &projectPath, std::string const &directory)
 {
     if (projectPath) {
-        return pbxproj::PBX::Project::Open(filesystem, *projectPath);
+        return pbxproj::PBX::Project::Open(filesystem, *projectPath, projectCache);
     } else {
         bool multiple = false;
         std::string projectName;
@@ -141,7 +149,7 @@ OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &proj
             fprintf(stderr, "error: no project found\n");
             return nullptr;
         } else {
-            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, directory + "/" + projectName);
+            pbxproj::PBX::Project::shared_ptr project = pbxproj::PBX::Project::Open(filesystem, directory + "/" + projectName, projectCache);
             if (project == nullptr) {
                 fprintf(stderr, "error: unable to open project '%s'\n", projectName.c_str());
             }
@@ -151,8 +159,13 @@ OpenProject(Filesystem const *filesystem, ext::optional<std::string> const &proj
 }
 
 ext::optional<pbxbuild::WorkspaceContext> Parameters::
-loadWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuild::Build::Environment const &buildEnvironment, std::string const &workingDirectory) const
+loadWorkspace(Filesystem *filesystem, std::string const &userName, pbxbuild::Build::Environment const &buildEnvironment, std::string const &workingDirectory) const
 {
+    ext::optional<pbxproj::ProjectCache> projectCache;
+    if (_projectCachePath) {
+        projectCache = pbxproj::ProjectCache(filesystem, FSUtil::ResolveRelativePath(*_projectCachePath, workingDirectory));
+    }
+
     if (_workspace) {
         xcworkspace::XC::Workspace::shared_ptr workspace = xcworkspace::XC::Workspace::Open(filesystem, *_workspace);
         if (workspace == nullptr) {
@@ -160,14 +173,14 @@ loadWorkspace(Filesystem const *filesystem, std::string const &userName, pbxbuil
             return ext::nullopt;
         }
 
-        return pbxbuild::WorkspaceContext::Workspace(filesystem, userName, buildEnvironment.baseEnvironment(), workspace);
+        return pbxbuild::WorkspaceContext::Workspace(filesystem, projectCache ? &*projectCache : nullptr, userName, buildEnvironment.baseEnvironment(), workspace);
     } else {
-        pbxproj::PBX::Project::shared_ptr project = OpenProject(filesystem, _project, workingDirectory);
+        pbxproj::PBX::Project::shared_ptr project = OpenProject(filesystem, projectCache ? &*projectCache : nullptr, _project, workingDirectory);
         if (project == nullptr) {
             return ext::nullopt;
         }
 
-        return pbxbuild::WorkspaceContext::Project(filesystem, userName, buildEnvironment.baseEnvironment(), project);
+        return pbxbuild::WorkspaceContext::Project(filesystem, projectCache ? &*projectCache : nullptr, userName, buildEnvironment.baseEnvironment(), project);
     }
 }
 
@@ -14,6 +14,7 @@
 #include <pbxbuild/Phase/PhaseInvocations.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/ThreadPool.h>
 #include <process/Context.h>
 #include <process/MemoryContext.h>
 #include <process/Launcher.h>
@@ -22,7 +23,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <condition_variable>
+#include <mutex>
 #include <set>
+#include <thread>
 
 using xcexecution::SimpleExecutor;
 using xcexecution::Parameters;
@@ -31,10 +35,16 @@ using libutil::FSUtil;
 using libutil::Permissions;
 
 SimpleExecutor::
-SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins) :
-    Executor (formatter, dryRun, false),
-    _builtins(builtins)
+SimpleExecutor(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets) :
+    Executor           (formatter, dryRun, false),
+    _builtins          (builtins),
+    _jobs              (jobs == 0 ? 1 : jobs),
+    _parallelizeTargets(parallelizeTargets),
+    _cancelled         (false)
 {
+    if (_jobs > 1) {
+        _pool = std::unique_ptr<libutil::ThreadPool>(new libutil::ThreadPool(_jobs));
+    }
 }
 
 SimpleExecutor::
@@ -42,6 +52,29 @@ SimpleExecutor::
 {
 }
 
+/*
+ * Creates the environment and invocations of a target. Resolving inputs can
+ * look at the filesystem, such as for search paths and header maps, so this
+ * waits until the targets it depends on are built; targets not depending on
+ * each other can be planned at the same time.
+ */
+static void
+PlanTarget(
+    pbxbuild::Build::Environment const &buildEnvironment,
+    pbxbuild::Build::Context const &buildContext,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    ext::optional<pbxbuild::Target::Environment> *targetEnvironment,
+    ext::optional<pbxbuild::Phase::PhaseInvocations> *phaseInvocations)
+{
+    *targetEnvironment = buildContext.targetEnvironment(buildEnvironment, target);
+    if (!*targetEnvironment) {
+        return;
+    }
+
+    pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, buildContext, target, **targetEnvironment);
+    *phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
+}
+
 bool SimpleExecutor::
 build(
     process::User const *user,
@@ -61,7 +94,7 @@ build(
         return false;
     }
 
-    xcformatter::Formatter::Print(_formatter->begin(*buildContext));
+    print([&] { return _formatter->begin(*buildContext); });
 
     ext::optional<pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>> targetGraph = buildParameters.resolveDependencies(buildEnvironment, *buildContext);
     if (!targetGraph) {
@@ -74,37 +107,232 @@ build(
         return false;
     }
 
-    for (pbxproj::PBX::Target::shared_ptr const &target : *orderedTargets) {
-        xcformatter::Formatter::Print(_formatter->beginTarget(*buildContext, target));
+    if (_parallelizeTargets && _pool != nullptr && !_dryRun) {
+        std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> result = buildTargetsInParallel(*targetGraph, *orderedTargets, [&](pbxproj::PBX::Target::shared_ptr const &target) {
+            ext::optional<pbxbuild::Target::Environment> targetEnvironment;
+            ext::optional<pbxbuild::Phase::PhaseInvocations> phaseInvocations;
+            PlanTarget(buildEnvironment, *buildContext, target, &targetEnvironment, &phaseInvocations);
 
-        ext::optional<pbxbuild::Target::Environment> targetEnvironment = buildContext->targetEnvironment(buildEnvironment, target);
-        if (!targetEnvironment) {
-            fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+            return buildTargetInContext(processContext, processLauncher, filesystem, *buildContext, target, targetEnvironment, phaseInvocations);
+        });
+        if (!result.first) {
+            print([&] { return _formatter->failure(*buildContext, result.second); });
             return false;
         }
+    } else {
+        std::vector<ext::optional<pbxbuild::Target::Environment>> targetEnvironments = std::vector<ext::optional<pbxbuild::Target::Environment>>(orderedTargets->size());
+        std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>> phaseInvocations = std::vector<ext::optional<pbxbuild::Phase::PhaseInvocations>>(orderedTargets->size());
+        libutil::ThreadPool planningPool(libutil::ThreadPool::DefaultSize());
+
+        std::vector<std::vector<size_t>> waves = PlanningWaves(*targetGraph, *orderedTargets);
+        auto wave = waves.begin();
+
+        for (size_t i = 0; i < orderedTargets->size(); i++) {
+            if (wave != waves.end() && wave->front() == i) {
+                /*
+                 * Plan every target whose dependencies are now built, this one
+                 * among them, in parallel. The job limit is for invocations, and
+                 * doesn't apply here.
+                 */
+                std::vector<size_t> const &plannable = *wave;
+                planningPool.apply(plannable.size(), [&](size_t k) {
+                    size_t j = plannable[k];
+                    PlanTarget(buildEnvironment, *buildContext, (*orderedTargets)[j], &targetEnvironments[j], &phaseInvocations[j]);
+                });
+                ++wave;
+            }
 
-        xcformatter::Formatter::Print(_formatter->beginCheckDependencies(target));
-        pbxbuild::Phase::Environment phaseEnvironment = pbxbuild::Phase::Environment(buildEnvironment, *buildContext, target, *targetEnvironment);
-        pbxbuild::Phase::PhaseInvocations phaseInvocations = pbxbuild::Phase::PhaseInvocations::Create(phaseEnvironment, target);
-        xcformatter::Formatter::Print(_formatter->finishCheckDependencies(target));
+            std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> result = buildTargetInContext(processContext, processLauncher, filesystem, *buildContext, (*orderedTargets)[i], targetEnvironments[i], phaseInvocations[i]);
+            if (!result.first) {
+                print([&] { return _formatter->failure(*buildContext, result.second); });
+                return false;
+            }
+        }
+    }
 
-        auto result = buildTarget(processContext, processLauncher, filesystem, target, *targetEnvironment, phaseInvocations.auxiliaryFiles(), phaseInvocations.invocations());
-        if (!result.first) {
-            xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
-            xcformatter::Formatter::Print(_formatter->failure(*buildContext, result.second));
-            return false;
+    print([&] { return _formatter->success(*buildContext); });
+    return true;
+}
+
+std::vector<std::vector<size_t>> SimpleExecutor::
+PlanningWaves(
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets)
+{
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> indexes;
+    for (size_t i = 0; i < orderedTargets.size(); i++) {
+        indexes.insert({ orderedTargets[i], i });
+    }
+
+    std::vector<std::vector<size_t>> waves;
+    std::vector<bool> planned = std::vector<bool>(orderedTargets.size(), false);
+
+    for (size_t i = 0; i < orderedTargets.size(); i++) {
+        if (planned[i]) {
+            continue;
+        }
+
+        /*
+         * Before building target i, everything before it is built. Any target
+         * depending on nothing from i on can be planned now, in build order.
+         */
+        std::vector<size_t> wave;
+        for (size_t j = i; j < orderedTargets.size(); j++) {
+            bool built = true;
+            for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(orderedTargets[j])) {
+                if (indexes.at(dependency) >= i && dependency != orderedTargets[j]) {
+                    built = false;
+                    break;
+                }
+            }
+
+            if (!planned[j] && built) {
+                wave.push_back(j);
+                planned[j] = true;
+            }
         }
 
-        xcformatter::Formatter::Print(_formatter->finishTarget(*buildContext, target));
+        waves.push_back(wave);
     }
 
-    xcformatter::Formatter::Print(_formatter->success(*buildContext));
-    return true;
+    return waves;
 }
 
-static ext::optional<std::vector<pbxbuild::Tool::Invocation>>
-SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+buildTargetInContext(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    pbxbuild::Build::Context const &buildContext,
+    pbxproj::PBX::Target::shared_ptr const &target,
+    ext::optional<pbxbuild::Target::Environment> const &targetEnvironment,
+    ext::optional<pbxbuild::Phase::PhaseInvocations> const &phaseInvocations)
+{
+    print([&] { return _formatter->beginTarget(buildContext, target); });
+
+    if (!targetEnvironment || !phaseInvocations) {
+        fprintf(stderr, "error: couldn't create target environment for %s\n", target->name().c_str());
+        print([&] { return _formatter->finishTarget(buildContext, target); });
+        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+    }
+
+    /* The invocations were created once the target's dependencies were built. */
+    print([&] { return _formatter->beginCheckDependencies(target); });
+    print([&] { return _formatter->finishCheckDependencies(target); });
+
+    std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> result = buildTarget(processContext, processLauncher, filesystem, target, *targetEnvironment, phaseInvocations->auxiliaryFiles(), phaseInvocations->invocations());
+    print([&] { return _formatter->finishTarget(buildContext, target); });
+    return result;
+}
+
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+buildTargetsInParallel(
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &targetGraph,
+    std::vector<pbxproj::PBX::Target::shared_ptr> const &orderedTargets,
+    std::function<std::pair<bool, std::vector<pbxbuild::Tool::Invocation>>(pbxproj::PBX::Target::shared_ptr const &)> const &targetBuilder)
+{
+    /*
+     * Count the unfinished dependencies of each target, and the reverse
+     * edges to follow when a target finishes. Ready targets start in the
+     * order a serial build would build them.
+     */
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, size_t> indexes;
+    for (size_t i = 0; i < orderedTargets.size(); i++) {
+        indexes.insert({ orderedTargets[i], i });
+    }
+
+    std::vector<size_t> waiting = std::vector<size_t>(orderedTargets.size(), 0);
+    std::vector<std::vector<size_t>> dependents = std::vector<std::vector<size_t>>(orderedTargets.size());
+    for (size_t i = 0; i < orderedTargets.size(); i++) {
+        for (pbxproj::PBX::Target::shared_ptr const &dependency : targetGraph.adjacent(orderedTargets[i])) {
+            size_t j = indexes.at(dependency);
+            if (j != i) {
+                waiting[i]++;
+                dependents[j].push_back(i);
+            }
+        }
+    }
+
+    std::set<size_t> ready;
+    for (size_t i = 0; i < orderedTargets.size(); i++) {
+        if (waiting[i] == 0) {
+            ready.insert(i);
+        }
+    }
+
+    /*
+     * Each running target is planned and driven from its own thread, once
+     * the targets it depends on are built, but its invocations run on the
+     * shared pool: the job limit covers all targets together. The number of
+     * targets in progress at once is held to the same limit.
+     */
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::pair<size_t, std::pair<bool, std::vector<pbxbuild::Tool::Invocation>>>> completed;
+    std::vector<std::thread> threads;
+
+    size_t running = 0;
+    ext::optional<std::pair<bool, std::vector<pbxbuild::Tool::Invocation>>> failure;
+
+    while (true) {
+        while (!failure && !ready.empty() && running < _jobs) {
+            size_t i = *ready.begin();
+            ready.erase(ready.begin());
+
+            running++;
+            pbxproj::PBX::Target::shared_ptr const &target = orderedTargets[i];
+            threads.emplace_back([i, &target, &targetBuilder, &mutex, &condition, &completed] {
+                std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> result = targetBuilder(target);
+
+                std::unique_lock<std::mutex> lock(mutex);
+                completed.push_back({ i, result });
+                condition.notify_one();
+            });
+        }
+
+        if (running == 0) {
+            break;
+        }
+
+        /* Wait for at least one running target to finish. */
+        std::vector<std::pair<size_t, std::pair<bool, std::vector<pbxbuild::Tool::Invocation>>>> results;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&completed] { return !completed.empty(); });
+            results.swap(completed);
+        }
+
+        for (auto const &result : results) {
+            running--;
+
+            if (result.second.first) {
+                for (size_t j : dependents[result.first]) {
+                    if (--waiting[j] == 0) {
+                        ready.insert(j);
+                    }
+                }
+            } else if (!failure) {
+                /* Stop other targets from starting more invocations. */
+                failure = result.second;
+                _cancelled = true;
+            }
+        }
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    _cancelled = false;
+
+    if (failure) {
+        return *failure;
+    }
+
+    return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
+}
+
+static pbxbuild::DirectedGraph<pbxbuild::Tool::Invocation const *>
+CreateInvocationGraph(std::vector<pbxbuild::Tool::Invocation> const &invocations)
 {
     std::unordered_map<std::string, pbxbuild::Tool::Invocation const *> outputToInvocation;
     std::set<uint32_t, std::less<uint32_t>> orderedPhasePriorities;
@@ -149,6 +377,14 @@ SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
         }
     }
 
+    return graph;
+}
+
+static ext::optional<std::vector<pbxbuild::Tool::Invocation>>
+SortInvocations(std::vector<pbxbuild::Tool::Invocation> const &invocations)
+{
+    pbxbuild::DirectedGraph<pbxbuild::Tool::Invocation const *> graph = CreateInvocationGraph(invocations);
+
     std::vector<pbxbuild::Tool::Invocation> result;
 
     ext::optional<std::vector<pbxbuild::Tool::Invocation const *>> orderedInvocations = graph.ordered();
@@ -170,7 +406,7 @@ writeAuxiliaryFiles(
     for (pbxbuild::Tool::AuxiliaryFile const &auxiliaryFile : auxiliaryFiles) {
         std::string directory = FSUtil::GetDirectoryName(auxiliaryFile.path());
         if (filesystem->type(directory) != Filesystem::Type::Directory) {
-            xcformatter::Formatter::Print(_formatter->createAuxiliaryDirectory(directory));
+            print([&] { return _formatter->createAuxiliaryDirectory(directory); });
 
             if (!_dryRun) {
                 if (!filesystem->createDirectory(directory, true)) {
@@ -179,7 +415,7 @@ writeAuxiliaryFiles(
             }
         }
 
-        xcformatter::Formatter::Print(_formatter->writeAuxiliaryFile(auxiliaryFile.path()));
+        print([&] { return _formatter->writeAuxiliaryFile(auxiliaryFile.path()); });
 
         if (!_dryRun) {
             std::vector<uint8_t> data;
@@ -208,7 +444,7 @@ writeAuxiliaryFiles(
         }
 
         if (auxiliaryFile.executable() && !filesystem->isExecutable(auxiliaryFile.path())) {
-            xcformatter::Formatter::Print(_formatter->setAuxiliaryExecutable(auxiliaryFile.path()));
+            print([&] { return _formatter->setAuxiliaryExecutable(auxiliaryFile.path()); });
 
             if (!_dryRun) {
                 Permissions permissions = Permissions(
@@ -225,6 +461,72 @@ writeAuxiliaryFiles(
     return true;
 }
 
+/*
+ * Resolves the tool for an invocation. On success, returns the name shown
+ * by the formatter and a function that runs the tool and reports success.
+ * The function does not touch the formatter, so can run on any thread.
+ */
+static ext::optional<std::pair<std::string, std::function<bool()>>>
+ResolveInvocation(
+    builtin::Registry &builtins,
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    std::vector<std::string> const &executablePaths,
+    pbxbuild::Tool::Invocation const &invocation)
+{
+    pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
+
+    if (ext::optional<std::string> const &builtin = executable.builtin()) {
+        /* Builtin tool, find and run in-process. */
+        std::shared_ptr<builtin::Driver> driver = builtins.driver(*builtin);
+        if (driver == nullptr) {
+            return ext::nullopt;
+        }
+
+        std::string name = *builtin;
+        return std::make_pair(name, std::function<bool()>([driver, name, filesystem, &invocation]() -> bool {
+            process::MemoryContext context = process::MemoryContext(
+                name,
+                invocation.workingDirectory(),
+                invocation.arguments(),
+                invocation.environment());
+            return (driver->run(&context, filesystem) == 0);
+        }));
+    } else if (ext::optional<std::string> const &external = executable.external()) {
+        /* External tool, find on the filesystem. */
+        ext::optional<std::string> path;
+        if (FSUtil::IsAbsolutePath(*external)) {
+            if (filesystem->isExecutable(*external)) {
+                path = external;
+            }
+        } else {
+            path = filesystem->findExecutable(*external, executablePaths);
+        }
+
+        if (!path) {
+            return ext::nullopt;
+        }
+
+        std::string name = *path;
+        return std::make_pair(name, std::function<bool()>([processContext, processLauncher, name, filesystem, &invocation]() -> bool {
+            /* Create the execution environment from the process and invocation environments, preferring the invocation. */
+            std::unordered_map<std::string, std::string> environment = invocation.environment();
+            environment.insert(processContext->environmentVariables().begin(), processContext->environmentVariables().end());
+
+            process::MemoryContext context = process::MemoryContext(
+                name,
+                invocation.workingDirectory(),
+                invocation.arguments(),
+                environment);
+            ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
+            return (exitCode && *exitCode == 0);
+        }));
+    } else {
+        abort();
+    }
+}
+
 std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
 performInvocations(
     process::Context const *processContext,
@@ -233,21 +535,34 @@ performInvocations(
     std::vector<std::string> const &executablePaths,
     std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
     bool createProductStructure)
+{
+    if (_pool != nullptr && !_dryRun) {
+        return performInvocationsInParallel(processContext, processLauncher, filesystem, executablePaths, orderedInvocations, createProductStructure);
+    } else {
+        return performInvocationsSerially(processContext, processLauncher, filesystem, executablePaths, orderedInvocations, createProductStructure);
+    }
+}
+
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+performInvocationsSerially(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    std::vector<std::string> const &executablePaths,
+    std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
+    bool createProductStructure)
 {
     for (pbxbuild::Tool::Invocation const &invocation : orderedInvocations) {
         // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
         if (!invocation.executable()) {
             continue;
         }
-        pbxbuild::Tool::Invocation::Executable const &executable = *invocation.executable();
 
         if (invocation.createsProductStructure() != createProductStructure) {
             continue;
         }
 
         if (!_dryRun) {
-            bool success = true;
-
             for (std::string const &output : invocation.outputs()) {
                 std::string directory = FSUtil::GetDirectoryName(output);
 
@@ -256,63 +571,173 @@ performInvocations(
                 }
             }
 
-            if (ext::optional<std::string> const &builtin = executable.builtin()) {
-                /* Builtin tool, find and run in-process. */
-                if (std::shared_ptr<builtin::Driver> driver = _builtins.driver(*builtin)) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *builtin, createProductStructure));
-
-                    process::MemoryContext context = process::MemoryContext(
-                        *builtin,
-                        invocation.workingDirectory(),
-                        invocation.arguments(),
-                        invocation.environment());
-                    int exitCode = driver->run(&context, filesystem);
-                    success = (exitCode == 0);
-
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *builtin, createProductStructure));
-                } else {
-                    /* Failed to find builtin tool. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
-                }
-            } else if (ext::optional<std::string> const &external = executable.external()) {
-                /* External tool, find on the filesystem. */
-                ext::optional<std::string> path;
-                if (FSUtil::IsAbsolutePath(*external)) {
-                    if (filesystem->isExecutable(*external)) {
-                        path = external;
-                    }
-                } else {
-                    path = filesystem->findExecutable(*external, executablePaths);
-                }
+            ext::optional<std::pair<std::string, std::function<bool()>>> resolved = ResolveInvocation(_builtins, processContext, processLauncher, filesystem, executablePaths, invocation);
+            if (!resolved) {
+                /* Failed to find tool. */
+                return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+            }
 
-                if (path) {
-                    xcformatter::Formatter::Print(_formatter->beginInvocation(invocation, *path, createProductStructure));
+            print([&] { return _formatter->beginInvocation(invocation, resolved->first, createProductStructure); });
+            bool success = resolved->second();
+            print([&] { return _formatter->finishInvocation(invocation, resolved->first, createProductStructure); });
 
-                    /* Create the execution environment from the process and invocation environments, preferring the invocation. */
-                    std::unordered_map<std::string, std::string> environment = invocation.environment();
-                    environment.insert(processContext->environmentVariables().begin(), processContext->environmentVariables().end());
+            if (!success) {
+                return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+            }
+        }
+    }
 
-                    process::MemoryContext context = process::MemoryContext(
-                        *path,
-                        invocation.workingDirectory(),
-                        invocation.arguments(),
-                        environment);
-                    ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
-                    success = (exitCode && *exitCode == 0);
+    return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
+}
 
-                    xcformatter::Formatter::Print(_formatter->finishInvocation(invocation, *path, createProductStructure));
-                } else {
-                    /* Failed to find executable. */
-                    return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> SimpleExecutor::
+performInvocationsInParallel(
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Filesystem *filesystem,
+    std::vector<std::string> const &executablePaths,
+    std::vector<pbxbuild::Tool::Invocation> const &orderedInvocations,
+    bool createProductStructure)
+{
+    /*
+     * Number each invocation by its position in the input. When several are
+     * ready at once, the earliest runs first, so a build with few dependencies
+     * between invocations starts them in the same order as a serial build.
+     */
+    std::unordered_map<pbxbuild::Tool::Invocation const *, size_t> indexes;
+    for (size_t i = 0; i < orderedInvocations.size(); i++) {
+        indexes.insert({ &orderedInvocations[i], i });
+    }
+
+    /*
+     * Count the unfinished dependencies of each invocation, including the
+     * barriers between phase priorities, and the reverse edges to follow
+     * when an invocation finishes.
+     */
+    pbxbuild::DirectedGraph<pbxbuild::Tool::Invocation const *> graph = CreateInvocationGraph(orderedInvocations);
+    std::vector<size_t> waiting = std::vector<size_t>(orderedInvocations.size(), 0);
+    std::vector<std::vector<size_t>> dependents = std::vector<std::vector<size_t>>(orderedInvocations.size());
+    for (size_t i = 0; i < orderedInvocations.size(); i++) {
+        for (pbxbuild::Tool::Invocation const *dependency : graph.adjacent(&orderedInvocations[i])) {
+            size_t j = indexes.at(dependency);
+            if (j != i) {
+                waiting[i]++;
+                dependents[j].push_back(i);
+            }
+        }
+    }
+
+    std::set<size_t> ready;
+    for (size_t i = 0; i < orderedInvocations.size(); i++) {
+        if (waiting[i] == 0) {
+            ready.insert(i);
+        }
+    }
+
+    /* Completed invocations, reported back from the worker threads. */
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<std::pair<size_t, bool>> completed;
+
+    size_t finished = 0;
+    size_t running = 0;
+    ext::optional<size_t> failed;
+    std::unordered_map<size_t, std::string> names;
+
+    auto finish = [&](size_t i) {
+        finished++;
+        for (size_t j : dependents[i]) {
+            if (--waiting[j] == 0) {
+                ready.insert(j);
+            }
+        }
+    };
+
+    while (true) {
+        /* Start everything that is ready, unless something has failed. */
+        while (!failed && !_cancelled && !ready.empty()) {
+            size_t i = *ready.begin();
+            ready.erase(ready.begin());
+
+            pbxbuild::Tool::Invocation const &invocation = orderedInvocations[i];
+
+            // TODO(grp): This should perhaps be a separate flag for a 'phony' invocation.
+            if (!invocation.executable() || invocation.createsProductStructure() != createProductStructure) {
+                finish(i);
+                continue;
+            }
+
+            for (std::string const &output : invocation.outputs()) {
+                std::string directory = FSUtil::GetDirectoryName(output);
+
+                if (!filesystem->createDirectory(directory, true)) {
+                    failed = i;
+                    break;
                 }
-            } else {
-                abort();
+            }
+            if (failed) {
+                break;
             }
 
-            if (!success) {
-                return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ invocation }));
+            ext::optional<std::pair<std::string, std::function<bool()>>> resolved = ResolveInvocation(_builtins, processContext, processLauncher, filesystem, executablePaths, invocation);
+            if (!resolved) {
+                /* Failed to find tool. */
+                failed = i;
+                break;
             }
+
+            names[i] = resolved->first;
+            print([&] { return _formatter->beginInvocation(invocation, resolved->first, createProductStructure); });
+
+            std::function<bool()> run = resolved->second;
+            running++;
+            _pool->submit([i, run, &mutex, &condition, &completed] {
+                bool success = run();
+
+                std::unique_lock<std::mutex> lock(mutex);
+                completed.push_back({ i, success });
+                condition.notify_one();
+            });
+        }
+
+        if (running == 0) {
+            break;
         }
+
+        /* Wait for at least one running invocation to finish. */
+        std::vector<std::pair<size_t, bool>> results;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&completed] { return !completed.empty(); });
+            results.swap(completed);
+        }
+
+        for (std::pair<size_t, bool> const &result : results) {
+            running--;
+
+            pbxbuild::Tool::Invocation const &invocation = orderedInvocations[result.first];
+            print([&] { return _formatter->finishInvocation(invocation, names[result.first], createProductStructure); });
+
+            if (result.second) {
+                finish(result.first);
+            } else if (!failed) {
+                failed = result.first;
+            }
+        }
+    }
+
+    if (failed) {
+        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>({ orderedInvocations[*failed] }));
+    }
+
+    if (_cancelled) {
+        /* Another target failed; that failure is the one reported. */
+        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
+    }
+
+    if (finished != orderedInvocations.size()) {
+        fprintf(stderr, "error: cycle detected building invocation graph\n");
+        return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
     }
 
     return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
@@ -328,9 +753,9 @@ buildTarget(
     std::vector<pbxbuild::Tool::AuxiliaryFile> const &auxiliaryFiles,
     std::vector<pbxbuild::Tool::Invocation> const &invocations)
 {
-    xcformatter::Formatter::Print(_formatter->beginWriteAuxiliaryFiles(target));
+    print([&] { return _formatter->beginWriteAuxiliaryFiles(target); });
     bool auxiliaryFilesSuccess = this->writeAuxiliaryFiles(filesystem, auxiliaryFiles);
-    xcformatter::Formatter::Print(_formatter->finishWriteAuxiliaryFiles(target));
+    print([&] { return _formatter->finishWriteAuxiliaryFiles(target); });
     if (!auxiliaryFilesSuccess) {
         return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
     }
@@ -341,9 +766,9 @@ buildTarget(
         return std::make_pair(false, std::vector<pbxbuild::Tool::Invocation>());
     }
 
-    xcformatter::Formatter::Print(_formatter->beginCreateProductStructure(target));
+    print([&] { return _formatter->beginCreateProductStructure(target); });
     std::pair<bool, std::vector<pbxbuild::Tool::Invocation>> structureResult = performInvocations(processContext, processLauncher, filesystem, targetEnvironment.executablePaths(), *orderedInvocations, true);
-    xcformatter::Formatter::Print(_formatter->finishCreateProductStructure(target));
+    print([&] { return _formatter->finishCreateProductStructure(target); });
     if (!structureResult.first) {
         return structureResult;
     }
@@ -356,12 +781,21 @@ buildTarget(
     return std::make_pair(true, std::vector<pbxbuild::Tool::Invocation>());
 }
 
+void SimpleExecutor::
+print(std::function<std::string()> const &format)
+{
+    std::lock_guard<std::mutex> lock(_formatterMutex);
+    xcformatter::Formatter::Print(format());
+}
+
 std::unique_ptr<SimpleExecutor> SimpleExecutor::
-Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins)
+Create(std::shared_ptr<xcformatter::Formatter> const &formatter, bool dryRun, builtin::Registry const &builtins, size_t jobs, bool parallelizeTargets)
 {
     return std::unique_ptr<SimpleExecutor>(new SimpleExecutor(
         formatter,
         dryRun,
-        builtins
+        builtins,
+        jobs,
+        parallelizeTargets
     ));
 }
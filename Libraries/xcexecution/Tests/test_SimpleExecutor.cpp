@@ -10,12 +10,18 @@
 #include <xcexecution/SimpleExecutor.h>
 #include <xcformatter/NullFormatter.h>
 #include <pbxbuild/Tool/Invocation.h>
+#include <pbxproj/PBX/NativeTarget.h>
 #include <builtin/Driver.h>
 #include <builtin/Registry.h>
 #include <process/MemoryContext.h>
 #include <process/MemoryLauncher.h>
 #include <libutil/MemoryFilesystem.h>
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
 using xcexecution::SimpleExecutor;
 using libutil::Filesystem;
 using libutil::MemoryFilesystem;
@@ -90,7 +96,7 @@ TEST(SimpleExecutor, PropagateToolResult)
     /* Create test executor. */
     auto formatter = xcformatter::NullFormatter::Create();
     std::vector<std::string> const executablePaths = { filesystem.path("") };
-    SimpleExecutor executor = SimpleExecutor(formatter, false, registry);
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 1, false);
 
     /* Succeed if all tools succeed. */
     auto success = executor.performInvocations(
@@ -138,3 +144,321 @@ TEST(SimpleExecutor, PropagateToolResult)
     EXPECT_EQ(fail2.second.size(), 1);
 }
 
+
+TEST(SimpleExecutor, ParallelDependencyOrder)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({ });
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&mutex, &order](std::string const &name) -> int {
+        std::unique_lock<std::mutex> lock(mutex);
+        order.push_back(name);
+        return (name == "fail" ? 1 : 0);
+    };
+
+    std::vector<std::shared_ptr<builtin::Driver>> drivers;
+    for (std::string const &name : std::vector<std::string>({ "first", "second", "third", "other", "fail" })) {
+        drivers.push_back(std::static_pointer_cast<builtin::Driver>(std::make_shared<Driver>(name, [name, record](process::Context const *context, Filesystem *filesystem) -> int {
+            return record(name);
+        })));
+    }
+    auto registry = builtin::Registry::Create(drivers);
+    auto launcher = process::MemoryLauncher({ });
+
+    auto context = process::MemoryContext(
+        "",
+        filesystem.path(""),
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>());
+
+    /* Create a chain of invocations, each using the output of the last. */
+    auto first = pbxbuild::Tool::Invocation();
+    first.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("first");
+    first.outputs() = { filesystem.path("out/first") };
+    auto second = pbxbuild::Tool::Invocation();
+    second.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("second");
+    second.inputs() = { filesystem.path("out/first") };
+    second.outputs() = { filesystem.path("out/second") };
+    auto third = pbxbuild::Tool::Invocation();
+    third.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("third");
+    third.inputs() = { filesystem.path("out/second") };
+    auto other = pbxbuild::Tool::Invocation();
+    other.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("other");
+    auto fail = pbxbuild::Tool::Invocation();
+    fail.executable() = pbxbuild::Tool::Invocation::Executable::Builtin("fail");
+    fail.outputs() = { filesystem.path("out/fail") };
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { filesystem.path("") };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, registry, 4, false);
+    EXPECT_EQ(4, executor.jobs());
+
+    /* Dependencies finish before the invocations that use them start. */
+    auto success = executor.performInvocations(
+        &context,
+        &launcher,
+        &filesystem,
+        executablePaths,
+        {
+            first,
+            second,
+            third,
+            other,
+        },
+        false);
+    ASSERT_TRUE(success.first);
+    EXPECT_EQ(success.second.size(), 0);
+    ASSERT_EQ(order.size(), 4);
+
+    auto position = [&order](std::string const &name) {
+        return std::find(order.begin(), order.end(), name) - order.begin();
+    };
+    EXPECT_LT(position("first"), position("second"));
+    EXPECT_LT(position("second"), position("third"));
+    EXPECT_NE(position("other"), order.size());
+
+    /* Invocations depending on a failed invocation never run. */
+    order.clear();
+    second.inputs() = { filesystem.path("out/fail") };
+    auto failure = executor.performInvocations(
+        &context,
+        &launcher,
+        &filesystem,
+        executablePaths,
+        {
+            fail,
+            second,
+            third,
+        },
+        false);
+    ASSERT_FALSE(failure.first);
+    ASSERT_EQ(failure.second.size(), 1);
+    EXPECT_EQ(failure.second.front().executable()->builtin(), std::string("fail"));
+    EXPECT_EQ(order, std::vector<std::string>({ "fail" }));
+}
+
+/*
+ * A graph of targets for building targets in parallel, each of which runs
+ * the tool named for it through the launcher.
+ */
+class TargetGraph {
+private:
+    std::unordered_map<std::string, pbxproj::PBX::Target::shared_ptr> _targets;
+    std::unordered_map<pbxproj::PBX::Target::shared_ptr, std::string>  _names;
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr>          _graph;
+
+public:
+    TargetGraph(std::vector<std::pair<std::string, std::vector<std::string>>> const &targets)
+    {
+        for (auto const &entry : targets) {
+            pbxproj::PBX::Target::shared_ptr target = std::make_shared<pbxproj::PBX::NativeTarget>();
+            _targets.insert({ entry.first, target });
+            _names.insert({ target, entry.first });
+        }
+
+        for (auto const &entry : targets) {
+            std::unordered_set<pbxproj::PBX::Target::shared_ptr> dependencies;
+            for (std::string const &dependency : entry.second) {
+                dependencies.insert(_targets.at(dependency));
+            }
+            _graph.insert(_targets.at(entry.first), dependencies);
+        }
+    }
+
+public:
+    pbxbuild::DirectedGraph<pbxproj::PBX::Target::shared_ptr> const &graph() const
+    { return _graph; }
+    std::vector<pbxproj::PBX::Target::shared_ptr> ordered() const
+    { return *_graph.ordered(); }
+    std::string const &name(pbxproj::PBX::Target::shared_ptr const &target) const
+    { return _names.at(target); }
+    pbxproj::PBX::Target::shared_ptr const &target(std::string const &name) const
+    { return _targets.at(name); }
+};
+
+static pbxbuild::Tool::Invocation
+ExternalInvocation(std::string const &tool, std::vector<std::string> const &inputs, std::vector<std::string> const &outputs)
+{
+    auto invocation = pbxbuild::Tool::Invocation();
+    invocation.executable() = pbxbuild::Tool::Invocation::Executable::External(tool);
+    invocation.inputs() = inputs;
+    invocation.outputs() = outputs;
+    return invocation;
+}
+
+TEST(SimpleExecutor, ParallelTargets)
+{
+    /* Create in-memory execution environment. */
+    std::vector<std::string> names = { "lib", "framework", "app", "tests", "other" };
+    std::vector<MemoryFilesystem::Entry> entries;
+    for (std::string const &name : names) {
+        entries.push_back(MemoryFilesystem::Entry::File(name, std::vector<uint8_t>()));
+    }
+    auto filesystem = MemoryFilesystem(entries);
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    std::string failing;
+    std::unordered_map<std::string, process::MemoryLauncher::Handler> handlers;
+    for (std::string const &name : names) {
+        handlers.insert({ filesystem.path(name), [name, &mutex, &order, &failing](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            std::unique_lock<std::mutex> lock(mutex);
+            order.push_back(name);
+            return (name == failing ? 1 : 0);
+        } });
+    }
+    auto launcher = process::MemoryLauncher(handlers);
+
+    auto context = process::MemoryContext(
+        "",
+        filesystem.path(""),
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>());
+
+    /* Two independent targets, one depending on both, and one on that. */
+    TargetGraph targets = TargetGraph({
+        { "lib", { } },
+        { "framework", { } },
+        { "app", { "lib", "framework" } },
+        { "tests", { "app" } },
+        { "other", { } },
+    });
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { filesystem.path("") };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 4, true);
+
+    auto build = [&](pbxproj::PBX::Target::shared_ptr const &target) {
+        return executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { ExternalInvocation(targets.name(target), { }, { }) }, false);
+    };
+
+    /* Targets start once their dependencies are built. */
+    auto success = executor.buildTargetsInParallel(targets.graph(), targets.ordered(), build);
+    ASSERT_TRUE(success.first);
+    EXPECT_EQ(success.second.size(), 0);
+    ASSERT_EQ(order.size(), names.size());
+
+    auto position = [&order](std::string const &name) {
+        return std::find(order.begin(), order.end(), name) - order.begin();
+    };
+    EXPECT_LT(position("lib"), position("app"));
+    EXPECT_LT(position("framework"), position("app"));
+    EXPECT_LT(position("app"), position("tests"));
+
+    /* After a target fails, the targets depending on it never start. */
+    order.clear();
+    failing = "lib";
+    auto failure = executor.buildTargetsInParallel(targets.graph(), targets.ordered(), build);
+    ASSERT_FALSE(failure.first);
+    ASSERT_EQ(failure.second.size(), 1);
+    EXPECT_EQ(failure.second.front().executable()->external(), std::string("lib"));
+    EXPECT_EQ(position("app"), order.size());
+    EXPECT_EQ(position("tests"), order.size());
+    EXPECT_FALSE(executor.cancelled());
+}
+
+TEST(SimpleExecutor, ParallelTargetsCancel)
+{
+    /* Create in-memory execution environment. */
+    auto filesystem = MemoryFilesystem({
+        MemoryFilesystem::Entry::File("fail", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("slow", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::File("after", std::vector<uint8_t>()),
+        MemoryFilesystem::Entry::Directory("out", { }),
+    });
+
+    /* Create test executor. */
+    auto formatter = xcformatter::NullFormatter::Create();
+    std::vector<std::string> const executablePaths = { filesystem.path("") };
+    SimpleExecutor executor = SimpleExecutor(formatter, false, builtin::Registry::Create({ }), 4, true);
+
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&mutex, &order](std::string const &name) {
+        std::unique_lock<std::mutex> lock(mutex);
+        order.push_back(name);
+    };
+
+    auto launcher = process::MemoryLauncher({
+        { filesystem.path("fail"), [&record](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            record("fail");
+            return 1;
+        } },
+        { filesystem.path("slow"), [&record, &executor](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            /* Still running when the other target fails. */
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (!executor.cancelled() && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            record("slow");
+            return 0;
+        } },
+        { filesystem.path("after"), [&record](Filesystem *filesystem, process::Context const *context) -> ext::optional<int> {
+            record("after");
+            return 0;
+        } },
+    });
+
+    auto context = process::MemoryContext(
+        "",
+        filesystem.path(""),
+        std::vector<std::string>(),
+        std::unordered_map<std::string, std::string>());
+
+    TargetGraph targets = TargetGraph({
+        { "failing", { } },
+        { "running", { } },
+    });
+
+    /* The running target's invocations after the failure are cancelled. */
+    auto failure = executor.buildTargetsInParallel(targets.graph(), targets.ordered(), [&](pbxproj::PBX::Target::shared_ptr const &target) {
+        if (targets.name(target) == "failing") {
+            return executor.performInvocations(&context, &launcher, &filesystem, executablePaths, { ExternalInvocation("fail", { }, { }) }, false);
+        }
+
+        return executor.performInvocations(&context, &launcher, &filesystem, executablePaths, {
+            ExternalInvocation("slow", { }, { filesystem.path("out/slow") }),
+            ExternalInvocation("after", { filesystem.path("out/slow") }, { }),
+        }, false);
+    });
+    ASSERT_FALSE(failure.first);
+    ASSERT_EQ(failure.second.size(), 1);
+    EXPECT_EQ(failure.second.front().executable()->external(), std::string("fail"));
+    EXPECT_EQ(order, std::vector<std::string>({ "fail", "slow" }));
+    EXPECT_FALSE(executor.cancelled());
+}
+
+TEST(SimpleExecutor, PlanningWaves)
+{
+    TargetGraph targets = TargetGraph({
+        { "base", { } },
+        { "util", { } },
+        { "core", { "base" } },
+        { "ui", { "core", "util" } },
+        { "app", { "ui" } },
+        { "docs", { } },
+    });
+
+    std::vector<pbxproj::PBX::Target::shared_ptr> ordered;
+    for (std::string const &name : std::vector<std::string>({ "base", "util", "core", "ui", "app", "docs" })) {
+        ordered.push_back(targets.target(name));
+    }
+
+    /* Each wave is every target whose dependencies are built, in build order. */
+    std::vector<std::vector<size_t>> waves = SimpleExecutor::PlanningWaves(targets.graph(), ordered);
+    EXPECT_EQ(waves, std::vector<std::vector<size_t>>({ { 0, 1, 5 }, { 2 }, { 3 }, { 4 } }));
+
+    /* The same graph plans the same way every time. */
+    for (size_t n = 0; n < 10; n++) {
+        EXPECT_EQ(waves, SimpleExecutor::PlanningWaves(targets.graph(), ordered));
+    }
+
+    /* Independent targets are all planned in the first wave. */
+    TargetGraph flat = TargetGraph({ { "a", { } }, { "b", { } }, { "c", { } } });
+    std::vector<pbxproj::PBX::Target::shared_ptr> flatOrdered = { flat.target("c"), flat.target("a"), flat.target("b") };
+    EXPECT_EQ(SimpleExecutor::PlanningWaves(flat.graph(), flatOrdered), std::vector<std::vector<size_t>>({ { 0, 1, 2 } }));
+}
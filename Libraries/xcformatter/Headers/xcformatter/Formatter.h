@@ -19,7 +19,8 @@ namespace Tool { class Invocation; }
 namespace xcformatter {
 
 /*
- * Abstract formatter for build output.
+ * Abstract formatter for build output. Executors building targets in
+ * parallel call the formatter from several threads, but never at once.
  */
 class Formatter {
 protected:
@@ -16,9 +16,11 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; }
+namespace plist { class Dictionary; }
 namespace xcsdk { class Configuration; }
 
 namespace xcsdk { namespace SDK {
@@ -33,6 +35,10 @@ private:
     std::vector<Platform::shared_ptr>  _platforms;
     std::vector<Toolchain::shared_ptr> _toolchains;
 
+private:
+    std::vector<std::string>           _toolchainsPaths;
+    std::vector<std::string>           _platformsPaths;
+
 public:
     Manager();
     ~Manager();
@@ -102,11 +108,53 @@ public:
         Target::shared_ptr const &target,
         std::vector<Toolchain::shared_ptr> const &toolchains) const;
 
+public:
+    /*
+     * The files and directories searched and read to find the contents of
+     * the developer root. If none of them have changed, neither have the
+     * contents.
+     */
+    std::vector<std::string> dependencies() const;
+
+    /*
+     * Serialize the platforms, SDKs, and toolchains in the developer root,
+     * along with the modification time of each of the dependencies.
+     */
+    std::unique_ptr<plist::Dictionary> snapshot(libutil::Filesystem const *filesystem) const;
+
 public:
     /*
      * Load from a developer root. Returns nullptr on error.
      */
     static std::shared_ptr<Manager> Open(libutil::Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration);
+
+    /*
+     * Load from a snapshot of a developer root, without searching it or
+     * reading any property lists. Returns nullptr if the snapshot is of
+     * another developer root or configuration, or if anything it depends
+     * on has changed since it was taken.
+     */
+    static std::shared_ptr<Manager> Load(libutil::Filesystem const *filesystem, plist::Dictionary const *snapshot, std::string const &path, ext::optional<Configuration> const &configuration);
+
+    /*
+     * Load from a developer root, using the snapshot stored at a path if it
+     * is still valid. Otherwise, the developer root is searched and a new
+     * snapshot is written to replace it. Returns nullptr on error.
+     */
+    static std::shared_ptr<Manager> Open(libutil::Filesystem *filesystem, std::string const &path, ext::optional<Configuration> const &configuration, std::string const &snapshotPath);
+
+public:
+    /*
+     * If none of the dependencies in a snapshot have changed; that is, if
+     * each has the same modification time, or is still missing.
+     */
+    static bool ValidDependencies(libutil::Filesystem const *filesystem, plist::Dictionary const *dependencies);
+
+    /*
+     * Record the modification time of each dependency. Missing files and
+     * directories are recorded as well, in case they are created later.
+     */
+    static std::unique_ptr<plist::Dictionary> RecordDependencies(libutil::Filesystem const *filesystem, std::vector<std::string> const &dependencies);
 };
 
 } }
@@ -28,37 +28,41 @@ public:
     typedef std::vector <shared_ptr> vector;
 
 private:
-    std::weak_ptr<Manager>           _manager;
-    PlatformVersion::shared_ptr      _platformVersion;
-    std::vector<Target::shared_ptr>  _targets;
+    std::weak_ptr<Manager>             _manager;
+    PlatformVersion::shared_ptr        _platformVersion;
+    std::vector<Target::shared_ptr>    _targets;
 
 private:
-    std::string                      _path;
-    std::string                      _name;
+    std::string                        _path;
+    std::string                        _name;
 
 private:
-    ext::optional<std::string>       _identifier;
-    ext::optional<std::string>       _description;
-    ext::optional<std::string>       _type;
-    ext::optional<std::string>       _icon;
-    ext::optional<std::string>       _version;
+    std::string                        _plistPath;
+    std::unique_ptr<plist::Dictionary> _plist;
 
 private:
-    ext::optional<std::string>       _familyIdentifier;
-    ext::optional<std::string>       _familyName;
+    ext::optional<std::string>         _identifier;
+    ext::optional<std::string>         _description;
+    ext::optional<std::string>         _type;
+    ext::optional<std::string>         _icon;
+    ext::optional<std::string>         _version;
 
 private:
-    ext::optional<pbxsetting::Level> _defaultProperties;
-    ext::optional<pbxsetting::Level> _overrideProperties;
+    ext::optional<std::string>         _familyIdentifier;
+    ext::optional<std::string>         _familyName;
 
 private:
-    ext::optional<pbxsetting::Level> _additionalInfo;
-    ext::optional<std::string>       _minimumSDKVersion;
+    ext::optional<pbxsetting::Level>   _defaultProperties;
+    ext::optional<pbxsetting::Level>   _overrideProperties;
 
 private:
-    ext::optional<bool>              _isDeploymentPlatform;
-    plist::Dictionary         const *_defaultDebuggerSettings;
-    ext::optional<std::string>       _runtimeSystemSpecification;
+    ext::optional<pbxsetting::Level>   _additionalInfo;
+    ext::optional<std::string>         _minimumSDKVersion;
+
+private:
+    ext::optional<bool>                _isDeploymentPlatform;
+    plist::Dictionary           const *_defaultDebuggerSettings;
+    ext::optional<std::string>         _runtimeSystemSpecification;
 
 public:
     Platform();
@@ -126,8 +130,24 @@ public:
 public:
     std::vector<std::string> executablePaths() const;
 
+public:
+    /*
+     * The files and directories the platform and its SDKs were loaded from.
+     */
+    void dependencies(std::vector<std::string> *dependencies) const;
+
+    /*
+     * Serialize the platform and its SDKs. Loading the result does not
+     * read any files.
+     */
+    std::unique_ptr<plist::Dictionary> snapshot() const;
+
 public:
     static Platform::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string const &path);
+    static Platform::shared_ptr Load(std::shared_ptr<Manager> manager, plist::Dictionary const *snapshot);
+
+private:
+    static Platform::shared_ptr Create(std::shared_ptr<Manager> manager, std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist);
 
 private:
     bool parse(plist::Dictionary const *dict);
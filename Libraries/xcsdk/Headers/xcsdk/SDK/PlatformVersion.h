@@ -11,6 +11,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; };
@@ -23,15 +24,20 @@ public:
     typedef std::shared_ptr <PlatformVersion> shared_ptr;
 
 private:
-    ext::optional<std::string> _projectName;
-    ext::optional<std::string> _productBuildVersion;
-    ext::optional<std::string> _buildVersion;
-    ext::optional<std::string> _sourceVersion;
-    ext::optional<std::string> _bundleShortVersionString;
-    ext::optional<std::string> _bundleVersion;
+    std::string                        _plistPath;
+    std::unique_ptr<plist::Dictionary> _plist;
+
+private:
+    ext::optional<std::string>         _projectName;
+    ext::optional<std::string>         _productBuildVersion;
+    ext::optional<std::string>         _buildVersion;
+    ext::optional<std::string>         _sourceVersion;
+    ext::optional<std::string>         _bundleShortVersionString;
+    ext::optional<std::string>         _bundleVersion;
 
 public:
     PlatformVersion();
+    ~PlatformVersion();
 
 public:
     inline ext::optional<std::string> const &projectName() const
@@ -47,8 +53,23 @@ public:
     inline ext::optional<std::string> const &bundleVersion() const
     { return _bundleVersion; }
 
+public:
+    /*
+     * The files the platform version was loaded from.
+     */
+    void dependencies(std::vector<std::string> *dependencies) const;
+
+    /*
+     * Serialize the platform version. Loading the result does not read any files.
+     */
+    std::unique_ptr<plist::Dictionary> snapshot() const;
+
 public:
     static PlatformVersion::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static PlatformVersion::shared_ptr Load(plist::Dictionary const *snapshot);
+
+private:
+    static PlatformVersion::shared_ptr Create(std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist);
 
 private:
     bool parse(plist::Dictionary const *dict);
@@ -11,6 +11,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <ext/optional>
 
 namespace libutil { class Filesystem; };
@@ -23,14 +24,19 @@ public:
     typedef std::shared_ptr <Product> shared_ptr;
 
 private:
-    ext::optional<std::string> _productName;
-    ext::optional<std::string> _productVersion;
-    ext::optional<std::string> _productUserVisibleVersion;
-    ext::optional<std::string> _productBuildVersion;
-    ext::optional<std::string> _productCopyright;
+    std::string                        _plistPath;
+    std::unique_ptr<plist::Dictionary> _plist;
+
+private:
+    ext::optional<std::string>         _productName;
+    ext::optional<std::string>         _productVersion;
+    ext::optional<std::string>         _productUserVisibleVersion;
+    ext::optional<std::string>         _productBuildVersion;
+    ext::optional<std::string>         _productCopyright;
 
 public:
     Product();
+    ~Product();
 
 public:
     inline ext::optional<std::string> const &name() const
@@ -44,8 +50,23 @@ public:
     inline ext::optional<std::string> const &copyright() const
     { return _productCopyright; }
 
+public:
+    /*
+     * The files the product was loaded from.
+     */
+    void dependencies(std::vector<std::string> *dependencies) const;
+
+    /*
+     * Serialize the product. Loading the result does not read any files.
+     */
+    std::unique_ptr<plist::Dictionary> snapshot() const;
+
 public:
     static Product::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static Product::shared_ptr Load(plist::Dictionary const *snapshot);
+
+private:
+    static Product::shared_ptr Create(std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist);
 
 private:
     bool parse(plist::Dictionary const *dict);
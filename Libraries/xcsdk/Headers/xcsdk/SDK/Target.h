@@ -42,6 +42,10 @@ private:
     std::string                             _path;
     std::string                             _bundleName;
 
+private:
+    std::string                             _plistPath;
+    std::unique_ptr<plist::Dictionary>      _plist;
+
 private:
     ext::optional<std::string>              _canonicalName;
     ext::optional<std::string>              _displayName;
@@ -130,8 +134,23 @@ public:
 public:
     std::vector<std::string> executablePaths() const;
 
+public:
+    /*
+     * The files and directories the target was loaded from.
+     */
+    void dependencies(std::vector<std::string> *dependencies) const;
+
+    /*
+     * Serialize the target. Loading the result does not read any files.
+     */
+    std::unique_ptr<plist::Dictionary> snapshot() const;
+
 public:
     static Target::shared_ptr Open(libutil::Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared_ptr<Platform>, std::string const &path);
+    static Target::shared_ptr Load(std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, plist::Dictionary const *snapshot);
+
+private:
+    static Target::shared_ptr Create(std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist);
 
 private:
     bool parse(plist::Dictionary const *dict);
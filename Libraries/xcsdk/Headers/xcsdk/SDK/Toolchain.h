@@ -31,6 +31,10 @@ private:
     std::string                             _path;
     std::string                             _name;
 
+private:
+    std::string                             _plistPath;
+    std::unique_ptr<plist::Dictionary>      _plist;
+
 private:
     ext::optional<std::string>              _identifier;
     ext::optional<std::vector<std::string>> _aliases;
@@ -98,12 +102,27 @@ public:
 public:
     std::vector<std::string> executablePaths() const;
 
+public:
+    /*
+     * The files and directories the toolchain was loaded from.
+     */
+    void dependencies(std::vector<std::string> *dependencies) const;
+
+    /*
+     * Serialize the toolchain. Loading the result does not read any files.
+     */
+    std::unique_ptr<plist::Dictionary> snapshot() const;
+
 public:
     static Toolchain::shared_ptr Open(libutil::Filesystem const *filesystem, std::string const &path);
+    static Toolchain::shared_ptr Load(plist::Dictionary const *snapshot);
 
 public:
     static std::string DefaultIdentifier(void);
 
+private:
+    static Toolchain::shared_ptr Create(std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist);
+
 private:
     bool parse(plist::Dictionary const *dict);
 };
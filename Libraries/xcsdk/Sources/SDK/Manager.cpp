@@ -9,8 +9,14 @@
 #include <xcsdk/SDK/Manager.h>
 #include <xcsdk/Configuration.h>
 #include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
 #include <pbxsetting/Setting.h>
 #include <pbxsetting/Type.h>
+#include <plist/Array.h>
+#include <plist/Dictionary.h>
+#include <plist/Integer.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
 
 #include <algorithm>
 #include <iostream>
@@ -22,6 +28,7 @@ using xcsdk::SDK::Target;
 using xcsdk::SDK::Toolchain;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::MappedFile;
 
 Manager::
 Manager()
@@ -166,6 +173,140 @@ executablePaths(Platform::shared_ptr const &platform, Target::shared_ptr const &
     return paths;
 }
 
+static std::vector<std::string>
+ToolchainsPaths(std::string const &path, ext::optional<Configuration> const &configuration)
+{
+    std::vector<std::string> toolchainsPaths = { path + "/" + "Toolchains" };
+    if (configuration) {
+        std::vector<std::string> const &extraToolchainsPaths = configuration->extraToolchainsPaths();
+        toolchainsPaths.insert(toolchainsPaths.end(), extraToolchainsPaths.begin(), extraToolchainsPaths.end());
+    }
+    return toolchainsPaths;
+}
+
+static std::vector<std::string>
+PlatformsPaths(std::string const &path, ext::optional<Configuration> const &configuration)
+{
+    std::vector<std::string> platformsPaths = { path + "/" + "Platforms" };
+    if (configuration) {
+        std::vector<std::string> const &extraPlatformsPaths = configuration->extraPlatformsPaths();
+        platformsPaths.insert(platformsPaths.end(), extraPlatformsPaths.begin(), extraPlatformsPaths.end());
+    }
+    return platformsPaths;
+}
+
+std::vector<std::string> Manager::
+dependencies() const
+{
+    std::vector<std::string> dependencies;
+    dependencies.insert(dependencies.end(), _toolchainsPaths.begin(), _toolchainsPaths.end());
+    dependencies.insert(dependencies.end(), _platformsPaths.begin(), _platformsPaths.end());
+
+    for (Toolchain::shared_ptr const &toolchain : _toolchains) {
+        toolchain->dependencies(&dependencies);
+    }
+
+    for (Platform::shared_ptr const &platform : _platforms) {
+        platform->dependencies(&dependencies);
+    }
+
+    return dependencies;
+}
+
+/*
+ * Increment when the format of the snapshot changes.
+ */
+static int64_t const SnapshotVersion = 1;
+
+static std::unique_ptr<plist::Array>
+StringArray(std::vector<std::string> const &values)
+{
+    auto array = plist::Array::New();
+    for (std::string const &value : values) {
+        array->append(plist::String::New(value));
+    }
+    return array;
+}
+
+static bool
+EqualStringArray(plist::Array const *array, std::vector<std::string> const &values)
+{
+    if (array == nullptr || array->count() != values.size()) {
+        return false;
+    }
+
+    for (size_t n = 0; n < values.size(); n++) {
+        plist::String const *value = array->value<plist::String>(n);
+        if (value == nullptr || value->value() != values[n]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::unique_ptr<plist::Dictionary> Manager::
+snapshot(Filesystem const *filesystem) const
+{
+    auto toolchains = plist::Array::New();
+    for (Toolchain::shared_ptr const &toolchain : _toolchains) {
+        toolchains->append(toolchain->snapshot());
+    }
+
+    auto platforms = plist::Array::New();
+    for (Platform::shared_ptr const &platform : _platforms) {
+        platforms->append(platform->snapshot());
+    }
+
+    auto snapshot = plist::Dictionary::New();
+    snapshot->set("Version", plist::Integer::New(SnapshotVersion));
+    snapshot->set("Path", plist::String::New(_path));
+    snapshot->set("ToolchainsPaths", StringArray(_toolchainsPaths));
+    snapshot->set("PlatformsPaths", StringArray(_platformsPaths));
+    snapshot->set("Dependencies", RecordDependencies(filesystem, dependencies()));
+    snapshot->set("Toolchains", std::move(toolchains));
+    snapshot->set("Platforms", std::move(platforms));
+    return snapshot;
+}
+
+bool Manager::
+ValidDependencies(Filesystem const *filesystem, plist::Dictionary const *dependencies)
+{
+    for (size_t n = 0; n < dependencies->count(); n++) {
+        plist::Integer const *modificationTime = dependencies->value<plist::Integer>(n);
+        if (modificationTime == nullptr) {
+            return false;
+        }
+
+        ext::optional<uint64_t> current = filesystem->modificationTime(dependencies->key(n));
+        if (current) {
+            if (modificationTime->value() < 0 || static_cast<uint64_t>(modificationTime->value()) != *current) {
+                return false;
+            }
+        } else {
+            if (modificationTime->value() >= 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+std::unique_ptr<plist::Dictionary> Manager::
+RecordDependencies(Filesystem const *filesystem, std::vector<std::string> const &dependencies)
+{
+    auto modificationTimes = plist::Dictionary::New();
+    for (std::string const &dependency : dependencies) {
+        if (ext::optional<uint64_t> modificationTime = filesystem->modificationTime(dependency)) {
+            modificationTimes->set(dependency, plist::Integer::New(static_cast<int64_t>(*modificationTime)));
+        } else {
+            modificationTimes->set(dependency, plist::Integer::New(-1));
+        }
+    }
+    return modificationTimes;
+}
+
 std::shared_ptr<Manager> Manager::
 Open(Filesystem const *filesystem, std::string const &path, ext::optional<Configuration> const &configuration)
 {
@@ -176,15 +317,11 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
 
     auto manager = std::make_shared <Manager> ();
     manager->_path = path;
-
-    std::vector<std::string> toolchainsPaths = { path + "/" + "Toolchains" };
-    if (configuration) {
-        std::vector<std::string> const &extraToolchainsPaths = configuration->extraToolchainsPaths();
-        toolchainsPaths.insert(toolchainsPaths.end(), extraToolchainsPaths.begin(), extraToolchainsPaths.end());
-    }
+    manager->_toolchainsPaths = ToolchainsPaths(path, configuration);
+    manager->_platformsPaths = PlatformsPaths(path, configuration);
 
     std::vector<std::shared_ptr<Toolchain>> toolchains;
-    for (std::string const &toolchainsPath : toolchainsPaths) {
+    for (std::string const &toolchainsPath : manager->_toolchainsPaths) {
         filesystem->readDirectory(toolchainsPath, false, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "xctoolchain") {
                 return;
@@ -199,14 +336,8 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
     }
     manager->_toolchains = toolchains;
 
-    std::vector<std::string> platformsPaths = { path + "/" + "Platforms" };
-    if (configuration) {
-        std::vector<std::string> const &extraPlatformsPaths = configuration->extraPlatformsPaths();
-        platformsPaths.insert(platformsPaths.end(), extraPlatformsPaths.begin(), extraPlatformsPaths.end());
-    }
-
     std::vector<std::shared_ptr<Platform>> platforms;
-    for (std::string const &platformsPath : platformsPaths) {
+    for (std::string const &platformsPath : manager->_platformsPaths) {
         filesystem->readDirectory(platformsPath, false, [&](std::string const &filename) -> void {
             if (FSUtil::GetFileExtension(filename) != "platform") {
                 return;
@@ -226,3 +357,112 @@ Open(Filesystem const *filesystem, std::string const &path, ext::optional<Config
 
     return manager;
 }
+
+std::shared_ptr<Manager> Manager::
+Load(Filesystem const *filesystem, plist::Dictionary const *snapshot, std::string const &path, ext::optional<Configuration> const &configuration)
+{
+    plist::Integer const *version = snapshot->value<plist::Integer>("Version");
+    if (version == nullptr || version->value() != SnapshotVersion) {
+        return nullptr;
+    }
+
+    /*
+     * The snapshot must be of the same developer root, searched in the same places.
+     */
+    plist::String const *snapshotPath = snapshot->value<plist::String>("Path");
+    if (snapshotPath == nullptr || snapshotPath->value() != path) {
+        return nullptr;
+    }
+
+    std::vector<std::string> toolchainsPaths = ToolchainsPaths(path, configuration);
+    std::vector<std::string> platformsPaths = PlatformsPaths(path, configuration);
+    if (!EqualStringArray(snapshot->value<plist::Array>("ToolchainsPaths"), toolchainsPaths) ||
+        !EqualStringArray(snapshot->value<plist::Array>("PlatformsPaths"), platformsPaths)) {
+        return nullptr;
+    }
+
+    plist::Dictionary const *dependencies = snapshot->value<plist::Dictionary>("Dependencies");
+    if (dependencies == nullptr || !ValidDependencies(filesystem, dependencies)) {
+        return nullptr;
+    }
+
+    plist::Array const *toolchainSnapshots = snapshot->value<plist::Array>("Toolchains");
+    plist::Array const *platformSnapshots = snapshot->value<plist::Array>("Platforms");
+    if (toolchainSnapshots == nullptr || platformSnapshots == nullptr) {
+        return nullptr;
+    }
+
+    auto manager = std::make_shared <Manager> ();
+    manager->_path = path;
+    manager->_toolchainsPaths = toolchainsPaths;
+    manager->_platformsPaths = platformsPaths;
+
+    /*
+     * Toolchains first: targets look up their toolchains as they are created.
+     */
+    for (size_t n = 0; n < toolchainSnapshots->count(); n++) {
+        plist::Dictionary const *toolchainSnapshot = toolchainSnapshots->value<plist::Dictionary>(n);
+        if (toolchainSnapshot == nullptr) {
+            return nullptr;
+        }
+
+        Toolchain::shared_ptr toolchain = Toolchain::Load(toolchainSnapshot);
+        if (toolchain == nullptr) {
+            return nullptr;
+        }
+
+        manager->_toolchains.push_back(toolchain);
+    }
+
+    /* Platforms were sorted before they were serialized. */
+    for (size_t n = 0; n < platformSnapshots->count(); n++) {
+        plist::Dictionary const *platformSnapshot = platformSnapshots->value<plist::Dictionary>(n);
+        if (platformSnapshot == nullptr) {
+            return nullptr;
+        }
+
+        Platform::shared_ptr platform = Platform::Load(manager, platformSnapshot);
+        if (platform == nullptr) {
+            return nullptr;
+        }
+
+        manager->_platforms.push_back(platform);
+    }
+
+    return manager;
+}
+
+std::shared_ptr<Manager> Manager::
+Open(Filesystem *filesystem, std::string const &path, ext::optional<Configuration> const &configuration, std::string const &snapshotPath)
+{
+    std::unique_ptr<MappedFile> contents = (filesystem->isReadable(snapshotPath) ? filesystem->map(snapshotPath) : nullptr);
+    if (contents != nullptr) {
+        auto deserialized = plist::Format::Binary::Deserialize(contents->data(), contents->size(), plist::Format::Binary::Create());
+        if (plist::Dictionary const *snapshot = plist::CastTo<plist::Dictionary>(deserialized.first.get())) {
+            if (std::shared_ptr<Manager> manager = Load(filesystem, snapshot, path, configuration)) {
+                return manager;
+            }
+        }
+    }
+
+    std::shared_ptr<Manager> manager = Open(filesystem, path, configuration);
+    if (manager == nullptr) {
+        return nullptr;
+    }
+
+    /*
+     * A snapshot that can't be written isn't an error; the next load will
+     * search the developer root again. Processes loading at the same time
+     * each write the whole snapshot, and the write replaces the file at once,
+     * so the last one wins with a snapshot as good as any other.
+     */
+    std::unique_ptr<plist::Dictionary> snapshot = manager->snapshot(filesystem);
+    auto serialized = plist::Format::Binary::Serialize(snapshot.get(), plist::Format::Binary::Create());
+    if (serialized.first == nullptr ||
+        !filesystem->createDirectory(FSUtil::GetDirectoryName(snapshotPath), true) ||
+        !filesystem->replace(*serialized.first, snapshotPath)) {
+        fprintf(stderr, "warning: unable to write sdk snapshot to '%s'\n", snapshotPath.c_str());
+    }
+
+    return manager;
+}
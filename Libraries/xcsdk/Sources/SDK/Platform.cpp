@@ -331,22 +331,12 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
-    if (plist == nullptr) {
+    if (plist::CastTo<plist::Dictionary>(result.first.get()) == nullptr) {
         return nullptr;
     }
 
-    /*
-     * Create the platform object.
-     */
-    auto platform = std::make_shared<Platform>();
-    platform->_manager = manager;
-    platform->_path = FSUtil::GetDirectoryName(realPath);
-
-    /*
-     * Parse platform info dictionary.
-     */
-    if (!platform->parse(plist)) {
+    auto platform = Create(manager, realPath, plist::static_unique_pointer_cast<plist::Dictionary>(std::move(result.first)));
+    if (platform == nullptr) {
         return nullptr;
     }
 
@@ -375,3 +365,102 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::string
 
     return platform;
 }
+
+Platform::shared_ptr Platform::
+Load(std::shared_ptr<Manager> manager, plist::Dictionary const *snapshot)
+{
+    auto P  = snapshot->value<plist::String>("Path");
+    auto C  = snapshot->value<plist::Dictionary>("Contents");
+    auto V  = snapshot->value<plist::Dictionary>("PlatformVersion");
+    auto Ts = snapshot->value<plist::Array>("Targets");
+    if (P == nullptr || C == nullptr || Ts == nullptr) {
+        return nullptr;
+    }
+
+    auto platform = Create(manager, P->value(), C->copy());
+    if (platform == nullptr) {
+        return nullptr;
+    }
+
+    if (V != nullptr) {
+        platform->_platformVersion = PlatformVersion::Load(V);
+        if (platform->_platformVersion == nullptr) {
+            return nullptr;
+        }
+    }
+
+    /* Targets were sorted before they were serialized. */
+    for (size_t n = 0; n < Ts->count(); n++) {
+        auto T = Ts->value<plist::Dictionary>(n);
+        if (T == nullptr) {
+            return nullptr;
+        }
+
+        auto target = Target::Load(manager, platform, T);
+        if (target == nullptr) {
+            return nullptr;
+        }
+
+        platform->_targets.push_back(target);
+    }
+
+    return platform;
+}
+
+Platform::shared_ptr Platform::
+Create(std::shared_ptr<Manager> manager, std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist)
+{
+    /*
+     * Create the platform object.
+     */
+    auto platform = std::make_shared<Platform>();
+    platform->_manager = manager;
+    platform->_path = FSUtil::GetDirectoryName(plistPath);
+
+    /*
+     * Parse platform info dictionary.
+     */
+    if (!platform->parse(plist.get())) {
+        return nullptr;
+    }
+
+    platform->_plistPath = plistPath;
+    platform->_plist = std::move(plist);
+
+    return platform;
+}
+
+void Platform::
+dependencies(std::vector<std::string> *dependencies) const
+{
+    /* The directories as well, to notice version information or SDKs being added. */
+    dependencies->push_back(_path);
+    dependencies->push_back(_plistPath);
+    dependencies->push_back(_path + "/Developer/SDKs");
+
+    if (_platformVersion != nullptr) {
+        _platformVersion->dependencies(dependencies);
+    }
+
+    for (Target::shared_ptr const &target : _targets) {
+        target->dependencies(dependencies);
+    }
+}
+
+std::unique_ptr<plist::Dictionary> Platform::
+snapshot() const
+{
+    auto targets = plist::Array::New();
+    for (Target::shared_ptr const &target : _targets) {
+        targets->append(target->snapshot());
+    }
+
+    auto snapshot = plist::Dictionary::New();
+    snapshot->set("Path", plist::String::New(_plistPath));
+    snapshot->set("Contents", _plist->copy());
+    if (_platformVersion != nullptr) {
+        snapshot->set("PlatformVersion", _platformVersion->snapshot());
+    }
+    snapshot->set("Targets", std::move(targets));
+    return snapshot;
+}
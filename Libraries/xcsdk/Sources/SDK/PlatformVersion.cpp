@@ -21,6 +21,11 @@ PlatformVersion()
 {
 }
 
+PlatformVersion::
+~PlatformVersion()
+{
+}
+
 bool PlatformVersion::
 parse(plist::Dictionary const *dict)
 {
@@ -98,18 +103,53 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
-    if (plist == nullptr) {
+    if (plist::CastTo<plist::Dictionary>(result.first.get()) == nullptr) {
+        return nullptr;
+    }
+
+    return Create(realPath, plist::static_unique_pointer_cast<plist::Dictionary>(std::move(result.first)));
+}
+
+PlatformVersion::shared_ptr PlatformVersion::
+Load(plist::Dictionary const *snapshot)
+{
+    auto P = snapshot->value<plist::String>("Path");
+    auto C = snapshot->value<plist::Dictionary>("Contents");
+    if (P == nullptr || C == nullptr) {
         return nullptr;
     }
 
+    return Create(P->value(), C->copy());
+}
+
+PlatformVersion::shared_ptr PlatformVersion::
+Create(std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist)
+{
     /*
-     * Parse the version dictionary and create the object.
+     * Parse the dictionary and create the object.
      */
     auto platformVersion = std::make_shared<PlatformVersion>();
-    if (!platformVersion->parse(plist)) {
+    if (!platformVersion->parse(plist.get())) {
         return nullptr;
     }
 
+    platformVersion->_plistPath = plistPath;
+    platformVersion->_plist = std::move(plist);
+
     return platformVersion;
 }
+
+void PlatformVersion::
+dependencies(std::vector<std::string> *dependencies) const
+{
+    dependencies->push_back(_plistPath);
+}
+
+std::unique_ptr<plist::Dictionary> PlatformVersion::
+snapshot() const
+{
+    auto snapshot = plist::Dictionary::New();
+    snapshot->set("Path", plist::String::New(_plistPath));
+    snapshot->set("Contents", _plist->copy());
+    return snapshot;
+}
@@ -21,6 +21,11 @@ Product()
 {
 }
 
+Product::
+~Product()
+{
+}
+
 bool Product::
 parse(plist::Dictionary const *dict)
 {
@@ -93,18 +98,53 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
-    if (plist == nullptr) {
+    if (plist::CastTo<plist::Dictionary>(result.first.get()) == nullptr) {
+        return nullptr;
+    }
+
+    return Create(realPath, plist::static_unique_pointer_cast<plist::Dictionary>(std::move(result.first)));
+}
+
+Product::shared_ptr Product::
+Load(plist::Dictionary const *snapshot)
+{
+    auto P = snapshot->value<plist::String>("Path");
+    auto C = snapshot->value<plist::Dictionary>("Contents");
+    if (P == nullptr || C == nullptr) {
         return nullptr;
     }
 
+    return Create(P->value(), C->copy());
+}
+
+Product::shared_ptr Product::
+Create(std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist)
+{
     /*
      * Parse the dictionary and create the object.
      */
-    auto product = std::make_shared <Product> ();
-    if (!product->parse(plist)) {
+    auto product = std::make_shared<Product>();
+    if (!product->parse(plist.get())) {
         return nullptr;
     }
 
+    product->_plistPath = plistPath;
+    product->_plist = std::move(plist);
+
     return product;
 }
+
+void Product::
+dependencies(std::vector<std::string> *dependencies) const
+{
+    dependencies->push_back(_plistPath);
+}
+
+std::unique_ptr<plist::Dictionary> Product::
+snapshot() const
+{
+    auto snapshot = plist::Dictionary::New();
+    snapshot->set("Path", plist::String::New(_plistPath));
+    snapshot->set("Contents", _plist->copy());
+    return snapshot;
+}
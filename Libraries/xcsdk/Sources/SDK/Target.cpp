@@ -235,31 +235,93 @@ Open(Filesystem const *filesystem, std::shared_ptr<Manager> manager, std::shared
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
-    if (plist == nullptr) {
+    if (plist::CastTo<plist::Dictionary>(result.first.get()) == nullptr) {
+        return nullptr;
+    }
+
+    auto target = Create(manager, platform, realPath, plist::static_unique_pointer_cast<plist::Dictionary>(std::move(result.first)));
+    if (target == nullptr) {
         return nullptr;
     }
 
+    /*
+     * Parse product information.
+     */
+    target->_product = Product::Open(filesystem, target->_path);
+
+    return target;
+}
+
+Target::shared_ptr Target::
+Load(std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, plist::Dictionary const *snapshot)
+{
+    auto P  = snapshot->value<plist::String>("Path");
+    auto C  = snapshot->value<plist::Dictionary>("Contents");
+    auto Pr = snapshot->value<plist::Dictionary>("Product");
+    if (P == nullptr || C == nullptr) {
+        return nullptr;
+    }
+
+    auto target = Create(manager, platform, P->value(), C->copy());
+    if (target == nullptr) {
+        return nullptr;
+    }
+
+    if (Pr != nullptr) {
+        target->_product = Product::Load(Pr);
+        if (target->_product == nullptr) {
+            return nullptr;
+        }
+    }
+
+    return target;
+}
+
+Target::shared_ptr Target::
+Create(std::shared_ptr<Manager> manager, std::shared_ptr<Platform> platform, std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist)
+{
     /*
      * Create the target object.
      */
     auto target = std::make_shared<Target>();
     target->_manager  = manager;
     target->_platform = platform;
-    target->_path       = FSUtil::GetDirectoryName(realPath);
-    target->_bundleName = FSUtil::GetBaseName(realPath);
+    target->_path       = FSUtil::GetDirectoryName(plistPath);
+    target->_bundleName = FSUtil::GetBaseName(plistPath);
 
     /*
      * Parse the settings dictionary.
      */
-    if (!target->parse(plist)) {
+    if (!target->parse(plist.get())) {
         return nullptr;
     }
 
-    /*
-     * Parse product information.
-     */
-    target->_product = Product::Open(filesystem, target->_path);
+    target->_plistPath = plistPath;
+    target->_plist = std::move(plist);
 
     return target;
 }
+
+void Target::
+dependencies(std::vector<std::string> *dependencies) const
+{
+    /* The directory as well, as adding SDKSettings.plist would replace Info.plist. */
+    dependencies->push_back(_path);
+    dependencies->push_back(_plistPath);
+
+    if (_product != nullptr) {
+        _product->dependencies(dependencies);
+    }
+}
+
+std::unique_ptr<plist::Dictionary> Target::
+snapshot() const
+{
+    auto snapshot = plist::Dictionary::New();
+    snapshot->set("Path", plist::String::New(_plistPath));
+    snapshot->set("Contents", _plist->copy());
+    if (_product != nullptr) {
+        snapshot->set("Product", _product->snapshot());
+    }
+    return snapshot;
+}
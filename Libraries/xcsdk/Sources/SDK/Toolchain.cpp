@@ -168,28 +168,65 @@ Open(Filesystem const *filesystem, std::string const &path)
         return nullptr;
     }
 
-    plist::Dictionary *plist = plist::CastTo<plist::Dictionary>(result.first.get());
-    if (plist == nullptr) {
+    if (plist::CastTo<plist::Dictionary>(result.first.get()) == nullptr) {
         return nullptr;
     }
 
+    return Create(realPath, plist::static_unique_pointer_cast<plist::Dictionary>(std::move(result.first)));
+}
+
+Toolchain::shared_ptr Toolchain::
+Load(plist::Dictionary const *snapshot)
+{
+    auto P = snapshot->value<plist::String>("Path");
+    auto C = snapshot->value<plist::Dictionary>("Contents");
+    if (P == nullptr || C == nullptr) {
+        return nullptr;
+    }
+
+    return Create(P->value(), C->copy());
+}
+
+Toolchain::shared_ptr Toolchain::
+Create(std::string const &plistPath, std::unique_ptr<plist::Dictionary> plist)
+{
     /*
      * Create the toolchain object.
      */
     auto toolchain = std::make_shared<Toolchain>();
-    toolchain->_path = FSUtil::GetDirectoryName(realPath);
+    toolchain->_path = FSUtil::GetDirectoryName(plistPath);
     toolchain->_name = FSUtil::GetBaseNameWithoutExtension(toolchain->_path);
 
     /*
      * Parse the toolchain dictionary.
      */
-    if (!toolchain->parse(plist)) {
+    if (!toolchain->parse(plist.get())) {
         return nullptr;
     }
 
+    toolchain->_plistPath = plistPath;
+    toolchain->_plist = std::move(plist);
+
     return toolchain;
 }
 
+void Toolchain::
+dependencies(std::vector<std::string> *dependencies) const
+{
+    /* The directory as well, as adding ToolchainInfo.plist would replace Info.plist. */
+    dependencies->push_back(_path);
+    dependencies->push_back(_plistPath);
+}
+
+std::unique_ptr<plist::Dictionary> Toolchain::
+snapshot() const
+{
+    auto snapshot = plist::Dictionary::New();
+    snapshot->set("Path", plist::String::New(_plistPath));
+    snapshot->set("Contents", _plist->copy());
+    return snapshot;
+}
+
 std::string Toolchain::
 DefaultIdentifier(void)
 {
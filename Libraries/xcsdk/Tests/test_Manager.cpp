@@ -12,10 +12,12 @@
 #include <xcsdk/SDK/Platform.h>
 #include <xcsdk/SDK/Toolchain.h>
 #include <libutil/MemoryFilesystem.h>
+#include <plist/Dictionary.h>
 
 using xcsdk::Configuration;
 using xcsdk::SDK::Manager;
 using xcsdk::SDK::Platform;
+using xcsdk::SDK::Target;
 using xcsdk::SDK::Toolchain;
 using libutil::MemoryFilesystem;
 
@@ -58,3 +60,88 @@ TEST(Manager, ConfigurationExtraPaths)
     Toolchain::shared_ptr const &toolchain = manager->toolchains().front();
     EXPECT_EQ(toolchain->identifier(), std::string("extra"));
 }
+
+static MemoryFilesystem
+DeveloperFilesystem()
+{
+    return MemoryFilesystem({
+        MemoryFilesystem::Entry::Directory("Platforms", {
+            MemoryFilesystem::Entry::Directory("Test.platform", {
+                MemoryFilesystem::Entry::File("Info.plist", Contents("{ Identifier = test; Name = test; }")),
+                MemoryFilesystem::Entry::Directory("Developer", {
+                    MemoryFilesystem::Entry::Directory("SDKs", {
+                        MemoryFilesystem::Entry::Directory("Test1.0.sdk", {
+                            MemoryFilesystem::Entry::File("SDKSettings.plist", Contents("{ CanonicalName = test1.0; Toolchains = ( test ); }")),
+                        }),
+                    }),
+                }),
+            }),
+        }),
+        MemoryFilesystem::Entry::Directory("Toolchains", {
+            MemoryFilesystem::Entry::Directory("Test.xctoolchain", {
+                MemoryFilesystem::Entry::File("ToolchainInfo.plist", Contents("{ Identifier = test; }")),
+            }),
+        }),
+    });
+}
+
+TEST(Manager, Snapshot)
+{
+    auto filesystem = DeveloperFilesystem();
+
+    auto manager = Manager::Open(&filesystem, filesystem.path(""), ext::nullopt);
+    ASSERT_NE(nullptr, manager);
+    std::unique_ptr<plist::Dictionary> snapshot = manager->snapshot(&filesystem);
+
+    /* Loaded unchanged, including links between targets and toolchains. */
+    auto loaded = Manager::Load(&filesystem, snapshot.get(), filesystem.path(""), ext::nullopt);
+    ASSERT_NE(nullptr, loaded);
+    ASSERT_EQ(1, loaded->toolchains().size());
+    ASSERT_EQ(1, loaded->platforms().size());
+    Target::shared_ptr target = loaded->findTarget(nullptr, "test1.0");
+    ASSERT_NE(nullptr, target);
+    EXPECT_EQ(manager->platforms().front()->path(), target->platform()->path());
+    ASSERT_EQ(1, target->toolchains().size());
+    EXPECT_EQ(loaded->toolchains().front(), target->toolchains().front());
+
+    /* Not for another developer root or configuration. */
+    EXPECT_EQ(nullptr, Manager::Load(&filesystem, snapshot.get(), filesystem.path("Other"), ext::nullopt));
+    EXPECT_EQ(nullptr, Manager::Load(&filesystem, snapshot.get(), filesystem.path(""), Configuration({ filesystem.path("ExtraPlatforms") }, { })));
+
+    /* Adding an SDK invalidates the snapshot. */
+    ASSERT_TRUE(filesystem.createDirectory(filesystem.path("Platforms/Test.platform/Developer/SDKs/Test2.0.sdk"), false));
+    ASSERT_TRUE(filesystem.write(Contents("{ CanonicalName = test2.0; }"), filesystem.path("Platforms/Test.platform/Developer/SDKs/Test2.0.sdk/SDKSettings.plist")));
+    EXPECT_EQ(nullptr, Manager::Load(&filesystem, snapshot.get(), filesystem.path(""), ext::nullopt));
+
+    /* Creating a missing search directory invalidates the snapshot. */
+    auto configuration = Configuration({ filesystem.path("ExtraPlatforms") }, { });
+    manager = Manager::Open(&filesystem, filesystem.path(""), configuration);
+    ASSERT_NE(nullptr, manager);
+    snapshot = manager->snapshot(&filesystem);
+    EXPECT_NE(nullptr, Manager::Load(&filesystem, snapshot.get(), filesystem.path(""), configuration));
+    ASSERT_TRUE(filesystem.createDirectory(filesystem.path("ExtraPlatforms"), false));
+    EXPECT_EQ(nullptr, Manager::Load(&filesystem, snapshot.get(), filesystem.path(""), configuration));
+}
+
+TEST(Manager, SnapshotPath)
+{
+    auto filesystem = DeveloperFilesystem();
+    std::string snapshotPath = filesystem.path("Cache/sdk_snapshot.plist");
+
+    /* Written on first use, then used until something changes. */
+    auto cold = Manager::Open(&filesystem, filesystem.path(""), ext::nullopt, snapshotPath);
+    ASSERT_NE(nullptr, cold);
+    EXPECT_TRUE(filesystem.exists(snapshotPath));
+    ext::optional<uint64_t> written = filesystem.modificationTime(snapshotPath);
+
+    auto warm = Manager::Open(&filesystem, filesystem.path(""), ext::nullopt, snapshotPath);
+    ASSERT_NE(nullptr, warm);
+    EXPECT_NE(nullptr, warm->findTarget(nullptr, "test1.0"));
+    EXPECT_EQ(written, filesystem.modificationTime(snapshotPath));
+
+    ASSERT_TRUE(filesystem.write(Contents("{ Identifier = changed; }"), filesystem.path("Toolchains/Test.xctoolchain/ToolchainInfo.plist")));
+    auto changed = Manager::Open(&filesystem, filesystem.path(""), ext::nullopt, snapshotPath);
+    ASSERT_NE(nullptr, changed);
+    EXPECT_NE(nullptr, changed->findToolchain(nullptr, "changed"));
+    EXPECT_NE(written, filesystem.modificationTime(snapshotPath));
+}
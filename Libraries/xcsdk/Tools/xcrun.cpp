@@ -13,6 +13,7 @@
 #include <libutil/DefaultFilesystem.h>
 #include <libutil/Filesystem.h>
 #include <libutil/FSUtil.h>
+#include <libutil/MappedFile.h>
 #include <libutil/Options.h>
 #include <process/Context.h>
 #include <process/DefaultContext.h>
@@ -22,10 +23,14 @@
 #include <process/User.h>
 #include <process/DefaultUser.h>
 #include <pbxsetting/Type.h>
+#include <plist/Dictionary.h>
+#include <plist/String.h>
+#include <plist/Format/Binary.h>
 
 using libutil::DefaultFilesystem;
 using libutil::Filesystem;
 using libutil::FSUtil;
+using libutil::MappedFile;
 
 class Options {
 private:
@@ -209,8 +214,8 @@ Help(std::string const &error = std::string())
     fprintf(stderr, "Options:\n");
     fprintf(stderr, INDENT "-v, --verbose\n");
     fprintf(stderr, INDENT "-l, --log\n");
-    fprintf(stderr, INDENT "-n, --no-cache (not implemented)\n");
-    fprintf(stderr, INDENT "-k, --kill-cache (not implemented)\n");
+    fprintf(stderr, INDENT "-n, --no-cache (don't use or update cached lookups)\n");
+    fprintf(stderr, INDENT "-k, --kill-cache (remove cached lookups)\n");
 #undef INDENT
 
     return (error.empty() ? 0 : -1);
@@ -223,6 +228,148 @@ Version()
     return 0;
 }
 
+/*
+ * The lookup cache and the SDK snapshot are only used if a path is given for
+ * them. Nothing is written otherwise, so xcrun never writes to a directory
+ * that wasn't asked for, such as a read-only or shared home directory.
+ */
+static ext::optional<std::string>
+LookupCachePath(process::Context const *processContext)
+{
+    if (ext::optional<std::string> path = processContext->environmentVariable("XCRUN_CACHE_PATH")) {
+        if (!path->empty()) {
+            return path;
+        }
+    }
+
+    return ext::nullopt;
+}
+
+static ext::optional<std::string>
+SDKSnapshotPath(process::Context const *processContext)
+{
+    /* Shared with xcbuild, which loads the same developer root. */
+    if (ext::optional<std::string> path = processContext->environmentVariable("XCBUILD_SDK_SNAPSHOT_PATH")) {
+        if (!path->empty()) {
+            return path;
+        }
+    }
+
+    return ext::nullopt;
+}
+
+/*
+ * Cached lookups, keyed by everything that determines which tool is found.
+ * Each lookup also records the modification time of the developer root's
+ * contents and of each directory searched for the tool, so it is only used
+ * if neither the available SDKs nor the tools in those directories changed.
+ */
+static std::unique_ptr<plist::Dictionary>
+LoadLookupCache(Filesystem const *filesystem, std::string const &path)
+{
+    std::unique_ptr<MappedFile> contents = (filesystem->isReadable(path) ? filesystem->map(path) : nullptr);
+    if (contents != nullptr) {
+        /* A cache that can't be read, say from another version, is started over. */
+        auto deserialized = plist::Format::Binary::Deserialize(contents->data(), contents->size(), plist::Format::Binary::Create());
+        if (plist::CastTo<plist::Dictionary>(deserialized.first.get()) != nullptr) {
+            return plist::static_unique_pointer_cast<plist::Dictionary>(std::move(deserialized.first));
+        }
+    }
+
+    return plist::Dictionary::New();
+}
+
+/*
+ * The SDK as finding it sees it. An SDK can be given by name or by path, and
+ * a relative path finds a different SDK from each directory, so paths are
+ * made absolute and resolved; a name is kept along with any path it names.
+ */
+static std::string
+CanonicalSDK(Filesystem const *filesystem, std::string const &currentDirectory, std::string const &SDK)
+{
+    std::string absolute = FSUtil::NormalizePath(FSUtil::ResolveRelativePath(SDK, currentDirectory));
+    std::string path = filesystem->resolvePath(absolute);
+    if (SDK.find('/') != std::string::npos) {
+        return (!path.empty() ? path : absolute);
+    }
+
+    return SDK + "\t" + path;
+}
+
+static std::string
+LookupCacheKey(
+    std::string const &developerRoot,
+    ext::optional<std::string> const &SDK,
+    ext::optional<std::string> const &toolchainsInput,
+    bool toolchainSpecified,
+    std::string const &tool,
+    std::vector<std::string> const &defaultExecutablePaths)
+{
+    std::string key = developerRoot;
+    key += "\n" + SDK.value_or("");
+    key += "\n" + std::string(toolchainSpecified ? "toolchain:" : "TOOLCHAINS:") + toolchainsInput.value_or("");
+    key += "\n" + tool;
+    for (std::string const &path : defaultExecutablePaths) {
+        key += "\n" + path;
+    }
+    return key;
+}
+
+static int
+RunTool(
+    Filesystem *filesystem,
+    process::Context const *processContext,
+    process::Launcher *processLauncher,
+    Options const &options,
+    std::string const &executable,
+    ext::optional<std::string> const &SDKROOT,
+    bool verbose,
+    bool log)
+{
+    if (options.find()) {
+        /*
+         * Just find the tool; i.e. print its path.
+         */
+        printf("%s\n", executable.c_str());
+        return 0;
+    } else {
+        /* Run is the default. */
+
+        std::unordered_map<std::string, std::string> environment = processContext->environmentVariables();
+
+        if (SDKROOT) {
+            /*
+             * Update effective environment to include the target path.
+             */
+            environment["SDKROOT"] = *SDKROOT;
+            if (log) {
+                printf("env SDKROOT=%s %s\n", SDKROOT->c_str(), executable.c_str());
+            }
+        }
+
+        /*
+         * Execute the process!
+         */
+        if (verbose) {
+            printf("verbose: executing tool: %s\n", executable.c_str());
+        }
+
+        process::MemoryContext context = process::MemoryContext(
+            executable,
+            processContext->currentDirectory(),
+            options.args(),
+            environment);
+
+        ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
+        if (!exitCode) {
+            fprintf(stderr, "error: unable to execute tool '%s'\n", options.tool()->c_str());
+            return -1;
+        }
+
+        return *exitCode;
+    }
+}
+
 static int Run(Filesystem *filesystem, process::User const *user, process::Context const *processContext, process::Launcher *processLauncher)
 {
     /*
@@ -263,23 +410,78 @@ static int Run(Filesystem *filesystem, process::User const *user, process::Conte
     bool log = options.log() || (bool)processContext->environmentVariable("xcrun_log");
     bool nocache = options.noCache() || (bool)processContext->environmentVariable("xcrun_nocache");
 
+    bool showSDKValue = options.showSDKPath() ||
+        options.showSDKVersion() ||
+        options.showSDKBuildVersion() ||
+        options.showSDKPlatformPath() ||
+        options.showSDKPlatformVersion();
+
     /*
-     * Warn about unhandled arguments.
+     * Killing the cache removes all cached lookups. Unless also disabled,
+     * the cache is then rebuilt as tools are found.
      */
-    if (nocache || options.killCache()) {
-        fprintf(stderr, "warning: cache options not implemented\n");
+    ext::optional<std::string> lookupCachePath = LookupCachePath(processContext);
+    ext::optional<std::string> snapshotPath = SDKSnapshotPath(processContext);
+    if (options.killCache()) {
+        for (ext::optional<std::string> const &path : { lookupCachePath, snapshotPath }) {
+            if (path && filesystem->exists(*path) && !filesystem->removeFile(*path)) {
+                fprintf(stderr, "warning: unable to remove cache '%s'\n", path->c_str());
+            }
+        }
+    }
+    if (nocache) {
+        lookupCachePath = ext::nullopt;
+        snapshotPath = ext::nullopt;
     }
 
-    /*
-     * Load the SDK manager from the developer root.
-     */
     ext::optional<std::string> developerRoot = xcsdk::Environment::DeveloperRoot(user, processContext, filesystem);
     if (!developerRoot) {
         fprintf(stderr, "error: unable to find developer root\n");
         return -1;
     }
-    auto configuration = xcsdk::Configuration::Load(filesystem, xcsdk::Configuration::DefaultPaths(user, processContext));
-    auto manager = xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration);
+
+    /*
+     * Use a cached lookup if nothing it depends on has changed. This avoids
+     * loading the developer root at all.
+     */
+    std::unique_ptr<plist::Dictionary> lookupCache;
+    std::string lookupCacheKey;
+    if (lookupCachePath && !showSDKValue && options.tool()) {
+        lookupCache = LoadLookupCache(filesystem, *lookupCachePath);
+        ext::optional<std::string> canonicalSDK = (SDK ? ext::make_optional(CanonicalSDK(filesystem, processContext->currentDirectory(), *SDK)) : ext::nullopt);
+        lookupCacheKey = LookupCacheKey(*developerRoot, canonicalSDK, toolchainsInput, toolchainSpecified, *options.tool(), processContext->executableSearchPaths());
+
+        if (plist::Dictionary const *entry = lookupCache->value<plist::Dictionary>(lookupCacheKey)) {
+            plist::String const *executable = entry->value<plist::String>("Executable");
+            plist::String const *SDKROOT = entry->value<plist::String>("SDKROOT");
+            plist::Dictionary const *dependencies = entry->value<plist::Dictionary>("Dependencies");
+
+            if (executable != nullptr && dependencies != nullptr && xcsdk::SDK::Manager::ValidDependencies(filesystem, dependencies)) {
+                if (verbose) {
+                    fprintf(stderr, "verbose: using cached tool '%s': %s\n", options.tool()->c_str(), executable->value().c_str());
+                }
+
+                return RunTool(
+                    filesystem,
+                    processContext,
+                    processLauncher,
+                    options,
+                    executable->value(),
+                    SDKROOT != nullptr ? ext::make_optional(SDKROOT->value()) : ext::nullopt,
+                    verbose,
+                    log);
+            }
+        }
+    }
+
+    /*
+     * Load the SDK manager from the developer root.
+     */
+    std::vector<std::string> configurationPaths = xcsdk::Configuration::DefaultPaths(user, processContext);
+    auto configuration = xcsdk::Configuration::Load(filesystem, configurationPaths);
+    auto manager = (snapshotPath ?
+        xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration, *snapshotPath) :
+        xcsdk::SDK::Manager::Open(filesystem, *developerRoot, configuration));
     if (manager == nullptr) {
         fprintf(stderr, "error: unable to load manager from '%s'\n", developerRoot->c_str());
         return -1;
@@ -288,12 +490,6 @@ static int Run(Filesystem *filesystem, process::User const *user, process::Conte
         fprintf(stderr, "verbose: using developer root '%s'\n", manager->path().c_str());
     }
 
-    bool showSDKValue = options.showSDKPath() ||
-        options.showSDKVersion() ||
-        options.showSDKBuildVersion() ||
-        options.showSDKPlatformPath() ||
-        options.showSDKPlatformVersion();
-
     /*
      * Determine the SDK to use.
      */
@@ -419,48 +615,44 @@ static int Run(Filesystem *filesystem, process::User const *user, process::Conte
             fprintf(stderr, "verbose: resolved tool '%s' to: %s\n", options.tool()->c_str(), executable->c_str());
         }
 
-        if (options.find()) {
-            /*
-             * Just find the tool; i.e. print its path.
-             */
-            printf("%s\n", executable->c_str());
-            return 0;
-        } else {
-            /* Run is the default. */
-
-            std::unordered_map<std::string, std::string> environment = processContext->environmentVariables();
+        /*
+         * Cache the lookup for next time. Other lookups may have been cached
+         * since this one started, so add to the cache as it is now rather than
+         * as it was loaded. Lookups cached between that read and the write are
+         * still lost, as the last write wins, but they are found again next time.
+         */
+        if (lookupCache != nullptr) {
+            std::vector<std::string> dependencies = manager->dependencies();
+            dependencies.insert(dependencies.end(), configurationPaths.begin(), configurationPaths.end());
+            dependencies.insert(dependencies.end(), executablePaths.begin(), executablePaths.end());
 
+            auto entry = plist::Dictionary::New();
+            entry->set("Executable", plist::String::New(*executable));
             if (target != nullptr) {
-                /*
-                 * Update effective environment to include the target path.
-                 */
-                environment["SDKROOT"] = target->path();
-                if (log) {
-                    printf("env SDKROOT=%s %s\n", target->path().c_str(), executable->c_str());
-                }
-            }
-
-            /*
-             * Execute the process!
-             */
-            if (verbose) {
-                printf("verbose: executing tool: %s\n", executable->c_str());
+                entry->set("SDKROOT", plist::String::New(target->path()));
             }
+            entry->set("Dependencies", xcsdk::SDK::Manager::RecordDependencies(filesystem, dependencies));
 
-            process::MemoryContext context = process::MemoryContext(
-                *executable,
-                processContext->currentDirectory(),
-                options.args(),
-                environment);
+            lookupCache = LoadLookupCache(filesystem, *lookupCachePath);
+            lookupCache->set(lookupCacheKey, std::move(entry));
 
-            ext::optional<int> exitCode = processLauncher->launch(filesystem, &context);
-            if (!exitCode) {
-                fprintf(stderr, "error: unable to execute tool '%s'\n", options.tool()->c_str());
-                return -1;
+            auto serialized = plist::Format::Binary::Serialize(lookupCache.get(), plist::Format::Binary::Create());
+            if (serialized.first == nullptr ||
+                !filesystem->createDirectory(FSUtil::GetDirectoryName(*lookupCachePath), true) ||
+                !filesystem->replace(*serialized.first, *lookupCachePath)) {
+                fprintf(stderr, "warning: unable to write cache '%s'\n", lookupCachePath->c_str());
             }
-
-            return *exitCode;
         }
+
+        return RunTool(
+            filesystem,
+            processContext,
+            processLauncher,
+            options,
+            *executable,
+            target != nullptr ? ext::make_optional(target->path()) : ext::nullopt,
+            verbose,
+            log);
     }
 }
 
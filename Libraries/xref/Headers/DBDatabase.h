@@ -11,14 +11,21 @@
 
 #include <SQLiteModern.h>
 #include <any>
+#include <memory>
 #include <sqlite3.h>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <variant>
+#include <vector>
 
 namespace plugin {
 
 typedef int(*sqlite_callback_t)(void*,int,char**,char**);
 
+class DBInserter;
+
 class DBDatabase {
 
 public:
@@ -38,6 +45,22 @@ public:
     void query(const std::string& query);
 
     int lastRowId(){ return (int)m_db.last_insert_rowid(); };
+    // The database file, or an empty string if it is in memory.
+    std::string path(){ const char* path = sqlite3_db_filename(m_db.connection().get(), "main"); return path ? path : ""; };
+    // Rows changed by the last INSERT, UPDATE, or DELETE.
+    int changes(){ return sqlite3_changes(m_db.connection().get()); };
+
+    // Prepares a statement once, to bind and execute it many times. Unlike
+    // statements made by m_db << sql, it is only executed when asked to.
+    sqlite::database_binder prepare(const std::string& sql);
+    // Inserts rows into a table in batches; see DBInserter.
+    DBInserter inserter(const std::string& table, const std::vector<std::string>& columns,
+                        size_t batchRows, size_t commitRows);
+
+    // Bulk loads trade durability for speed: WAL journaling, and no sync
+    // on commit. Both must be called outside of a transaction.
+    void beginBulkLoad();
+    void endBulkLoad();
 
     template<typename T>
     T getProperty(const std::string& build, const std::string& project, const std::string& property);
@@ -64,6 +87,55 @@ private:
     
     std::atomic_int __nestedTransactions;
     sqlite::database m_db;
+    std::string m_journalMode;
+    int m_synchronous;
+};
+
+//
+// Inserts rows into one table through prepared statements. Rows are
+// buffered and written batchRows at a time by a single multi-row
+// INSERT ... VALUES (...),(...) statement, prepared once; the rows
+// left over at flush() are written by a statement prepared for that
+// count. If commitRows is not 0 and a transaction is open, it is
+// committed and reopened after about every commitRows rows.
+//
+// Values are integers, text, or nullptr for NULL. Call flush() once
+// done, so that a failure to write the last rows is thrown to the
+// caller: the destructor never writes, and drops any rows still
+// buffered.
+//
+class DBInserter {
+public:
+    typedef std::variant<std::nullptr_t, sqlite3_int64, std::string> Value;
+
+    DBInserter(sqlite::database& db, const std::string& table, const std::vector<std::string>& columns,
+               size_t batchRows, size_t commitRows);
+    DBInserter(DBInserter&& other) = default;
+    ~DBInserter();
+
+    template<typename... Values>
+    void insert(const Values&... values);
+    void flush();
+
+    // Rows written so far, not counting buffered rows.
+    uint64_t rows() const { return m_rows; }
+
+private:
+    template<typename T>
+    static Value value(const T& v);
+    std::string statement(size_t rows) const;
+    void write(sqlite::database_binder& statement, size_t rows);
+
+    sqlite::database& m_db;
+    std::string m_table;
+    std::vector<std::string> m_columns;
+    size_t m_batchRows;
+    size_t m_commitRows;
+    std::unique_ptr<sqlite::database_binder> m_batch;
+    std::vector<Value> m_pending;
+    uint64_t m_rows;
+    uint64_t m_uncommitted;
+    int m_uncaught;
 };
 
 
@@ -149,6 +221,32 @@ DBDatabase::queryArray(const std::string& query){
     return result;
 }
 
+template<typename T> DBInserter::Value
+DBInserter::value(const T& v){
+    if constexpr (std::is_same_v<T, std::nullptr_t>) {
+        return nullptr;
+    } else if constexpr (std::is_same_v<T, char>) {
+        return std::string(1, v); // a character is stored as text, like '%c'
+    } else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+        return (sqlite3_int64)v;
+    } else {
+        return std::string(v);
+    }
+}
+
+template<typename... Values> void
+DBInserter::insert(const Values&... values){
+    if (sizeof...(values) != m_columns.size()) {
+        throw std::invalid_argument("DBInserter: " + std::to_string(sizeof...(values)) +
+                                    " values for " + std::to_string(m_columns.size()) +
+                                    " columns of " + m_table);
+    }
+    (m_pending.push_back(value(values)), ...);
+    if (m_pending.size() == m_batchRows * m_columns.size()) {
+        flush();
+    }
+}
+
 } // namespace plugin
 
 #endif /* DBManager_hpp */
@@ -0,0 +1,106 @@
+//
+//  SymbolIndex.h
+//  libxref
+//
+//  Copyright © 2021 The PureDarwin Project. All rights reserved.
+//
+
+#ifndef SymbolIndex_hpp
+#define SymbolIndex_hpp
+
+#include <DBDatabase.h>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace plugin {
+
+//
+// An index of the external symbols of the Mach-O objects of a build, as
+// recorded in mach_o_symbols by registerFiles.
+//
+// Symbol names are interned once each, and numbered in sorted order, so
+// a name is found by binary search. Each object has a sorted array of the
+// symbols it defines and one of the symbols it imports (type 'U'), and
+// each symbol has the inverse: the objects defining it and the objects
+// importing it. Objects are numbered in order of serial.
+//
+// The index is one flat buffer, stored in a file beside the database
+// (<database>.<build>.symbols) and mapped into memory to be used in place,
+// so opening it doesn't depend on its size. It is rebuilt when the build's
+// objects change: serials are never reused, so the count and the highest
+// serial of the objects identify the objects it was built from.
+//
+class SymbolIndex {
+public:
+    // Loads the index of a build, first building and storing it if it is
+    // missing or out of date. Returns null if nothing is registered.
+    static std::unique_ptr<SymbolIndex> Open(DBDatabase& db, const std::string& build);
+
+    // Builds the index of a build from mach_o_symbols.
+    static std::unique_ptr<SymbolIndex> Build(DBDatabase& db, const std::string& build);
+
+    // Maps a stored index, or returns null if it isn't valid.
+    static std::unique_ptr<SymbolIndex> Load(const std::string& path);
+
+    ~SymbolIndex();
+
+public:
+    uint32_t symbolCount() const { return m_symbols; }
+    uint32_t objectCount() const { return m_objects; }
+
+    // The symbol with a name, if any object defines or imports it.
+    std::optional<uint32_t> find(std::string_view name) const;
+    std::string_view name(uint32_t symbol) const;
+
+    // The serial in mach_o_objects of an object.
+    sqlite3_int64 serial(uint32_t object) const { return m_serials[object]; }
+
+    // Sorted symbols of an object.
+    std::span<const uint32_t> defined(uint32_t object) const;
+    std::span<const uint32_t> undefined(uint32_t object) const;
+
+    // Sorted objects defining or importing a symbol.
+    std::span<const uint32_t> definers(uint32_t symbol) const;
+    std::span<const uint32_t> importers(uint32_t symbol) const;
+
+    // Stores the index, replacing the file at path all at once.
+    bool write(const std::string& path) const;
+
+    // Prints the project and path of each object a lookup (definers or
+    // importers) gives for each named symbol, opening the build's index
+    // as Open does. Returns 1 if any name has none, or nothing is
+    // registered.
+    static int PrintObjects(DBDatabase& db, const std::string& build, const std::vector<std::string>& names,
+                            std::span<const uint32_t> (SymbolIndex::*objects)(uint32_t) const);
+
+private:
+    SymbolIndex();
+    bool map(const uint8_t* base, size_t size);
+
+    std::vector<uint8_t> m_data;
+    void* m_mapping;
+    const uint8_t* m_base;
+    size_t m_size;
+    uint32_t m_symbols;
+    uint32_t m_objects;
+    const sqlite3_int64* m_serials;
+    const uint32_t* m_nameOffsets;
+    const char* m_names;
+    const uint32_t* m_definedOffsets;
+    const uint32_t* m_defined;
+    const uint32_t* m_undefinedOffsets;
+    const uint32_t* m_undefined;
+    const uint32_t* m_definerOffsets;
+    const uint32_t* m_definers;
+    const uint32_t* m_importerOffsets;
+    const uint32_t* m_importers;
+};
+
+} // namespace plugin
+
+#endif /* SymbolIndex_hpp */
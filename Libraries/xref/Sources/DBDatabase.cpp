@@ -6,6 +6,8 @@
 //  Copyright © 2021 The PureDarwin Project. All rights reserved.
 //
 
+#include <algorithm>
+#include <exception>
 #include <iomanip>
 #include <iostream>
 #include <stdexcept>
@@ -14,7 +16,7 @@
 
 namespace plugin {
 
-DBDatabase::DBDatabase(const std::string& db) : m_db(db)
+DBDatabase::DBDatabase(const std::string& db) : m_db(db), m_synchronous(-1)
 {
     std::atomic_init(&__nestedTransactions, 0);
 }
@@ -112,4 +114,119 @@ DBDatabase::query(const std::string& query){
     m_db << query;
 }
 
+sqlite::database_binder
+DBDatabase::prepare(const std::string& sql){
+    sqlite::database_binder statement = m_db << sql;
+    statement.used(true); // don't execute it unbound when it goes away
+    return statement;
+}
+
+DBInserter
+DBDatabase::inserter(const std::string& table, const std::vector<std::string>& columns,
+                     size_t batchRows, size_t commitRows){
+    return DBInserter(m_db, table, columns, batchRows, commitRows);
+}
+
+void
+DBDatabase::beginBulkLoad(){
+    if (m_synchronous >= 0)
+        return;
+    m_db << "PRAGMA journal_mode" >> m_journalMode;
+    m_db << "PRAGMA synchronous" >> m_synchronous;
+    std::string mode;
+    m_db << "PRAGMA journal_mode=WAL" >> mode;
+    m_db << "PRAGMA synchronous=OFF";
+}
+
+void
+DBDatabase::endBulkLoad(){
+    if (m_synchronous < 0)
+        return;
+    m_db << "PRAGMA synchronous=" + std::to_string(m_synchronous);
+    std::string mode;
+    m_db << "PRAGMA journal_mode=" + m_journalMode >> mode;
+    m_synchronous = -1;
+}
+
+DBInserter::DBInserter(sqlite::database& db, const std::string& table, const std::vector<std::string>& columns,
+                       size_t batchRows, size_t commitRows)
+    : m_db(db), m_table(table), m_columns(columns), m_batchRows(batchRows), m_commitRows(commitRows),
+      m_rows(0), m_uncommitted(0), m_uncaught(std::uncaught_exceptions())
+{
+    if (m_columns.empty()) {
+        throw std::invalid_argument("DBInserter: no columns for " + m_table);
+    }
+
+    // A statement can only have so many parameters.
+    size_t variables = (size_t)sqlite3_limit(m_db.connection().get(), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+    m_batchRows = std::max<size_t>(1, std::min(m_batchRows, variables / m_columns.size()));
+    m_pending.reserve(m_batchRows * m_columns.size());
+}
+
+DBInserter::~DBInserter(){
+    // Buffered rows are only written by flush(), which can report failure.
+    // Dropping them while unwinding is expected; otherwise it's a bug.
+    if (!m_pending.empty() && std::uncaught_exceptions() == m_uncaught) {
+        std::cerr << "warning: " << m_pending.size() / m_columns.size()
+                  << " rows for " << m_table << " were never flushed" << std::endl;
+    }
+}
+
+std::string
+DBInserter::statement(size_t rows) const {
+    std::string row = "(";
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        row += (i == 0 ? "?" : ",?");
+    }
+    row += ")";
+
+    std::string sql = "INSERT INTO " + m_table + " (";
+    for (size_t i = 0; i < m_columns.size(); ++i) {
+        sql += (i == 0 ? "" : ",") + m_columns[i];
+    }
+    sql += ") VALUES ";
+    for (size_t i = 0; i < rows; ++i) {
+        sql += (i == 0 ? "" : ",") + row;
+    }
+    return sql;
+}
+
+void
+DBInserter::write(sqlite::database_binder& statement, size_t rows){
+    for (const Value& value : m_pending) {
+        std::visit([&](const auto& v) { statement << v; }, value);
+    }
+    statement.execute();
+    m_pending.clear();
+    m_rows += rows;
+    m_uncommitted += rows;
+
+    // Only commit a transaction the caller opened, and leave it open.
+    if (m_commitRows != 0 && m_uncommitted >= m_commitRows &&
+        !sqlite3_get_autocommit(m_db.connection().get())) {
+        m_db << "COMMIT";
+        m_db << "BEGIN";
+        m_uncommitted = 0;
+    }
+}
+
+void
+DBInserter::flush(){
+    size_t rows = m_pending.size() / m_columns.size();
+    if (rows == 0)
+        return;
+
+    if (rows == m_batchRows) {
+        if (!m_batch) {
+            m_batch = std::make_unique<sqlite::database_binder>(m_db << statement(m_batchRows));
+            m_batch->used(true);
+        }
+        write(*m_batch, rows);
+    } else {
+        sqlite::database_binder partial = m_db << statement(rows);
+        partial.used(true);
+        write(partial, rows);
+    }
+}
+
 } // namespace plugin
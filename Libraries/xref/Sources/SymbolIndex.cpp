@@ -0,0 +1,417 @@
+//
+//  SymbolIndex.cpp
+//  libxref
+//
+//  Copyright © 2021 The PureDarwin Project. All rights reserved.
+//
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include <SymbolIndex.h>
+
+namespace plugin {
+
+namespace {
+
+const char     IndexMagic[4] = { 'X', 'S', 'Y', 'M' };
+const uint32_t IndexVersion  = 1;
+
+struct IndexHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t symbols;
+    uint32_t objects;
+    uint32_t defined;    // entries of all objects' defined arrays
+    uint32_t undefined;  // entries of all objects' undefined arrays
+    uint64_t nameBytes;
+};
+
+// Where each array starts in the buffer; each is 8-byte aligned.
+struct IndexLayout {
+    size_t serials, nameOffsets, names;
+    size_t definedOffsets, defined, undefinedOffsets, undefined;
+    size_t definerOffsets, definers, importerOffsets, importers;
+    size_t size;
+
+    IndexLayout(const IndexHeader& header) : size(sizeof(IndexHeader)) {
+        serials          = section(sizeof(sqlite3_int64) * header.objects);
+        nameOffsets      = section(sizeof(uint32_t) * ((size_t)header.symbols + 1));
+        names            = section(header.nameBytes);
+        definedOffsets   = section(sizeof(uint32_t) * ((size_t)header.objects + 1));
+        defined          = section(sizeof(uint32_t) * header.defined);
+        undefinedOffsets = section(sizeof(uint32_t) * ((size_t)header.objects + 1));
+        undefined        = section(sizeof(uint32_t) * header.undefined);
+        definerOffsets   = section(sizeof(uint32_t) * ((size_t)header.symbols + 1));
+        definers         = section(sizeof(uint32_t) * header.defined);
+        importerOffsets  = section(sizeof(uint32_t) * ((size_t)header.symbols + 1));
+        importers        = section(sizeof(uint32_t) * header.undefined);
+    }
+
+    size_t section(size_t bytes) {
+        size_t start = size;
+        size = (size + bytes + 7) & ~(size_t)7;
+        return start;
+    }
+};
+
+// Fills offsets and values of arrays of values, grouped by key, from
+// (key, value) pairs sorted by key and then value.
+void
+group(const std::vector<std::pair<uint32_t, uint32_t>>& pairs, uint32_t keys, uint32_t* offsets, uint32_t* values){
+    size_t n = 0;
+    for (uint32_t key = 0; key < keys; ++key) {
+        offsets[key] = (uint32_t)n;
+        for (; n < pairs.size() && pairs[n].first == key; ++n) {
+            values[n] = pairs[n].second;
+        }
+    }
+    offsets[keys] = (uint32_t)n;
+}
+
+// Checks offsets into an array of count entries, each less than limit.
+bool
+valid(const uint32_t* offsets, uint32_t keys, const uint32_t* values, uint32_t count, uint32_t limit){
+    if (offsets[0] != 0 || offsets[keys] != count)
+        return false;
+    for (uint32_t key = 0; key < keys; ++key) {
+        if (offsets[key] > offsets[key + 1])
+            return false;
+    }
+    for (uint32_t n = 0; n < count; ++n) {
+        if (values[n] >= limit)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+SymbolIndex::SymbolIndex() : m_mapping(nullptr), m_base(nullptr), m_size(0)
+{
+}
+
+SymbolIndex::~SymbolIndex()
+{
+    if (m_mapping != nullptr) {
+        munmap(m_mapping, m_size);
+    }
+}
+
+std::unique_ptr<SymbolIndex>
+SymbolIndex::Load(const std::string& path){
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return nullptr;
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1 || sb.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* mapping = mmap(nullptr, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    std::unique_ptr<SymbolIndex> index(new SymbolIndex());
+    index->m_mapping = mapping;
+    index->m_size = (size_t)sb.st_size;
+    if (!index->map(static_cast<const uint8_t*>(mapping), (size_t)sb.st_size))
+        return nullptr;
+    return index;
+}
+
+bool
+SymbolIndex::write(const std::string& path) const {
+    std::string temporary = path + "." + std::to_string(getpid());
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+
+    bool written = (fwrite(m_base, 1, m_size, file) == m_size);
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool
+SymbolIndex::map(const uint8_t* base, size_t size){
+    IndexHeader header;
+    if (size < sizeof(header))
+        return false;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, IndexMagic, sizeof(IndexMagic)) != 0 || header.version != IndexVersion)
+        return false;
+    if (header.nameBytes > size)
+        return false;
+
+    IndexLayout layout(header);
+    if (layout.size != size)
+        return false;
+
+    m_base             = base;
+    m_size             = size;
+    m_symbols          = header.symbols;
+    m_objects          = header.objects;
+    m_serials          = reinterpret_cast<const sqlite3_int64*>(base + layout.serials);
+    m_nameOffsets      = reinterpret_cast<const uint32_t*>(base + layout.nameOffsets);
+    m_names            = reinterpret_cast<const char*>(base + layout.names);
+    m_definedOffsets   = reinterpret_cast<const uint32_t*>(base + layout.definedOffsets);
+    m_defined          = reinterpret_cast<const uint32_t*>(base + layout.defined);
+    m_undefinedOffsets = reinterpret_cast<const uint32_t*>(base + layout.undefinedOffsets);
+    m_undefined        = reinterpret_cast<const uint32_t*>(base + layout.undefined);
+    m_definerOffsets   = reinterpret_cast<const uint32_t*>(base + layout.definerOffsets);
+    m_definers         = reinterpret_cast<const uint32_t*>(base + layout.definers);
+    m_importerOffsets  = reinterpret_cast<const uint32_t*>(base + layout.importerOffsets);
+    m_importers        = reinterpret_cast<const uint32_t*>(base + layout.importers);
+
+    // Each name is followed by a NUL.
+    if (m_nameOffsets[0] != 0 || m_nameOffsets[m_symbols] != header.nameBytes)
+        return false;
+    for (uint32_t symbol = 0; symbol < m_symbols; ++symbol) {
+        if (m_nameOffsets[symbol] >= m_nameOffsets[symbol + 1] || m_names[m_nameOffsets[symbol + 1] - 1] != 0)
+            return false;
+    }
+
+    return valid(m_definedOffsets, m_objects, m_defined, header.defined, m_symbols) &&
+           valid(m_undefinedOffsets, m_objects, m_undefined, header.undefined, m_symbols) &&
+           valid(m_definerOffsets, m_symbols, m_definers, header.defined, m_objects) &&
+           valid(m_importerOffsets, m_symbols, m_importers, header.undefined, m_objects);
+}
+
+std::unique_ptr<SymbolIndex>
+SymbolIndex::Build(DBDatabase& db, const std::string& build){
+    std::vector<sqlite3_int64> serials;
+    db.prepare("SELECT serial FROM mach_o_objects WHERE build=? ORDER BY serial")
+        << build >> [&](sqlite3_int64 serial) {
+            serials.push_back(serial);
+        };
+
+    // Intern names in the order they are read; they are numbered in
+    // sorted order once all are known. Local symbols (lowercase types)
+    // can't be linked against, so they are left out.
+    std::unordered_map<std::string, uint32_t> interned;
+    std::vector<const std::string*> names;
+    std::vector<std::pair<uint32_t, uint32_t>> defined;
+    std::vector<std::pair<uint32_t, uint32_t>> undefined;
+
+    // CROSS JOIN makes SQLite scan the symbols once in table order and
+    // look each one's object up by serial, rather than search
+    // mach_o_symbols_index once per object and read the symbols found
+    // in whatever order they were inserted.
+    db.prepare("SELECT s.mach_o_object, s.type, s.name FROM mach_o_symbols s CROSS JOIN mach_o_objects o "
+               "ON o.serial = s.mach_o_object WHERE o.build=? AND s.type BETWEEN 'A' AND 'Z'")
+        << build >> [&](sqlite3_int64 serial, std::string type, std::string name) {
+            auto object = (uint32_t)(std::lower_bound(serials.begin(), serials.end(), serial) - serials.begin());
+            auto interning = interned.try_emplace(std::move(name), (uint32_t)names.size());
+            if (interning.second) {
+                names.push_back(&interning.first->first);
+            }
+            (type == "U" ? undefined : defined).emplace_back(object, interning.first->second);
+        };
+
+    std::vector<uint32_t> order(names.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return *names[a] < *names[b]; });
+    std::vector<uint32_t> rank(names.size());
+    for (uint32_t n = 0; n < order.size(); ++n) {
+        rank[order[n]] = n;
+    }
+
+    // Sort each object's symbols by number, and drop any duplicates.
+    for (auto* pairs : { &defined, &undefined }) {
+        for (auto& pair : *pairs) {
+            pair.second = rank[pair.second];
+        }
+        std::sort(pairs->begin(), pairs->end());
+        pairs->erase(std::unique(pairs->begin(), pairs->end()), pairs->end());
+    }
+
+    IndexHeader header;
+    memcpy(header.magic, IndexMagic, sizeof(IndexMagic));
+    header.version = IndexVersion;
+    header.symbols = (uint32_t)names.size();
+    header.objects = (uint32_t)serials.size();
+    header.defined = (uint32_t)defined.size();
+    header.undefined = (uint32_t)undefined.size();
+    header.nameBytes = 0;
+    for (const std::string* name : names) {
+        header.nameBytes += name->size() + 1;
+    }
+
+    IndexLayout layout(header);
+    std::vector<uint8_t> data(layout.size);
+    uint8_t* base = data.data();
+    memcpy(base, &header, sizeof(header));
+    memcpy(base + layout.serials, serials.data(), sizeof(sqlite3_int64) * serials.size());
+
+    auto nameOffsets = reinterpret_cast<uint32_t*>(base + layout.nameOffsets);
+    auto namesData = reinterpret_cast<char*>(base + layout.names);
+    uint32_t offset = 0;
+    for (uint32_t n = 0; n < order.size(); ++n) {
+        const std::string& name = *names[order[n]];
+        nameOffsets[n] = offset;
+        memcpy(namesData + offset, name.c_str(), name.size() + 1);
+        offset += (uint32_t)name.size() + 1;
+    }
+    nameOffsets[order.size()] = offset;
+
+    group(defined, header.objects,
+          reinterpret_cast<uint32_t*>(base + layout.definedOffsets), reinterpret_cast<uint32_t*>(base + layout.defined));
+    group(undefined, header.objects,
+          reinterpret_cast<uint32_t*>(base + layout.undefinedOffsets), reinterpret_cast<uint32_t*>(base + layout.undefined));
+
+    // The inverted index: the same pairs, grouped by symbol instead.
+    for (auto* pairs : { &defined, &undefined }) {
+        for (auto& pair : *pairs) {
+            std::swap(pair.first, pair.second);
+        }
+        std::sort(pairs->begin(), pairs->end());
+    }
+    group(defined, header.symbols,
+          reinterpret_cast<uint32_t*>(base + layout.definerOffsets), reinterpret_cast<uint32_t*>(base + layout.definers));
+    group(undefined, header.symbols,
+          reinterpret_cast<uint32_t*>(base + layout.importerOffsets), reinterpret_cast<uint32_t*>(base + layout.importers));
+
+    std::unique_ptr<SymbolIndex> index(new SymbolIndex());
+    index->m_data = std::move(data);
+    index->map(index->m_data.data(), index->m_data.size());
+    return index;
+}
+
+std::unique_ptr<SymbolIndex>
+SymbolIndex::Open(DBDatabase& db, const std::string& build){
+    sqlite3_int64 objects = 0;
+    sqlite3_int64 serial = 0;
+    std::unique_ptr<SymbolIndex> index;
+
+    // Beside the database, unless it is in memory.
+    std::string path = db.path();
+    if (!path.empty()) {
+        std::string name = build;
+        std::replace(name.begin(), name.end(), '/', '_');
+        path += "." + name + ".symbols";
+    }
+
+    // In one transaction, so an index built matches the objects it is
+    // stored for.
+    db.beginTransaction();
+    try {
+        try {
+            db.prepare("SELECT COUNT(*), IFNULL(MAX(serial), 0) FROM mach_o_objects WHERE build=?")
+                << build >> [&](sqlite3_int64 count, sqlite3_int64 max) {
+                    objects = count;
+                    serial = max;
+                };
+        } catch (sqlite::sqlite_exception& e) {
+            // nothing was ever registered
+        }
+
+        if (objects != 0) {
+            if (!path.empty()) {
+                index = Load(path);
+            }
+
+            if (!index || index->objectCount() != objects || index->serial(index->objectCount() - 1) != serial) {
+                index = Build(db, build);
+                if (!path.empty() && !index->write(path)) {
+                    perror(path.c_str());
+                }
+            }
+        }
+    } catch (...) {
+        db.rollbackTransaction();
+        throw;
+    }
+    db.commitTransaction();
+
+    return index;
+}
+
+std::optional<uint32_t>
+SymbolIndex::find(std::string_view name) const {
+    uint32_t low = 0;
+    uint32_t high = m_symbols;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int order = this->name(mid).compare(name);
+        if (order == 0) {
+            return mid;
+        } else if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view
+SymbolIndex::name(uint32_t symbol) const {
+    return std::string_view(m_names + m_nameOffsets[symbol], m_nameOffsets[symbol + 1] - m_nameOffsets[symbol] - 1);
+}
+
+std::span<const uint32_t>
+SymbolIndex::defined(uint32_t object) const {
+    return std::span<const uint32_t>(m_defined + m_definedOffsets[object], m_definedOffsets[object + 1] - m_definedOffsets[object]);
+}
+
+std::span<const uint32_t>
+SymbolIndex::undefined(uint32_t object) const {
+    return std::span<const uint32_t>(m_undefined + m_undefinedOffsets[object], m_undefinedOffsets[object + 1] - m_undefinedOffsets[object]);
+}
+
+std::span<const uint32_t>
+SymbolIndex::definers(uint32_t symbol) const {
+    return std::span<const uint32_t>(m_definers + m_definerOffsets[symbol], m_definerOffsets[symbol + 1] - m_definerOffsets[symbol]);
+}
+
+std::span<const uint32_t>
+SymbolIndex::importers(uint32_t symbol) const {
+    return std::span<const uint32_t>(m_importers + m_importerOffsets[symbol], m_importerOffsets[symbol + 1] - m_importerOffsets[symbol]);
+}
+
+int
+SymbolIndex::PrintObjects(DBDatabase& db, const std::string& build, const std::vector<std::string>& names,
+                          std::span<const uint32_t> (SymbolIndex::*objects)(uint32_t) const){
+    auto index = SymbolIndex::Open(db, build);
+    if (!index) {
+        std::cerr << "no Mach-O objects registered for " << build << std::endl;
+        return 1;
+    }
+
+    int res = 0;
+    auto object = db.prepare("SELECT project, path FROM mach_o_objects WHERE serial=?");
+    for (const std::string& name : names) {
+        auto symbol = index->find(name);
+        if (!symbol || ((*index).*objects)(*symbol).empty()) {
+            std::cerr << name << ": not found" << std::endl;
+            res = 1;
+            continue;
+        }
+
+        std::cout << name << ":" << std::endl;
+        for (uint32_t found : ((*index).*objects)(*symbol)) {
+            object << index->serial(found) >> [&](std::string project, std::string path) {
+                std::cout << "\t" << project << "\t" << path << std::endl;
+            };
+        }
+    }
+    return res;
+}
+
+} // namespace plugin
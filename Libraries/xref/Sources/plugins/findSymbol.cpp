@@ -0,0 +1,35 @@
+//
+//  findSymbol.cpp
+//  libxref
+//
+//  Copyright © 2021 The PureDarwin Project. All rights reserved.
+//
+
+#include "Plugin.h"
+#include "SymbolIndex.h"
+
+namespace plugin {
+
+//
+// Prints the objects, and their projects, that export each symbol.
+//
+class FindSymbol : BasicPlugin<DBString> {
+public:
+    FindSymbol() : BasicPlugin("findSymbol") {}
+   ~FindSymbol()                             {}
+
+    int run(DBDatabase &db, const std::string& build, const std::vector<std::string>& argv) override {
+        if (argv.empty())
+            return -1;
+
+        return SymbolIndex::PrintObjects(db, build, argv, &SymbolIndex::definers);
+    };
+
+    std::string usage() override {
+        return "<symbol> ...";
+    };
+};
+
+DECLARE_PLUGIN(FindSymbol, findSymbol);
+
+} // namespace plugin
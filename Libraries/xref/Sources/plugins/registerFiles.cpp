@@ -33,17 +33,27 @@
 
 #include "Plugin.h"
 #include "DBDatabase.h"
+#include <libutil/ThreadPool.h>
 #include <sys/syslimits.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <fts.h>
 #include <unistd.h>
+#include <cstdarg>
 #include <cstdlib>
 #include <cstdio>
 #include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 #include <CommonCrypto/CommonDigest.h>
 
 // If the path points to a Mach-O file, records all dylib
@@ -74,15 +84,104 @@ public:
 
     std::string project = argv.at(i++);
     std::string dstRoot = argv.at(i++);
-    res = this->register_files(db, build, project, dstRoot);
+
+    size_t jobs = libutil::ThreadPool::DefaultSize();
+    if (argv.size() > 2) {
+      int value = atoi(argv.at(i++).c_str());
+      if (value <= 0)
+        return EINVAL;
+      jobs = (size_t)value;
+    }
+
+    res = this->register_files(db, build, project, dstRoot, jobs);
     return res;
   }
-  std::string usage() override { return (std::string) "<project> <dstroot>"; }
+  std::string usage() override { return (std::string) "<project> <dstroot> [<jobs>]"; }
+
+  //
+  // What a worker finds in one Mach-O image, written to the database later
+  // by the writer thread.
+  //
+  struct MachOSymbol {
+    char type;
+    uint64_t value;
+    std::string name;
+  };
+
+  struct MachOObject {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t cputype;
+    uint32_t cpusubtype;
+    uint32_t flags;
+    std::vector<std::string> dependencies;
+    std::vector<MachOSymbol> symbols;
+  };
+
+  //
+  // What the last registration of the project recorded about a regular
+  // file. A file with the same size, modification time and inode is taken
+  // to be unchanged and isn't read at all; otherwise it is hashed, and only
+  // parsed if its digest changed too.
+  //
+  struct Fingerprint {
+    sqlite3_int64 size;
+    sqlite3_int64 mtime;
+    sqlite3_int64 inode;
+    std::string checksum;
+    // the file's unresolved dependencies, one per line
+    std::string dependencies;
+  };
+
+  // How much of a regular file had to be read again.
+  enum class Scan { Skipped, Rehashed, Reparsed };
+
+  //
+  // One entry of the DSTROOT, in the order the walk found it. Regular files
+  // are filled in by a worker, then marked done for the writer.
+  //
+  struct FileEntry {
+    std::string filename;
+    std::string accpath;
+    std::string symlink;
+    int info;
+    mode_t mode;
+    uid_t uid;
+    gid_t gid;
+    off_t size;
+    sqlite3_int64 mtime;
+    ino_t inode;
+
+    // Default to empty SHA-1 checksum
+    std::string checksum = "                                        ";
+    std::vector<MachOObject> objects;
+    const Fingerprint *fingerprint = nullptr;
+    Scan scan = Scan::Reparsed;
+    int error = 0;
+    bool done = false;
+  };
+
+  struct Tally {
+    int loaded = 0;
+    int skipped = 0;
+    int rehashed = 0;
+    int reparsed = 0;
+  };
 
   static int compare(const FTSENT **a, const FTSENT **b) {
     return strcmp((*a)->fts_name, (*b)->fts_name);
   }
 
+  // Modification time in nanoseconds.
+  static sqlite3_int64 modification_time(const struct stat &sb) {
+#if defined(__APPLE__)
+    const struct timespec &time = sb.st_mtimespec;
+#else
+    const struct timespec &time = sb.st_mtim;
+#endif
+    return (sqlite3_int64)time.tv_sec * 1000000000 + (sqlite3_int64)time.tv_nsec;
+  }
+
   static size_t ent_filename(FTSENT *ent, char *filename, size_t bufsiz) {
     if (ent == nullptr)
       return 0;
@@ -98,33 +197,21 @@ public:
     return bufsiz;
   }
 
-  std::string calculate_digest(int fd) {
-    unsigned char md[CC_SHA1_DIGEST_LENGTH];
+  std::string calculate_digest(const uint8_t *data, size_t size) {
+    unsigned char md[CC_SHA1_DIGEST_LENGTH] = {0};
     CC_SHA1_CTX c;
+    size_t pos = 0;
     CC_SHA1_Init(&c);
 
-    memset(md, 0, CC_SHA1_DIGEST_LENGTH);
+    // CC_LONG is 32 bits, so hash large files in parts.
+    const size_t blockLen = 1024 * 1024 * 1024;
 
-    ssize_t len;
-    const unsigned int blocklen = 8192;
-    static unsigned char *block = nullptr;
-    if (block == nullptr) {
-      block = static_cast<unsigned char *>(malloc(blocklen));
-    }
-    while (true) {
-      len = read(fd, block, blocklen);
-      if (len == 0) {
-        close(fd);
-        break;
-      }
-      if ((len < 0) && (errno == EINTR))
-        continue;
-      if (len < 0) {
-        close(fd);
-        return nullptr;
-      }
-      CC_SHA1_Update(&c, block, (CC_LONG)len);
+    while (size - pos > blockLen) {
+      CC_SHA1_Update(&c, data + pos, (CC_LONG)blockLen);
+      pos += blockLen;
     }
+    // last block
+    CC_SHA1_Update(&c, data + pos, (CC_LONG)(size - pos));
 
     CC_SHA1_Final(md, &c);
     return this->format("%02x%02x%02x%02x"
@@ -137,123 +224,93 @@ public:
   }
 
   std::string calculate_digest(const std::vector<char> &data) {
-    unsigned char md[CC_SHA1_DIGEST_LENGTH] = {0};
-    CC_SHA1_CTX c;
-    auto pos = 0;
-    CC_SHA1_Init(&c);
+    return calculate_digest((const uint8_t *)data.data(), data.size());
+  }
 
-    size_t size = data.size();
-    const unsigned int blockLen = 8192;
+  //
+  // Copies a structure out of the mapped file, if it is all inside it.
+  // Mapped files have no alignment guarantees past the start, so the
+  // structures are never used in place.
+  //
+  template <typename T>
+  static bool read_struct(const uint8_t *data, size_t size, uint64_t offset, T *out) {
+    if (offset > size || size - offset < sizeof(T))
+      return false;
+    memcpy(out, data + offset, sizeof(T));
+    return true;
+  }
 
-    while (pos < size && (pos + blockLen) < size) {
-      CC_SHA1_Update(&c, data.data()+pos, (CC_LONG)blockLen);
-      pos += blockLen;
-    }
-    // last block
-    CC_SHA1_Update(&c, data.data()+pos, (CC_LONG)(data.size() - pos));
+  // Reads a NUL-terminated string from within a load command.
+  static std::string lc_string(const std::vector<uint8_t> &lc, uint32_t offset) {
+    if (offset >= lc.size())
+      return std::string();
+    const char *str = (const char *)lc.data() + offset;
+    return std::string(str, strnlen(str, lc.size() - offset));
+  }
 
-    CC_SHA1_Final(md, &c);
-    return this->format("%02x%02x%02x%02x"
-                  "%02x%02x%02x%02x"
-                  "%02x%02x%02x%02x"
-                  "%02x%02x%02x%02x"
-                  "%02x%02x%02x%02x",
-                  md[0], md[1], md[2], md[3], md[4], md[5], md[6], md[7], md[8], md[9], md[10],
-                  md[11], md[12], md[13], md[14], md[15], md[16], md[17], md[18], md[19]);
+  static bool section_is(const char *sectname, const char *segname,
+                         const char *sect, const char *seg) {
+    return strncmp(sectname, sect, 16) == 0 && strncmp(segname, seg, 16) == 0;
   }
 
-  int register_mach_header(DBDatabase &database,
-                                  const std::string &build,
-                                  const std::string &project,
-                                  const std::string &path,
-                                  struct fat_arch *fa,
-                                  int fd, int *isMachO) {
-    ssize_t res;
+  //
+  // Parses the Mach-O image at `origin` in the mapped file. Only images
+  // that can be linked against or run are recorded.
+  //
+  static void parse_mach_header(const uint8_t *data, size_t size, uint64_t origin,
+                                std::vector<MachOObject> *objects) {
     uint32_t magic;
-    int swap = 0;
+    if (!read_struct(data, size, origin, &magic))
+      return;
 
-    struct mach_header *mh = nullptr;
-    struct mach_header_64 *mh64 = nullptr;
-
-    if (isMachO)
-      *isMachO = 0;
-
-    res = read(fd, &magic, sizeof(uint32_t));
-    if (res < sizeof(uint32_t)) {
-      return 0;
-    }
+    int is64 = (magic == MH_MAGIC_64 || magic == MH_CIGAM_64);
+    int swap = (magic == MH_CIGAM || magic == MH_CIGAM_64);
+    if (!is64 && magic != MH_MAGIC && magic != MH_CIGAM)
+      return;
 
     //
-    // 32-bit, read the rest of the header
+    // Read the header, widening 32-bit headers; the fields we use are the same.
     //
-    if (magic == MH_MAGIC || magic == MH_CIGAM) {
-      if (isMachO)
-        *isMachO = 1;
-      mh = static_cast<mach_header *>(malloc(sizeof(struct mach_header)));
-      if (mh == nullptr)
-        return -1;
-      memset(mh, 0, sizeof(struct mach_header));
-      mh->magic = magic;
-      res =
-          read(fd, &mh->cputype, sizeof(struct mach_header) - sizeof(uint32_t));
-      if (res < sizeof(struct mach_header) - sizeof(uint32_t)) {
-        return 0;
-      }
-      if (magic == MH_CIGAM) {
-        swap = 1;
-        swap_mach_header(mh, NXHostByteOrder());
-      }
-      //
-      // 64-bit, read the rest of the header
-      //
-    } else if (magic == MH_MAGIC_64 || magic == MH_CIGAM_64) {
-      if (isMachO)
-        *isMachO = 1;
-      mh64 =
-          static_cast<mach_header_64 *>(malloc(sizeof(struct mach_header_64)));
-      if (mh64 == nullptr)
-        return -1;
-      memset(mh64, 0, sizeof(struct mach_header_64));
-      mh64->magic = magic;
-      res = read(fd, &mh64->cputype,
-                 sizeof(struct mach_header_64) - sizeof(uint32_t));
-      if (res < sizeof(struct mach_header_64) - sizeof(uint32_t)) {
-        return 0;
-      }
-      if (magic == MH_CIGAM_64) {
-        swap = 1;
-        swap_mach_header_64(mh64, NXHostByteOrder());
-      }
-      //
-      // Not a Mach-O
-      //
+    struct mach_header_64 mh {};
+    uint64_t offset = origin;
+    if (is64) {
+      if (!read_struct(data, size, offset, &mh))
+        return;
+      if (swap)
+        swap_mach_header_64(&mh, NXHostByteOrder());
+      offset += sizeof(struct mach_header_64);
     } else {
-      return 0;
+      struct mach_header mh32 {};
+      if (!read_struct(data, size, offset, &mh32))
+        return;
+      if (swap)
+        swap_mach_header(&mh32, NXHostByteOrder());
+      mh.magic = mh32.magic;
+      mh.cputype = mh32.cputype;
+      mh.cpusubtype = mh32.cpusubtype;
+      mh.filetype = mh32.filetype;
+      mh.ncmds = mh32.ncmds;
+      mh.sizeofcmds = mh32.sizeofcmds;
+      mh.flags = mh32.flags;
+      offset += sizeof(struct mach_header);
     }
 
-    switch (mh64 ? mh64->filetype : mh->filetype) {
+    switch (mh.filetype) {
     case MH_EXECUTE:
     case MH_DYLIB:
     case MH_BUNDLE:
       break;
     case MH_OBJECT:
     default:
-      return 0;
+      return;
     }
 
-    std::string query =
-        "INSERT INTO "
-        "mach_o_objects (magic, type, cputype, cpusubtype, flags, build, project, path) "
-        "VALUES (" +
-        std::to_string(mh64 ? mh64->magic : mh->magic) +
-        std::to_string(mh64 ? mh64->filetype : mh->filetype) +
-        std::to_string(mh64 ? mh64->cputype : mh->cputype) +
-        std::to_string(mh64 ? mh64->cpusubtype : mh->cpusubtype) +
-        std::to_string(mh64 ? mh64->flags : mh->flags) + build + project +
-        path + ")";
-
-    database.query(query);
-    uint64_t serial = database.lastRowId();
+    MachOObject object {};
+    object.magic = mh.magic;
+    object.type = mh.filetype;
+    object.cputype = mh.cputype;
+    object.cpusubtype = mh.cpusubtype;
+    object.flags = mh.flags;
 
     //
     // Information needed to parse the symbol table
@@ -264,154 +321,98 @@ public:
     unsigned char bss_nsect = NO_SECT;
 
     uint32_t nsyms = 0;
-    uint8_t *symbols = nullptr;
+    const uint8_t *symbols = nullptr;
 
     uint32_t strsize = 0;
-    uint8_t *strings = nullptr;
+    const uint8_t *strings = nullptr;
 
-    int i;
-    uint32_t ncmds = mh64 ? mh64->ncmds : mh->ncmds;
-    for (i = 0; i < ncmds; ++i) {
+    std::vector<uint8_t> lc;
+    for (uint32_t i = 0; i < mh.ncmds; ++i) {
       //
-      // Read a generic load command into memory.
+      // Read a generic load command.
       // At first, we only know it has a type and size.
       //
       struct load_command lctmp {};
-
-      res = read(fd, &lctmp, sizeof(struct load_command));
-      if (res < sizeof(struct load_command)) {
-        return 0;
-      }
+      if (!read_struct(data, size, offset, &lctmp))
+        break;
 
       uint32_t cmd = swap ? OSSwapInt32(lctmp.cmd) : lctmp.cmd;
       uint32_t cmdsize = swap ? OSSwapInt32(lctmp.cmdsize) : lctmp.cmdsize;
-      if (cmdsize == 0)
-        continue;
+      if (cmdsize < sizeof(struct load_command) || cmdsize > size - offset)
+        break;
 
-      auto *lc = static_cast<load_command *>(malloc(cmdsize));
-      if (lc == nullptr) {
-        return 0;
-      }
-      memset(lc, 0, cmdsize);
-      memcpy(lc, &lctmp, sizeof(lctmp));
-
-      // Read the remainder of the load command.
-      res = read(fd, (uint8_t *)lc + sizeof(struct load_command),
-                 cmdsize - sizeof(struct load_command));
-      if (res < (cmdsize - sizeof(struct load_command))) {
-        free(lc);
-        return 0;
-      }
+      // Copy the whole load command, to swap it in place.
+      lc.assign(data + offset, data + offset + cmdsize);
+      offset += cmdsize;
 
       //
       // LC_LOAD_DYLIB and LC_LOAD_WEAK_DYLIB
       // Add dylibs as unresolved "lib" dependencies.
       //
-      if (cmd == LC_LOAD_DYLIB || cmd == LC_LOAD_WEAK_DYLIB) {
-        auto *dylib = (struct dylib_command *)lc;
+      if ((cmd == LC_LOAD_DYLIB || cmd == LC_LOAD_WEAK_DYLIB) &&
+          cmdsize >= sizeof(struct dylib_command)) {
+        auto *dylib = (struct dylib_command *)lc.data();
         if (swap)
           swap_dylib_command(dylib, NXHostByteOrder());
-
-        // sections immediately follow the dylib_command structure, and are
-        // reflected in the cmdsize.
-
-        //			int _strsize = dylib->cmdsize - sizeof(struct dylib_command); 			char* str = malloc(_strsize+1); 			strncpy(str, (char*)((uint8_t*)dylib + dylib->dylib.name.offset), _strsize);
-        //			str[_strsize] = 0; // NUL-terminate
-
-        std::stringstream stream{};
-        stream << "INSERT INTO unresolved_dependencies (build,project,type,dependency) ";
-        stream << "VALUES (" << build << "," << project << ",lib,";
-        stream << (char *)((uint8_t *)dylib + dylib->dylib.name.offset) << ")";
-        database.query(stream.str());
-
-        //			free(str);
+        object.dependencies.push_back(lc_string(lc, dylib->dylib.name.offset));
 
         //
         // LC_LOAD_DYLINKER
         // Add the dynamic linker (usually dyld) as an unresolved "lib" dependency.
         //
-      } else if (cmd == LC_LOAD_DYLINKER) {
-        auto *dylinker = (struct dylinker_command *)lc;
+      } else if (cmd == LC_LOAD_DYLINKER &&
+                 cmdsize >= sizeof(struct dylinker_command)) {
+        auto *dylinker = (struct dylinker_command *)lc.data();
         if (swap)
           swap_dylinker_command(dylinker, NXHostByteOrder());
-
-        // sections immediately follow the dylib_command structure, and are
-        // reflected in the cmdsize.
-
-        //			strsize = dylinker->cmdsize - sizeof(struct dylinker_command); 			char* str = static_cast<char *>(malloc(strsize + 1)); 			strncpy(str, (char*)((uint8_t*)dylinker + dylinker->name.offset), strsize); 			str[strsize] = 0; // NUL-terminate
-        //
-        //			gDatabse->query("INSERT INTO unresolved_dependencies (build,project,type,dependency) VALUES (%Q,%Q,%Q,%Q)", 			build, project, "lib", str);
-
-        //			free(str);
-        std::stringstream stream{};
-        stream << "INSERT INTO unresolved_dependencies (build,project,type,dependency) ";
-        stream << "VALUES (" << build << "," << project << ",lib,";
-        stream << (char *)((uint8_t *)dylinker + dylinker->name.offset) << ")";
-        database.query(stream.str());
+        object.dependencies.push_back(lc_string(lc, dylinker->name.offset));
 
         //
         // LC_SYMTAB
-        // Read the symbol table into memory, we'll process it after we're
-        // done with the load commands.
+        // The symbol table is already mapped, so just remember where it is;
+        // we'll process it after we're done with the load commands.
         //
-      } else if (cmd == LC_SYMTAB && symbols == nullptr) {
-        auto *symtab = (struct symtab_command *)lc;
+      } else if (cmd == LC_SYMTAB && symbols == nullptr &&
+                 cmdsize >= sizeof(struct symtab_command)) {
+        auto *symtab = (struct symtab_command *)lc.data();
         if (swap)
           swap_symtab_command(symtab, NXHostByteOrder());
 
-        nsyms = symtab->nsyms;
-        uint32_t symsize =
-            nsyms * (mh64 ? sizeof(struct nlist_64) : sizeof(struct nlist));
-        symbols = static_cast<uint8_t *>(malloc(symsize));
-
-        strsize = symtab->strsize;
-        // XXX: check strsize != 0
-        strings = static_cast<uint8_t *>(malloc(strsize));
-
-        off_t save = lseek(fd, 0, SEEK_CUR);
-
-        off_t origin = fa ? fa->offset : 0;
-
-        lseek(fd, (off_t)symtab->symoff + origin, SEEK_SET);
-        res = read(fd, symbols, symsize);
-        if (res < symsize) { /* XXX: leaks */
-          return 0;
+        uint64_t symsize = (uint64_t)symtab->nsyms *
+                           (is64 ? sizeof(struct nlist_64) : sizeof(struct nlist));
+        uint64_t symoff = origin + symtab->symoff;
+        uint64_t stroff = origin + symtab->stroff;
+        if (symoff <= size && size - symoff >= symsize &&
+            stroff <= size && size - stroff >= symtab->strsize) {
+          nsyms = symtab->nsyms;
+          symbols = data + symoff;
+          strsize = symtab->strsize;
+          strings = data + stroff;
         }
 
-        lseek(fd, (off_t)symtab->stroff + origin, SEEK_SET);
-        res = read(fd, strings, strsize);
-        if (res < strsize) { /* XXX: leaks */
-          return 0;
-        }
-
-        lseek(fd, save, SEEK_SET);
-
         //
         // LC_SEGMENT
         // We're looking for the section number of the text, data, and bss segments in order to parse symbols.
         //
-      } else if (cmd == LC_SEGMENT) {
-        auto *seg = (struct segment_command *)lc;
+      } else if (cmd == LC_SEGMENT && cmdsize >= sizeof(struct segment_command)) {
+        auto *seg = (struct segment_command *)lc.data();
         if (swap)
           swap_segment_command(seg, NXHostByteOrder());
 
         // sections immediately follow the segment_command structure, and are
         // reflected in the cmdsize.
-        int k;
-        for (k = 0; k < seg->nsects; ++k) {
-          auto *sect = (struct section *)((uint8_t *)seg +
-                                          sizeof(struct segment_command) +
-                                          k * sizeof(struct section));
+        for (uint32_t k = 0; k < seg->nsects; ++k) {
+          size_t sectoff = sizeof(struct segment_command) + k * sizeof(struct section);
+          if (sectoff + sizeof(struct section) > cmdsize)
+            break;
+          auto *sect = (struct section *)(lc.data() + sectoff);
           if (swap)
             swap_section(sect, 1, NXHostByteOrder());
-          if (strcmp(sect->sectname, SECT_TEXT) == 0 &&
-              strcmp(sect->segname, SEG_TEXT) == 0) {
+          if (section_is(sect->sectname, sect->segname, SECT_TEXT, SEG_TEXT)) {
             text_nsect = ++count_nsect;
-          } else if (strcmp(sect->sectname, SECT_DATA) == 0 &&
-                     strcmp(sect->segname, SEG_DATA) == 0) {
+          } else if (section_is(sect->sectname, sect->segname, SECT_DATA, SEG_DATA)) {
             data_nsect = ++count_nsect;
-          } else if (strcmp(sect->sectname, SECT_BSS) == 0 &&
-                     strcmp(sect->segname, SEG_DATA) == 0) {
+          } else if (section_is(sect->sectname, sect->segname, SECT_BSS, SEG_DATA)) {
             bss_nsect = ++count_nsect;
           } else {
             ++count_nsect;
@@ -422,57 +423,50 @@ public:
         // LC_SEGMENT_64
         // Same as LC_SEGMENT, but for 64-bit binaries.
         //
-      } else if (lc->cmd == LC_SEGMENT_64) {
-        auto *seg = (struct segment_command_64 *)lc;
+      } else if (cmd == LC_SEGMENT_64 && cmdsize >= sizeof(struct segment_command_64)) {
+        auto *seg = (struct segment_command_64 *)lc.data();
         if (swap)
           swap_segment_command_64(seg, NXHostByteOrder());
 
-        // sections immediately follow the segment_command structure, and are
-        // reflected in the cmdsize.
-        int k;
-        for (k = 0; k < seg->nsects; ++k) {
-          auto *sect = (struct section_64 *)((uint8_t *)seg +
-                                             sizeof(struct segment_command_64) +
-                                             k * sizeof(struct section_64));
+        for (uint32_t k = 0; k < seg->nsects; ++k) {
+          size_t sectoff = sizeof(struct segment_command_64) + k * sizeof(struct section_64);
+          if (sectoff + sizeof(struct section_64) > cmdsize)
+            break;
+          auto *sect = (struct section_64 *)(lc.data() + sectoff);
           if (swap)
             swap_section_64(sect, 1, NXHostByteOrder());
-          if (strcmp(sect->sectname, SECT_TEXT) == 0 &&
-              strcmp(sect->segname, SEG_TEXT) == 0) {
+          if (section_is(sect->sectname, sect->segname, SECT_TEXT, SEG_TEXT)) {
             text_nsect = ++count_nsect;
-          } else if (strcmp(sect->sectname, SECT_DATA) == 0 &&
-                     strcmp(sect->segname, SEG_DATA) == 0) {
+          } else if (section_is(sect->sectname, sect->segname, SECT_DATA, SEG_DATA)) {
             data_nsect = ++count_nsect;
-          } else if (strcmp(sect->sectname, SECT_BSS) == 0 &&
-                     strcmp(sect->segname, SEG_DATA) == 0) {
+          } else if (section_is(sect->sectname, sect->segname, SECT_BSS, SEG_DATA)) {
             bss_nsect = ++count_nsect;
           } else {
             ++count_nsect;
           }
         }
       }
-
-      free(lc);
     }
 
     //
-    // Finished processing the load commands, now insert symbols into the database.
+    // Finished processing the load commands, now collect the symbols.
     //
-    int j;
-    for (j = 0; j < nsyms; ++j) {
+    for (uint32_t j = 0; j < nsyms; ++j) {
       struct nlist_64 symbol {};
-      if (mh64) {
-        memcpy(&symbol, (symbols + j * sizeof(struct nlist_64)),
-               sizeof(struct nlist_64));
+      if (is64) {
+        memcpy(&symbol, symbols + j * sizeof(struct nlist_64), sizeof(struct nlist_64));
         if (swap)
           swap_nlist_64(&symbol, 1, NXHostByteOrder());
       } else {
-        symbol.n_value = 0;
-        memcpy(&symbol, (symbols + j * sizeof(struct nlist)),
-               sizeof(struct nlist));
+        struct nlist symbol32 {};
+        memcpy(&symbol32, symbols + j * sizeof(struct nlist), sizeof(struct nlist));
         if (swap)
-          swap_nlist_64(&symbol, 1, NXHostByteOrder());
-        // we copied a 32-bit nlist into a 64-bit one, adjust the value accordingly all other fields are identical sizes
-        symbol.n_value >>= 32;
+          swap_nlist(&symbol32, 1, NXHostByteOrder());
+        symbol.n_un.n_strx = symbol32.n_un.n_strx;
+        symbol.n_type = symbol32.n_type;
+        symbol.n_sect = symbol32.n_sect;
+        symbol.n_desc = symbol32.n_desc;
+        symbol.n_value = symbol32.n_value;
       }
       char type = '?';
       switch (symbol.n_type & N_TYPE) {
@@ -508,96 +502,244 @@ public:
       }
 
       if (type != '?' && type != 'u' && type != 'c') {
-        const auto *name = (const uint8_t *)"";
-        if (symbol.n_un.n_strx != 0) {
-          name = (uint8_t *)(strings + symbol.n_un.n_strx);
+        std::string name;
+        if (symbol.n_un.n_strx != 0 && symbol.n_un.n_strx < strsize) {
+          const char *str = (const char *)strings + symbol.n_un.n_strx;
+          name = std::string(str, strnlen(str, strsize - symbol.n_un.n_strx));
         }
-
-        std::stringstream stream{};
-        stream << "INSERT INTO mach_o_symbols "; // VALUES (%lld, \'%c\', %lld, %Q)";
-        stream << "VALUES (" << serial << ",\'" << type << "\',";
-        stream << symbol.n_value << "," << name << ")";
-        database.query(stream.str());
-
-        //			res = SQL("INSERT INTO mach_o_symbols VALUES (%lld, \'%c\', %lld, %Q)", 				serial, 				type, 				symbol.n_value, 				name);
+        object.symbols.push_back({type, symbol.n_value, name});
       }
     }
 
-    return 0;
+    objects->push_back(std::move(object));
   }
 
-  int register_libraries(DBDatabase &database,
-                                int fd, const std::string &build,
-                                const std::string &project,
-                                const std::string &filename, int *isMachO) {
-    ssize_t res;
-
+  static void parse_libraries(const uint8_t *data, size_t size,
+                              std::vector<MachOObject> *objects) {
     uint32_t magic;
-
-    res = read(fd, &magic, sizeof(uint32_t));
-    if (res < sizeof(uint32_t)) {
-      goto error_out;
-    }
+    if (!read_struct(data, size, 0, &magic))
+      return;
 
     if (magic == FAT_MAGIC || magic == FAT_CIGAM) {
       struct fat_header fh {};
-      int swap = 0;
+      if (!read_struct(data, size, 0, &fh))
+        return;
 
-      res =
-          read(fd, &fh.nfat_arch, sizeof(struct fat_header) - sizeof(uint32_t));
-      if (res < sizeof(uint32_t)) {
-        goto error_out;
-      }
-
-      if (magic == FAT_CIGAM) {
-        swap = 1;
+      int swap = (magic == FAT_CIGAM);
+      if (swap)
         swap_fat_header(&fh, NXHostByteOrder());
-      }
 
-      int i;
-      for (i = 0; i < fh.nfat_arch; ++i) {
+      for (uint32_t i = 0; i < fh.nfat_arch; ++i) {
         struct fat_arch fa {};
-        res = read(fd, &fa, sizeof(fa));
-        if (res < sizeof(fa)) {
-          goto error_out;
-        }
+        if (!read_struct(data, size, sizeof(struct fat_header) + (uint64_t)i * sizeof(struct fat_arch), &fa))
+          return;
 
         if (swap)
           swap_fat_arch(&fa, 1, NXHostByteOrder());
 
-        off_t save = lseek(fd, 0, SEEK_CUR);
-        lseek(fd, (off_t)fa.offset, SEEK_SET);
+        parse_mach_header(data, size, fa.offset, objects);
+      }
+    } else {
+      parse_mach_header(data, size, 0, objects);
+    }
+  }
+
+  //
+  // Worker: reads a regular file once through a mapping, for both the
+  // Mach-O load commands and the digest. A file whose digest is the one
+  // last registered isn't parsed; its objects are kept.
+  //
+  void process_file(FileEntry *entry) {
+    int fd = open(entry->accpath.c_str(), O_RDONLY);
+    if (fd == -1) {
+      entry->error = errno;
+      return;
+    }
 
-        register_mach_header(database, build, project, filename, &fa, fd, isMachO);
+    struct stat sb {};
+    if (fstat(fd, &sb) != 0) {
+      entry->error = errno;
+      close(fd);
+      return;
+    }
+
+    // Empty files can't be mapped, but still have a digest.
+    if (sb.st_size == 0) {
+      close(fd);
+      entry->checksum = calculate_digest(nullptr, 0);
+      if (entry->fingerprint != nullptr && entry->fingerprint->checksum == entry->checksum)
+        entry->scan = Scan::Rehashed;
+      return;
+    }
 
-        lseek(fd, save, SEEK_SET);
+    void *map = mmap(nullptr, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+      entry->error = errno;
+      return;
+    }
+
+    const auto *data = (const uint8_t *)map;
+    entry->checksum = calculate_digest(data, (size_t)sb.st_size);
+    if (entry->fingerprint != nullptr && entry->fingerprint->checksum == entry->checksum)
+      entry->scan = Scan::Rehashed;
+    else
+      parse_libraries(data, (size_t)sb.st_size, &entry->objects);
+
+    munmap(map, (size_t)sb.st_size);
+  }
+
+  //
+  // The writer's inserts, batched per table. Objects are given serials
+  // here rather than by SQLite, so an object's symbols can be batched
+  // without waiting for its row id. As with AUTOINCREMENT, a serial is
+  // never reused, even after its object is pruned. The last batches are
+  // only written by flush(), which the writer calls before pruning.
+  //
+  struct Inserters {
+    static const size_t batch_rows = 256;
+
+    DBInserter objects;
+    DBInserter dependencies;
+    DBInserter symbols;
+    DBInserter files;
+    DBInserter fingerprints;
+    DBInserter kept;
+    sqlite3_int64 serial;
+
+    Inserters(DBDatabase &database)
+      : objects(database.inserter("mach_o_objects",
+                                  {"serial", "magic", "type", "cputype", "cpusubtype", "flags", "build", "project", "path"},
+                                  batch_rows, 0)),
+        dependencies(database.inserter("unresolved_dependencies", {"build", "project", "type", "dependency"},
+                                       batch_rows, 0)),
+        symbols(database.inserter("mach_o_symbols", {"mach_o_object", "type", "value", "name"}, batch_rows, 0)),
+        files(database.inserter("files", {"build", "project", "path"}, batch_rows, 0)),
+        fingerprints(database.inserter("file_fingerprints",
+                                       {"build", "project", "path", "size", "mtime", "inode", "checksum", "dependencies"},
+                                       batch_rows, 0)),
+        kept(database.inserter("temp.kept_files", {"path"}, batch_rows, 0)),
+        serial(database.query<sqlite3_int64>(
+            "SELECT MAX(IFNULL((SELECT seq FROM sqlite_sequence WHERE name='mach_o_objects'), 0), "
+            "IFNULL((SELECT MAX(serial) FROM mach_o_objects), 0))")) {}
+
+    void flush() {
+      objects.flush();
+      dependencies.flush();
+      symbols.flush();
+      files.flush();
+      fingerprints.flush();
+      kept.flush();
+    }
+  };
+
+  //
+  // Writer: records one finished entry in the database and the receipt.
+  // Only the writer thread uses the database while the walk is running.
+  //
+  void write_entry(Inserters &inserters,
+                   const std::string &build,
+                   const std::string &project,
+                   const FileEntry &entry,
+                   std::stringstream &stream,
+                   Tally &tally) {
+    std::string dependencies;
+    for (const MachOObject &object : entry.objects) {
+      sqlite3_int64 serial = ++inserters.serial;
+      inserters.objects.insert(serial, object.magic, object.type, object.cputype, object.cpusubtype, object.flags,
+                               build, project, entry.filename);
+
+      for (const std::string &dependency : object.dependencies) {
+        inserters.dependencies.insert(build, project, "lib", dependency);
+        dependencies += dependency;
+        dependencies += '\n';
+      }
+
+      for (const MachOSymbol &symbol : object.symbols) {
+        inserters.symbols.insert(serial, symbol.type, symbol.value, symbol.name);
       }
-    } else {
-      lseek(fd, 0, SEEK_SET);
-      register_mach_header(database, build, project, filename, nullptr, fd, isMachO);
     }
-  error_out:
-    return 0;
+
+    if (entry.info == FTS_F) {
+      if (entry.scan == Scan::Reparsed) {
+        ++tally.reparsed;
+      } else {
+        // The file's objects and symbols are kept, but its dependencies
+        // were pruned with the rest of the project's, so add them again.
+        dependencies = entry.fingerprint->dependencies;
+        std::string::size_type start = 0, end;
+        while ((end = dependencies.find('\n', start)) != std::string::npos) {
+          inserters.dependencies.insert(build, project, "lib", dependencies.substr(start, end - start));
+          start = end + 1;
+        }
+        inserters.kept.insert(entry.filename);
+        ++(entry.scan == Scan::Skipped ? tally.skipped : tally.rehashed);
+      }
+      inserters.fingerprints.insert(build, project, entry.filename, (sqlite3_int64)entry.size, entry.mtime,
+                                    (sqlite3_int64)entry.inode, entry.checksum, dependencies);
+    }
+
+    // register regular files and symlinks in the DB
+    if (entry.info == FTS_F || entry.info == FTS_SL || entry.info == FTS_SLNONE) {
+      inserters.files.insert(build, project, entry.filename);
+      ++tally.loaded;
+    }
+
+    // add all regular files, directories, and symlinks to the manifest
+    if (entry.info == FTS_F || entry.info == FTS_D ||
+        entry.info == FTS_SL || entry.info == FTS_SLNONE) {
+      stream << entry.checksum << " ";
+      stream << std::oct << entry.mode << " ";
+      stream << entry.uid << " ";
+      stream << entry.gid << " ";
+      stream << ((entry.info != FTS_D) ? entry.size : (off_t)0) << " ";
+      stream << entry.filename << (!entry.symlink.empty() ? " -> " : "") << entry.symlink;
+      stream << std::endl;
+    }
   }
 
   static int create_tables(DBDatabase &database) {
     std::string files_table =
-        "CREATE TABLE files (build text, project text, path text)";
+        "CREATE TABLE IF NOT EXISTS files (build text, project text, path text)";
     std::string files_index =
-        "CREATE INDEX files_index ON files (build, project, path)";
+        "CREATE INDEX IF NOT EXISTS files_index ON files (build, project, path)";
+    std::string files_path_index =
+        "CREATE INDEX IF NOT EXISTS files_path_index ON files (path)";
     std::string unresolved_dependencies_table =
-        "CREATE TABLE unresolved_dependencies (build text, project text, type text, dependency)";
+        "CREATE TABLE IF NOT EXISTS unresolved_dependencies (build text, project text, type text, dependency)";
+    std::string unresolved_dependencies_index =
+        "CREATE INDEX IF NOT EXISTS unresolved_dependencies_index ON unresolved_dependencies (build, project, type, dependency)";
     std::string mach_o_objects_table =
-        "CREATE TABLE mach_o_objects (serial INTEGER PRIMARY KEY AUTOINCREMENT, magic INTEGER, type INTEGER, cputype INTEGER, cpusubtype INTEGER, flags INTEGER, build TEXT, project TEXT, path TEXT)";
+        "CREATE TABLE IF NOT EXISTS mach_o_objects (serial INTEGER PRIMARY KEY AUTOINCREMENT, magic INTEGER, type INTEGER, cputype INTEGER, cpusubtype INTEGER, flags INTEGER, build TEXT, project TEXT, path TEXT)";
     std::string mach_o_symbols_table =
-        "CREATE TABLE mach_o_symbols (mach_o_object INTEGER, type INTEGER, value INTEGER, name TEXT)";
-
+        "CREATE TABLE IF NOT EXISTS mach_o_symbols (mach_o_object INTEGER, type INTEGER, value INTEGER, name TEXT)";
+    // so pruning an object's symbols doesn't scan every symbol
+    std::string mach_o_symbols_index =
+        "CREATE INDEX IF NOT EXISTS mach_o_symbols_index ON mach_o_symbols (mach_o_object)";
+    // what each regular file was when last registered, to skip it if unchanged
+    std::string file_fingerprints_table =
+        "CREATE TABLE IF NOT EXISTS file_fingerprints (build TEXT, project TEXT, path TEXT, size INTEGER, mtime INTEGER, inode INTEGER, checksum TEXT, dependencies TEXT, PRIMARY KEY (build, project, path))";
+    // files whose objects are carried over from the last registration
+    std::string kept_files_table =
+        "CREATE TEMP TABLE IF NOT EXISTS kept_files (path TEXT PRIMARY KEY)";
+    // projects registered since resolveDeps last looked, for resolveDeps -changed
+    std::string modified_projects_table =
+        "CREATE TABLE IF NOT EXISTS modified_projects (build TEXT, project TEXT, PRIMARY KEY (build, project))";
+
+    // The indexes resolveDeps joins on are made here, before the load,
+    // so it never has to index a full table at once.
     try {
       database.query(files_table);
       database.query(files_index);
+      database.query(files_path_index);
       database.query(unresolved_dependencies_table);
+      database.query(unresolved_dependencies_index);
       database.query(mach_o_objects_table);
       database.query(mach_o_symbols_table);
+      database.query(mach_o_symbols_index);
+      database.query(file_fingerprints_table);
+      database.query(kept_files_table);
+      database.query(modified_projects_table);
     } catch (std::exception &err) {
       //          std::cout << "exists..............\n";
     }
@@ -624,17 +766,46 @@ public:
     }
     stream.str(""); // clear string
 
-    stream << R"(DELETE FROM mach_o_objects WHERE "build"=")" << build
-           << R"(" AND "project"=")" << project << "\"";
-    try {
-      database.query(stream.str());
-      database.query(R"(DELETE FROM mach_o_symbols WHERE "mach_o_object" NOT IN (SELECT serial FROM mach_o_objects))");
-    } catch (std::exception &e) {
-    }
+    // Objects are pruned after the walk, once it is known which are kept.
+    (database.prepare("DELETE FROM file_fingerprints WHERE build=? AND project=?") << build << project).execute();
+    database.query("DELETE FROM temp.kept_files");
 
     return 0;
   }
 
+  //
+  // Prunes the objects from the last registration of the project, except
+  // those of the files found unchanged; objects at or below `last_serial`
+  // are the ones from before this registration.
+  //
+  int prune_old_objects(DBDatabase &database,
+                        const std::string &build,
+                        const std::string &project,
+                        sqlite3_int64 last_serial) {
+    (database.prepare("DELETE FROM mach_o_symbols WHERE mach_o_object IN "
+                      "(SELECT serial FROM mach_o_objects WHERE build=? AND project=? AND serial<=? "
+                      "AND path NOT IN (SELECT path FROM temp.kept_files))")
+        << build << project << last_serial).execute();
+    (database.prepare("DELETE FROM mach_o_objects WHERE build=? AND project=? AND serial<=? "
+                      "AND path NOT IN (SELECT path FROM temp.kept_files)")
+        << build << project << last_serial).execute();
+    return 0;
+  }
+
+  std::unordered_map<std::string, Fingerprint> load_fingerprints(DBDatabase &database,
+                                                                 const std::string &build,
+                                                                 const std::string &project) {
+    std::unordered_map<std::string, Fingerprint> fingerprints;
+    auto select = database.prepare("SELECT path, size, mtime, inode, checksum, dependencies "
+                                   "FROM file_fingerprints WHERE build=? AND project=?");
+    select << build << project >> [&](std::string path, sqlite3_int64 size, sqlite3_int64 mtime,
+                                      sqlite3_int64 inode, std::string checksum, std::string dependencies) {
+      fingerprints.emplace(std::move(path), Fingerprint{size, mtime, inode, std::move(checksum),
+                                                        std::move(dependencies)});
+    };
+    return fingerprints;
+  }
+
   std::string format(const std::string format, ...){
     va_list args;
 
@@ -653,97 +824,182 @@ public:
   int register_files(DBDatabase &database,
                      const std::string &build,
                      const std::string &project,
-                     const std::string &path) {
+                     const std::string &path,
+                     size_t jobs) {
     ssize_t res = 0;
-    int loaded = 0;
+    Tally tally;
     std::stringstream stream;
     create_tables(database);
+    database.beginBulkLoad();
     database.query("BEGIN");
+    // Read by the walk and the workers; not changed once the walk starts.
+    const std::unordered_map<std::string, Fingerprint> fingerprints = load_fingerprints(database, build, project);
     prune_old_entries(database, build, project);
+    (database.prepare("INSERT OR IGNORE INTO modified_projects (build, project) VALUES (?, ?)")
+        << build << project).execute();
 
     //
-    // Enumerate the files in the path (DSTROOT) and associate them
-    // with the project name and version in the sqlitemodern database.
-    // Uses ent->fts_number to mark which files we have and have
-    // not seen before.
+    // The walk, the workers, and the writer run as a pipeline: this thread
+    // walks the DSTROOT and queues each entry in walk order, workers read
+    // regular files, and one writer thread records finished entries in the
+    // same order, so the database and receipt match a serial walk. The
+    // queue is bounded, so the walk can't get far ahead of the writer.
     //
-    // Skip the first result, since that is . of the DSTROOT itself.
-    char *path_argv[] = {(char *)path.c_str(), nullptr};
-    FTS *fts = fts_open(path_argv, FTS_PHYSICAL | FTS_COMFOLLOW | FTS_XDEV, compare);
-    FTSENT *ent = fts_read(fts); // throw away the entry for the DSTROOT itself
-    while ((ent = fts_read(fts)) != nullptr) {
-      char filename[MAXPATHLEN + 1];
-      char symlink[MAXPATHLEN + 1];
-      ssize_t len;
-
-      // Filename
-      filename[0] = 0;
-      ent_filename(ent, filename, MAXPATHLEN);
-
-      // Symlinks
-      symlink[0] = 0;
-      if (ent->fts_info == FTS_SL || ent->fts_info == FTS_SLNONE) {
-        len = readlink(ent->fts_accpath, symlink, MAXPATHLEN);
-        if (len >= 0)
-          symlink[len] = 0;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::shared_ptr<FileEntry>> pending;
+    const size_t max_pending = jobs * 64;
+    bool walking = true;
+    int error = 0;
+    std::string error_filename;
+    std::exception_ptr write_exception;
+
+    auto next_entry = [&]() -> std::shared_ptr<FileEntry> {
+      std::shared_ptr<FileEntry> entry;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] {
+          return (!pending.empty() && pending.front()->done) || (!walking && pending.empty());
+        });
+        if (pending.empty())
+          return nullptr;
+        entry = pending.front();
+        pending.pop_front();
       }
-
-      // Default to empty SHA-1 checksum
-      std::string checksum = "                                        ";
-
-      // Checksum regular files
-      if (ent->fts_info == FTS_F) {
-        int fd = open(ent->fts_accpath, O_RDONLY);
-        if (fd == -1) {
-          perror(filename);
-          return -1;
+      changed.notify_all();
+      return entry;
+    };
+
+    std::thread writer([&] {
+      try {
+        Inserters inserters(database);
+        const sqlite3_int64 last_serial = inserters.serial;
+        while (std::shared_ptr<FileEntry> entry = next_entry()) {
+          if (entry->error != 0) {
+            error = entry->error;
+            error_filename = entry->filename;
+            break;
+          }
+          write_entry(inserters, build, project, *entry, stream, tally);
         }
-        int isMachO;
-        res = register_libraries(database, fd, build, project, filename, &isMachO);
-        lseek(fd, (off_t)0, SEEK_SET);
-        checksum = calculate_digest(fd);
-        close(fd);
+        inserters.flush();
+        prune_old_objects(database, build, project, last_serial);
+      } catch (...) {
+        write_exception = std::current_exception();
       }
 
-      // register regular files and symlinks in the DB
-      if (ent->fts_info == FTS_F || ent->fts_info == FTS_SL ||
-          ent->fts_info == FTS_SLNONE) {
-        std::stringstream local_stream{};
-        local_stream << "INSERT INTO files(build, project, path) VALUES(\""
-                     << build << "\",\""
-                     << project << "\",\""
-                     << filename << "\")";
-        try {
-          database.query(local_stream.str());
-        } catch (std::exception &e) {}
-        ++loaded;
+      // After a failure, keep draining so the walk can finish.
+      while (next_entry()) {
       }
+    });
+
+    {
+      libutil::ThreadPool pool(jobs);
 
-      // add all regular files, directories, and symlinks to the manifest
-      if (ent->fts_info == FTS_F || ent->fts_info == FTS_D ||
-          ent->fts_info == FTS_SL || ent->fts_info == FTS_SLNONE) {
-//        stream << this->format("%s %o %d %d %lld .%s%s%s",
-//                               checksum.c_str(),
-//                               ent->fts_statp->st_mode, ent->fts_statp->st_uid,
-//                               ent->fts_statp->st_gid,
-//                               (ent->fts_info != FTS_D) ? ent->fts_statp->st_size : (off_t)0,
-//                               filename, symlink[0] ? " -> " : "", symlink[0] ? symlink : "");
-        stream << checksum << " ";
-        stream << std::oct << ent->fts_statp->st_mode << " ";
-        stream << ent->fts_statp->st_uid << " ";
-        stream << ent->fts_statp->st_gid << " ";
-        stream << ((ent->fts_info != FTS_D) ? ent->fts_statp->st_size : (off_t)0) << " ";
-        stream <<  filename << (symlink[0] ? " -> " : "") << (symlink[0] ? symlink : "");
-        stream << std::endl;
+      //
+      // Enumerate the files in the path (DSTROOT) and associate them
+      // with the project name and version in the sqlitemodern database.
+      // FTS_NOCHDIR keeps each fts_accpath usable from the workers.
+      //
+      // Skip the first result, since that is . of the DSTROOT itself.
+      char *path_argv[] = {(char *)path.c_str(), nullptr};
+      FTS *fts = fts_open(path_argv, FTS_PHYSICAL | FTS_COMFOLLOW | FTS_XDEV | FTS_NOCHDIR, compare);
+      FTSENT *ent = fts_read(fts); // throw away the entry for the DSTROOT itself
+      while ((ent = fts_read(fts)) != nullptr) {
+        auto entry = std::make_shared<FileEntry>();
+        char filename[MAXPATHLEN + 1];
+        char symlink[MAXPATHLEN + 1];
+        ssize_t len;
+
+        // Filename
+        filename[0] = 0;
+        ent_filename(ent, filename, MAXPATHLEN);
+
+        // Symlinks
+        symlink[0] = 0;
+        if (ent->fts_info == FTS_SL || ent->fts_info == FTS_SLNONE) {
+          len = readlink(ent->fts_accpath, symlink, MAXPATHLEN);
+          if (len >= 0)
+            symlink[len] = 0;
+        }
+
+        entry->filename = filename;
+        entry->accpath = ent->fts_accpath;
+        entry->symlink = symlink;
+        entry->info = ent->fts_info;
+        entry->mode = ent->fts_statp->st_mode;
+        entry->uid = ent->fts_statp->st_uid;
+        entry->gid = ent->fts_statp->st_gid;
+        entry->size = ent->fts_statp->st_size;
+        entry->mtime = modification_time(*ent->fts_statp);
+        entry->inode = ent->fts_statp->st_ino;
+
+        if (ent->fts_info == FTS_F) {
+          auto found = fingerprints.find(entry->filename);
+          if (found != fingerprints.end()) {
+            const Fingerprint &fingerprint = found->second;
+            entry->fingerprint = &fingerprint;
+            if (fingerprint.size == (sqlite3_int64)entry->size && fingerprint.mtime == entry->mtime &&
+                fingerprint.inode == (sqlite3_int64)entry->inode) {
+              entry->checksum = fingerprint.checksum;
+              entry->scan = Scan::Skipped;
+            }
+          }
+        }
+        entry->done = (ent->fts_info != FTS_F || entry->scan == Scan::Skipped);
+
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [&] { return pending.size() < max_pending; });
+          pending.push_back(entry);
+        }
+
+        // Checksum and parse changed regular files on the workers
+        if (!entry->done) {
+          pool.submit([this, entry, &mutex, &changed] {
+            this->process_file(entry.get());
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              entry->done = true;
+            }
+            changed.notify_all();
+          });
+        } else {
+          changed.notify_all();
+        }
       }
+      fts_close(fts);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      walking = false;
+    }
+    changed.notify_all();
+    writer.join();
+
+    if (write_exception) {
+      database.query("ROLLBACK");
+      database.endBulkLoad();
+      std::rethrow_exception(write_exception);
+    }
+
+    if (error != 0) {
+      errno = error;
+      perror(error_filename.c_str());
+      database.query("ROLLBACK");
+      database.endBulkLoad();
+      return -1;
     }
-    fts_close(fts);
 
     database.query("COMMIT");
+    database.endBulkLoad();
 
     std::cout << stream.str() << std::endl;
     res = setReceiptData(stream.str());
-    std::cerr << project << " - " << loaded << " files registered.\n";
+    std::cerr << project << " - " << tally.loaded << " files registered.\n";
+    std::cerr << project << " - " << tally.skipped << " unchanged, " << tally.rehashed << " rehashed, "
+              << tally.reparsed << " reparsed.\n";
     return (int)res;
 
   }
@@ -751,7 +1007,7 @@ public:
   int setReceiptData(const std::string &receiptData){
     std::vector<char> data(receiptData.begin(), receiptData.end());
     auto shaFilename = calculate_digest(data);
-    this->m_data.emplace_back("", ""); // so that m_data is never empty
+    this->m_data.resize(2); // the digest, then the receipt
     this->m_data[0] = shaFilename;
     this->m_data[1] = receiptData;
     return 0;
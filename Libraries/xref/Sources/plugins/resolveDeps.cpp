@@ -43,135 +43,193 @@ public:
    ~ResolveDeps()                              {}
     
     int run(DBDatabase &db, const std::string& build, const std::vector<std::string>& argv) override {
-        std::vector<std::string> data;
-        size_t count = argv.size();
         std::string project;
-        std::string version;
         int commit = 0;
-
-        if (count > 0) {
-            if (argv[0] == std::string("-commit")) {
-            commit = 1;
-          } else {
-            project = argv.at(0);
-          }
+        int changed = 0;
+
+        for (const std::string& arg : argv) {
+            if (arg == "-commit") {
+                commit = 1;
+            } else if (arg == "-changed") {
+                changed = 1;
+            } else if (project.empty()) {
+                project = arg;
+            } else {
+                return -1;
+            }
         }
-
-        if (count > 1) {
-            project = argv[1];
+        if (changed && !project.empty()) {
+            return -1;
         }
 
-        resolve_dependencies(db, build, project, commit);
-        return 0;
+        return resolve_dependencies(db, build, project, changed, commit);
     };
     
     std::string usage() override {
-        return "[-commit] [<project>]";
+        return "[-commit] [-changed | <project>]";
     };
-    
-    int resolve_dependencies(DBDatabase &db, const std::string& build, const std::string& project, int commit){
-        std::vector<std::string> builds;
-        std::vector<std::string> projects;
+
+    //
+    // Resolves unresolved dependencies (i.e. path names) to the projects
+    // that install them, in a few set-based statements rather than a few
+    // queries per dependency. Resolves the dependencies of every project,
+    // of one project, or with -changed, only those that may resolve
+    // differently since the last full or -changed resolve: those of
+    // projects registered since, and those on files they installed.
+    //
+    int resolve_dependencies(DBDatabase &db, const std::string& build, const std::string& project, int changed, int commit){
         int resolvedCount = 0, unresolvedCount = 0;
-        // if committing, use all projects, otherwise use unresolved projects
-        std::string table = (char*)( commit ? "properties" : "unresolved_dependencies" );
-
-        //
-        // If no project, version specified, resolve everything.
-        // Otherwise, resolve only that project or version.
-        //
-        if (project.empty()) {
-            builds = db.queryArray<std::string>("SELECT DISTINCT build FROM "+table+" WHERE project IS NOT NULL");
-            projects = db.queryArray<std::string>("SELECT DISTINCT project FROM "+table+" WHERE project IS NOT NULL");
-        } else {
-            builds = db.queryArray<std::string>("SELECT DISTINCT build FROM "+table+" WHERE project="+project);
-            projects = db.queryArray<std::string>("SELECT DISTINCT project FROM "+table+" WHERE project="+project);
+
+        create_tables(db);
+
+        // The unresolved dependencies u to resolve, with the project as ?1.
+        std::string scope = "1";
+        if (changed) {
+            scope = "u.rowid IN (SELECT id FROM temp.changed)";
+        } else if (!project.empty()) {
+            scope = "u.project = ?1";
         }
-        
-        unsigned long count = projects.size();
-        for (int i = 0; i < count; ++i) {
-            auto build = builds[i];
-            auto project = projects[i];
-            std::cerr << project <<" (" << build << ")\n";
-            resolve_project_dependencies(db, build, project, resolvedCount, unresolvedCount, commit);
+        auto statement = [&](const std::string& sql) {
+            auto statement = db.prepare(sql);
+            if (!changed && !project.empty()) {
+                statement << project;
+            }
+            return statement;
+        };
+
+        db.beginTransaction();
+        try {
+            // Collect the changed dependencies up front, so the statements
+            // below can look them up rather than scan for them.
+            if (changed) {
+                db.query("DELETE FROM temp.changed");
+                // CROSS JOIN keeps SQLite from scanning all files for the
+                // few modified projects, as it has no statistics on them.
+                db.query("INSERT INTO temp.changed (id) "
+                         "SELECT u.rowid FROM modified_projects m CROSS JOIN unresolved_dependencies u "
+                         "ON u.build = m.build AND u.project = m.project "
+                         "UNION SELECT u.rowid FROM unresolved_dependencies u WHERE u.dependency IN ("
+                         "SELECT f.path FROM modified_projects m CROSS JOIN files f "
+                         "ON f.build = m.build AND f.project = m.project)");
+            }
+
+            // Join each dependency on a path to a project installing that
+            // path, and keep the resolved dependencies not yet recorded.
+            // XXX
+            // This assumes a 1-to-1 mapping between files and projects;
+            // if several projects install a path, the first by name wins.
+            db.query("DELETE FROM temp.resolved");
+            statement("INSERT INTO temp.resolved (build, project, type, dependency) "
+                      "SELECT DISTINCT build, project, type, owner FROM ("
+                      "  SELECT u.build, u.project, u.type, MIN(f.project) AS owner "
+                      "  FROM unresolved_dependencies u JOIN files f ON f.path = u.dependency "
+                      "  WHERE f.project <> '' AND " + scope +
+                      "  GROUP BY u.build, u.project, u.type, u.dependency) r "
+                      "WHERE NOT EXISTS (SELECT 1 FROM dependencies d WHERE d.build = r.build AND "
+                      "d.project = r.project AND d.type = r.type AND d.dependency = r.owner)").execute();
+
+            std::string last;
+            db.prepare("SELECT build, project, type, dependency FROM temp.resolved ORDER BY build, project, type, dependency")
+                >> [&](std::string b, std::string p, std::string type, std::string dep) {
+                    if (last != b + "\n" + p) {
+                        last = b + "\n" + p;
+                        std::cerr << p << " (" << b << ")\n";
+                    }
+                    std::cerr << "\t" << dep << "(" << type << ")\n";
+                };
+
+            db.query("INSERT INTO dependencies (build, project, type, dependency) "
+                     "SELECT build, project, type, dependency FROM temp.resolved");
+            resolvedCount = db.changes();
+
+            // Deletes unresolved_dependencies after they are processed.
+            statement("DELETE FROM unresolved_dependencies WHERE rowid IN ("
+                      "SELECT u.rowid FROM unresolved_dependencies u WHERE " + scope +
+                      " AND EXISTS (SELECT 1 FROM files f WHERE f.path = u.dependency AND f.project <> ''))").execute();
+
+            statement("SELECT COUNT(*) FROM (SELECT DISTINCT u.build, u.project, u.type, u.dependency "
+                      "FROM unresolved_dependencies u WHERE " + scope + ")") >> unresolvedCount;
+
+            // Everything that could have changed has been resolved again.
+            if (project.empty()) {
+                db.query("DELETE FROM modified_projects");
+            }
+
+            if (commit) {
+                // if committing, use all projects
+                std::vector<std::string> builds;
+                std::vector<std::string> projects;
+                statement(std::string("SELECT DISTINCT build, project FROM properties u WHERE project IS NOT NULL AND ") +
+                          (changed ? "1" : scope))
+                    >> [&](std::string b, std::string p) {
+                        builds.push_back(b);
+                        projects.push_back(p);
+                    };
+                for (size_t i = 0; i < projects.size(); ++i) {
+                    commit_project_dependencies(db, builds[i], projects[i]);
+                }
+            }
+        } catch (...) {
+            db.rollbackTransaction();
+            throw;
         }
+        db.commitTransaction();
 
         std::cout << resolvedCount <<" dependencies resolved, "<< unresolvedCount <<" remaining." << std::endl;
         
         return 0;
     };
 
-    int resolve_project_dependencies(DBDatabase &db, std::string build, std::string project, int& resolvedCount, int& unresolvedCount, int commit) {
-        std::vector<std::string> files;
-        std::vector<std::string> types;
+    // The tables and indexes are normally made by registerFiles before it
+    // loads anything, but may be missing from older databases.
+    static void create_tables(DBDatabase &db) {
+        const char *statements[] = {
+            "CREATE TABLE IF NOT EXISTS dependencies (build TEXT, project TEXT, type TEXT, dependency TEXT)",
+            "CREATE INDEX IF NOT EXISTS dependencies_project_index ON dependencies (build, project, type, dependency)",
+            "CREATE INDEX IF NOT EXISTS unresolved_dependencies_index ON unresolved_dependencies (build, project, type, dependency)",
+            "CREATE INDEX IF NOT EXISTS files_path_index ON files (path)",
+            "CREATE TABLE IF NOT EXISTS modified_projects (build TEXT, project TEXT, PRIMARY KEY (build, project))",
+            "CREATE TEMP TABLE IF NOT EXISTS resolved (build TEXT, project TEXT, type TEXT, dependency TEXT)",
+            "CREATE TEMP TABLE IF NOT EXISTS changed (id INTEGER PRIMARY KEY)",
+        };
+        for (const char *sql : statements) {
+            try {
+                db.query(sql);
+            } catch (std::exception &e) {
+            }
+        }
+    }
 
-        db.query("CREATE TABLE dependencies (build TEXT, project TEXT, type TEXT, dependency TEXT)");
-        db.query("CREATE INDEX dependencies_index ON unresolved_dependencies (build, project, type, dependency)");
-        
-        db.beginTransaction();
+    // Merges resolved dependencies to the dependencies property dictionary.
+    // Deletes resolved dependencies after they are processed.
+    int commit_project_dependencies(DBDatabase &db, const std::string& build, const std::string& project) {
+        std::vector<std::string> types;
+        std::vector<std::string> projs;
+        auto dependencies = db.getDictionaryProp<std::string,std::vector<std::string>>(build, project, "dependencies");
 
-        // Convert from unresolved_dependencies (i.e. path names) to resolved dependencies (i.e. project names)
-        // Deletes unresolved_dependencies after they are processed.
-        files = db.queryArray<std::string>("SELECT DISTINCT dependency FROM unresolved_dependencies WHERE build="
-                                          +build+" AND project="+project);
-        types = db.queryArray<std::string>("SELECT DISTINCT type FROM unresolved_dependencies WHERE build="
-                                          +build+" AND project="+project);
+        db.prepare("SELECT DISTINCT dependency,type FROM dependencies WHERE build=? AND project=?")
+            << build << project >> [&](std::string proj, std::string type) {
+                projs.push_back(proj);
+                types.push_back(type);
+            };
 
-        for (int i = 0; i < files.size(); ++i) {
-            std::string file = files.at(i);
+        for (int i = 0; i < projs.size(); ++i) {
+            std::string proj = projs.at(i);
             std::string type = types.at(i);
-            // XXX
-            // This assumes a 1-to-1 mapping between files and projects.
-            std::string dep = db.query<std::string>("SELECT project FROM files WHERE path="+file);
-            if (!dep.empty()) {
-                // don't add duplicates
-                bool exists = db.query<bool>("SELECT 1 FROM dependencies WHERE build="+build+" AND project="
-                                             +project+" AND type="+type+" AND dependency="+dep);
-                if (!exists) {
-                    db.query("INSERT INTO dependencies (build,project,type,dependency) VALUES"
-                             "("+build+","+project+","+type+","+dep+")");
-                    resolvedCount += 1;
-                    std::cerr << "\t" << dep << "(" << type << ")\n";
-                }
-                db.query("DELETE FROM unresolved_dependencies WHERE"
-                         "build="+build+" AND project="+project+" AND type="+type+" AND dependency="+file);
-            } else {
-                unresolvedCount += 1;
-            }
-        }
 
-        // If committing, merge resolved dependencies to the dependencies property dictionary.
-        // Deletes resolved dependencies after they are processed.
-        if (commit) {
-            std::vector<std::string> types;
-            std::vector<std::string> projs;
-            std::vector<std::vector<std::string>> params = { projs, types };
-            auto dependencies = db.getDictionaryProp<std::string,std::vector<std::string>>(build, project, "dependencies");
-            
-            db.queryArray<std::string>("SELECT DISTINCT dependency,type FROM dependencies WHERE"
-                                        "build="+build+" AND project="+project);
-            
-            for (int i = 0; i < projs.size(); ++i) {
-                std::string proj = projs.at(i);
-                std::string type = types.at(i);
-                
-                auto deparray = dependencies[type];
-                if (deparray.empty()) {
-                    dependencies[type] = deparray;
-                }
-                
-                if (std::find(deparray.begin(), deparray.end(), proj) != deparray.end()) {
-                    deparray.push_back(proj);
-                }
+            auto deparray = dependencies[type];
+            if (deparray.empty()) {
+                dependencies[type] = deparray;
             }
-            
-//            DBSetProp(cfstr(build), cfstr(project), CFSTR("dependencies"), dependencies);
 
-            db.query("DELETE FROM dependencies WHERE build="+build+
-                     " AND project="+project);
+            if (std::find(deparray.begin(), deparray.end(), proj) != deparray.end()) {
+                deparray.push_back(proj);
+            }
         }
 
-        db.commitTransaction();
+//        DBSetProp(cfstr(build), cfstr(project), CFSTR("dependencies"), dependencies);
+
+        (db.prepare("DELETE FROM dependencies WHERE build=? AND project=?") << build << project).execute();
         return 0;
     }
     
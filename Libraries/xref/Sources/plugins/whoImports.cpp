@@ -0,0 +1,35 @@
+//
+//  whoImports.cpp
+//  libxref
+//
+//  Copyright © 2021 The PureDarwin Project. All rights reserved.
+//
+
+#include "Plugin.h"
+#include "SymbolIndex.h"
+
+namespace plugin {
+
+//
+// Prints the objects, and their projects, that import each symbol.
+//
+class WhoImports : BasicPlugin<DBString> {
+public:
+    WhoImports() : BasicPlugin("whoImports") {}
+   ~WhoImports()                             {}
+
+    int run(DBDatabase &db, const std::string& build, const std::vector<std::string>& argv) override {
+        if (argv.empty())
+            return -1;
+
+        return SymbolIndex::PrintObjects(db, build, argv, &SymbolIndex::importers);
+    };
+
+    std::string usage() override {
+        return "<symbol> ...";
+    };
+};
+
+DECLARE_PLUGIN(WhoImports, whoImports);
+
+} // namespace plugin